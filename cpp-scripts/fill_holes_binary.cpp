@@ -51,6 +51,19 @@ int main(int argc, char* const argv[]) {
                          "Radius to define the neighborhood");
   opt_desc.add_options()("iterations", po::value<size_t>()->default_value(1000),
                          "Number of max iterations");
+  opt_desc.add_options()(
+      "mode", po::value<std::string>()->default_value("voting"),
+      "Hole filling algorithm. [voting|voting_front|cavities]. "
+      "voting_front gives the same result than voting, but only visits the "
+      "pixels around the last changes. cavities fills the background not "
+      "connected to the border, it ignores majority, radius and iterations.");
+  opt_desc.add_options()(
+      "fully_connected", po::bool_switch()->default_value(false),
+      "Only for cavities mode: connect background pixels also through edges "
+      "and corners.");
+  opt_desc.add_options()("threads", po::value<size_t>()->default_value(0),
+                         "Number of threads for voting_front and cavities. "
+                         "0 uses the ITK default.");
   opt_desc.add_options()(
       "output_filename_simple,z", po::bool_switch()->default_value(false),
       "Filename does not contain the parameters used for this filter.");
@@ -89,6 +102,13 @@ int main(int argc, char* const argv[]) {
   bool verbose = vm["verbose"].as<bool>();
   bool output_filename_simple = vm["output_filename_simple"].as<bool>();
   std::string foreground = vm["foreground"].as<std::string>();
+  const std::string mode = vm["mode"].as<std::string>();
+  if(!(mode == "voting" || mode == "voting_front" || mode == "cavities")) {
+    throw po::validation_error(po::validation_error::invalid_option_value,
+                               "mode");
+  }
+  const bool fully_connected = vm["fully_connected"].as<bool>();
+  const size_t num_threads = vm["threads"].as<size_t>();
   if(static_cast<bool>(vm.count("foreground")) &&
      (!(foreground == "white" || foreground == "black"))) {
     throw po::validation_error(po::validation_error::invalid_option_value,
@@ -121,9 +141,13 @@ int main(int argc, char* const argv[]) {
   } else {
     std::string output_file_string = input_stem.string() + "_FILLED";
     if(!output_filename_simple) {
-      output_file_string += "_M" + std::to_string(majority) + "_R" +
-                            std::to_string(radius) + "_N" +
-                            std::to_string(iterations);
+      if(mode == "cavities") {
+        output_file_string += fully_connected ? "_cavitiesFull" : "_cavities";
+      } else {
+        output_file_string += "_M" + std::to_string(majority) + "_R" +
+                              std::to_string(radius) + "_N" +
+                              std::to_string(iterations);
+      }
     }
     output_file_path = fs::path(output_file_string);
     output_full_path =
@@ -155,8 +179,17 @@ int main(int argc, char* const argv[]) {
   ImageType::Pointer image =
       (invert_image) ? inverter->GetOutput() : reader->GetOutput();
 
-  const auto filled_image = SG::fill_holes_voting_iterative_function(
-      image, radius, majority, iterations, verbose);
+  ImageType::Pointer filled_image;
+  if(mode == "cavities") {
+    filled_image = SG::fill_holes_cavities_function(
+        image, fully_connected, num_threads, verbose);
+  } else if(mode == "voting_front") {
+    filled_image = SG::fill_holes_voting_front_function(
+        image, radius, majority, iterations, num_threads, verbose);
+  } else {
+    filled_image = SG::fill_holes_voting_iterative_function(
+        image, radius, majority, iterations, verbose);
+  }
 
   using WriterType = itk::ImageFileWriter<ImageType>;
   auto writer = WriterType::New();
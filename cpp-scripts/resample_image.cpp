@@ -43,8 +43,20 @@ int main(int argc, char *const argv[]) {
     opt_desc.add_options()("shrink_factor,s", po::value<double>()->required(),
                            "Shrink factor. If > 1 downsamples the image. If "
                            "between (0, 1) upsamples.");
+    opt_desc.add_options()(
+            "partial_volume", po::bool_switch()->default_value(false),
+            "Set foreground the output voxels with at least half of their "
+            "volume covered by foreground, instead of using the nearest "
+            "input voxel. Avoids losing thin structures when downsampling.");
+    opt_desc.add_options()("threads", po::value<size_t>()->default_value(0),
+                           "Number of threads, 0 uses the default of ITK.");
     opt_desc.add_options()("verbose,v", po::bool_switch()->default_value(false),
                            "verbose output");
+    opt_desc.add_options()(
+            "stream_output", po::bool_switch()->default_value(false),
+            "Write the output in slabs of z planes, without holding the whole "
+            "resampled image in memory. The output is an uncompressed .mha "
+            "file.");
     opt_desc.add_options()("nocompress",
                            po::bool_switch()->default_value(false),
                            "Do not use compression to write output.");
@@ -71,7 +83,12 @@ int main(int argc, char *const argv[]) {
     std::string filename = vm["input"].as<std::string>();
     double shrink_factor = vm["shrink_factor"].as<double>();
     const bool verbose = vm["verbose"].as<bool>();
+    const auto rule = vm["partial_volume"].as<bool>()
+                              ? SG::BinaryResampleRule::partial_volume
+                              : SG::BinaryResampleRule::nearest_neighbor;
+    const size_t num_threads = vm["threads"].as<size_t>();
     const bool nocompress = vm["nocompress"].as<bool>();
+    const bool stream_output = vm["stream_output"].as<bool>();
     if (static_cast<bool>(vm.count("outputFolder"))) {
         const fs::path output_folder_path{vm["outputFolder"].as<std::string>()};
         if (!fs::exists(output_folder_path)) {
@@ -101,8 +118,10 @@ int main(int argc, char *const argv[]) {
         std::string output_file_string = input_stem.string() + "_resampledX" +
                                          std::to_string(shrink_factor);
         output_file_path = fs::path(output_file_string);
-        output_full_path = output_folder_path /
-                           fs::path(output_file_path.string() + ".nrrd");
+        output_full_path =
+                output_folder_path /
+                fs::path(output_file_path.string() +
+                         (stream_output ? ".mha" : ".nrrd"));
     }
     if (verbose) {
         std::cout << "output_folder_path: " << output_folder_path.string()
@@ -122,8 +141,27 @@ int main(int argc, char *const argv[]) {
     reader->SetFileName(filename);
     reader->Update();
 
+    if (stream_output) {
+        const auto spacing = reader->GetOutput()->GetSpacing();
+        const auto size = reader->GetOutput()->GetLargestPossibleRegion().GetSize();
+        auto output_spacing = spacing;
+        auto output_size = size;
+        for (size_t i = 0; i < Dim; ++i) {
+            output_spacing[i] *= shrink_factor;
+            output_size[i] = static_cast<size_t>(size[i] / shrink_factor);
+        }
+        SG::resample_binary_image_to_file(
+                reader->GetOutput(), output_spacing, output_size,
+                output_full_path.string(), rule, 0.5, num_threads);
+        if (verbose) {
+            std::cout << "Resample Binary Image finished." << std::endl;
+            std::cout << "Output: " << output_full_path.string() << std::endl;
+        }
+        return EXIT_SUCCESS;
+    }
+
     const auto resampled_image = SG::resample_image_function(
-            reader->GetOutput(), shrink_factor, verbose);
+            reader->GetOutput(), shrink_factor, verbose, rule, num_threads);
 
     using WriterType = itk::ImageFileWriter<ImageType>;
     auto writer = WriterType::New();
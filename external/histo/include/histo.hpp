@@ -27,6 +27,7 @@ calculate and optimize breaks automatically. Accepts different precissions.
 #ifndef HISTO_HPP_
 #define HISTO_HPP_
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <iomanip> // std::setw
 #include <iostream>
@@ -48,6 +49,19 @@ enum breaks_method {
 };
 /** @} */
 
+/**
+ * @brief What to do with values out of the range of the breaks when filling
+ * the counts, @sa Histo::FillCounts
+ */
+enum class out_of_range_policy {
+    /** Throw histo_error. */
+    Throw,
+    /** Do not count the value. */
+    Ignore,
+    /** Count the value in the first or last bin. NaN values are ignored. */
+    Clamp
+};
+
 /** \defgroup GenerateBreaks Generate breaks from data, range, and/or bins. */
 /** @{
  * @brief Help functions to manually creating breaks from input range
@@ -207,6 +221,7 @@ struct Histo {
                                static_cast<PRECI>(*range_ptr.second));
         breaks = CalculateBreaks(data, range, method);
         bins = static_cast<decltype(bins)>(breaks.size() - 1);
+        UpdateBinLookup();
         ResetCounts();
         FillCounts(data);
     }
@@ -224,6 +239,7 @@ struct Histo {
         range = input_range;
         breaks = CalculateBreaks(data, range, method);
         bins = static_cast<decltype(bins)>(breaks.size() - 1);
+        UpdateBinLookup();
         ResetCounts();
         FillCounts(data);
     }
@@ -243,6 +259,7 @@ struct Histo {
             throw histo_error("input_breaks are not monotocally increasing");
         range = std::make_pair(breaks[0], breaks[breaks.size() - 1]);
         bins = static_cast<decltype(bins)>(breaks.size() - 1);
+        UpdateBinLookup();
         ResetCounts();
         FillCounts(data);
     }
@@ -329,31 +346,64 @@ struct Histo {
     /**
      * @brief Return the index of @sa counts associated to the input value
      *
+     * Bin i is [breaks[i], breaks[i + 1]), and the last bin includes its
+     * right border.
+     * If the breaks are uniform (@sa UpdateBinLookup) the index is computed
+     * arithmetically, otherwise with a binary search over the breaks.
+     * Both give the same index.
+     *
      * @param value Ranging from range.first to range.second
      * @return Index of counts
      */
     template <typename TData>
     size_t IndexFromValue(const TData &value) const {
-        // We could use this with a custom comparator:
-        // typename std::vector<T>::iterator low =
-        // std::lower_bound(breaks.begin(), breaks.end(), value);
-        size_t lo{0}, hi{bins}, newb; // include right border in the last bin.
-        if (value >= breaks[lo] &&
-            (value < breaks[hi] ||
-             histo::isequalthan<PRECI>(value, breaks[hi]))) {
-            while (hi - lo >= 2) {
-                newb = (hi + lo) / 2;
-                if ((value >= breaks[newb]))
-                    lo = newb;
-                else
-                    hi = newb;
-            }
-        } else {
+        if (!IsInRange(value)) {
             throw histo_error(" IndexFromValue: " + std::to_string(value) +
                               " is out of bonds");
         }
+        if (HasBinLookup()) {
+            return IndexFromValueInRange(value,
+                                         IndexEstimateFromValue(value));
+        }
+        return BinarySearchIndexFromValue(value);
+    }
 
-        return lo;
+    /**
+     * @brief Check if the breaks are uniform, to use a direct arithmetic
+     * bin lookup in @sa IndexFromValue and @sa FillCounts.
+     *
+     * It is called by the constructors. Call it again if the breaks are
+     * modified manually, otherwise the lookup falls back to a binary
+     * search (results are the same, only slower).
+     */
+    void UpdateBinLookup() {
+        lookup_bins_ = 0;
+        lookup_low_ = 0;
+        lookup_inv_width_ = 0;
+        if (bins == 0 || breaks.size() != bins + 1) {
+            return;
+        }
+        const PRECI low = breaks.front();
+        const PRECI width = (breaks.back() - low) / static_cast<PRECI>(bins);
+        if (!(width > 0)) {
+            return;
+        }
+        // The estimate is corrected by one bin at most, breaks can differ
+        // from the uniform grid because of rounding.
+        for (size_t i = 0; i != bins + 1; ++i) {
+            if (std::abs(breaks[i] - (low + static_cast<PRECI>(i) * width)) >
+                width / 4) {
+                return;
+            }
+        }
+        lookup_bins_ = bins;
+        lookup_low_ = low;
+        lookup_inv_width_ = static_cast<PRECI>(1) / width;
+    }
+    /** @brief True if the breaks are uniform. @sa UpdateBinLookup */
+    bool HasBinLookup() const {
+        return lookup_bins_ != 0 && lookup_bins_ == bins &&
+               breaks.size() == bins + 1;
     }
 
     /** @brief Resize counts and reset value to zero. */
@@ -373,12 +423,80 @@ struct Histo {
      */
     template <typename TData>
     CountsType &FillCounts(const std::vector<TData> &data) {
-        for (auto &v : data) {
-            counts[IndexFromValue(v)]++;
-        }
+        FillCounts(std::begin(data), std::end(data), out_of_range_policy::Throw);
         return counts;
     }
 
+    /**
+     * @brief Fill counts from the values in [first, last).
+     * Breaks must have been set-up before calling this method.
+     *
+     * Values are binned in blocks: the bin estimates of a block are computed
+     * in a branch-free loop that the compiler can vectorize, and then
+     * corrected with the breaks, so the result is the same than
+     * @sa IndexFromValue for each value.
+     *
+     * @param first, last input range of values
+     * @param policy what to do with values out of range. With Throw, the
+     * values before the first out of range value are already counted.
+     *
+     * @return number of values that were not counted.
+     */
+    template <typename TIterator>
+    size_t FillCounts(TIterator first,
+                      TIterator last,
+                      const out_of_range_policy policy) {
+        using ValueType =
+                typename std::iterator_traits<TIterator>::value_type;
+        constexpr size_t block_size = 256;
+        std::array<ValueType, block_size> values;
+        std::array<size_t, block_size> estimates;
+        const bool has_bin_lookup = HasBinLookup();
+        const PRECI max_estimate = static_cast<PRECI>(bins == 0 ? 0 : bins - 1);
+        size_t not_counted = 0;
+        while (first != last) {
+            size_t block = 0;
+            for (; block != block_size && first != last; ++block, ++first) {
+                values[block] = *first;
+            }
+            if (has_bin_lookup) {
+                for (size_t i = 0; i != block; ++i) {
+                    // max and min in this order map NaN to 0.
+                    const PRECI x = (values[i] - lookup_low_) *
+                                    lookup_inv_width_;
+                    estimates[i] = static_cast<size_t>(std::min(
+                            std::max(static_cast<PRECI>(0), x), max_estimate));
+                }
+            }
+            for (size_t i = 0; i != block; ++i) {
+                const ValueType &value = values[i];
+                if (!IsInRange(value)) {
+                    if (policy == out_of_range_policy::Throw) {
+                        throw histo_error(" FillCounts: " +
+                                          std::to_string(value) +
+                                          " is out of bonds");
+                    }
+                    if (policy == out_of_range_policy::Clamp && bins != 0) {
+                        if (value < breaks[0]) {
+                            ++counts[0];
+                            continue;
+                        }
+                        if (value > breaks[bins]) {
+                            ++counts[bins - 1];
+                            continue;
+                        }
+                    }
+                    ++not_counted;
+                    continue;
+                }
+                ++counts[has_bin_lookup
+                                 ? IndexFromValueInRange(value, estimates[i])
+                                 : BinarySearchIndexFromValue(value)];
+            }
+        }
+        return not_counted;
+    }
+
     /** \defgroup CountsManipulation Counts Safe Manipulation */
     /** @{
      * @brief Increase count by one, checking if exceeds
@@ -422,6 +540,55 @@ struct Histo {
 
     /** @} */
   protected:
+    /** @sa UpdateBinLookup. lookup_bins_ = 0 disables the lookup. */
+    size_t lookup_bins_{0};
+    PRECI lookup_low_{0};
+    PRECI lookup_inv_width_{0};
+
+    /** value is in [breaks[0], breaks[bins]], false for NaN. */
+    template <typename TData> bool IsInRange(const TData &value) const {
+        return bins != 0 && value >= breaks[0] &&
+               (value < breaks[bins] ||
+                histo::isequalthan<PRECI>(value, breaks[bins]));
+    }
+    /** Bin of a value in range, from uniform breaks. It can be one bin off
+     * because of rounding. */
+    template <typename TData>
+    size_t IndexEstimateFromValue(const TData &value) const {
+        const PRECI x = (value - lookup_low_) * lookup_inv_width_;
+        return static_cast<size_t>(std::min(std::max(static_cast<PRECI>(0), x),
+                                            static_cast<PRECI>(bins - 1)));
+    }
+    /** Correct the estimate of the bin of a value in range. */
+    template <typename TData>
+    size_t IndexFromValueInRange(const TData &value, size_t index) const {
+        if (value < breaks[index]) {
+            --index; // index > 0, because value >= breaks[0]
+            if (value < breaks[index]) {
+                return BinarySearchIndexFromValue(value);
+            }
+        } else if (index + 1 < bins && value >= breaks[index + 1]) {
+            ++index;
+            if (index + 1 < bins && value >= breaks[index + 1]) {
+                return BinarySearchIndexFromValue(value);
+            }
+        }
+        return index;
+    }
+    /** Binary search of the bin of a value in range. */
+    template <typename TData>
+    size_t BinarySearchIndexFromValue(const TData &value) const {
+        size_t lo{0}, hi{bins}, newb; // include right border in the last bin.
+        while (hi - lo >= 2) {
+            newb = (hi + lo) / 2;
+            if ((value >= breaks[newb]))
+                lo = newb;
+            else
+                hi = newb;
+        }
+        return lo;
+    }
+
     bool CheckIfMonotonicallyIncreasing(
             const BreaksType &input_breaks) const {
         auto prev_value = input_breaks[0];
@@ -634,6 +801,7 @@ NormalizeByArea(const Histo<PRECI, PRECI_INTEGER> &input_histo) {
     Histo<PRECI, PRECI> normalized;
     normalized.bins = input_histo.bins;
     normalized.breaks = input_histo.breaks;
+    normalized.UpdateBinLookup();
     // normalized_counts has different type than input_histo.counts.
     normalized.counts.resize(input_histo.bins);
     std::transform(std::begin(input_histo.counts), std::end(input_histo.counts),
@@ -242,3 +242,74 @@ TEST(NormalizeByArea, withJustData) {
   EXPECT_FLOAT_EQ(counts[3], 1.0 / sum_areas);
   EXPECT_FLOAT_EQ(counts[19], 1.0 / sum_areas);
 }
+
+namespace {
+/** Bin of value by linear search, reference for IndexFromValue. */
+size_t LinearSearchIndex(const Histo<double> &h, const double &value) {
+  for (size_t i = 0; i + 1 < h.bins; ++i) {
+    if (value < h.breaks[i + 1])
+      return i;
+  }
+  return h.bins - 1;
+}
+} // namespace
+
+TEST(IndexFromValue, uniformBreaksAreEqualToSearch) {
+  auto breaks = histo::GenerateBreaksFromRangeAndBins<double>(-1.0, 1.0, 100);
+  Histo<double> h(vector<double>(), breaks);
+  EXPECT_TRUE(h.HasBinLookup());
+  std::mt19937 engine(10);
+  std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+  for (size_t i = 0; i < 100000; ++i) {
+    const double value = distribution(engine);
+    EXPECT_EQ(h.IndexFromValue(value), LinearSearchIndex(h, value));
+  }
+  for (const auto &value : breaks) {
+    EXPECT_EQ(h.IndexFromValue(value), LinearSearchIndex(h, value));
+    const double previous = std::nextafter(value, -2.0);
+    if (previous >= breaks.front()) {
+      EXPECT_EQ(h.IndexFromValue(previous), LinearSearchIndex(h, previous));
+    }
+  }
+  EXPECT_EQ(h.IndexFromValue(1.0), h.bins - 1);
+  ASSERT_THROW(h.IndexFromValue(1.1), histo_error);
+  ASSERT_THROW(h.IndexFromValue(std::nan("")), histo_error);
+}
+
+TEST(IndexFromValue, nonUniformBreaksUseSearch) {
+  vector<double> breaks{0.0, 0.1, 0.5, 2.0, 10.0};
+  Histo<double> h(vector<double>(), breaks);
+  EXPECT_FALSE(h.HasBinLookup());
+  EXPECT_EQ(h.IndexFromValue(0.05), 0);
+  EXPECT_EQ(h.IndexFromValue(0.5), 2);
+  EXPECT_EQ(h.IndexFromValue(3.0), 3);
+  EXPECT_EQ(h.IndexFromValue(10.0), 3);
+}
+
+TEST(FillCounts, batchIsEqualToIndexFromValue) {
+  auto breaks = histo::GenerateBreaksFromRangeAndBins<double>(0.0, 3.0, 30);
+  std::mt19937 engine(10);
+  std::uniform_real_distribution<double> distribution(0.0, 3.0);
+  vector<double> data(1000);
+  for (auto &v : data)
+    v = distribution(engine);
+  Histo<double> h(data, breaks);
+  vector<size_t> expected_counts(h.bins, 0);
+  for (const auto &v : data)
+    expected_counts[LinearSearchIndex(h, v)]++;
+  EXPECT_EQ(h.counts, expected_counts);
+}
+
+TEST(FillCounts, outOfRangePolicy) {
+  auto breaks = histo::GenerateBreaksFromRangeAndBins<double>(0.0, 1.0, 10);
+  Histo<double> h(vector<double>(), breaks);
+  const vector<double> data{-1.0, 0.05, 0.95, 2.0, std::nan("")};
+  EXPECT_EQ(h.FillCounts(data.begin(), data.end(), out_of_range_policy::Ignore), 3);
+  EXPECT_EQ(std::accumulate(h.counts.begin(), h.counts.end(), size_t(0)), 2);
+  h.ResetCounts();
+  EXPECT_EQ(h.FillCounts(data.begin(), data.end(), out_of_range_policy::Clamp), 1);
+  EXPECT_EQ(h.counts[0], 2);
+  EXPECT_EQ(h.counts[9], 2);
+  ASSERT_THROW(h.FillCounts(data.begin(), data.end(), out_of_range_policy::Throw), histo_error);
+  ASSERT_THROW(h.FillCounts(data), histo_error);
+}
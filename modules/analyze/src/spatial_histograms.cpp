@@ -67,6 +67,7 @@ histo::Histo<double> read_histogram(std::istream &is) {
     histo.bins = histo.counts.size();
     histo.range.first = histo.breaks[0];
     histo.range.second = histo.breaks.back();
+    histo.UpdateBinLookup();
     return histo;
 }
 
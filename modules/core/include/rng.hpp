@@ -118,6 +118,17 @@ inline std::array<double, 3> random_orientation(const double &r) {
     const double theta = rand_2pi();
     return {r * sin(phi) * cos(theta), r * sin(phi) * sin(theta), r * cos(phi)};
 }
+/** @brief random_orientation drawing from the input engine eng,
+ * instead of @ref engine().
+ */
+inline std::array<double, 3> random_orientation(const double &r,
+                                                std::mt19937 &eng) {
+    std::uniform_real_distribution<double> upi(0.0, pi);
+    std::uniform_real_distribution<double> u2pi(0.0, two_pi);
+    const double phi = upi(eng);
+    const double theta = u2pi(eng);
+    return {r * sin(phi) * cos(theta), r * sin(phi) * sin(theta), r * cos(phi)};
+}
 /**
  * Lognormal distribution variable.
  * @param mean log of variable
@@ -24,6 +24,9 @@
 #include "spatial_edge.hpp"  // for SG::PointType
 #include "spatial_graph.hpp" // for SG::GraphAL
 
+#include <stdexcept>
+#include <string>
+
 namespace SG {
 
 /**
@@ -75,25 +78,136 @@ index_array_to_physical_space_array(const SG::PointType &input_array,
     return physical_array;
 }
 
-inline void
-transform_graph_to_physical_space(SG::GraphAL &sg,
-                                  const SG::PointType &origin,
-                                  const SG::PointType &spacing,
-                                  const SG::DirectionMatrixType &direction) {
-    // Loop over all nodes and transform pos.
-    auto verts = boost::vertices(sg);
-    for (auto &&vi = verts.first; vi != verts.second; ++vi) {
-        sg[*vi].pos = index_array_to_physical_space_array(
-                sg[*vi].pos, origin, spacing, direction);
-    }
-    // Loop over all edges and transform edge_points
-    auto edges = boost::edges(sg);
-    for (auto ei = edges.first; ei != edges.second; ++ei) {
-        for (auto &&ep : sg[*ei].edge_points) {
-            ep = index_array_to_physical_space_array(
-                    ep, origin, spacing, direction);
+/**
+ * 3x4 affine transform [M | t], row-major, with p' = M * p + t.
+ *
+ *      A0, A1, A2,  A3
+ * A =  A4, A5, A6,  A7
+ *      A8, A9, A10, A11
+ *
+ */
+using AffineMatrixType = std::array<double, 12>;
+
+/**
+ * Affine equivalent to ITK TransformIndexToPhysicalPoint:
+ * M = direction * diag(spacing), t = origin.
+ *
+ * @param origin
+ * @param spacing
+ * @param direction
+ *
+ * @return index to physical space affine
+ */
+AffineMatrixType
+index_to_physical_space_affine(const SG::PointType &origin,
+                               const SG::PointType &spacing,
+                               const SG::DirectionMatrixType &direction);
+
+/**
+ * Inverse of an affine transform.
+ * Throws std::runtime_error if the matrix is singular.
+ *
+ * @param affine
+ *
+ * @return inverted affine
+ */
+AffineMatrixType invert_affine(const AffineMatrixType &affine);
+
+/**
+ * Composition of two affine transforms, the result applies first, then
+ * second: p' = second(first(p)).
+ *
+ * @param first
+ * @param second
+ *
+ * @return composed affine
+ */
+AffineMatrixType compose_affine(const AffineMatrixType &first,
+                                const AffineMatrixType &second);
+
+inline SG::PointType apply_affine(const AffineMatrixType &affine,
+                                  const SG::PointType &input_array) {
+    // clang-format off
+    return SG::PointType({
+        affine[0] * input_array[0] + affine[1] * input_array[1] +
+        affine[2] * input_array[2] + affine[3],
+        affine[4] * input_array[0] + affine[5] * input_array[1] +
+        affine[6] * input_array[2] + affine[7],
+        affine[8] * input_array[0] + affine[9] * input_array[1] +
+        affine[10] * input_array[2] + affine[11]
+    });
+    // clang-format on
+}
+
+/**
+ * Apply the affine to all the node positions and edge points of the graph.
+ *
+ * The affine is applied in contiguous runs of points (the edge_points of each
+ * edge, and the nodes), and the runs are distributed between threads,
+ * balancing the number of points per thread.
+ *
+ * @param sg input/output graph
+ * @param affine transform to apply
+ * @param round_to_nearest_index if true, round the result to the nearest
+ * integer, as ITK TransformPhysicalPointToIndex does.
+ * @param num_threads number of threads, 0 to use all the available.
+ * Small graphs are always transformed in the calling thread.
+ */
+void transform_graph_with_affine(SG::GraphAL &sg,
+                                 const AffineMatrixType &affine,
+                                 const bool round_to_nearest_index = false,
+                                 const size_t num_threads = 0);
+
+/**
+ * Batch equivalent of index_array_to_physical_space_array applied to every
+ * point of the graph. The affine is computed once.
+ */
+void transform_graph_to_physical_space(
+        SG::GraphAL &sg,
+        const SG::PointType &origin,
+        const SG::PointType &spacing,
+        const SG::DirectionMatrixType &direction,
+        const size_t num_threads = 0);
+
+/**
+ * Inverse of transform_graph_to_physical_space.
+ *
+ * @param round_to_nearest_index if true (default), the positions are rounded
+ * to the nearest index, as ITK TransformPhysicalPointToIndex does.
+ * If false, the continuous index is kept.
+ */
+void transform_graph_to_index_space(SG::GraphAL &sg,
+                                    const SG::PointType &origin,
+                                    const SG::PointType &spacing,
+                                    const SG::DirectionMatrixType &direction,
+                                    const bool round_to_nearest_index = true,
+                                    const size_t num_threads = 0);
+
+/**
+ * Index to physical space affine from the metadata of an ITK image.
+ * Only 3D images are supported.
+ */
+template <typename TImage>
+AffineMatrixType index_to_physical_space_affine(const TImage *itk_image) {
+    constexpr auto dim = TImage::ImageDimension;
+    if (dim != 3)
+        throw std::runtime_error(
+                "index_to_physical_space_affine, image dimension " +
+                std::to_string(dim) + " is not supported, only 3D.");
+    SG::PointType origin;
+    SG::PointType spacing;
+    SG::DirectionMatrixType direction;
+    const auto &itk_origin = itk_image->GetOrigin();
+    const auto &itk_spacing = itk_image->GetSpacing();
+    const auto &itk_direction = itk_image->GetDirection();
+    for (size_t i = 0; i < 3; i++) {
+        origin[i] = itk_origin[i];
+        spacing[i] = itk_spacing[i];
+        for (size_t j = 0; j < 3; j++) {
+            direction[3 * i + j] = itk_direction[i][j];
         }
     }
+    return index_to_physical_space_affine(origin, spacing, direction);
 }
 
 template <typename TImage>
@@ -156,37 +270,23 @@ physical_space_array_to_index_array(const SG::PointType &input_array,
 
 template <typename TImage>
 void transform_graph_to_physical_space(SG::GraphAL &sg,
-                                       const TImage *itk_image) {
-    // Loop over all nodes and transform pos.
-    auto verts = boost::vertices(sg);
-    for (auto &&vi = verts.first; vi != verts.second; ++vi) {
-        sg[*vi].pos =
-                index_array_to_physical_space_array(sg[*vi].pos, itk_image);
-    }
-    // Loop over all edges and transform edge_points
-    auto edges = boost::edges(sg);
-    for (auto ei = edges.first; ei != edges.second; ++ei) {
-        for (auto &&ep : sg[*ei].edge_points) {
-            ep = index_array_to_physical_space_array(ep, itk_image);
-        }
-    }
+                                       const TImage *itk_image,
+                                       const size_t num_threads = 0) {
+    transform_graph_with_affine(sg, index_to_physical_space_affine(itk_image),
+                                false, num_threads);
 }
 
+/**
+ * Equivalent to physical_space_array_to_index_array applied to every point
+ * of the graph: positions are rounded to the nearest index.
+ */
 template <typename TImage>
-void transform_graph_to_index_space(SG::GraphAL &sg, const TImage *itk_image) {
-    // Loop over all nodes and transform pos.
-    auto verts = boost::vertices(sg);
-    for (auto &&vi = verts.first; vi != verts.second; ++vi) {
-        sg[*vi].pos =
-                physical_space_array_to_index_array(sg[*vi].pos, itk_image);
-    }
-    // Loop over all edges and transform edge_points
-    auto edges = boost::edges(sg);
-    for (auto ei = edges.first; ei != edges.second; ++ei) {
-        for (auto &&ep : sg[*ei].edge_points) {
-            ep = physical_space_array_to_index_array(ep, itk_image);
-        }
-    }
+void transform_graph_to_index_space(SG::GraphAL &sg,
+                                    const TImage *itk_image,
+                                    const size_t num_threads = 0) {
+    transform_graph_with_affine(
+            sg, invert_affine(index_to_physical_space_affine(itk_image)), true,
+            num_threads);
 }
 
 } // namespace SG
@@ -0,0 +1,216 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+
+#include "transform_to_physical_point.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+namespace SG {
+
+namespace {
+/** Contiguous run of points, i.e. the edge_points of an edge. */
+struct PointsRun {
+    SG::PointType *points;
+    size_t size;
+};
+
+/** Below this number of points, the graph is transformed serially. */
+constexpr size_t min_points_per_thread = 4096;
+
+/**
+ * Kernel applying the affine to a contiguous run of points.
+ * Coefficients are loaded into locals, so the compiler can keep them in
+ * registers and vectorize the loop.
+ */
+void apply_affine_to_run(const AffineMatrixType &affine,
+                         SG::PointType *points,
+                         const size_t size,
+                         const bool round_to_nearest_index) {
+    const double a0 = affine[0], a1 = affine[1], a2 = affine[2],
+                 a3 = affine[3];
+    const double a4 = affine[4], a5 = affine[5], a6 = affine[6],
+                 a7 = affine[7];
+    const double a8 = affine[8], a9 = affine[9], a10 = affine[10],
+                 a11 = affine[11];
+    for (size_t i = 0; i < size; ++i) {
+        const double x = points[i][0];
+        const double y = points[i][1];
+        const double z = points[i][2];
+        points[i][0] = a0 * x + a1 * y + a2 * z + a3;
+        points[i][1] = a4 * x + a5 * y + a6 * z + a7;
+        points[i][2] = a8 * x + a9 * y + a10 * z + a11;
+    }
+    if (round_to_nearest_index) {
+        // As ITK RoundHalfIntegerUp, used in TransformPhysicalPointToIndex
+        for (size_t i = 0; i < size; ++i) {
+            for (size_t d = 0; d < 3; ++d) {
+                points[i][d] = std::floor(points[i][d] + 0.5);
+            }
+        }
+    }
+}
+} // namespace
+
+AffineMatrixType
+index_to_physical_space_affine(const SG::PointType &origin,
+                               const SG::PointType &spacing,
+                               const SG::DirectionMatrixType &direction) {
+    AffineMatrixType affine;
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = 0; j < 3; ++j) {
+            affine[4 * i + j] = direction[3 * i + j] * spacing[j];
+        }
+        affine[4 * i + 3] = origin[i];
+    }
+    return affine;
+}
+
+AffineMatrixType invert_affine(const AffineMatrixType &a) {
+    // Cofactors of the 3x3 linear part
+    const double c00 = a[5] * a[10] - a[6] * a[9];
+    const double c01 = a[6] * a[8] - a[4] * a[10];
+    const double c02 = a[4] * a[9] - a[5] * a[8];
+    const double det = a[0] * c00 + a[1] * c01 + a[2] * c02;
+    if (det == 0.0) {
+        throw std::runtime_error("invert_affine: the matrix is singular.");
+    }
+    const double inv_det = 1.0 / det;
+    AffineMatrixType inv;
+    inv[0] = c00 * inv_det;
+    inv[1] = (a[2] * a[9] - a[1] * a[10]) * inv_det;
+    inv[2] = (a[1] * a[6] - a[2] * a[5]) * inv_det;
+    inv[4] = c01 * inv_det;
+    inv[5] = (a[0] * a[10] - a[2] * a[8]) * inv_det;
+    inv[6] = (a[2] * a[4] - a[0] * a[6]) * inv_det;
+    inv[8] = c02 * inv_det;
+    inv[9] = (a[1] * a[8] - a[0] * a[9]) * inv_det;
+    inv[10] = (a[0] * a[5] - a[1] * a[4]) * inv_det;
+    // t' = -M^-1 * t
+    for (size_t i = 0; i < 3; ++i) {
+        inv[4 * i + 3] = -(inv[4 * i] * a[3] + inv[4 * i + 1] * a[7] +
+                           inv[4 * i + 2] * a[11]);
+    }
+    return inv;
+}
+
+AffineMatrixType compose_affine(const AffineMatrixType &first,
+                                const AffineMatrixType &second) {
+    AffineMatrixType out;
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = 0; j < 4; ++j) {
+            double value = j == 3 ? second[4 * i + 3] : 0.0;
+            for (size_t k = 0; k < 3; ++k) {
+                value += second[4 * i + k] * first[4 * k + j];
+            }
+            out[4 * i + j] = value;
+        }
+    }
+    return out;
+}
+
+void transform_graph_with_affine(SG::GraphAL &sg,
+                                 const AffineMatrixType &affine,
+                                 const bool round_to_nearest_index,
+                                 const size_t num_threads) {
+    // Gather the contiguous runs of points: one per node, one per edge.
+    std::vector<PointsRun> runs;
+    runs.reserve(boost::num_vertices(sg) + boost::num_edges(sg));
+    size_t total_points = 0;
+    const auto verts = boost::vertices(sg);
+    for (auto vi = verts.first; vi != verts.second; ++vi) {
+        runs.push_back({&sg[*vi].pos, 1});
+        ++total_points;
+    }
+    const auto edges = boost::edges(sg);
+    for (auto ei = edges.first; ei != edges.second; ++ei) {
+        auto &edge_points = sg[*ei].edge_points;
+        if (!edge_points.empty()) {
+            runs.push_back({edge_points.data(), edge_points.size()});
+            total_points += edge_points.size();
+        }
+    }
+
+    const size_t available_threads =
+            num_threads == 0
+                    ? std::max(1u, std::thread::hardware_concurrency())
+                    : num_threads;
+    const size_t threads = std::max<size_t>(
+            1, std::min(available_threads,
+                        total_points / min_points_per_thread));
+
+    const auto transform_runs = [&](const size_t begin, const size_t end) {
+        for (size_t r = begin; r < end; ++r) {
+            apply_affine_to_run(affine, runs[r].points, runs[r].size,
+                                round_to_nearest_index);
+        }
+    };
+    if (threads == 1) {
+        transform_runs(0, runs.size());
+        return;
+    }
+
+    // Split the runs in ranges with a similar number of points.
+    const size_t points_per_thread = (total_points + threads - 1) / threads;
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    size_t begin = 0;
+    size_t accumulated = 0;
+    for (size_t r = 0; r < runs.size(); ++r) {
+        accumulated += runs[r].size;
+        if (accumulated >= points_per_thread || r + 1 == runs.size()) {
+            workers.emplace_back(transform_runs, begin, r + 1);
+            begin = r + 1;
+            accumulated = 0;
+        }
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+void transform_graph_to_physical_space(
+        SG::GraphAL &sg,
+        const SG::PointType &origin,
+        const SG::PointType &spacing,
+        const SG::DirectionMatrixType &direction,
+        const size_t num_threads) {
+    transform_graph_with_affine(
+            sg, index_to_physical_space_affine(origin, spacing, direction),
+            false, num_threads);
+}
+
+void transform_graph_to_index_space(SG::GraphAL &sg,
+                                    const SG::PointType &origin,
+                                    const SG::PointType &spacing,
+                                    const SG::DirectionMatrixType &direction,
+                                    const bool round_to_nearest_index,
+                                    const size_t num_threads) {
+    transform_graph_with_affine(
+            sg,
+            invert_affine(index_to_physical_space_affine(origin, spacing,
+                                                         direction)),
+            round_to_nearest_index, num_threads);
+}
+
+} // namespace SG
@@ -187,3 +187,87 @@ TEST_F(non_default_image, transform_graph_to_index_space) {
     EXPECT_DOUBLE_EQ(ep2[1], 1.);
     EXPECT_DOUBLE_EQ(ep2[2], 0.);
 }
+
+TEST(affine, invert_and_compose) {
+    const SG::PointType origin = {{1.0, -2.0, 3.0}};
+    const SG::PointType spacing = {{0.5, 2.0, 1.5}};
+    // Rotation of 90 degrees around z
+    const SG::DirectionMatrixType direction = {{0, -1, 0, 1, 0, 0, 0, 0, 1}};
+    const auto affine =
+            SG::index_to_physical_space_affine(origin, spacing, direction);
+    const auto input_array = SG::PointType{{3.0, 4.0, 5.0}};
+    const auto physical = SG::apply_affine(affine, input_array);
+    const auto expected = SG::index_array_to_physical_space_array(
+            input_array, origin, spacing, direction);
+    for (size_t i = 0; i < 3; i++) {
+        EXPECT_DOUBLE_EQ(physical[i], expected[i]);
+    }
+    const auto back = SG::apply_affine(SG::invert_affine(affine), physical);
+    for (size_t i = 0; i < 3; i++) {
+        EXPECT_NEAR(back[i], input_array[i], 1e-12);
+    }
+    // Composition is equivalent to apply both transforms sequentially
+    const auto composed = SG::compose_affine(affine, affine);
+    const auto twice = SG::apply_affine(composed, input_array);
+    const auto sequential = SG::apply_affine(affine, physical);
+    for (size_t i = 0; i < 3; i++) {
+        EXPECT_NEAR(twice[i], sequential[i], 1e-12);
+    }
+    // Singular matrix
+    const SG::DirectionMatrixType singular = {{1, 0, 0, 1, 0, 0, 0, 0, 1}};
+    EXPECT_THROW(SG::invert_affine(SG::index_to_physical_space_affine(
+                         origin, spacing, singular)),
+                 std::runtime_error);
+}
+
+TEST_F(non_default_image, transform_graph_batch_multithreaded) {
+    // Big enough to be split between multiple threads
+    using GraphType = SG::GraphAL;
+    const size_t num_vertices = 2000;
+    GraphType g(num_vertices);
+    for (size_t i = 0; i < num_vertices; i++) {
+        g[i].pos = {{static_cast<double>(i % 10),
+                     static_cast<double>((i / 10) % 10),
+                     static_cast<double>(i / 100)}};
+    }
+    for (size_t i = 0; i + 1 < num_vertices; i++) {
+        SG::SpatialEdge se;
+        for (size_t k = 0; k < 10; k++) {
+            se.edge_points.push_back(
+                    {{static_cast<double>(k), static_cast<double>(i % 7),
+                      static_cast<double>(i % 3)}});
+        }
+        boost::add_edge(i, i + 1, se, g);
+    }
+    const GraphType g_original = g;
+    SG::transform_graph_to_physical_space<ImageType>(g, this->image, 4);
+    // Compare with the point by point ITK transform
+    for (size_t i = 0; i < num_vertices; i++) {
+        const auto expected = SG::index_array_to_physical_space_array(
+                g_original[i].pos, this->image.GetPointer());
+        for (size_t d = 0; d < 3; d++) {
+            EXPECT_DOUBLE_EQ(g[i].pos[d], expected[d]);
+        }
+    }
+    // Back to index space
+    SG::transform_graph_to_index_space<ImageType>(g, this->image, 4);
+    auto edges = boost::edges(g);
+    auto edges_original = boost::edges(g_original);
+    for (; edges.first != edges.second;
+         ++edges.first, ++edges_original.first) {
+        const auto &eps = g[*edges.first].edge_points;
+        const auto &eps_original =
+                g_original[*edges_original.first].edge_points;
+        ASSERT_EQ(eps.size(), eps_original.size());
+        for (size_t k = 0; k < eps.size(); k++) {
+            for (size_t d = 0; d < 3; d++) {
+                EXPECT_DOUBLE_EQ(eps[k][d], eps_original[k][d]);
+            }
+        }
+    }
+    for (size_t i = 0; i < num_vertices; i++) {
+        for (size_t d = 0; d < 3; d++) {
+            EXPECT_DOUBLE_EQ(g[i].pos[d], g_original[i].pos[d]);
+        }
+    }
+}
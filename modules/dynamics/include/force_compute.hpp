@@ -21,9 +21,12 @@
 #ifndef SG_FORCE_COMPUTE_HPP
 #define SG_FORCE_COMPUTE_HPP
 
+#include "neighbor_list.hpp"
 #include "system.hpp"
 #include <functional>
+#include <random>
 #include <set>
+#include <utility>
 
 namespace SG {
 struct ParticleForce {
@@ -46,9 +49,9 @@ struct ForceCompute {
     std::vector<ParticleForce> particle_forces;
 
     explicit ForceCompute(const System *sys) : m_sys(sys) {
-        particle_forces.reserve(sys->all.particles.size());
-        for (const auto &p : sys->all.particles) {
-            particle_forces.emplace_back(p.id, ArrayUtilities::Array3D());
+        particle_forces.reserve(sys->all.size());
+        for (const auto &id : sys->all.ids) {
+            particle_forces.emplace_back(id, ArrayUtilities::Array3D());
         }
     };
     virtual ~ForceCompute(){};
@@ -61,18 +64,45 @@ struct ForceCompute {
     }
     inline virtual std::string get_type() { return "ForceCompute"; };
 
+    /**
+     * Random engine of this force compute, random forces draw from it
+     * instead of the engine of the thread running compute().
+     * Seeded once with seed_engine, Integrator::compute_forces seeds it
+     * before the first compute.
+     */
+    std::mt19937 engine;
+    /**
+     * Seed engine with a std::seed_seq of numbers drawn from source.
+     */
+    void seed_engine(std::mt19937 &source);
+    inline bool engine_is_seeded() const { return m_engine_is_seeded; }
+
   protected:
     const System *m_sys;
+    bool m_engine_is_seeded = false;
 };
 
 struct ParticleForceCompute : public ForceCompute {
     using force_function_t =
             std::function<ArrayUtilities::Array3D(const Particle &)>;
+    /** Force on a copy of each particle. */
     force_function_t force_function;
+    using indexed_force_function_t = std::function<ArrayUtilities::Array3D(
+            const ParticleCollection &particles, const size_t &index)>;
+    /**
+     * Force on the particle at index in particles. It reads only the arrays
+     * it needs, instead of a copy of the whole Particle.
+     * Used instead of force_function when it is set.
+     */
+    indexed_force_function_t indexed_force_function;
 
     using ForceCompute::ForceCompute;
     ParticleForceCompute(const System *sys, force_function_t in_force_function)
             : ForceCompute(sys), force_function(in_force_function) {}
+    ParticleForceCompute(const System *sys,
+                         indexed_force_function_t in_indexed_force_function)
+            : ForceCompute(sys),
+              indexed_force_function(in_indexed_force_function) {}
 
     void compute() override;
     inline virtual std::string get_type() override {
@@ -80,12 +110,37 @@ struct ParticleForceCompute : public ForceCompute {
     };
 };
 
+/**
+ * Force on all the particles in one call, instead of one call per particle.
+ * force_function receives all the particles and sets the force of each
+ * particle in particle_forces, in the same order as the particles.
+ *
+ * Useful when the force function has a high cost per call, for example
+ * when it is defined in python.
+ */
+struct ParticleBatchForceCompute : public ForceCompute {
+    using force_function_t = std::function<void(
+            const ParticleCollection &, std::vector<ParticleForce> &)>;
+    force_function_t force_function;
+
+    using ForceCompute::ForceCompute;
+    ParticleBatchForceCompute(const System *sys,
+                              force_function_t in_force_function)
+            : ForceCompute(sys), force_function(in_force_function) {}
+
+    void compute() override;
+    inline virtual std::string get_type() override {
+        return "ParticleBatchForceCompute";
+    };
+};
+
 struct ParticleRandomForceCompute : public ParticleForceCompute {
     using ParticleForceCompute::ParticleForceCompute;
     /**
      * Initialize the force_function to a random
      * force that can be used in langevin and brownian
-     * dynamics.
+     * dynamics. The random orientations are drawn from engine,
+     * compute() seeds it from RNG::engine() if it is not seeded yet.
      *
      * The modulo of the force is:
      * |Force| = sqrt(2 * dimension * kT * gamma / deltaT)
@@ -102,6 +157,7 @@ struct ParticleRandomForceCompute : public ParticleForceCompute {
                                const double &deltaT,
                                const size_t &dimension = 3);
 
+    void compute() override;
     inline virtual std::string get_type() override {
         return "ParticleRandomForceCompute";
     };
@@ -146,8 +202,37 @@ struct BondForce {
 struct PairBondForce : public ForceCompute {
     using force_function_t = std::function<ArrayUtilities::Array3D(
             const Particle &, const Particle &, const Bond &)>;
+    /** Force F_{a,b} from copies of the particles of each bond. */
     force_function_t force_function;
+    using indexed_force_function_t =
+            std::function<ArrayUtilities::Array3D(const ParticleCollection &,
+                                                  const size_t &a_index,
+                                                  const size_t &b_index,
+                                                  const Bond &)>;
+    /**
+     * Force F_{a,b} from the indices of the particles a and b of the bond in
+     * particles. It reads only the arrays it needs, instead of copies of the
+     * whole particles.
+     * Used instead of force_function when it is set.
+     */
+    indexed_force_function_t indexed_force_function;
     std::vector<BondForce> bond_forces;
+    /**
+     * Indices (in the particles of the system) of the particles a and b of
+     * each bond of bond_forces.
+     * compute() resolves them only when they are not valid anymore, i.e
+     * when bond_forces or the particles have changed.
+     */
+    std::vector<size_t> particle_a_indices;
+    std::vector<size_t> particle_b_indices;
+    /**
+     * Number of threads evaluating force_function in compute(), and adding
+     * the bond forces to the particles.
+     * 0 uses all the hardware threads.
+     * force_function must be thread-safe when num_threads != 1.
+     * The result does not depend on num_threads.
+     */
+    size_t num_threads = 1;
 
     using ForceCompute::ForceCompute;
 
@@ -176,6 +261,11 @@ struct PairBondForce : public ForceCompute {
             : PairBondForce(sys) {
         force_function = in_force_function;
     }
+    PairBondForce(const System *sys,
+                  indexed_force_function_t in_indexed_force_function)
+            : PairBondForce(sys) {
+        indexed_force_function = in_indexed_force_function;
+    }
 
     PairBondForce(const System *sys,
         force_function_t in_force_function,
@@ -185,6 +275,17 @@ struct PairBondForce : public ForceCompute {
     }
 
     void compute() override;
+    /**
+     * Resolve particle_a_indices and particle_b_indices from the ids of the
+     * bonds, and the bonds of each particle.
+     * Throws if a particle of a bond is not in the system.
+     */
+    void update_bond_particle_indices();
+    /**
+     * True if the indices have one entry per bond in bond_forces, and they
+     * point to the particles with the ids of the bond.
+     */
+    bool bond_particle_indices_are_valid() const;
     inline void reset_bond_forces_to_zero() {
         for (auto &bf : bond_forces) {
             std::fill(bf.force.begin(), bf.force.end(), 0);
@@ -194,6 +295,107 @@ struct PairBondForce : public ForceCompute {
     inline virtual std::string get_type() override {
         return "PairBondForce";
     };
+
+  protected:
+    /**
+     * Apply half of bond_force (F_{a,b}) to particle a, and the other half
+     * with opposite sign to particle b.
+     */
+    void add_bond_force_to_particles(const ArrayUtilities::Array3D &bond_force,
+                                     const size_t &particle_a_index,
+                                     const size_t &particle_b_index);
+    /**
+     * Add all the bond_forces to the particles, as
+     * add_bond_force_to_particles. Each particle sums the forces of its
+     * bonds in bond order, in parallel over the particles.
+     */
+    void add_bond_forces_to_particles();
+    /** Fill m_particle_bond_offsets and m_particle_bonds from the indices. */
+    void update_particle_bonds();
+    /**
+     * Bonds of each particle, in bond order.
+     * The bonds of particle p are
+     * m_particle_bonds[m_particle_bond_offsets[p], m_particle_bond_offsets[p+1]),
+     * stored as 2 * bond_index if p is the particle a of the bond, and
+     * 2 * bond_index + 1 if it is the particle b.
+     */
+    std::vector<size_t> m_particle_bond_offsets;
+    std::vector<size_t> m_particle_bonds;
+};
+
+/**
+ * PairBondForce applying the worm-like chain force of
+ * force_function_wlc_petrosyan, without calling a force_function per bond.
+ *
+ * The bonds are compiled to compiled_bonds, with the indices of their
+ * particles and their parameters: BondChain::length_contour, and
+ * persistence_length and kT from BondPropertiesPhysical.
+ * They are compiled again when the particle indices are not valid anymore.
+ * Call compile_bonds after modifying the parameters of the bonds.
+ */
+struct PairBondForceWLCPetrosyan : public PairBondForce {
+    struct CompiledBond {
+        size_t a_index;
+        size_t b_index;
+        double length_contour;
+        double persistence_length;
+        double kT;
+    };
+    std::vector<CompiledBond> compiled_bonds;
+
+    PairBondForceWLCPetrosyan(const System *sys) : PairBondForce(sys) {}
+    PairBondForceWLCPetrosyan(
+            const System *sys,
+            const BondProperties::tags_t &in_only_apply_to_bond_with_tags)
+            : PairBondForce(sys, in_only_apply_to_bond_with_tags) {}
+
+    void compute() override;
+    /**
+     * Resolve the particle indices and the parameters of each bond.
+     * Throws if a bond is not a BondChain with BondPropertiesPhysical.
+     */
+    void compile_bonds();
+    inline virtual std::string get_type() override {
+        return "PairBondForceWLCPetrosyan";
+    };
+};
+
+/**
+ * PairBondForce computing the force of all the bonds in one call.
+ *
+ * batch_force_function receives all the particles, and the indices (in
+ * particles) of the particles a and b of each bond of bond_forces. It sets
+ * the force F_{a,b} of each bond in bond_forces, the forces are then applied
+ * to the particles as in PairBondForce.
+ */
+struct PairBondBatchForce : public PairBondForce {
+    using batch_force_function_t =
+            std::function<void(const ParticleCollection &,
+                               const std::vector<size_t> &particle_a_indices,
+                               const std::vector<size_t> &particle_b_indices,
+                               std::vector<BondForce> &)>;
+    batch_force_function_t batch_force_function;
+
+    PairBondBatchForce(const System *sys) : PairBondForce(sys) {}
+    PairBondBatchForce(
+            const System *sys,
+            const BondProperties::tags_t &in_only_apply_to_bond_with_tags)
+            : PairBondForce(sys, in_only_apply_to_bond_with_tags) {}
+    PairBondBatchForce(const System *sys,
+                       batch_force_function_t in_batch_force_function)
+            : PairBondForce(sys),
+              batch_force_function(in_batch_force_function) {}
+    PairBondBatchForce(
+            const System *sys,
+            batch_force_function_t in_batch_force_function,
+            const BondProperties::tags_t &in_only_apply_to_bond_with_tags)
+            : PairBondForce(sys, in_only_apply_to_bond_with_tags),
+              batch_force_function(in_batch_force_function) {}
+
+    void compute() override;
+    inline virtual std::string get_type() override {
+        return "PairBondBatchForce";
+    };
 };
 
 struct FixedPairBondForce : public PairBondForce {
@@ -208,6 +410,43 @@ struct FixedPairBondForce : public PairBondForce {
     };
 };
 
+/**
+ * Excluded volume between particles, using a repulsive soft sphere force
+ * (force_soft_sphere) between all the particles closer than the sum of their
+ * radii (ParticleMaterial::radius).
+ *
+ * The pairs are found with neighbor_list, its cutoff is raised to twice
+ * the largest radius if needed. Set neighbor_list.boundary_condition and
+ * box_size for periodic systems, and neighbor_list.skin to trade list size
+ * for the frequency of rebuilds.
+ */
+struct ExcludedVolumeForce : public ForceCompute {
+    /** Energy of the soft sphere potential at full overlap. */
+    double stiffness = 1.0;
+    /**
+     * Ignore pairs of particles joined by a bond of the system.
+     * Bonds are read when the neighbor list is rebuilt.
+     */
+    bool exclude_bonded = true;
+    NeighborList neighbor_list;
+
+    using ForceCompute::ForceCompute;
+    ExcludedVolumeForce(const System *sys, const double &in_stiffness)
+            : ForceCompute(sys), stiffness(in_stiffness) {}
+
+    void compute() override;
+    inline virtual std::string get_type() override {
+        return "ExcludedVolumeForce";
+    };
+
+  protected:
+    /** Sorted pairs of particle indices (a < b) joined by a bond. */
+    std::vector<std::pair<size_t, size_t>> m_bonded_pairs;
+    /** neighbor_list.number_of_builds when m_bonded_pairs was updated. */
+    size_t m_bonded_pairs_build = 0;
+    void update_bonded_pairs();
+};
+
 
 } // namespace SG
 #endif
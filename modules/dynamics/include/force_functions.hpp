@@ -22,6 +22,7 @@
 #define SG_FORCE_FUNCTIONS_HPP
 
 #include <functional>
+#include <limits>
 
 #include "array_utilities.hpp"
 #include "bond.hpp"
@@ -54,5 +55,46 @@ using force_function_particles_with_bond_t =
  */
 ArrayUtilities::Array3D force_function_wlc_petrosyan(
         const SG::Particle &a, const SG::Particle &b, const SG::Bond &chain);
+
+/**
+ * Force of force_function_wlc_petrosyan from the positions of the particles
+ * and the parameters of the bond.
+ *
+ * @param pos_a position of the first particle
+ * @param pos_b position of the second particle
+ * @param length_contour contour length of the chain
+ * @param persistence_length
+ * @param kT
+ *
+ * @return F_{a,b}
+ */
+inline ArrayUtilities::Array3D
+force_wlc_petrosyan(const ArrayUtilities::Array3D &pos_a,
+                    const ArrayUtilities::Array3D &pos_b,
+                    const double &length_contour,
+                    const double &persistence_length,
+                    const double &kT) {
+    const auto d_ete_vector = ArrayUtilities::minus(pos_b, pos_a); // F_{a, b}
+    const auto d_ete_modulo = ArrayUtilities::norm(d_ete_vector);
+    // handle chains with same start/end particles (zero force)
+    if (d_ete_modulo <= 2.0 * std::numeric_limits<double>::epsilon()) {
+        return ArrayUtilities::Array3D();
+    }
+    double relative_extension = d_ete_modulo / length_contour;
+    // TODO handle relative_extension ~ 1 (wlc_petrosyan_normalized
+    // would diverge)
+    // TODO: THis is a hack, if relative extension is close to one return zero.
+    // Most of the close-to-one relative extension comes from really short
+    // edges.
+    if (relative_extension > 0.98) {
+        relative_extension = 0.98;
+    }
+    const auto force_modulo = SG::force_extension_wlc_petrosyan(
+            relative_extension, persistence_length, kT);
+    // d_ete_vector/d_ete_modulo is the unitary vector, in the direction
+    // F_{a,b}
+    return ArrayUtilities::product_scalar(d_ete_vector,
+                                          force_modulo / d_ete_modulo);
+}
 } // end namespace SG
 #endif
@@ -21,6 +21,7 @@
 #ifndef SG_INTEGRATOR_HPP
 #define SG_INTEGRATOR_HPP
 
+#include <iostream>
 #include <memory>
 #include <vector>
 
@@ -28,6 +29,24 @@
 #include "system.hpp"
 namespace SG {
 
+/**
+ * Sum of the forces acting on the particle with index part_index.
+ * The particle_forces of each force type are indexed as the particles of
+ * the system.
+ */
+inline ArrayUtilities::Array3D sum_particle_forces(
+        const std::vector<std::shared_ptr<ForceCompute>> &force_types,
+        const size_t &part_index) {
+    ArrayUtilities::Array3D net_force = {0.0, 0.0, 0.0};
+    for (const auto &force_type : force_types) {
+        const auto &force = force_type->particle_forces[part_index].force;
+        net_force[0] += force[0];
+        net_force[1] += force[1];
+        net_force[2] += force[2];
+    }
+    return net_force;
+}
+
 // TODO Add a particle_selector (with lambda), here or on Integrator.
 // Integrator has IntegratorMethods
 struct IntegratorMethod {
@@ -36,6 +55,11 @@ struct IntegratorMethod {
             : deltaT(deltaT_input), m_sys(sys){};
     virtual ~IntegratorMethod(){};
     double deltaT;
+    /**
+     * Threads used to integrate the particles, split in ranges of particles.
+     * 0 uses all the hardware threads.
+     */
+    size_t num_threads = 1;
     virtual void integrate() = 0;
 
   protected:
@@ -54,6 +78,14 @@ struct TwoStepIntegratorMethod : public IntegratorMethod {
      *
      */
     virtual void integrateStepTwo() = 0;
+    /**
+     * Sum the forces of force_types into the net force of each particle,
+     * and then integrateStepTwo.
+     * The default implementation makes a pass over the particles for each
+     * of the two operations, override it to fuse them in a single pass.
+     */
+    virtual void integrateStepTwo(
+            const std::vector<std::shared_ptr<ForceCompute>> &force_types);
 };
 
 struct VerletVelocitiesIntegratorMethod : public TwoStepIntegratorMethod {
@@ -74,6 +106,12 @@ struct VerletVelocitiesIntegratorMethod : public TwoStepIntegratorMethod {
      *
      */
     void integrateStepTwo() override;
+    /**
+     * Sum the net force of each particle and integrateStepTwo in the same
+     * loop, every particle is visited only once.
+     */
+    void integrateStepTwo(const std::vector<std::shared_ptr<ForceCompute>>
+                                  &force_types) override;
 };
 
 // 1. Collect, and sum all the forces affecting every particle.
@@ -84,8 +122,19 @@ class Integrator {
     explicit Integrator(System *sys) : m_sys(sys), all_old_state(sys->all){};
     virtual ~Integrator(){};
     virtual void update(unsigned int time_step) = 0;
-    /// Compute the sum of forces for each particle and store it in Particle
+    /// Compute the sum of forces for each particle and store it in net_forces
     virtual void compute_net_forces(System *sys) const;
+    /**
+     * Compute all the force_types.
+     * With num_threads > 1, different force computes run concurrently,
+     * each of them writes only its own particle_forces.
+     * The engine of each force compute is seeded from RNG::engine() before
+     * its first compute, and random forces draw only from it afterwards.
+     * Random forces give the same result for any num_threads.
+     */
+    void compute_forces();
+    /// Print the forces of each force type, and the net force of each particle
+    void print_forces(std::ostream &os) const;
 
     /**
      * add force to the integrator
@@ -113,6 +162,14 @@ class Integrator {
      * allowing to create an instance of ForceCompute
      */
     std::vector<std::shared_ptr<ForceCompute>> force_types;
+    /**
+     * Threads used to compute the force types concurrently, and to sum the
+     * net forces. 0 uses all the hardware threads.
+     * The threads of the integrator_method are set independently.
+     */
+    size_t num_threads = 1;
+    /// Print all the forces after each update
+    bool verbose = false;
 
   protected:
     System *m_sys;
@@ -123,7 +180,18 @@ struct IntegratorTwoStep : public Integrator {
     using Integrator::Integrator;
     // TODO only one method? Add more methods when/if added particle selector
     std::shared_ptr<TwoStepIntegratorMethod> integrator_method;
+    /**
+     * integrateStepOne, compute_forces, and integrateStepTwo.
+     * The net forces are summed in the same pass as integrateStepTwo if
+     * fuse_net_forces, otherwise compute_net_forces is called first.
+     */
     void update(unsigned int time_step) override;
+    /**
+     * If true, update sums the net forces inside
+     * integrateStepTwo(force_types), and compute_net_forces is not called.
+     * Derived classes that override compute_net_forces must return false.
+     */
+    virtual bool fuse_net_forces() const { return true; }
 };
 
 } // namespace SG
@@ -0,0 +1,98 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+#ifndef SG_NEIGHBOR_LIST_HPP
+#define SG_NEIGHBOR_LIST_HPP
+
+#include "boundary_conditions.hpp" // from core module
+#include "particle_collection.hpp"
+#include "particle_neighbors.hpp"
+
+#include <vector>
+
+namespace SG {
+/**
+ * Verlet list of the pairs of particles closer than cutoff + skin, built
+ * binning the particles in cells of at least that size, so only the 27
+ * cells around each particle are visited.
+ *
+ * The list is valid while no particle has moved more than skin / 2 since
+ * the last build, update() only rebuilds it when that happens, or when the
+ * number of particles, the cutoff or the skin changes.
+ *
+ * Only the pairs (i, j) with i < j are stored, where i, j are indices in
+ * the particles of the ParticleCollection.
+ */
+struct NeighborList {
+    NeighborList() = default;
+    NeighborList(const double &input_cutoff, const double &input_skin)
+            : cutoff(input_cutoff), skin(input_skin) {}
+
+    /** Interaction distance. */
+    double cutoff = 1.0;
+    /** Extra distance in the list, to avoid rebuilding it every step. */
+    double skin = 0.3;
+    ArrayUtilities::boundary_condition boundary_condition =
+            ArrayUtilities::boundary_condition::NONE;
+    /** Periodic box [0, box_size), only used with PERIODIC. */
+    ArrayUtilities::Array3D box_size = ArrayUtilities::ones3d;
+
+    /** The neighbors of particle i are
+     * neighbors[neighbor_offsets[i], neighbor_offsets[i + 1]). */
+    std::vector<size_t> neighbor_offsets;
+    std::vector<size_t> neighbors;
+    /** Number of times the list has been built. */
+    size_t number_of_builds = 0;
+
+    /**
+     * Build the list if needs_rebuild.
+     *
+     * @return true if the list was built
+     */
+    bool update(const ParticleCollection &collection);
+    /** Build the list from the current positions. */
+    void build(const ParticleCollection &collection);
+    /** True if the list might be missing pairs closer than cutoff. */
+    bool needs_rebuild(const ParticleCollection &collection) const;
+    /** Difference a - b, with the minimum image convention if PERIODIC. */
+    ArrayUtilities::Array3D minus(const ArrayUtilities::Array3D &a,
+                                  const ArrayUtilities::Array3D &b) const;
+
+  protected:
+    std::vector<ArrayUtilities::Array3D> m_positions_at_build;
+    double m_cutoff_at_build = 0.0;
+    double m_skin_at_build = 0.0;
+    ArrayUtilities::boundary_condition m_boundary_condition_at_build =
+            ArrayUtilities::boundary_condition::NONE;
+    ArrayUtilities::Array3D m_box_size_at_build = ArrayUtilities::ones3d;
+};
+
+/**
+ * Neighbors per particle from a neighbor list, in both directions and using
+ * particle ids, as in System::collision_neighbor_list.
+ * Includes all the pairs of the list, closer than cutoff + skin at the time
+ * it was built.
+ */
+ParticleNeighborsCollection
+make_particle_neighbors(const NeighborList &neighbor_list,
+                        const ParticleCollection &collection);
+
+} // namespace SG
+#endif
@@ -22,60 +22,57 @@
 #define SG_PARTICLE_COLLECTION_HPP
 
 #include "particle.hpp"
-#include <algorithm>
-#include <cassert>
 #include <vector>
 
 namespace SG {
 /**
- * Simplest ParticleCollection.
- * No multi-threaded, no GPU.
- * For optimizations, have a look at HOOMD ParticleData and friends.
- * That includes spatial optimizations (trees) and multi-threading,
- * including GPU acceleration.
- * NOTE(phcerdan): Too early to optimize, but it would be possible to copy
- * from HOOMD if needed.
- * The main drawback (but I might be wrong) is that HOOMD's ParticleData
- * seems to have a fixed num of particles, at least in MD.
+ * Particles stored as a struct of arrays: the particle with index i is the
+ * element i of each array. The loops of the integrators and the forces read
+ * only the arrays they need, instead of every member of every particle.
+ *
+ * Particle is used to add, get or set all the data of a particle at once.
+ * The arrays can be modified directly, but all of them must keep the same
+ * size, use push_back, resize or set_particles to change the number of
+ * particles.
  */
 struct ParticleCollection {
-    std::vector<Particle> particles;
+    std::vector<size_t> ids;
+    std::vector<ArrayUtilities::Array3D> positions;
+    std::vector<ArrayUtilities::Array3D> velocities;
+    std::vector<ArrayUtilities::Array3D> accelerations;
+    std::vector<ArrayUtilities::Array3D> net_forces;
+    std::vector<ParticleMaterial> materials;
     bool sorted = false;
-    void sort();
 
-    template <typename ForwardIt>
-    inline ForwardIt binary_find(const ForwardIt &first,
-                                 const ForwardIt &last,
-                                 const size_t &id_value) const {
-        if (!sorted) {
-            throw std::runtime_error(
-                    "Particles not sorted in ParticleCollection before a find. "
-                    "Call sort() first.");
-        }
-        constexpr auto comp = [](const Particle &p, const size_t &value) {
-            return p.id < value;
-        };
-        const auto lower_bound_search_it =
-                std::lower_bound(first, last, id_value, comp);
+    ParticleCollection() = default;
+    explicit ParticleCollection(const std::vector<Particle> &particles);
 
-        if (lower_bound_search_it == last ||
-            id_value < (*lower_bound_search_it).id) {
-            return last;
-        }
-        return lower_bound_search_it;
-    }
-    std::vector<Particle>::iterator binary_find(const size_t &id_value);
+    inline size_t size() const { return ids.size(); }
+    inline bool empty() const { return ids.empty(); }
+    void reserve(const size_t &num_particles);
+    /** New particles are value initialized (zero id, position...). */
+    void resize(const size_t &num_particles);
+    void clear();
+    void push_back(const Particle &particle);
 
-    std::vector<Particle>::const_iterator
-    binary_find(const size_t &id_value) const;
-
-    std::pair<std::vector<Particle>::const_iterator, size_t>
-    find_particle_and_index(const size_t &id_value) const;
-    std::pair<std::vector<Particle>::iterator, size_t>
-    find_particle_and_index(const size_t &id_value);
+    /** Copy of the data of the particle with index. */
+    Particle get_particle(const size_t &index) const;
+    void set_particle(const size_t &index, const Particle &particle);
+    /** Copy of all the particles, in order. */
+    std::vector<Particle> get_particles() const;
+    /** Replace all the particles. */
+    void set_particles(const std::vector<Particle> &particles);
 
+    /** Sort all the arrays by id. sorted is only modified here. */
+    void sort();
+    /**
+     * Index of the particle with id_value, using a binary search.
+     * Throws if the collection is not sorted.
+     *
+     * @return index of the particle, or std::numeric_limits<size_t>::max()
+     * if not found.
+     */
     size_t find_index(const size_t &id_value) const;
-    friend void print(const ParticleCollection &collection);
 };
 
 void print_end_collection(const ParticleCollection &collection,
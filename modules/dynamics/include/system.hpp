@@ -26,6 +26,7 @@
 #include "bond_collection.hpp"
 #include "particle_collection.hpp"
 #include "particle_neighbors.hpp"
+#include "thread_pool.hpp"
 
 namespace SG {
 /**
@@ -33,11 +34,14 @@ namespace SG {
  * Classes might need a pointer to it in the constructor.
  */
 struct System : public std::enable_shared_from_this<System> {
-    ParticleCollection all; ///< all particles
+    ParticleCollection all; ///< all particles, as a struct of arrays
     BondCollection bonds; ///< fixed bonds between particles
     ParticleNeighborsCollection conexions;
     /** Dynamic neighbors per particle based on positions. */
     ParticleNeighborsCollection collision_neighbor_list;
+    /** Threads of the integrator and the force computes.
+     * Copies of the system share the pool. */
+    std::shared_ptr<ThreadPool> thread_pool = std::make_shared<ThreadPool>();
     // Helpers to get references of data.
     ArrayUtilities::Array3D &get_position(size_t index);
     const ArrayUtilities::Array3D &get_position(size_t index) const;
@@ -45,12 +49,14 @@ struct System : public std::enable_shared_from_this<System> {
     const ArrayUtilities::Array3D &get_velocity(size_t index) const;
     ArrayUtilities::Array3D &get_acceleration(size_t index);
     const ArrayUtilities::Array3D &get_acceleration(size_t index) const;
+    ArrayUtilities::Array3D &get_net_force(size_t index);
+    const ArrayUtilities::Array3D &get_net_force(size_t index) const;
     /// Return copy of positions
-    auto all_positions_copy();
+    std::vector<ArrayUtilities::Array3D> all_positions_copy() const;
     /// Return copy of velocities
-    auto all_velocities_copy();
+    std::vector<ArrayUtilities::Array3D> all_velocities_copy() const;
     /// Return copy of accelerations
-    auto all_accelerations_copy();
+    std::vector<ArrayUtilities::Array3D> all_accelerations_copy() const;
 };
 
 /**
@@ -0,0 +1,93 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+#ifndef SG_THREAD_POOL_HPP
+#define SG_THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace SG {
+/**
+ * Number of threads to use for num_threads, 0 meaning all the hardware
+ * threads.
+ */
+size_t resolve_num_threads(const size_t &num_threads);
+
+/**
+ * Worker threads that live as long as the pool, running the chunks of
+ * parallel_for_chunks. Workers are started the first time they are needed,
+ * and wait for work between calls.
+ *
+ * The calling thread runs chunks too, and only waits for the chunks that
+ * workers already started. parallel_for_chunks can be called from a
+ * function running in the pool (nested), or from different threads at the
+ * same time.
+ */
+class ThreadPool {
+  public:
+    ThreadPool() = default;
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+    /** Stop and join the workers. */
+    ~ThreadPool();
+
+    using chunk_function_t = std::function<void(size_t, size_t)>;
+    /**
+     * Call function(begin, end) over contiguous chunks of [0, size) using
+     * num_threads threads, the calling thread included.
+     * num_threads == 0 uses all the hardware threads.
+     * With one thread, function(0, size) is called in the calling thread.
+     * Exceptions thrown by function are rethrown after all the started
+     * chunks finish.
+     *
+     * @param size number of items
+     * @param num_threads maximum number of threads
+     * @param function callable with signature void(size_t begin, size_t end)
+     * @param min_chunk_size do not use a thread for less items than this
+     */
+    void parallel_for_chunks(const size_t &size,
+                             const size_t &num_threads,
+                             const chunk_function_t &function,
+                             const size_t &min_chunk_size = 1);
+
+    /** Number of started workers. */
+    size_t num_workers() const;
+
+  private:
+    struct Job;
+    void start_workers(const size_t &num_workers);
+    void worker_loop();
+    static void run_chunks(Job &job);
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_job_available;
+    /** Jobs that accept more workers. */
+    std::deque<std::shared_ptr<Job>> m_jobs;
+    std::vector<std::thread> m_workers;
+    bool m_stop = false;
+};
+} // namespace SG
+#endif
@@ -60,6 +60,31 @@ force_linear_drag(double sphere_radius,
                              velocity);
 }
 
+/**
+ * Repulsive soft sphere force between two spheres at distance r, with the
+ * potential:
+ * \f[ U = \epsilon (1 - r / \sigma)^2, \quad r < \sigma \f]
+ * and zero beyond sigma, where sigma is the sum of the radii of the spheres.
+ *
+ * @param stiffness epsilon of the potential, energy at full overlap
+ * @param sigma distance where the spheres touch (sum of radii)
+ * @param a_minus_b vector from sphere b to sphere a
+ * @param distance norm of a_minus_b
+ *
+ * @return force on sphere a (the force on b is the opposite)
+ */
+inline ArrayUtilities::Array3D
+force_soft_sphere(double stiffness,
+                  double sigma,
+                  const ArrayUtilities::Array3D &a_minus_b,
+                  double distance) {
+    if (distance >= sigma || distance <= 0.0) {
+        return ArrayUtilities::Array3D{0.0, 0.0, 0.0};
+    }
+    const double modulo = 2.0 * stiffness / sigma * (1.0 - distance / sigma);
+    return ArrayUtilities::product_scalar(a_minus_b, modulo / distance);
+}
+
 // TODO: Add Newtonian fluid: shear_stress = shear_viscosity * du/dy
 // where du/dy is the derivative of the velocity component that is parallel
 // to the direction of shear, relative to displacement in the perpendicular
@@ -26,7 +26,7 @@ namespace SG {
 ParticleGraphGlueData particles_from_graph(const GraphType &graph) {
     ParticleGraphGlueData glue_data;
     const auto num_vertices = boost::num_vertices(graph);
-    auto &particles = glue_data.particle_collection.particles;
+    auto &particles = glue_data.particle_collection;
     auto &particle_graph_map = glue_data.particle_graph_map;
     auto &graph_particle_map = glue_data.graph_particle_map;
     auto &connected_list = glue_data.connected_list;
@@ -40,7 +40,7 @@ ParticleGraphGlueData particles_from_graph(const GraphType &graph) {
         const Particle particle = {particle_id, graph[*ui].pos,
                                    ParticleDynamicProperties(),
                                    ParticleMaterial()};
-        particles.emplace_back(particle);
+        particles.push_back(particle);
         particle_graph_map->operator[](particle_id) = *ui;
         graph_particle_map->operator[](*ui) = particle_id;
         const auto degree = boost::out_degree(*ui, graph);
@@ -19,42 +19,235 @@
  * *******************************************************************/
 
 #include "force_compute.hpp"
+#include "force_functions.hpp"
 #include "particle_collection.hpp"
 #include "rng.hpp" // from core module
+#include "unbonded_forces.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
 
 namespace SG {
+
+namespace {
+/** Particles per thread under which launching a thread is not worth it. */
+constexpr size_t min_particles_per_thread = 4096;
+} // namespace
+
+void ForceCompute::seed_engine(std::mt19937 &source) {
+    std::array<std::mt19937::result_type, std::mt19937::state_size> seeds;
+    for (auto &seed : seeds) {
+        seed = source();
+    }
+    std::seed_seq seq(seeds.begin(), seeds.end());
+    engine.seed(seq);
+    m_engine_is_seeded = true;
+}
+
 void PairBondForce::compute() {
-    if (!force_function) {
+    if (!force_function && !indexed_force_function) {
         throw std::runtime_error("force_function is not set in PairBondForce");
     }
 
     reset_forces_to_zero();
-    reset_bond_forces_to_zero();
+    if (!bond_particle_indices_are_valid()) {
+        update_bond_particle_indices();
+    }
 
     // Compute and store forces per bond
-    for (auto &bond_force : bond_forces) {
-        const auto [p_a, p_a_index] =
-                m_sys->all.find_particle_and_index(bond_force.bond->id_a);
-        const auto [p_b, p_b_index] =
-                m_sys->all.find_particle_and_index(bond_force.bond->id_b);
-        // Assign to bond_force
-        // Bond force is equal to F_{a,b}
-        bond_force.force = force_function(*p_a, *p_b, *bond_force.bond);
-        // Translating a bond force using as a reference the force
-        // from particle a to b, (i.e. F_{a,b}) to each particle.
-        // We divide the bond force by half, and apply each half to each
-        // particle, changing the sign. (the particles are always at the two
-        // ends of the bond).
-        const auto half_bond_force =
-                ArrayUtilities::product_scalar(bond_force.force, 0.5);
-        // Assign to the per particle forces
-        auto &force_on_a = particle_forces[p_a_index].force;
-        auto &force_on_b = particle_forces[p_b_index].force;
-        // F_{a,b}
-        force_on_a = ArrayUtilities::plus(force_on_a, half_bond_force);
-        // change sign of bond_force for the F_{b,a}
-        force_on_b = ArrayUtilities::minus(force_on_b, half_bond_force);
+    // Bond force is equal to F_{a,b}
+    const auto &particles = m_sys->all;
+    m_sys->thread_pool->parallel_for_chunks(
+            bond_forces.size(), num_threads,
+            [&](const size_t &begin, const size_t &end) {
+                if (indexed_force_function) {
+                    for (size_t i = begin; i < end; ++i) {
+                        auto &bond_force = bond_forces[i];
+                        bond_force.force = indexed_force_function(
+                                particles, particle_a_indices[i],
+                                particle_b_indices[i], *bond_force.bond);
+                    }
+                    return;
+                }
+                for (size_t i = begin; i < end; ++i) {
+                    auto &bond_force = bond_forces[i];
+                    bond_force.force = force_function(
+                            particles.get_particle(particle_a_indices[i]),
+                            particles.get_particle(particle_b_indices[i]),
+                            *bond_force.bond);
+                }
+            });
+    add_bond_forces_to_particles();
+}
+
+void PairBondForce::update_bond_particle_indices() {
+    const size_t num_bonds = bond_forces.size();
+    particle_a_indices.resize(num_bonds);
+    particle_b_indices.resize(num_bonds);
+    for (size_t i = 0; i < num_bonds; ++i) {
+        const auto &bond = *bond_forces[i].bond;
+        particle_a_indices[i] = m_sys->all.find_index(bond.id_a);
+        particle_b_indices[i] = m_sys->all.find_index(bond.id_b);
+        if (particle_a_indices[i] == std::numeric_limits<size_t>::max() ||
+            particle_b_indices[i] == std::numeric_limits<size_t>::max()) {
+            throw std::runtime_error(get_type() +
+                                     ": the particles of a bond are not in "
+                                     "the system");
+        }
+    }
+    update_particle_bonds();
+}
+
+void PairBondForce::update_particle_bonds() {
+    const size_t num_bonds = bond_forces.size();
+    const size_t nparts = particle_forces.size();
+    m_particle_bond_offsets.assign(nparts + 1, 0);
+    for (size_t i = 0; i < num_bonds; ++i) {
+        ++m_particle_bond_offsets[particle_a_indices[i] + 1];
+        ++m_particle_bond_offsets[particle_b_indices[i] + 1];
+    }
+    for (size_t p = 0; p < nparts; ++p) {
+        m_particle_bond_offsets[p + 1] += m_particle_bond_offsets[p];
+    }
+    m_particle_bonds.resize(2 * num_bonds);
+    auto next = m_particle_bond_offsets;
+    for (size_t i = 0; i < num_bonds; ++i) {
+        m_particle_bonds[next[particle_a_indices[i]]++] = 2 * i;
+        m_particle_bonds[next[particle_b_indices[i]]++] = 2 * i + 1;
+    }
+}
+
+void PairBondForce::add_bond_forces_to_particles() {
+    if (m_particle_bond_offsets.size() != particle_forces.size() + 1 ||
+        m_particle_bonds.size() != 2 * bond_forces.size()) {
+        update_particle_bonds();
+    }
+    // Same operations, in the same order, as add_bond_force_to_particles
+    // for each bond.
+    m_sys->thread_pool->parallel_for_chunks(
+            particle_forces.size(), num_threads,
+            [&](const size_t &begin, const size_t &end) {
+                for (size_t p = begin; p < end; ++p) {
+                    auto force = particle_forces[p].force;
+                    for (size_t k = m_particle_bond_offsets[p];
+                         k < m_particle_bond_offsets[p + 1]; ++k) {
+                        const size_t entry = m_particle_bonds[k];
+                        const auto half_bond_force =
+                                ArrayUtilities::product_scalar(
+                                        bond_forces[entry / 2].force, 0.5);
+                        force = (entry % 2 == 0)
+                                        ? ArrayUtilities::plus(force,
+                                                               half_bond_force)
+                                        : ArrayUtilities::minus(
+                                                  force, half_bond_force);
+                    }
+                    particle_forces[p].force = force;
+                }
+            },
+            min_particles_per_thread);
+}
+
+void PairBondForceWLCPetrosyan::compile_bonds() {
+    update_bond_particle_indices();
+    const size_t num_bonds = bond_forces.size();
+    compiled_bonds.resize(num_bonds);
+    for (size_t i = 0; i < num_bonds; ++i) {
+        const auto *chain = dynamic_cast<const BondChain *>(bond_forces[i].bond);
+        const auto properties =
+                chain ? std::dynamic_pointer_cast<BondPropertiesPhysical>(
+                                chain->properties)
+                      : nullptr;
+        if (!properties) {
+            throw std::runtime_error(
+                    get_type() +
+                    ": the bonds need to be BondChain, with properties of "
+                    "type BondPropertiesPhysical with persistence_length and "
+                    "kT populated");
+        }
+        compiled_bonds[i] = {particle_a_indices[i], particle_b_indices[i],
+                             chain->length_contour,
+                             properties->persistence_length, properties->kT};
+    }
+}
+
+void PairBondForceWLCPetrosyan::compute() {
+    reset_forces_to_zero();
+    if (compiled_bonds.size() != bond_forces.size() ||
+        !bond_particle_indices_are_valid()) {
+        compile_bonds();
+    }
+    const auto &positions = m_sys->all.positions;
+    m_sys->thread_pool->parallel_for_chunks(
+            compiled_bonds.size(), num_threads,
+            [&](const size_t &begin, const size_t &end) {
+                for (size_t i = begin; i < end; ++i) {
+                    const auto &bond = compiled_bonds[i];
+                    bond_forces[i].force = force_wlc_petrosyan(
+                            positions[bond.a_index], positions[bond.b_index],
+                            bond.length_contour, bond.persistence_length,
+                            bond.kT);
+                }
+            });
+    add_bond_forces_to_particles();
+}
+
+bool PairBondForce::bond_particle_indices_are_valid() const {
+    const size_t num_bonds = bond_forces.size();
+    if (particle_a_indices.size() != num_bonds ||
+        particle_b_indices.size() != num_bonds) {
+        return false;
+    }
+    const auto &ids = m_sys->all.ids;
+    const size_t nparts = ids.size();
+    for (size_t i = 0; i < num_bonds; ++i) {
+        const auto &bond = *bond_forces[i].bond;
+        const auto a = particle_a_indices[i];
+        const auto b = particle_b_indices[i];
+        if (a >= nparts || b >= nparts || ids[a] != bond.id_a ||
+            ids[b] != bond.id_b) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void PairBondForce::add_bond_force_to_particles(
+        const ArrayUtilities::Array3D &bond_force,
+        const size_t &particle_a_index,
+        const size_t &particle_b_index) {
+    // Translating a bond force using as a reference the force
+    // from particle a to b, (i.e. F_{a,b}) to each particle.
+    // We divide the bond force by half, and apply each half to each
+    // particle, changing the sign. (the particles are always at the two
+    // ends of the bond).
+    const auto half_bond_force =
+            ArrayUtilities::product_scalar(bond_force, 0.5);
+    // Assign to the per particle forces
+    auto &force_on_a = particle_forces[particle_a_index].force;
+    auto &force_on_b = particle_forces[particle_b_index].force;
+    // F_{a,b}
+    force_on_a = ArrayUtilities::plus(force_on_a, half_bond_force);
+    // change sign of bond_force for the F_{b,a}
+    force_on_b = ArrayUtilities::minus(force_on_b, half_bond_force);
+}
+
+void PairBondBatchForce::compute() {
+    if (!batch_force_function) {
+        throw std::runtime_error(
+                "batch_force_function is not set in PairBondBatchForce");
+    }
+
+    reset_forces_to_zero();
+    reset_bond_forces_to_zero();
+
+    if (!bond_particle_indices_are_valid()) {
+        update_bond_particle_indices();
     }
+    batch_force_function(m_sys->all, particle_a_indices, particle_b_indices,
+                         bond_forces);
+    add_bond_forces_to_particles();
 }
 
 void PairBondForce::only_apply_to_bonds_with_tags(
@@ -94,27 +287,108 @@ void FixedPairBondForce::negate_forces() {
 }
 
 void ParticleForceCompute::compute() {
-    if (!force_function) {
+    if (!force_function && !indexed_force_function) {
         throw std::runtime_error(
                 "force_function is not set in ParticleForceCompute");
     }
     reset_forces_to_zero();
 
-    size_t current_particle_index = 0;
-    for (const auto &particle : m_sys->all.particles) {
+    const auto &particles = m_sys->all;
+    if (indexed_force_function) {
+        for (size_t index = 0; index < particles.size(); ++index) {
+            auto &force = particle_forces[index].force;
+            force = ArrayUtilities::plus(
+                    force, indexed_force_function(particles, index));
+        }
+        return;
+    }
+    for (size_t current_particle_index = 0;
+         current_particle_index < particles.size(); ++current_particle_index) {
         auto &current_particle_force =
                 particle_forces[current_particle_index].force;
-        assert(particle.id ==
+        assert(particles.ids[current_particle_index] ==
                        particle_forces[current_particle_index].particle_id &&
                "particle ids are not synchronized in "
                "PairBondeForce:compute(), they should be sorted as well as "
                "all the particles.");
-        current_particle_force = ArrayUtilities::plus(current_particle_force,
-                                                      force_function(particle));
-        current_particle_index++;
+        current_particle_force = ArrayUtilities::plus(
+                current_particle_force,
+                force_function(particles.get_particle(current_particle_index)));
     }
 }
 
+void ParticleBatchForceCompute::compute() {
+    if (!force_function) {
+        throw std::runtime_error(
+                "force_function is not set in ParticleBatchForceCompute");
+    }
+    reset_forces_to_zero();
+    force_function(m_sys->all, particle_forces);
+}
+
+void ExcludedVolumeForce::compute() {
+    reset_forces_to_zero();
+    const auto &positions = m_sys->all.positions;
+    const auto &materials = m_sys->all.materials;
+    double max_radius = 0.0;
+    for (const auto &material : materials) {
+        max_radius = std::max(max_radius, material.radius);
+    }
+    if (neighbor_list.cutoff < 2.0 * max_radius) {
+        neighbor_list.cutoff = 2.0 * max_radius;
+    }
+    neighbor_list.update(m_sys->all);
+    if (exclude_bonded &&
+        m_bonded_pairs_build != neighbor_list.number_of_builds) {
+        update_bonded_pairs();
+    }
+
+    const auto &offsets = neighbor_list.neighbor_offsets;
+    const auto &neighbors = neighbor_list.neighbors;
+    for (size_t i = 0; i < positions.size(); ++i) {
+        auto &force_on_a = particle_forces[i].force;
+        for (size_t k = offsets[i]; k < offsets[i + 1]; ++k) {
+            const size_t j = neighbors[k];
+            const double sigma = materials[i].radius + materials[j].radius;
+            const auto a_minus_b =
+                    neighbor_list.minus(positions[i], positions[j]);
+            const double distance_squared =
+                    ArrayUtilities::dot_product(a_minus_b, a_minus_b);
+            if (distance_squared >= sigma * sigma) {
+                continue;
+            }
+            if (exclude_bonded &&
+                std::binary_search(m_bonded_pairs.begin(),
+                                   m_bonded_pairs.end(), std::make_pair(i, j))) {
+                continue;
+            }
+            const auto force = force_soft_sphere(stiffness, sigma, a_minus_b,
+                                                 std::sqrt(distance_squared));
+            force_on_a = ArrayUtilities::plus(force_on_a, force);
+            auto &force_on_b = particle_forces[j].force;
+            force_on_b = ArrayUtilities::minus(force_on_b, force);
+        }
+    }
+}
+
+void ExcludedVolumeForce::update_bonded_pairs() {
+    m_bonded_pairs.clear();
+    m_bonded_pairs.reserve(m_sys->bonds.bonds.size());
+    for (const auto &bond : m_sys->bonds.bonds) {
+        const size_t a = m_sys->all.find_index(bond->id_a);
+        const size_t b = m_sys->all.find_index(bond->id_b);
+        if (a == std::numeric_limits<size_t>::max() ||
+            b == std::numeric_limits<size_t>::max()) {
+            throw std::runtime_error(get_type() +
+                                     ": the particles of a bond are not in "
+                                     "the system");
+        }
+        m_bonded_pairs.emplace_back(std::min(a, b), std::max(a, b));
+    }
+    std::sort(m_bonded_pairs.begin(), m_bonded_pairs.end());
+    m_bonded_pairs_build = neighbor_list.number_of_builds;
+}
+
 ParticleRandomForceCompute::ParticleRandomForceCompute(
         const System *sys,
         const double &kT,
@@ -123,12 +397,20 @@ ParticleRandomForceCompute::ParticleRandomForceCompute(
         const size_t &dimension)
         : ParticleForceCompute(sys), kT(kT), gamma(gamma), deltaT(deltaT),
           dimension(dimension),
-          _modulo(sqrt(2.0 * dimension * kT * gamma / deltaT)) {
-    const auto &modulo = _modulo;
-    this->force_function = [&modulo](const Particle &
-                                     /*p*/) -> ArrayUtilities::Array3D {
-        return RNG::random_orientation(modulo);
-    };
+          _modulo(sqrt(2.0 * dimension * kT * gamma / deltaT)) {}
+
+void ParticleRandomForceCompute::compute() {
+    if (!engine_is_seeded()) {
+        seed_engine(RNG::engine());
+    }
+    if (force_function || indexed_force_function) {
+        ParticleForceCompute::compute();
+        return;
+    }
+    // The force does not depend on the particle.
+    for (auto &particle_force : particle_forces) {
+        particle_force.force = RNG::random_orientation(_modulo, engine);
+    }
 }
 
 } // namespace SG
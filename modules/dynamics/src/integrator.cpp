@@ -19,18 +19,61 @@
  * *******************************************************************/
 
 #include "integrator.hpp"
+#include "rng.hpp" // from core module
 
 namespace SG {
 
+namespace {
+/** Particles per thread under which launching a thread is not worth it. */
+constexpr size_t min_particles_per_thread = 4096;
+} // namespace
+
 void Integrator::compute_net_forces(System *sys) const {
-    const auto nparts = sys->all.particles.size();
-    for (size_t part_index = 0; part_index < nparts; ++part_index) {
-        auto &net_force = sys->all.particles[part_index].dynamics.net_force;
-        std::fill(net_force.begin(), net_force.end(), 0.0);
-        for (const auto &force_type : force_types) {
-            net_force = ArrayUtilities::plus(
-                    net_force, force_type->particle_forces[part_index].force);
-        };
+    auto &net_forces = sys->all.net_forces;
+    sys->thread_pool->parallel_for_chunks(
+            net_forces.size(), num_threads,
+            [&](const size_t &begin, const size_t &end) {
+                for (size_t part_index = begin; part_index < end;
+                     ++part_index) {
+                    net_forces[part_index] =
+                            sum_particle_forces(force_types, part_index);
+                }
+            },
+            min_particles_per_thread);
+}
+
+void Integrator::compute_forces() {
+    // Seed the engine of new force computes, in order, from the engine of
+    // this thread. Random forces draw from their own engine, so they do not
+    // depend on num_threads.
+    for (auto &force_type : force_types) {
+        if (!force_type->engine_is_seeded()) {
+            force_type->seed_engine(RNG::engine());
+        }
+    }
+    m_sys->thread_pool->parallel_for_chunks(
+            force_types.size(), num_threads,
+            [&](const size_t &begin, const size_t &end) {
+                for (size_t i = begin; i < end; ++i) {
+                    force_types[i]->compute();
+                }
+            });
+}
+
+void Integrator::print_forces(std::ostream &os) const {
+    for (const auto &force_type : force_types) {
+        os << "force_type: " << force_type->get_type() << std::endl;
+        for (const auto &particle_force : force_type->particle_forces) {
+            os << "Particle: " << particle_force.particle_id
+               << ", force: " << ArrayUtilities::to_string(particle_force.force)
+               << std::endl;
+        }
+    }
+    const auto &particles = m_sys->all;
+    for (size_t index = 0; index < particles.size(); ++index) {
+        os << "id: " << particles.ids[index] << "; net_force: "
+           << ArrayUtilities::to_string(particles.net_forces[index])
+           << std::endl;
     }
 }
 
@@ -42,66 +85,109 @@ void IntegratorTwoStep::update(unsigned int /* time_step */) {
     }
     this->integrator_method->integrateStepOne();
     // compute all types of forces
-    for (auto &force_type : this->force_types) {
-        force_type->compute();
-        { // TODO remove debug
-            std::cout << "force_type: " << force_type->get_type() << std::endl;
-            for (auto &particle_force : force_type->particle_forces) {
-                std::cout << "Particle: " << particle_force.particle_id
-                          << ", force: "
-                          << ArrayUtilities::to_string(particle_force.force)
-                          << std::endl;
-            }
-        }
+    this->compute_forces();
+    // sum net forces and finish the step.
+    if (this->fuse_net_forces()) {
+        this->integrator_method->integrateStepTwo(this->force_types);
+    } else {
+        this->compute_net_forces(m_sys);
+        this->integrator_method->integrateStepTwo();
     }
-    // sum net forces
-    this->compute_net_forces(m_sys);
-    this->integrator_method->integrateStepTwo();
-    { // TODO remove debug
-        for (auto &particle : m_sys->all.particles) {
-            std::cout << "id: " << particle.id << "; net_force: "
-                      << ArrayUtilities::to_string(particle.dynamics.net_force)
-                      << std::endl;
-        }
+    if (verbose) {
+        this->print_forces(std::cout);
     }
 }
 
+void TwoStepIntegratorMethod::integrateStepTwo(
+        const std::vector<std::shared_ptr<ForceCompute>> &force_types) {
+    auto &net_forces = m_sys->all.net_forces;
+    m_sys->thread_pool->parallel_for_chunks(
+            net_forces.size(), num_threads,
+            [&](const size_t &begin, const size_t &end) {
+                for (size_t index = begin; index < end; ++index) {
+                    net_forces[index] = sum_particle_forces(force_types, index);
+                }
+            },
+            min_particles_per_thread);
+    this->integrateStepTwo();
+}
+
 void VerletVelocitiesIntegratorMethod::integrateStepOne() {
     // perform the first half step of velocity verlet
     // r(t+deltaT) = r(t) + v(t)*deltaT + (1/2)a(t)*deltaT^2
     // v(t+deltaT/2) = v(t) + (1/2)a*deltaT
-    const auto nparts = m_sys->all.particles.size();
-    for (unsigned int index = 0; index < nparts; ++index) {
-        auto &position = m_sys->all.particles[index].pos;
-        auto &velocity = m_sys->all.particles[index].dynamics.vel;
-        const auto &acceleration = m_sys->all.particles[index].dynamics.acc;
-        const ArrayUtilities::Array3D dr = ArrayUtilities::plus(
-                ArrayUtilities::product_scalar(velocity, deltaT),
-                ArrayUtilities::product_scalar(acceleration,
-                                               deltaT * deltaT * 0.5));
-        // TODO limit the movement of the particles?
-        position = ArrayUtilities::plus(position, dr);
-        velocity = ArrayUtilities::plus(
-                velocity,
-                ArrayUtilities::product_scalar(acceleration, deltaT * 0.5));
-    }
+    auto &positions = m_sys->all.positions;
+    auto &velocities = m_sys->all.velocities;
+    const auto &accelerations = m_sys->all.accelerations;
+    m_sys->thread_pool->parallel_for_chunks(
+            positions.size(), num_threads,
+            [&](const size_t &begin, const size_t &end) {
+                for (size_t index = begin; index < end; ++index) {
+                    auto &position = positions[index];
+                    auto &velocity = velocities[index];
+                    const auto &acceleration = accelerations[index];
+                    const ArrayUtilities::Array3D dr = ArrayUtilities::plus(
+                            ArrayUtilities::product_scalar(velocity, deltaT),
+                            ArrayUtilities::product_scalar(
+                                    acceleration, deltaT * deltaT * 0.5));
+                    // TODO limit the movement of the particles?
+                    position = ArrayUtilities::plus(position, dr);
+                    velocity = ArrayUtilities::plus(
+                            velocity, ArrayUtilities::product_scalar(
+                                              acceleration, deltaT * 0.5));
+                }
+            },
+            min_particles_per_thread);
 }
 
 void VerletVelocitiesIntegratorMethod::integrateStepTwo() {
     // first update acceleration from current forces
     // a(t+deltaT) = force/mass
     // v(t+deltaT) = v(t+deltaT/2) + 1/2 * a(t+deltaT)*deltaT
-    const auto nparts = m_sys->all.particles.size();
-    for (unsigned int index = 0; index < nparts; ++index) {
-        // auto & position = m_sys->all.particles[index].pos;
-        auto &velocity = m_sys->all.particles[index].dynamics.vel;
-        auto &acceleration = m_sys->all.particles[index].dynamics.acc;
-        const auto &force = m_sys->all.particles[index].dynamics.net_force;
-        const auto &mass = m_sys->all.particles[index].material.mass;
-        acceleration = ArrayUtilities::product_scalar(force, 1.0 / mass);
-        velocity = ArrayUtilities::plus(
-                velocity,
-                ArrayUtilities::product_scalar(acceleration, deltaT * 0.5));
-    }
+    auto &velocities = m_sys->all.velocities;
+    auto &accelerations = m_sys->all.accelerations;
+    const auto &net_forces = m_sys->all.net_forces;
+    const auto &materials = m_sys->all.materials;
+    m_sys->thread_pool->parallel_for_chunks(
+            velocities.size(), num_threads,
+            [&](const size_t &begin, const size_t &end) {
+                for (size_t index = begin; index < end; ++index) {
+                    auto &velocity = velocities[index];
+                    auto &acceleration = accelerations[index];
+                    const auto &force = net_forces[index];
+                    const auto &mass = materials[index].mass;
+                    acceleration =
+                            ArrayUtilities::product_scalar(force, 1.0 / mass);
+                    velocity = ArrayUtilities::plus(
+                            velocity, ArrayUtilities::product_scalar(
+                                              acceleration, deltaT * 0.5));
+                }
+            },
+            min_particles_per_thread);
+}
+
+void VerletVelocitiesIntegratorMethod::integrateStepTwo(
+        const std::vector<std::shared_ptr<ForceCompute>> &force_types) {
+    // Same as integrateStepTwo(), computing the net force in place
+    auto &velocities = m_sys->all.velocities;
+    auto &accelerations = m_sys->all.accelerations;
+    auto &net_forces = m_sys->all.net_forces;
+    const auto &materials = m_sys->all.materials;
+    m_sys->thread_pool->parallel_for_chunks(
+            velocities.size(), num_threads,
+            [&](const size_t &begin, const size_t &end) {
+                for (size_t index = begin; index < end; ++index) {
+                    auto &net_force = net_forces[index];
+                    auto &acceleration = accelerations[index];
+                    net_force = sum_particle_forces(force_types, index);
+                    acceleration = ArrayUtilities::product_scalar(
+                            net_force, 1.0 / materials[index].mass);
+                    velocities[index] = ArrayUtilities::plus(
+                            velocities[index],
+                            ArrayUtilities::product_scalar(acceleration,
+                                                           deltaT * 0.5));
+                }
+            },
+            min_particles_per_thread);
 }
 } // namespace SG
@@ -0,0 +1,289 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+#include "neighbor_list.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+
+namespace SG {
+
+namespace {
+inline double squared_norm(const ArrayUtilities::Array3D &a) {
+    return a[0] * a[0] + a[1] * a[1] + a[2] * a[2];
+}
+} // namespace
+
+ArrayUtilities::Array3D
+NeighborList::minus(const ArrayUtilities::Array3D &a,
+                    const ArrayUtilities::Array3D &b) const {
+    if (boundary_condition == ArrayUtilities::boundary_condition::PERIODIC) {
+        const ArrayUtilities::Array3D box_size_inverse = {
+                1.0 / box_size[0], 1.0 / box_size[1], 1.0 / box_size[2]};
+        return ArrayUtilities::minus_with_boundary_condition_periodic(
+                a, b, box_size, box_size_inverse);
+    }
+    return ArrayUtilities::minus(a, b);
+}
+
+bool NeighborList::needs_rebuild(const ParticleCollection &collection) const {
+    const auto &positions = collection.positions;
+    if (number_of_builds == 0 ||
+        m_positions_at_build.size() != positions.size() ||
+        cutoff != m_cutoff_at_build || skin != m_skin_at_build ||
+        boundary_condition != m_boundary_condition_at_build ||
+        box_size != m_box_size_at_build) {
+        return true;
+    }
+    // Two particles moving skin / 2 towards each other might be in cutoff.
+    const double max_displacement_squared = 0.25 * skin * skin;
+    for (size_t i = 0; i < positions.size(); ++i) {
+        if (squared_norm(minus(positions[i], m_positions_at_build[i])) >
+            max_displacement_squared) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool NeighborList::update(const ParticleCollection &collection) {
+    if (!needs_rebuild(collection)) {
+        return false;
+    }
+    build(collection);
+    return true;
+}
+
+void NeighborList::build(const ParticleCollection &collection) {
+    const auto &positions = collection.positions;
+    const size_t nparts = positions.size();
+    const double list_radius = cutoff + skin;
+    if (!(list_radius > 0.0) || skin < 0.0) {
+        throw std::runtime_error("NeighborList: cutoff + skin must be "
+                                 "positive, and skin not negative.");
+    }
+    const bool periodic =
+            boundary_condition == ArrayUtilities::boundary_condition::PERIODIC;
+
+    // Grid of cells of at least list_radius per side.
+    ArrayUtilities::Array3D origin = {0.0, 0.0, 0.0};
+    ArrayUtilities::Array3D extent = box_size;
+    if (periodic) {
+        for (size_t d = 0; d < 3; ++d) {
+            if (!(2.0 * list_radius <= box_size[d])) {
+                throw std::runtime_error(
+                        "NeighborList: cutoff + skin must be at most half of "
+                        "box_size with PERIODIC boundary conditions.");
+            }
+        }
+    } else if (nparts > 0) {
+        origin = positions[0];
+        ArrayUtilities::Array3D upper = positions[0];
+        for (const auto &position : positions) {
+            for (size_t d = 0; d < 3; ++d) {
+                origin[d] = std::min(origin[d], position[d]);
+                upper[d] = std::max(upper[d], position[d]);
+            }
+        }
+        extent = ArrayUtilities::minus(upper, origin);
+    }
+    // Sparse systems: limit the number of cells to the order of nparts.
+    const double max_cells = 2.0 * static_cast<double>(std::max<size_t>(nparts, 1));
+    std::array<size_t, 3> num_cells;
+    for (size_t d = 0; d < 3; ++d) {
+        num_cells[d] = static_cast<size_t>(std::max(
+                1.0, std::min(std::floor(extent[d] / list_radius), max_cells)));
+    }
+    while (static_cast<double>(num_cells[0]) * num_cells[1] * num_cells[2] >
+           max_cells) {
+        auto &largest = *std::max_element(num_cells.begin(), num_cells.end());
+        largest = std::max<size_t>(1, largest / 2);
+    }
+    ArrayUtilities::Array3D cell_size_inverse;
+    for (size_t d = 0; d < 3; ++d) {
+        cell_size_inverse[d] =
+                extent[d] > 0.0 ? static_cast<double>(num_cells[d]) / extent[d]
+                                : 0.0;
+    }
+    const auto cell_coordinates = [&](const ArrayUtilities::Array3D &pos) {
+        std::array<size_t, 3> coordinates;
+        for (size_t d = 0; d < 3; ++d) {
+            double x = pos[d] - origin[d];
+            if (periodic) {
+                x -= std::floor(x / box_size[d]) * box_size[d];
+            }
+            const double cell = std::floor(x * cell_size_inverse[d]);
+            coordinates[d] = cell <= 0.0 ? 0
+                             : std::min(static_cast<size_t>(cell),
+                                        num_cells[d] - 1);
+        }
+        return coordinates;
+    };
+    const auto linear_cell = [&](const std::array<size_t, 3> &c) {
+        return c[0] + num_cells[0] * (c[1] + num_cells[1] * c[2]);
+    };
+
+    // Bin the particles (counting sort by cell).
+    const size_t total_cells = num_cells[0] * num_cells[1] * num_cells[2];
+    std::vector<size_t> particle_cell(nparts);
+    std::vector<size_t> cell_offsets(total_cells + 1, 0);
+    for (size_t i = 0; i < nparts; ++i) {
+        particle_cell[i] = linear_cell(cell_coordinates(positions[i]));
+        ++cell_offsets[particle_cell[i] + 1];
+    }
+    for (size_t c = 0; c < total_cells; ++c) {
+        cell_offsets[c + 1] += cell_offsets[c];
+    }
+    std::vector<size_t> cell_particles(nparts);
+    {
+        auto cell_fill = cell_offsets;
+        for (size_t i = 0; i < nparts; ++i) {
+            cell_particles[cell_fill[particle_cell[i]]++] = i;
+        }
+    }
+
+    // Positions in cell order, so the particles of a cell are contiguous.
+    std::vector<ArrayUtilities::Array3D> cell_positions(nparts);
+    for (size_t k = 0; k < nparts; ++k) {
+        cell_positions[k] = positions[cell_particles[k]];
+    }
+    const ArrayUtilities::Array3D box_size_inverse = {
+            1.0 / box_size[0], 1.0 / box_size[1], 1.0 / box_size[2]};
+    const auto squared_distance = [&](const ArrayUtilities::Array3D &a,
+                                      const ArrayUtilities::Array3D &b) {
+        double result = 0.0;
+        for (size_t d = 0; d < 3; ++d) {
+            double delta = a[d] - b[d];
+            if (periodic) {
+                delta -= box_size[d] * std::nearbyint(delta * box_size_inverse[d]);
+            }
+            result += delta * delta;
+        }
+        return result;
+    };
+
+    // Pairs from the cells around each cell, visiting the cells in order.
+    // The neighbors of each particle are contiguous in cell_neighbors.
+    const double list_radius_squared = list_radius * list_radius;
+    std::vector<size_t> cell_neighbors;
+    std::vector<size_t> neighbors_begin(nparts);
+    std::vector<size_t> neighbors_count(nparts);
+    std::array<size_t, 27> stencil;
+    for (size_t c = 0; c < total_cells; ++c) {
+        if (cell_offsets[c] == cell_offsets[c + 1]) {
+            continue;
+        }
+        const std::array<size_t, 3> coordinates = {
+                c % num_cells[0], (c / num_cells[0]) % num_cells[1],
+                c / (num_cells[0] * num_cells[1])};
+        size_t stencil_size = 0;
+        for (int dz = -1; dz <= 1; ++dz) {
+            for (int dy = -1; dy <= 1; ++dy) {
+                for (int dx = -1; dx <= 1; ++dx) {
+                    const std::array<int, 3> delta = {dx, dy, dz};
+                    std::array<size_t, 3> neighbor_cell;
+                    bool is_inside = true;
+                    for (size_t d = 0; d < 3; ++d) {
+                        const long n = static_cast<long>(num_cells[d]);
+                        long coordinate =
+                                static_cast<long>(coordinates[d]) + delta[d];
+                        if (periodic) {
+                            coordinate = (coordinate + n) % n;
+                        } else if (coordinate < 0 || coordinate >= n) {
+                            is_inside = false;
+                        }
+                        neighbor_cell[d] = static_cast<size_t>(coordinate);
+                    }
+                    if (is_inside) {
+                        stencil[stencil_size++] = linear_cell(neighbor_cell);
+                    }
+                }
+            }
+        }
+        // With less than 3 periodic cells, some neighbor cells repeat.
+        std::sort(stencil.begin(), stencil.begin() + stencil_size);
+        const auto stencil_end =
+                std::unique(stencil.begin(), stencil.begin() + stencil_size);
+
+        for (size_t k = cell_offsets[c]; k < cell_offsets[c + 1]; ++k) {
+            const size_t i = cell_particles[k];
+            const auto &pos_i = cell_positions[k];
+            neighbors_begin[i] = cell_neighbors.size();
+            for (auto it = stencil.begin(); it != stencil_end; ++it) {
+                for (size_t m = cell_offsets[*it]; m < cell_offsets[*it + 1];
+                     ++m) {
+                    const size_t j = cell_particles[m];
+                    if (j > i && squared_distance(pos_i, cell_positions[m]) <
+                                         list_radius_squared) {
+                        cell_neighbors.push_back(j);
+                    }
+                }
+            }
+            neighbors_count[i] = cell_neighbors.size() - neighbors_begin[i];
+        }
+    }
+    // Order by particle index.
+    neighbor_offsets.assign(nparts + 1, 0);
+    for (size_t i = 0; i < nparts; ++i) {
+        neighbor_offsets[i + 1] = neighbor_offsets[i] + neighbors_count[i];
+    }
+    neighbors.resize(cell_neighbors.size());
+    for (size_t i = 0; i < nparts; ++i) {
+        std::copy_n(cell_neighbors.begin() + neighbors_begin[i],
+                    neighbors_count[i],
+                    neighbors.begin() + neighbor_offsets[i]);
+    }
+
+    m_positions_at_build = positions;
+    m_cutoff_at_build = cutoff;
+    m_skin_at_build = skin;
+    m_boundary_condition_at_build = boundary_condition;
+    m_box_size_at_build = box_size;
+    ++number_of_builds;
+}
+
+ParticleNeighborsCollection
+make_particle_neighbors(const NeighborList &neighbor_list,
+                        const ParticleCollection &collection) {
+    const auto &ids = collection.ids;
+    const size_t nparts = ids.size();
+    if (neighbor_list.neighbor_offsets.size() != nparts + 1) {
+        throw std::runtime_error("make_particle_neighbors: the neighbor list "
+                                 "was not built for these particles.");
+    }
+    ParticleNeighborsCollection particle_neighbors;
+    particle_neighbors.reserve(nparts);
+    for (const auto &id : ids) {
+        particle_neighbors.emplace_back(id);
+    }
+    for (size_t i = 0; i < nparts; ++i) {
+        for (size_t k = neighbor_list.neighbor_offsets[i];
+             k < neighbor_list.neighbor_offsets[i + 1]; ++k) {
+            const size_t j = neighbor_list.neighbors[k];
+            particle_neighbors[i].neighbors.push_back(ids[j]);
+            particle_neighbors[j].neighbors.push_back(ids[i]);
+        }
+    }
+    return particle_neighbors;
+}
+
+} // namespace SG
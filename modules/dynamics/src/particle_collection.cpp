@@ -20,76 +20,150 @@
 
 #include "particle_collection.hpp"
 #include <algorithm>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
 
 namespace SG {
 
-void ParticleCollection::sort() {
-    std::sort(std::begin(particles), std::end(particles));
-    sorted = true;
+ParticleCollection::ParticleCollection(const std::vector<Particle> &particles) {
+    set_particles(particles);
+}
+
+void ParticleCollection::reserve(const size_t &num_particles) {
+    ids.reserve(num_particles);
+    positions.reserve(num_particles);
+    velocities.reserve(num_particles);
+    accelerations.reserve(num_particles);
+    net_forces.reserve(num_particles);
+    materials.reserve(num_particles);
+}
+
+void ParticleCollection::resize(const size_t &num_particles) {
+    ids.resize(num_particles);
+    positions.resize(num_particles);
+    velocities.resize(num_particles);
+    accelerations.resize(num_particles);
+    net_forces.resize(num_particles);
+    materials.resize(num_particles);
+}
+
+void ParticleCollection::clear() { resize(0); }
+
+void ParticleCollection::push_back(const Particle &particle) {
+    ids.push_back(particle.id);
+    positions.push_back(particle.pos);
+    velocities.push_back(particle.dynamics.vel);
+    accelerations.push_back(particle.dynamics.acc);
+    net_forces.push_back(particle.dynamics.net_force);
+    materials.push_back(particle.material);
 }
 
-std::vector<Particle>::iterator
-ParticleCollection::binary_find(const size_t &id_value) {
-    return binary_find(std::begin(particles), std::end(particles), id_value);
+Particle ParticleCollection::get_particle(const size_t &index) const {
+    Particle particle;
+    particle.id = ids[index];
+    particle.pos = positions[index];
+    particle.dynamics.vel = velocities[index];
+    particle.dynamics.acc = accelerations[index];
+    particle.dynamics.net_force = net_forces[index];
+    particle.material = materials[index];
+    return particle;
 }
-std::vector<Particle>::const_iterator
-ParticleCollection::binary_find(const size_t &id_value) const {
-    return binary_find(std::cbegin(particles), std::cend(particles), id_value);
+
+void ParticleCollection::set_particle(const size_t &index,
+                                      const Particle &particle) {
+    ids[index] = particle.id;
+    positions[index] = particle.pos;
+    velocities[index] = particle.dynamics.vel;
+    accelerations[index] = particle.dynamics.acc;
+    net_forces[index] = particle.dynamics.net_force;
+    materials[index] = particle.material;
 }
 
-std::pair<std::vector<Particle>::const_iterator, size_t>
-ParticleCollection::find_particle_and_index(const size_t &id_value) const {
-    const auto it = binary_find(id_value);
-    if (it != particles.end()) {
-        return std::make_pair(it, std::distance(particles.begin(), it));
+std::vector<Particle> ParticleCollection::get_particles() const {
+    const size_t num_particles = size();
+    std::vector<Particle> particles(num_particles);
+    for (size_t index = 0; index < num_particles; ++index) {
+        particles[index] = get_particle(index);
     }
-    return std::make_pair(it, std::numeric_limits<size_t>::max());
+    return particles;
 }
 
-std::pair<std::vector<Particle>::iterator, size_t>
-ParticleCollection::find_particle_and_index(const size_t &id_value) {
-    const auto it = binary_find(id_value);
-    if (it != particles.end()) {
-        return std::make_pair(it, std::distance(particles.begin(), it));
+void ParticleCollection::set_particles(const std::vector<Particle> &particles) {
+    clear();
+    reserve(particles.size());
+    for (const auto &particle : particles) {
+        push_back(particle);
     }
-    return std::make_pair(it, std::numeric_limits<size_t>::max());
+}
+
+namespace {
+template <typename T>
+void apply_permutation(std::vector<T> &values,
+                       const std::vector<size_t> &permutation) {
+    std::vector<T> permuted;
+    permuted.reserve(values.size());
+    for (const auto &index : permutation) {
+        permuted.push_back(values[index]);
+    }
+    values.swap(permuted);
+}
+} // namespace
+
+void ParticleCollection::sort() {
+    std::vector<size_t> permutation(size());
+    std::iota(std::begin(permutation), std::end(permutation), 0);
+    std::stable_sort(std::begin(permutation), std::end(permutation),
+                     [this](const size_t &lhs, const size_t &rhs) {
+                         return ids[lhs] < ids[rhs];
+                     });
+    apply_permutation(ids, permutation);
+    apply_permutation(positions, permutation);
+    apply_permutation(velocities, permutation);
+    apply_permutation(accelerations, permutation);
+    apply_permutation(net_forces, permutation);
+    apply_permutation(materials, permutation);
+    sorted = true;
 }
 
 size_t ParticleCollection::find_index(const size_t &id_value) const {
-    const auto it = binary_find(id_value);
-    if (it != particles.end()) {
-        return std::distance(particles.begin(), it);
+    if (!sorted) {
+        throw std::runtime_error(
+                "Particles not sorted in ParticleCollection before a find. "
+                "Call sort() first.");
+    }
+    const auto it = std::lower_bound(std::begin(ids), std::end(ids), id_value);
+    if (it == std::end(ids) || id_value < *it) {
+        return std::numeric_limits<size_t>::max();
     }
-    return std::numeric_limits<size_t>::max();
+    return std::distance(std::begin(ids), it);
 }
 
 void print_end_collection(const ParticleCollection &collection,
                           std::ostream &os) {
-    os << "All " << collection.particles.size() << " particles printed"
-       << std::endl;
+    os << "All " << collection.size() << " particles printed" << std::endl;
 }
 void print_id_pos(const ParticleCollection &collection, std::ostream &os) {
-    for (const auto &p : collection.particles) {
-        print_id_pos(p, os);
+    for (size_t index = 0; index < collection.size(); ++index) {
+        print_id_pos(collection.get_particle(index), os);
         os << "-------------------------------" << std::endl;
     }
     print_end_collection(collection, os);
 }
 void print(const ParticleCollection &collection, std::ostream &os) {
-    for (const auto &p : collection.particles) {
-        print(p, os);
+    for (size_t index = 0; index < collection.size(); ++index) {
+        print(collection.get_particle(index), os);
         os << "-------------------------------" << std::endl;
     }
     print_end_collection(collection, os);
 }
 
-void dump_csv_header(const ParticleCollection &all_particles,
+void dump_csv_header(const ParticleCollection & /*all_particles*/,
                      std::ostream &os,
                      bool add_end_of_line,
                      bool /*with_particle_id*/) {
     const bool internal_do_not_add_end_of_line = false;
-    dump_csv_header(all_particles.particles[0], os,
-                    internal_do_not_add_end_of_line);
+    dump_csv_header(Particle(), os, internal_do_not_add_end_of_line);
     if (add_end_of_line) {
         os << std::endl;
     }
@@ -99,8 +173,9 @@ void dump_csv_data(const ParticleCollection &all_particles,
                    bool add_end_of_line,
                    bool /*with_particle_id*/) {
     const bool internal_add_end_of_line = true;
-    for (const auto &particle_neighbors : all_particles.particles) {
-        dump_csv_data(particle_neighbors, os, internal_add_end_of_line);
+    for (size_t index = 0; index < all_particles.size(); ++index) {
+        dump_csv_data(all_particles.get_particle(index), os,
+                      internal_add_end_of_line);
     }
     if (add_end_of_line) {
         os << std::endl;
@@ -22,46 +22,37 @@
 namespace SG {
 
 ArrayUtilities::Array3D &System::get_position(size_t index) {
-    return all.particles[index].pos;
+    return all.positions[index];
 }
 const ArrayUtilities::Array3D &System::get_position(size_t index) const {
-    return all.particles[index].pos;
+    return all.positions[index];
 }
 ArrayUtilities::Array3D &System::get_velocity(size_t index) {
-    return all.particles[index].dynamics.vel;
+    return all.velocities[index];
 }
 const ArrayUtilities::Array3D &System::get_velocity(size_t index) const {
-    return all.particles[index].dynamics.vel;
+    return all.velocities[index];
 }
 ArrayUtilities::Array3D &System::get_acceleration(size_t index) {
-    return all.particles[index].dynamics.acc;
+    return all.accelerations[index];
 }
 const ArrayUtilities::Array3D &System::get_acceleration(size_t index) const {
-    return all.particles[index].dynamics.acc;
+    return all.accelerations[index];
 }
-auto System::all_positions_copy() {
-    const auto nparts = all.particles.size();
-    std::vector<ArrayUtilities::Array3D> positions(nparts);
-    for (unsigned int i = 0; i < nparts; ++i) {
-        positions[i] = all.particles[i].pos;
-    }
-    return positions;
+ArrayUtilities::Array3D &System::get_net_force(size_t index) {
+    return all.net_forces[index];
 }
-auto System::all_velocities_copy() {
-    const auto nparts = all.particles.size();
-    std::vector<ArrayUtilities::Array3D> velocities(nparts);
-    for (unsigned int i = 0; i < nparts; ++i) {
-        velocities[i] = all.particles[i].dynamics.vel;
-    }
-    return velocities;
+const ArrayUtilities::Array3D &System::get_net_force(size_t index) const {
+    return all.net_forces[index];
 }
-auto System::all_accelerations_copy() {
-    const auto nparts = all.particles.size();
-    std::vector<ArrayUtilities::Array3D> accelerations(nparts);
-    for (unsigned int i = 0; i < nparts; ++i) {
-        accelerations[i] = all.particles[i].dynamics.acc;
-    }
-    return accelerations;
+std::vector<ArrayUtilities::Array3D> System::all_positions_copy() const {
+    return all.positions;
+}
+std::vector<ArrayUtilities::Array3D> System::all_velocities_copy() const {
+    return all.velocities;
+}
+std::vector<ArrayUtilities::Array3D> System::all_accelerations_copy() const {
+    return all.accelerations;
 }
 
 std::vector<Bond> unique_bonds(const System *sys) {
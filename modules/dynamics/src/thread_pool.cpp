@@ -0,0 +1,165 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+namespace SG {
+
+size_t resolve_num_threads(const size_t &num_threads) {
+    return num_threads == 0
+                   ? std::max(1u, std::thread::hardware_concurrency())
+                   : num_threads;
+}
+
+struct ThreadPool::Job {
+    const chunk_function_t *function;
+    size_t size;
+    size_t chunk_size;
+    size_t num_chunks;
+    /** Workers that can still join the job. */
+    size_t free_slots;
+    std::atomic<size_t> next_chunk{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex mutex; // for error, done_chunks and done
+    size_t done_chunks = 0;
+    std::condition_variable done;
+};
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_job_available.notify_all();
+    for (auto &worker : m_workers) {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::num_workers() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_workers.size();
+}
+
+void ThreadPool::start_workers(const size_t &num_workers) {
+    // m_mutex is locked by the caller.
+    while (m_workers.size() < num_workers) {
+        m_workers.emplace_back([this] { worker_loop(); });
+    }
+}
+
+void ThreadPool::worker_loop() {
+    while (true) {
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_job_available.wait(lock,
+                                 [this] { return m_stop || !m_jobs.empty(); });
+            if (m_stop) {
+                return;
+            }
+            job = m_jobs.front();
+            if (--job->free_slots == 0) {
+                m_jobs.pop_front();
+            }
+        }
+        run_chunks(*job);
+    }
+}
+
+void ThreadPool::run_chunks(Job &job) {
+    size_t finished = 0;
+    for (size_t chunk = job.next_chunk++; chunk < job.num_chunks;
+         chunk = job.next_chunk++) {
+        if (!job.failed) {
+            const size_t begin = std::min(chunk * job.chunk_size, job.size);
+            try {
+                (*job.function)(begin,
+                                std::min(begin + job.chunk_size, job.size));
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(job.mutex);
+                if (!job.error) {
+                    job.error = std::current_exception();
+                }
+                job.failed = true;
+            }
+        }
+        ++finished;
+    }
+    if (finished == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(job.mutex);
+    job.done_chunks += finished;
+    if (job.done_chunks == job.num_chunks) {
+        job.done.notify_all();
+    }
+}
+
+void ThreadPool::parallel_for_chunks(const size_t &size,
+                                     const size_t &num_threads,
+                                     const chunk_function_t &function,
+                                     const size_t &min_chunk_size) {
+    const size_t max_threads =
+            (size + std::max<size_t>(min_chunk_size, 1) - 1) /
+            std::max<size_t>(min_chunk_size, 1);
+    const size_t threads =
+            std::min(resolve_num_threads(num_threads), max_threads);
+    if (threads <= 1) {
+        function(size_t(0), size);
+        return;
+    }
+    // A few chunks per thread to balance uneven costs.
+    auto job = std::make_shared<Job>();
+    job->function = &function;
+    job->size = size;
+    job->num_chunks = std::min(size, 4 * threads);
+    job->chunk_size = (size + job->num_chunks - 1) / job->num_chunks;
+    job->free_slots = threads - 1;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        start_workers(threads - 1);
+        m_jobs.push_back(job);
+    }
+    m_job_available.notify_all();
+    run_chunks(*job);
+    {
+        // Workers that did not join yet would find no chunks left.
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto queued = std::find(m_jobs.begin(), m_jobs.end(), job);
+        if (queued != m_jobs.end()) {
+            m_jobs.erase(queued);
+        }
+    }
+    {
+        std::unique_lock<std::mutex> lock(job->mutex);
+        job->done.wait(lock,
+                       [&job] { return job->done_chunks == job->num_chunks; });
+    }
+    if (job->error) {
+        std::rethrow_exception(job->error);
+    }
+}
+} // namespace SG
@@ -38,9 +38,10 @@ void write_vtu_file(const System *sys, const std::string &file_name) {
     auto vtk_points = vtkSmartPointer<vtkPoints>::New();
     using particle_id_t = size_t;
     std::unordered_map<particle_id_t, vtkIdType> particle_id_to_vtk_id_map;
-    for (const auto &particle : sys->all.particles) {
-        const auto &pos = particle.pos;
-        particle_id_to_vtk_id_map[particle.id] =
+    const auto &particles = sys->all;
+    for (size_t index = 0; index < particles.size(); ++index) {
+        const auto &pos = particles.positions[index];
+        particle_id_to_vtk_id_map[particles.ids[index]] =
                 vtk_points->InsertNextPoint(pos[0], pos[1], pos[2]);
     }
     ugrid->SetPoints(vtk_points);
@@ -77,8 +78,8 @@ void write_vtu_file(const System *sys, const std::string &file_name) {
         for (const auto &bond : unique_bonds) {
             // add end-to-end distance between particles
             const auto ete_distance = ArrayUtilities::distance(
-                    sys->all.binary_find(bond->id_a)->pos,
-                    sys->all.binary_find(bond->id_b)->pos);
+                    particles.positions[particles.find_index(bond->id_a)],
+                    particles.positions[particles.find_index(bond->id_b)]);
             ete_distance_array->SetTuple1(cell_ids[cell_id_index], ete_distance);
             // dynamically add extra quantities (depending on bond type)
             bond->append_to_vtu(ugrid, cell_ids[cell_id_index]);
@@ -121,17 +122,18 @@ void write_vtu_file(const System *sys, const std::string &file_name) {
     particle_id->SetNumberOfComponents(1);
     particle_id->SetNumberOfTuples(number_of_points);
 
-    size_t counter = 0;
-    for (const auto &particle : sys->all.particles) {
-        acc->SetTuple3(counter, particle.dynamics.acc[0],
-                       particle.dynamics.acc[1], particle.dynamics.acc[2]);
-        vel->SetTuple3(counter, particle.dynamics.vel[0],
-                       particle.dynamics.vel[1], particle.dynamics.vel[2]);
-        mass->SetTuple1(counter, particle.material.mass);
-        radius->SetTuple1(counter, particle.material.radius);
-        volume->SetTuple1(counter, particle.material.volume);
-        particle_id->SetTuple1(counter, particle.id);
-        counter++;
+    for (size_t index = 0; index < particles.size(); ++index) {
+        const auto &particle_acc = particles.accelerations[index];
+        const auto &particle_vel = particles.velocities[index];
+        const auto &material = particles.materials[index];
+        acc->SetTuple3(index, particle_acc[0], particle_acc[1],
+                       particle_acc[2]);
+        vel->SetTuple3(index, particle_vel[0], particle_vel[1],
+                       particle_vel[2]);
+        mass->SetTuple1(index, material.mass);
+        radius->SetTuple1(index, material.radius);
+        volume->SetTuple1(index, material.volume);
+        particle_id->SetTuple1(index, particles.ids[index]);
     }
     point_data->AddArray(acc);
     point_data->AddArray(vel);
@@ -158,7 +160,7 @@ std::shared_ptr<System> read_vtu_file(const std::string &file_name) {
     const auto npoints = static_cast<size_t>(ugrid->GetNumberOfPoints()); // particles
     const auto ncells = ugrid->GetNumberOfCells();   // bonds
 
-    auto &particles = sys->all.particles;
+    auto &particles = sys->all;
     auto &bonds = sys->bonds.bonds;
     auto &conexions = sys->conexions;
     particles.resize(npoints);
@@ -173,7 +175,7 @@ std::shared_ptr<System> read_vtu_file(const std::string &file_name) {
 }
 void read_vtu_point_data(vtkUnstructuredGrid *ugrid, System *sys) {
     const auto npoints = static_cast<size_t>(ugrid->GetNumberOfPoints()); // particles
-    auto &particles = sys->all.particles;
+    auto &particles = sys->all;
     if (particles.size() != npoints) {
         particles.resize(npoints);
     }
@@ -189,37 +191,38 @@ void read_vtu_point_data(vtkUnstructuredGrid *ugrid, System *sys) {
 
     for (size_t i = 0; i < npoints; i++) {
         // pos (always there)
-        memcpy(particles[i].pos.data(), ugrid->GetPoint(i), sizeof(double) * 3);
+        memcpy(particles.positions[i].data(), ugrid->GetPoint(i),
+               sizeof(double) * 3);
 
         // particle_id
         if (particle_id_array != nullptr) {
-            particles[i].id = particle_id_array->GetTuple1(i);
+            particles.ids[i] = particle_id_array->GetTuple1(i);
         } else {
-            particles[i].id = i;
+            particles.ids[i] = i;
         }
         if (acc_array != nullptr) {
-            memcpy(particles[i].dynamics.acc.data(), acc_array->GetTuple3(i),
+            memcpy(particles.accelerations[i].data(), acc_array->GetTuple3(i),
                    sizeof(double) * 3);
         }
         if (vel_array != nullptr) {
-            memcpy(particles[i].dynamics.vel.data(), vel_array->GetTuple3(i),
+            memcpy(particles.velocities[i].data(), vel_array->GetTuple3(i),
                    sizeof(double) * 3);
         }
         if (mass_array != nullptr) {
-            particles[i].material.mass = mass_array->GetTuple1(i);
+            particles.materials[i].mass = mass_array->GetTuple1(i);
         }
         if (volume_array != nullptr) {
-            particles[i].material.volume = volume_array->GetTuple1(i);
+            particles.materials[i].volume = volume_array->GetTuple1(i);
         }
         if (radius_array != nullptr) {
-            particles[i].material.radius = radius_array->GetTuple1(i);
+            particles.materials[i].radius = radius_array->GetTuple1(i);
         }
     }
 }
 
 void read_vtu_bond_ids(vtkUnstructuredGrid *ugrid, System *sys) {
     const auto ncells = static_cast<size_t>(ugrid->GetNumberOfCells()); // bonds
-    auto &particles = sys->all.particles;
+    const auto &ids = sys->all.ids;
     auto &bonds = sys->bonds.bonds;
     // Populate bonds ids from Cell points
     auto line_cell = vtkSmartPointer<vtkLine>::New();
@@ -236,8 +239,7 @@ void read_vtu_bond_ids(vtkUnstructuredGrid *ugrid, System *sys) {
         auto line_id_a = cell_point_ids->GetId(0);
         auto line_id_b = cell_point_ids->GetId(1);
         // Create bond (Base class) with this info
-        bonds[i] = std::make_shared<Bond>(particles[line_id_a].id,
-                                          particles[line_id_b].id);
+        bonds[i] = std::make_shared<Bond>(ids[line_id_a], ids[line_id_b]);
     }
 }
 
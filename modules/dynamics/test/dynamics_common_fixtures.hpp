@@ -52,23 +52,23 @@ struct System4Fixture : public System {
         // for testing purposes start the id_counter on 10.
         ParticleConsecutiveId::id_counter = 10;
         for (size_t i = 0; i < nparticles; i++) {
-            all.particles.emplace_back(ParticleConsecutiveId());
+            all.push_back(ParticleConsecutiveId());
         }
-        all.particles[0].pos = {0, 0, 0};
-        all.particles[1].pos = {1, 0, 0};
-        all.particles[2].pos = {2, 0, 0};
-        all.particles[3].pos = {1, 1, 0};
+        all.positions[0] = {0, 0, 0};
+        all.positions[1] = {1, 0, 0};
+        all.positions[2] = {2, 0, 0};
+        all.positions[3] = {1, 1, 0};
         conexions.emplace_back(ParticleNeighbors(
-                all.particles[0].id, {all.particles[1].id} // neighbor ids
+                all.ids[0], {all.ids[1]} // neighbor ids
                 ));
         conexions.emplace_back(ParticleNeighbors(
-                all.particles[1].id, {all.particles[0].id, all.particles[2].id,
-                                      all.particles[3].id} // neighbor ids
+                all.ids[1], {all.ids[0], all.ids[2],
+                                      all.ids[3]} // neighbor ids
                 ));
         conexions.emplace_back(
-                ParticleNeighbors(all.particles[2].id, {all.particles[1].id}));
+                ParticleNeighbors(all.ids[2], {all.ids[1]}));
         conexions.emplace_back(
-                ParticleNeighbors(all.particles[3].id, {all.particles[1].id}));
+                ParticleNeighbors(all.ids[3], {all.ids[1]}));
         all.sort();
         this->bonds =
                 SG::make_unique_bonds_from_system_conexions<SG::BondChain>(
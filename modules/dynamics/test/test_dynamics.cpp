@@ -35,9 +35,9 @@ struct ParticleCollection_Fixture : public ::testing::Test {
         // c id is the smallest so far, even though the position is greater
         c.id = 2;
         c.pos = {{100, 100, 100}};
-        collection.particles.emplace_back(b);
-        collection.particles.emplace_back(a);
-        collection.particles.emplace_back(c);
+        collection.push_back(b);
+        collection.push_back(a);
+        collection.push_back(c);
     }
 };
 
@@ -48,21 +48,36 @@ TEST_F(ParticleCollection_Fixture, ParticleCollection) {
     std::cout << "--COLLECTION AFTER SORT--" << std::endl;
     SG::print_id_pos(collection, std::cout);
 
-    auto it = collection.binary_find(a.id);
-    EXPECT_EQ((*it).id, a.id);
-    auto index = std::distance(std::begin(collection.particles), it);
+    auto index = collection.find_index(a.id);
     EXPECT_EQ(index, 1);
+    EXPECT_EQ(collection.ids[index], a.id);
+    EXPECT_EQ(collection.positions[index], a.pos);
 
-    it = collection.binary_find(b.id);
-    EXPECT_EQ((*it).id, b.id);
-    index = std::distance(std::begin(collection.particles), it);
+    index = collection.find_index(b.id);
     EXPECT_EQ(index, 2);
-    std::cout << "binary_find(" << b.id << ") result: " << (*it).id
-              << std::endl;
-    std::cout << "Found at index: " << index << std::endl;
+    EXPECT_EQ(collection.ids[index], b.id);
+    std::cout << "find_index(" << b.id << ") result: " << index << std::endl;
 
-    it = collection.binary_find(c.id);
-    EXPECT_EQ((*it).id, c.id);
-    index = std::distance(std::begin(collection.particles), it);
+    index = collection.find_index(c.id);
     EXPECT_EQ(index, 0);
+    EXPECT_EQ(collection.get_particle(index).pos, c.pos);
+
+    EXPECT_EQ(collection.find_index(100),
+              std::numeric_limits<size_t>::max());
+}
+
+TEST_F(ParticleCollection_Fixture, find_index_throws_if_not_sorted) {
+    EXPECT_FALSE(collection.sorted);
+    EXPECT_THROW(collection.find_index(a.id), std::runtime_error);
+}
+
+TEST_F(ParticleCollection_Fixture, sort_keeps_the_arrays_together) {
+    collection.velocities[0] = {6, 6, 6}; // b
+    collection.materials[0].mass = 6.0;
+    collection.sort();
+    const auto index = collection.find_index(b.id);
+    EXPECT_EQ(collection.positions[index], b.pos);
+    EXPECT_EQ(collection.velocities[index], (ArrayUtilities::Array3D{6, 6, 6}));
+    EXPECT_EQ(collection.materials[index].mass, 6.0);
+    EXPECT_EQ(collection.get_particles().size(), collection.size());
 }
@@ -0,0 +1,201 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+#include "dynamics_common_fixtures.hpp"
+#include "force_compute.hpp"
+#include "force_functions.hpp"
+#include "gmock/gmock.h"
+
+TEST(ForceCompute, ParticleBatchForceCompute) {
+    auto sys = std::make_shared<SG::System4Fixture>();
+    auto per_particle = SG::ParticleForceCompute(
+            sys.get(), [](const SG::Particle &p) { return p.pos; });
+    auto batch = SG::ParticleBatchForceCompute(
+            sys.get(), [](const SG::ParticleCollection &all,
+                          std::vector<SG::ParticleForce> &particle_forces) {
+                for (size_t i = 0; i < all.size(); ++i) {
+                    particle_forces[i].force = all.positions[i];
+                }
+            });
+    per_particle.compute();
+    batch.compute();
+    EXPECT_EQ(batch.get_type(), "ParticleBatchForceCompute");
+    ASSERT_EQ(batch.particle_forces.size(), per_particle.particle_forces.size());
+    for (size_t i = 0; i < batch.particle_forces.size(); ++i) {
+        EXPECT_EQ(batch.particle_forces[i].particle_id,
+                  per_particle.particle_forces[i].particle_id);
+        EXPECT_EQ(batch.particle_forces[i].force,
+                  per_particle.particle_forces[i].force);
+    }
+}
+
+TEST(ForceCompute, PairBondBatchForce) {
+    auto sys = std::make_shared<SG::System4Fixture>();
+    const auto spring = [](const SG::Particle &a, const SG::Particle &b) {
+        return ArrayUtilities::minus(b.pos, a.pos);
+    };
+    auto per_bond = SG::PairBondForce(
+            sys.get(), [&spring](const SG::Particle &a, const SG::Particle &b,
+                                 const SG::Bond &) { return spring(a, b); });
+    auto batch = SG::PairBondBatchForce(
+            sys.get(),
+            [&spring](const SG::ParticleCollection &all,
+                      const std::vector<size_t> &particle_a_indices,
+                      const std::vector<size_t> &particle_b_indices,
+                      std::vector<SG::BondForce> &bond_forces) {
+                for (size_t i = 0; i < bond_forces.size(); ++i) {
+                    bond_forces[i].force =
+                            spring(all.get_particle(particle_a_indices[i]),
+                                   all.get_particle(particle_b_indices[i]));
+                }
+            });
+    per_bond.compute();
+    batch.compute();
+    EXPECT_EQ(batch.get_type(), "PairBondBatchForce");
+    ASSERT_EQ(batch.bond_forces.size(), per_bond.bond_forces.size());
+    EXPECT_EQ(batch.particle_a_indices.size(), batch.bond_forces.size());
+    for (size_t i = 0; i < batch.bond_forces.size(); ++i) {
+        EXPECT_EQ(batch.bond_forces[i].force, per_bond.bond_forces[i].force);
+    }
+    for (size_t i = 0; i < batch.particle_forces.size(); ++i) {
+        EXPECT_EQ(batch.particle_forces[i].force,
+                  per_bond.particle_forces[i].force);
+    }
+
+    auto no_function = SG::PairBondBatchForce(sys.get());
+    EXPECT_THROW(no_function.compute(), std::runtime_error);
+}
+
+TEST(ForceCompute, PairBondForceIndices) {
+    auto sys = std::make_shared<SG::System4Fixture>();
+    const auto spring = [](const SG::Particle &a, const SG::Particle &b,
+                           const SG::Bond &) {
+        return ArrayUtilities::minus(b.pos, a.pos);
+    };
+    auto serial = SG::PairBondForce(sys.get(), spring);
+    auto parallel = SG::PairBondForce(sys.get(), spring);
+    parallel.num_threads = 4;
+    EXPECT_FALSE(serial.bond_particle_indices_are_valid());
+    serial.compute();
+    parallel.compute();
+    EXPECT_TRUE(serial.bond_particle_indices_are_valid());
+    ASSERT_EQ(serial.particle_a_indices.size(), serial.bond_forces.size());
+    for (size_t i = 0; i < serial.bond_forces.size(); ++i) {
+        const auto &bond = *serial.bond_forces[i].bond;
+        EXPECT_EQ(sys->all.ids[serial.particle_a_indices[i]], bond.id_a);
+        EXPECT_EQ(sys->all.ids[serial.particle_b_indices[i]], bond.id_b);
+        EXPECT_EQ(parallel.bond_forces[i].force, serial.bond_forces[i].force);
+    }
+    for (size_t i = 0; i < serial.particle_forces.size(); ++i) {
+        EXPECT_EQ(parallel.particle_forces[i].force,
+                  serial.particle_forces[i].force);
+    }
+
+    // Stale indices are resolved again in compute
+    const auto expected_particle_forces = serial.particle_forces;
+    std::swap(serial.particle_a_indices[0], serial.particle_b_indices[0]);
+    EXPECT_FALSE(serial.bond_particle_indices_are_valid());
+    serial.compute();
+    EXPECT_TRUE(serial.bond_particle_indices_are_valid());
+    for (size_t i = 0; i < serial.particle_forces.size(); ++i) {
+        EXPECT_EQ(serial.particle_forces[i].force,
+                  expected_particle_forces[i].force);
+    }
+}
+
+TEST(ForceCompute, IndexedForceFunctions) {
+    auto sys = std::make_shared<SG::System4Fixture>();
+    auto per_particle = SG::ParticleForceCompute(
+            sys.get(), [](const SG::Particle &p) { return p.pos; });
+    auto indexed_particle = SG::ParticleForceCompute(
+            sys.get(),
+            [](const SG::ParticleCollection &all, const size_t &index) {
+                return all.positions[index];
+            });
+    per_particle.compute();
+    indexed_particle.compute();
+    for (size_t i = 0; i < per_particle.particle_forces.size(); ++i) {
+        EXPECT_EQ(indexed_particle.particle_forces[i].force,
+                  per_particle.particle_forces[i].force);
+    }
+
+    auto per_bond = SG::PairBondForce(
+            sys.get(), [](const SG::Particle &a, const SG::Particle &b,
+                          const SG::Bond &) {
+                return ArrayUtilities::minus(b.pos, a.pos);
+            });
+    auto indexed_bond = SG::PairBondForce(
+            sys.get(), [](const SG::ParticleCollection &all,
+                          const size_t &a_index, const size_t &b_index,
+                          const SG::Bond &) {
+                return ArrayUtilities::minus(all.positions[b_index],
+                                             all.positions[a_index]);
+            });
+    per_bond.compute();
+    indexed_bond.compute();
+    ASSERT_EQ(indexed_bond.bond_forces.size(), per_bond.bond_forces.size());
+    for (size_t i = 0; i < per_bond.bond_forces.size(); ++i) {
+        EXPECT_EQ(indexed_bond.bond_forces[i].force,
+                  per_bond.bond_forces[i].force);
+    }
+    for (size_t i = 0; i < per_bond.particle_forces.size(); ++i) {
+        EXPECT_EQ(indexed_bond.particle_forces[i].force,
+                  per_bond.particle_forces[i].force);
+    }
+}
+
+TEST(ForceCompute, PairBondForceWLCPetrosyan) {
+    auto sys = std::make_shared<SG::System4Fixture>();
+    double length_contour = 1.5;
+    for (auto &bond : sys->bonds.bonds) {
+        auto chain = std::dynamic_pointer_cast<SG::BondChain>(bond);
+        chain->length_contour = length_contour;
+        chain->properties =
+                std::make_shared<SG::BondPropertiesPhysical>(1.0, 2.0);
+        length_contour += 0.25;
+    }
+    sys->all.positions[3] = {1.5, 1.2, 0.3};
+    auto per_bond =
+            SG::PairBondForce(sys.get(), SG::force_function_wlc_petrosyan);
+    auto compiled = SG::PairBondForceWLCPetrosyan(sys.get());
+    compiled.num_threads = 4;
+    per_bond.compute();
+    compiled.compute();
+    EXPECT_EQ(compiled.get_type(), "PairBondForceWLCPetrosyan");
+    ASSERT_EQ(compiled.compiled_bonds.size(), per_bond.bond_forces.size());
+    for (size_t i = 0; i < per_bond.bond_forces.size(); ++i) {
+        EXPECT_EQ(compiled.bond_forces[i].force, per_bond.bond_forces[i].force);
+    }
+    for (size_t i = 0; i < per_bond.particle_forces.size(); ++i) {
+        EXPECT_EQ(compiled.particle_forces[i].force,
+                  per_bond.particle_forces[i].force);
+    }
+
+    // Changed parameters are used after compile_bonds
+    auto chain = std::dynamic_pointer_cast<SG::BondChain>(sys->bonds.bonds[0]);
+    chain->length_contour = 3.0;
+    per_bond.compute();
+    compiled.compile_bonds();
+    compiled.compute();
+    EXPECT_EQ(compiled.bond_forces[0].force, per_bond.bond_forces[0].force);
+
+    chain->properties = std::make_shared<SG::BondProperties>();
+    EXPECT_THROW(compiled.compile_bonds(), std::runtime_error);
+}
@@ -23,10 +23,11 @@
 #include "force_compute.hpp"
 #include "force_functions.hpp"
 #include "integrator.hpp"
-// #include "rng.hpp" // to fix a seed of rng
+#include "rng.hpp" // to fix a seed of rng
 #include "unbonded_forces.hpp"
 #include "write_vtu_file.hpp"
 #include <fstream>
+#include <sstream>
 
 struct IntegratorPairBondForce_Fixture : public ::testing::Test {
     std::shared_ptr<SG::System> sys = std::static_pointer_cast<SG::System>(
@@ -65,7 +66,7 @@ struct IntegratorPairBondForce_Fixture : public ::testing::Test {
 
 TEST_F(IntegratorPairBondForce_Fixture, IntegratorWorks) {
     // Check System for sanity
-    EXPECT_EQ(sys->all.particles.size(), 4);
+    EXPECT_EQ(sys->all.size(), 4);
     EXPECT_EQ(sys->conexions.size(), 4);
     std::cout << "IntegratorPairBondForce_Fixture: IntegratorWorks"
               << std::endl;
@@ -336,3 +337,179 @@ TEST_F(IntegratorPairBondForce_Fixture, ParticleRandomForceCompute) {
     integrator.update(0);
 }
 
+
+TEST_F(IntegratorPairBondForce_Fixture, FusedStepTwoMatchesSeparatePasses) {
+    const auto spring = [](const SG::Particle &p) {
+        return ArrayUtilities::product_scalar(p.pos, -1.0);
+    };
+    const auto drag = [](const SG::Particle &p) {
+        return ArrayUtilities::product_scalar(p.dynamics.vel, -0.5);
+    };
+    integrator.add_force(
+            std::make_shared<SG::ParticleForceCompute>(sys.get(), spring));
+    integrator.add_force(
+            std::make_shared<SG::ParticleForceCompute>(sys.get(), drag));
+    // Reference: integrate with separate passes over the particles.
+    auto sys_reference = std::make_shared<SG::System>(*sys);
+    SG::IntegratorTwoStep reference(sys_reference.get());
+    reference.add_force(std::make_shared<SG::ParticleForceCompute>(
+            sys_reference.get(), spring));
+    reference.add_force(std::make_shared<SG::ParticleForceCompute>(
+            sys_reference.get(), drag));
+    SG::VerletVelocitiesIntegratorMethod method_reference(
+            sys_reference.get(), deltaT);
+    for (unsigned int time_step = 0; time_step < 5; ++time_step) {
+        method_reference.integrateStepOne();
+        for (auto &force_type : reference.force_types) {
+            force_type->compute();
+        }
+        reference.compute_net_forces(sys_reference.get());
+        method_reference.integrateStepTwo();
+
+        integrator.update(time_step);
+        EXPECT_EQ(sys->all.positions, sys_reference->all.positions);
+        EXPECT_EQ(sys->all.velocities, sys_reference->all.velocities);
+        EXPECT_EQ(sys->all.accelerations, sys_reference->all.accelerations);
+        EXPECT_EQ(sys->all.net_forces, sys_reference->all.net_forces);
+    }
+}
+
+namespace {
+/** Add a constant force to the net force of every particle. */
+struct IntegratorTwoStepConstantForce : public SG::IntegratorTwoStep {
+    using SG::IntegratorTwoStep::IntegratorTwoStep;
+    ArrayUtilities::Array3D constant_force = {0.0, 0.0, 0.0};
+    mutable size_t calls = 0;
+    bool fuse_net_forces() const override { return false; }
+    void compute_net_forces(SG::System *sys) const override {
+        ++calls;
+        SG::IntegratorTwoStep::compute_net_forces(sys);
+        for (auto &net_force : sys->all.net_forces) {
+            net_force = ArrayUtilities::plus(net_force, constant_force);
+        }
+    }
+};
+} // namespace
+
+TEST_F(IntegratorPairBondForce_Fixture, UpdateCallsOverriddenComputeNetForces) {
+    const auto spring = [](const SG::Particle &p) {
+        return ArrayUtilities::product_scalar(p.pos, -1.0);
+    };
+    auto sys_derived = std::make_shared<SG::System>(*sys);
+    IntegratorTwoStepConstantForce derived(sys_derived.get());
+    derived.integrator_method =
+            std::make_shared<SG::VerletVelocitiesIntegratorMethod>(
+                    sys_derived.get(), deltaT);
+    derived.add_force(std::make_shared<SG::ParticleForceCompute>(
+            sys_derived.get(), spring));
+    derived.constant_force = {0.0, 0.0, 1.0};
+    integrator.add_force(
+            std::make_shared<SG::ParticleForceCompute>(sys.get(), spring));
+    // All the particles start at z = 0, the spring has no z component yet.
+    derived.update(0);
+    integrator.update(0);
+    EXPECT_EQ(derived.calls, 1);
+    for (size_t i = 0; i < sys->all.size(); ++i) {
+        EXPECT_EQ(sys_derived->all.net_forces[i][2], 1.0);
+        EXPECT_EQ(sys->all.net_forces[i][2], 0.0);
+    }
+    derived.update(1);
+    integrator.update(1);
+    EXPECT_EQ(derived.calls, 2);
+    for (size_t i = 0; i < sys->all.size(); ++i) {
+        EXPECT_GT(sys_derived->all.positions[i][2], 0.0);
+        EXPECT_EQ(sys->all.positions[i][2], 0.0);
+    }
+}
+
+TEST(Integrator, ParallelUpdateMatchesSerial) {
+    // Enough particles to split the integration in several ranges.
+    const size_t nparts = 10000;
+    auto sys_serial = std::make_shared<SG::System>();
+    for (size_t i = 0; i < nparts; ++i) {
+        SG::Particle p;
+        p.id = i;
+        p.pos = {0.001 * i, 1.0 - 0.002 * i, 0.5};
+        p.dynamics.vel = {0.0, 0.1, -0.1};
+        p.material.mass = 1.0 + 0.01 * (i % 7);
+        sys_serial->all.push_back(p);
+    }
+    auto sys_parallel = std::make_shared<SG::System>(*sys_serial);
+    const auto spring = [](const SG::Particle &p) {
+        return ArrayUtilities::product_scalar(p.pos, -1.0);
+    };
+    const auto drag = [](const SG::Particle &p) {
+        return ArrayUtilities::product_scalar(p.dynamics.vel, -0.5);
+    };
+    const double deltaT = 0.1;
+    SG::IntegratorTwoStep serial(sys_serial.get());
+    serial.integrator_method =
+            std::make_shared<SG::VerletVelocitiesIntegratorMethod>(
+                    sys_serial.get(), deltaT);
+    serial.add_force(
+            std::make_shared<SG::ParticleForceCompute>(sys_serial.get(), spring));
+    serial.add_force(
+            std::make_shared<SG::ParticleForceCompute>(sys_serial.get(), drag));
+    SG::IntegratorTwoStep parallel(sys_parallel.get());
+    parallel.integrator_method =
+            std::make_shared<SG::VerletVelocitiesIntegratorMethod>(
+                    sys_parallel.get(), deltaT);
+    parallel.add_force(std::make_shared<SG::ParticleForceCompute>(
+            sys_parallel.get(), spring));
+    parallel.add_force(
+            std::make_shared<SG::ParticleForceCompute>(sys_parallel.get(), drag));
+    parallel.num_threads = 4;
+    parallel.integrator_method->num_threads = 4;
+
+    for (unsigned int time_step = 0; time_step < 5; ++time_step) {
+        serial.update(time_step);
+        parallel.update(time_step);
+    }
+    EXPECT_EQ(sys_parallel->all.positions, sys_serial->all.positions);
+    EXPECT_EQ(sys_parallel->all.velocities, sys_serial->all.velocities);
+    EXPECT_EQ(sys_parallel->all.net_forces, sys_serial->all.net_forces);
+    std::stringstream ss;
+    parallel.print_forces(ss);
+    EXPECT_FALSE(ss.str().empty());
+}
+
+TEST_F(IntegratorPairBondForce_Fixture,
+       RandomForcesDoNotDependOnNumThreads) {
+    const auto spring = [](const SG::Particle &p) {
+        return ArrayUtilities::product_scalar(p.pos, -1.0);
+    };
+    const auto run = [&](const size_t &num_threads) {
+        auto sys_run = std::make_shared<SG::System>(*sys);
+        SG::IntegratorTwoStep run_integrator(sys_run.get());
+        run_integrator.integrator_method =
+                std::make_shared<SG::VerletVelocitiesIntegratorMethod>(
+                        sys_run.get(), deltaT);
+        run_integrator.add_force(
+                std::make_shared<SG::ParticleRandomForceCompute>(
+                        sys_run.get(), 0.01, 1.0, deltaT));
+        run_integrator.add_force(std::make_shared<SG::ParticleForceCompute>(
+                sys_run.get(), spring));
+        run_integrator.add_force(
+                std::make_shared<SG::ParticleRandomForceCompute>(
+                        sys_run.get(), 0.02, 1.0, deltaT));
+        run_integrator.num_threads = num_threads;
+        RNG::engine().seed(42);
+        run_integrator.update(0);
+        // The force computes are seeded in the first update, then the
+        // engine of this thread is not used anymore.
+        const auto engine_after_seeding = RNG::engine();
+        for (unsigned int time_step = 1; time_step < 5; ++time_step) {
+            run_integrator.update(time_step);
+        }
+        EXPECT_TRUE(RNG::engine() == engine_after_seeding);
+        const auto next_random = RNG::engine()();
+        return std::make_pair(sys_run, next_random);
+    };
+    const auto serial = run(1);
+    const auto parallel = run(3);
+    EXPECT_EQ(serial.first->all.positions, parallel.first->all.positions);
+    EXPECT_EQ(serial.first->all.velocities, parallel.first->all.velocities);
+    EXPECT_EQ(serial.first->all.net_forces, parallel.first->all.net_forces);
+    EXPECT_NE(serial.first->all.positions, sys->all.positions);
+    EXPECT_EQ(serial.second, parallel.second);
+}
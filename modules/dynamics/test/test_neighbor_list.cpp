@@ -0,0 +1,173 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+#include "dynamics_common_fixtures.hpp"
+#include "force_compute.hpp"
+#include "neighbor_list.hpp"
+#include "gmock/gmock.h"
+
+#include <random>
+#include <set>
+
+namespace {
+SG::ParticleCollection random_particles(const size_t &nparts,
+                                        const double &box_side) {
+    std::mt19937 engine(0);
+    std::uniform_real_distribution<double> dist(0.0, box_side);
+    SG::ParticleCollection collection;
+    for (size_t i = 0; i < nparts; ++i) {
+        SG::Particle particle;
+        particle.id = i;
+        particle.pos = {dist(engine), dist(engine), dist(engine)};
+        collection.push_back(particle);
+    }
+    collection.sorted = true;
+    return collection;
+}
+
+using Pairs = std::set<std::pair<size_t, size_t>>;
+Pairs list_pairs(const SG::NeighborList &neighbor_list) {
+    Pairs pairs;
+    const auto &offsets = neighbor_list.neighbor_offsets;
+    for (size_t i = 0; i + 1 < offsets.size(); ++i) {
+        for (size_t k = offsets[i]; k < offsets[i + 1]; ++k) {
+            EXPECT_LT(i, neighbor_list.neighbors[k]);
+            pairs.emplace(i, neighbor_list.neighbors[k]);
+        }
+    }
+    return pairs;
+}
+
+Pairs brute_force_pairs(const SG::NeighborList &neighbor_list,
+                        const SG::ParticleCollection &collection,
+                        const double &radius) {
+    Pairs pairs;
+    const auto &positions = collection.positions;
+    for (size_t i = 0; i < positions.size(); ++i) {
+        for (size_t j = i + 1; j < positions.size(); ++j) {
+            if (ArrayUtilities::norm(neighbor_list.minus(
+                        positions[i], positions[j])) < radius) {
+                pairs.emplace(i, j);
+            }
+        }
+    }
+    return pairs;
+}
+} // namespace
+
+TEST(NeighborList, MatchesBruteForce) {
+    const auto collection = random_particles(500, 10.0);
+    SG::NeighborList neighbor_list(1.0, 0.3);
+    EXPECT_TRUE(neighbor_list.update(collection));
+    EXPECT_EQ(list_pairs(neighbor_list),
+              brute_force_pairs(neighbor_list, collection, 1.3));
+    EXPECT_FALSE(neighbor_list.update(collection));
+    EXPECT_EQ(neighbor_list.number_of_builds, 1);
+}
+
+TEST(NeighborList, Periodic) {
+    for (const double box_side : {10.0, 4.0}) {
+        const auto collection = random_particles(300, box_side);
+        SG::NeighborList neighbor_list(1.5, 0.3);
+        neighbor_list.boundary_condition =
+                ArrayUtilities::boundary_condition::PERIODIC;
+        neighbor_list.box_size = {box_side, box_side, box_side};
+        neighbor_list.build(collection);
+        EXPECT_EQ(list_pairs(neighbor_list),
+                  brute_force_pairs(neighbor_list, collection, 1.8));
+    }
+    SG::NeighborList too_large(1.5, 0.3);
+    too_large.boundary_condition = ArrayUtilities::boundary_condition::PERIODIC;
+    too_large.box_size = {3.0, 3.0, 3.0};
+    EXPECT_THROW(too_large.build(random_particles(10, 3.0)),
+                 std::runtime_error);
+}
+
+TEST(NeighborList, RebuildAfterHalfSkin) {
+    auto collection = random_particles(100, 5.0);
+    SG::NeighborList neighbor_list(1.0, 0.4);
+    neighbor_list.build(collection);
+    collection.positions[0][0] += 0.15;
+    EXPECT_FALSE(neighbor_list.needs_rebuild(collection));
+    collection.positions[0][0] += 0.1;
+    EXPECT_TRUE(neighbor_list.needs_rebuild(collection));
+    neighbor_list.cutoff = 1.1;
+    neighbor_list.build(collection);
+    EXPECT_FALSE(neighbor_list.needs_rebuild(collection));
+    neighbor_list.skin = 0.5;
+    EXPECT_TRUE(neighbor_list.needs_rebuild(collection));
+}
+
+TEST(NeighborList, make_particle_neighbors) {
+    SG::System4Fixture sys;
+    SG::NeighborList neighbor_list(1.1, 0.0);
+    neighbor_list.build(sys.all);
+    const auto particle_neighbors =
+            SG::make_particle_neighbors(neighbor_list, sys.all);
+    ASSERT_EQ(particle_neighbors.size(), 4);
+    // Same as conexions: 1 is the center of the star.
+    for (size_t i = 0; i < 4; ++i) {
+        auto neighbors = particle_neighbors[i].neighbors;
+        auto expected = sys.conexions[i].neighbors;
+        std::sort(neighbors.begin(), neighbors.end());
+        std::sort(expected.begin(), expected.end());
+        EXPECT_EQ(particle_neighbors[i].particle_id, sys.all.ids[i]);
+        EXPECT_EQ(neighbors, expected);
+    }
+}
+
+TEST(ExcludedVolumeForce, TwoParticles) {
+    SG::System sys;
+    sys.all.resize(2);
+    sys.all.ids[0] = 0;
+    sys.all.positions[0] = {0, 0, 0};
+    sys.all.ids[1] = 1;
+    sys.all.positions[1] = {1.5, 0, 0};
+    sys.all.sorted = true;
+    SG::ExcludedVolumeForce force(&sys, 1.0);
+    force.compute();
+    EXPECT_EQ(force.get_type(), "ExcludedVolumeForce");
+    EXPECT_DOUBLE_EQ(force.neighbor_list.cutoff, 2.0);
+    // 2 * stiffness / sigma * (1 - r / sigma)
+    EXPECT_DOUBLE_EQ(force.particle_forces[0].force[0], -0.25);
+    EXPECT_DOUBLE_EQ(force.particle_forces[1].force[0], 0.25);
+
+    sys.all.positions[1] = {2.5, 0, 0};
+    force.compute();
+    EXPECT_EQ(force.particle_forces[0].force, ArrayUtilities::Array3D());
+    EXPECT_EQ(force.particle_forces[1].force, ArrayUtilities::Array3D());
+}
+
+TEST(ExcludedVolumeForce, ExcludeBonded) {
+    // Default radius is 1, all the particles overlap.
+    SG::System4Fixture sys;
+    SG::ExcludedVolumeForce force(&sys, 1.0);
+    force.compute();
+    // Particle 1 is bonded to all the others.
+    EXPECT_EQ(force.particle_forces[1].force, ArrayUtilities::Array3D());
+    // 0 and 2 are at distance 2, the sum of radii, only 3 pushes them.
+    EXPECT_LT(force.particle_forces[0].force[0], 0.0);
+    EXPECT_LT(force.particle_forces[0].force[1], 0.0);
+    EXPECT_GT(force.particle_forces[3].force[1], 0.0);
+
+    force.exclude_bonded = false;
+    force.compute();
+    EXPECT_NE(force.particle_forces[1].force, ArrayUtilities::Array3D());
+}
@@ -60,7 +60,7 @@ TEST_F(ParticleGraphGlueData_Fixture, works) {
     std::cout << "ParticleGraphGlueData_Fixture: works" << std::endl;
     auto particle_graph_data = SG::particles_from_graph(graph0);
 
-    EXPECT_EQ(std::size(particle_graph_data.particle_collection.particles), 4);
+    EXPECT_EQ(particle_graph_data.particle_collection.size(), 4);
     EXPECT_EQ(std::size(*(particle_graph_data.particle_graph_map)), 4);
     EXPECT_EQ(std::size(particle_graph_data.connected_list[0].neighbors), 1);
     EXPECT_EQ(std::size(particle_graph_data.connected_list[1].neighbors), 3);
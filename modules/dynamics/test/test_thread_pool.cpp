@@ -0,0 +1,100 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+#include "thread_pool.hpp"
+#include "gmock/gmock.h"
+
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+
+using namespace ::testing;
+
+TEST(ThreadPool, EveryItemOnce) {
+    SG::ThreadPool pool;
+    const size_t size = 1000;
+    std::vector<int> visits(size, 0);
+    for (int call = 0; call < 10; ++call) {
+        pool.parallel_for_chunks(size, 4,
+                                 [&](const size_t &begin, const size_t &end) {
+                                     for (size_t i = begin; i < end; ++i) {
+                                         ++visits[i];
+                                     }
+                                 });
+    }
+    EXPECT_THAT(visits, Each(10));
+    // The workers are started once and reused.
+    EXPECT_EQ(pool.num_workers(), 3);
+}
+
+TEST(ThreadPool, OneThreadRunsInCallingThread) {
+    SG::ThreadPool pool;
+    const auto caller = std::this_thread::get_id();
+    size_t calls = 0;
+    pool.parallel_for_chunks(100, 1, [&](const size_t &begin,
+                                         const size_t &end) {
+        EXPECT_EQ(std::this_thread::get_id(), caller);
+        EXPECT_EQ(begin, 0);
+        EXPECT_EQ(end, 100);
+        ++calls;
+    });
+    EXPECT_EQ(calls, 1);
+    EXPECT_EQ(pool.num_workers(), 0);
+}
+
+TEST(ThreadPool, Nested) {
+    SG::ThreadPool pool;
+    const size_t outer = 8;
+    const size_t inner = 100;
+    std::vector<size_t> sums(outer, 0);
+    pool.parallel_for_chunks(outer, 4, [&](const size_t &begin,
+                                           const size_t &end) {
+        for (size_t o = begin; o < end; ++o) {
+            std::atomic<size_t> sum(0);
+            pool.parallel_for_chunks(
+                    inner, 4, [&](const size_t &b, const size_t &e) {
+                        for (size_t i = b; i < e; ++i) {
+                            sum += i;
+                        }
+                    });
+            sums[o] = sum;
+        }
+    });
+    EXPECT_THAT(sums, Each(inner * (inner - 1) / 2));
+}
+
+TEST(ThreadPool, RethrowsExceptions) {
+    SG::ThreadPool pool;
+    EXPECT_THROW(pool.parallel_for_chunks(
+                         100, 4,
+                         [](const size_t &begin, const size_t &) {
+                             if (begin == 0) {
+                                 throw std::runtime_error("chunk failed");
+                             }
+                         }),
+                 std::runtime_error);
+    // The pool is still usable.
+    std::atomic<size_t> count(0);
+    pool.parallel_for_chunks(100, 4, [&](const size_t &begin,
+                                         const size_t &end) {
+        count += end - begin;
+    });
+    EXPECT_EQ(count, 100);
+}
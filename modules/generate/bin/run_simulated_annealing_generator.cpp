@@ -19,6 +19,7 @@
  * *******************************************************************/
 
 #include <iostream>
+#include <random>
 // boost::program_options
 #include <boost/program_options/options_description.hpp>
 #include <boost/program_options/parsers.hpp>
@@ -26,6 +27,8 @@
 // boost::filesystem
 #include <boost/filesystem.hpp>
 
+#include "ensemble_generator.hpp"
+#include "parallel_tempering_generator.hpp"
 #include "simulated_annealing_generator.hpp"
 #include "spatial_graph_io.hpp"
 
@@ -46,6 +49,31 @@ int main(int argc, char *const argv[]) {
                            "verbose output");
     opt_desc.add_options()("default_config_file,c", po::value<std::string>(),
                            "Generate a default config file.");
+    opt_desc.add_options()(
+            "replicas,r", po::value<size_t>()->default_value(1),
+            "Number of replicas. If greater than 1, run parallel tempering "
+            "and output the graph with the lowest energy.");
+    opt_desc.add_options()(
+            "ensemble,e", po::value<size_t>()->default_value(0),
+            "Number of independent networks to generate. If greater than 0, "
+            "output a graph per seed and a summary of all of them.");
+    opt_desc.add_options()("threads,j", po::value<size_t>()->default_value(0),
+                           "Number of threads running the replicas or the "
+                           "ensemble. 0 uses all the available threads.");
+    opt_desc.add_options()("seed,s", po::value<size_t>()->default_value(0),
+                           "Seed of the replicas, or first seed of the "
+                           "ensemble. 0 uses a random seed.");
+    opt_desc.add_options()(
+            "checkpoint_file", po::value<std::string>()->default_value(""),
+            "Binary file to write periodic checkpoints of the simulation.");
+    opt_desc.add_options()(
+            "checkpoint_every", po::value<size_t>()->default_value(0),
+            "Write a checkpoint every this number of steps. 0 disables "
+            "checkpoints. Requires checkpoint_file.");
+    opt_desc.add_options()(
+            "resume", po::bool_switch()->default_value(false),
+            "Resume the simulation from checkpoint_file, instead of starting "
+            "a new one from the parameters in input.");
     opt_desc.add_options()(
             "visualize,t", po::bool_switch()->default_value(false),
             "Visualize thin result. Requires VISUALIZE option at build");
@@ -106,8 +134,86 @@ int main(int argc, char *const argv[]) {
     final_output_filename += timestr;
     final_output_filename += output_filename_extension.string();
 
+    const size_t ensemble_runs = vm["ensemble"].as<size_t>();
+    if (ensemble_runs > 0) {
+        SG::simulated_annealing_generator_config_tree tree;
+        tree.load(input_filename);
+        SG::ensemble_parameters params;
+        params.num_runs = ensemble_runs;
+        params.num_threads = vm["threads"].as<size_t>();
+        params.first_seed = vm["seed"].as<size_t>();
+        if (params.first_seed == 0) {
+            params.first_seed = std::random_device{}();
+        }
+        params.output_prefix =
+                (output_filename_parent_path /
+                 output_filename_without_extension)
+                        .string() +
+                timestr;
+        const auto result = SG::generate_ensemble(tree, params);
+        std::cout << "Generated " << result.runs.size() << " networks in "
+                  << result.time_elapsed << " s: " << result.runs_per_second()
+                  << " networks/s, " << result.steps_per_second()
+                  << " steps/s" << std::endl;
+        std::cout << "Summary: " << params.output_prefix << "_summary.tsv"
+                  << std::endl;
+        tree.save(params.output_prefix + "_parameters.json");
+        return EXIT_SUCCESS;
+    }
+
+    const size_t replicas = vm["replicas"].as<size_t>();
+    if (replicas > 1) {
+        SG::simulated_annealing_generator_config_tree tree;
+        tree.load(input_filename);
+        SG::parallel_tempering_parameters params;
+        params.num_replicas = replicas;
+        params.num_threads = vm["threads"].as<size_t>();
+        params.seed = vm["seed"].as<size_t>();
+        auto pt_gen = SG::parallel_tempering_generator(tree, params);
+        const auto result = pt_gen.engine();
+        std::cout << "Best energy: " << result.energy
+                  << " in replica: " << result.replica << std::endl;
+        for (size_t r = 0; r < result.replicas.size(); ++r) {
+            const auto &stats = result.replicas[r];
+            std::cout << "replica " << r << ": energy= " << stats.energy
+                      << " temp_current= " << stats.temp_current
+                      << " steps= " << stats.steps_performed
+                      << " exchanges_accepted= " << stats.exchanges_accepted
+                      << "/" << stats.exchanges_attempted << std::endl;
+        }
+        // The best graph is stored in a replica to reuse its print functions.
+        auto &best = pt_gen.replica(result.replica);
+        best.graph_ = result.graph;
+        best.populate_histogram_ete_distances();
+        best.populate_histogram_cosines();
+        best.transition_params.energy = result.energy;
+        std::ofstream ofile(final_output_filename, std::ios_base::app);
+        best.print(ofile);
+        best.print_histo_and_target_distribution_ete_distances(ofile);
+        best.print_histo_and_target_distribution_cosines(ofile);
+        SG::write_graphviz_sg(ofile, best.graph_);
+        std::string parameters_output_filename =
+                (output_filename_parent_path /
+                 output_filename_without_extension)
+                        .string() +
+                timestr + "_parameters.json";
+        best.save_parameters_to_file(parameters_output_filename);
+        return EXIT_SUCCESS;
+    }
+
     // Generator
+    const std::string checkpoint_file = vm["checkpoint_file"].as<std::string>();
+    const bool resume = vm["resume"].as<bool>();
+    if (resume && checkpoint_file.empty()) {
+        std::cerr << "resume requires checkpoint_file" << std::endl;
+        return EXIT_FAILURE;
+    }
     auto gen = SG::simulated_annealing_generator(input_filename);
+    if (resume) {
+        gen.load_checkpoint(checkpoint_file);
+    }
+    gen.checkpoint_file = checkpoint_file;
+    gen.checkpoint_every_steps = vm["checkpoint_every"].as<size_t>();
     if(verbose) { gen.verbose = verbose; }
     // gen.set_parameters_from_file(input_filename);
     // gen.init_graph_degree(gen.physical_scaling_params.num_vertices);
@@ -54,6 +54,12 @@ class contour_length_generator {
                             const PointType &end_point,
                             const double &k_bending,
                             const size_t &monomers = 100) const;
+    /**
+     * Populate the edge_points of all the edges of graph_.
+     * @sa SG::generate_contour_lengths
+     */
+    std::vector<double> generate_contour_lengths(const double &k_bending,
+                                                 const size_t &monomers = 100);
 
     /**
      * Perform von-mises test using histogram and target_cumulative_distro
@@ -24,6 +24,8 @@
 #include "spatial_edge.hpp"
 #include "spatial_graph.hpp"
 
+#include <vector>
+
 namespace SG {
 
 /**
@@ -56,5 +58,23 @@ generate_contour_length(const PointType &start_point,
                         const double &k_bending,
                         const size_t &monomers = 100);
 
+/**
+ * generate_contour_length for all the edges of the graph, in the order of
+ * boost::edges(graph). The edge_points of each edge are replaced with the
+ * generated ones.
+ * The result is the same as calling generate_contour_length for each edge.
+ *
+ * @param graph input graph with the position of the nodes, the edge_points
+ * of its edges are overwritten
+ * @param k_bending
+ * @param monomers
+ *
+ * @return ratio between contour length and end to end distance of each
+ * edge, in the order of boost::edges(graph)
+ */
+std::vector<double> generate_contour_lengths(GraphType &graph,
+                                             const double &k_bending,
+                                             const size_t &monomers = 100);
+
 }// end ns SG
 #endif
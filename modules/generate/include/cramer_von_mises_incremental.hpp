@@ -0,0 +1,280 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+
+#ifndef SG_CRAMER_VON_MISES_INCREMENTAL_HPP
+#define SG_CRAMER_VON_MISES_INCREMENTAL_HPP
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace SG {
+
+/**
+ * Keep the result of @ref cramer_von_mises_test_optimized up to date while
+ * the counts of the histogram change, without recomputing it over all the
+ * bins.
+ *
+ * With s_i = M_i - F_optimized_i, where M_i is the exclusive cumulative sum of
+ * the counts m_i, the test is:
+ * 1/(12 N) + 1/N^2 sum_i [m_i (m_i + 1) (2 m_i + 1) / 6 +
+ *                         m_i (m_i + 1) s_i + m_i s_i^2]
+ *
+ * Adding delta to the count of bin k changes m_k, and shifts s_j by delta for
+ * all j > k. Two representations are used, depending on the number of bins
+ * (@sa tree_min_bins):
+ * - Prefix sums over the bins: the value after some changes is computed in
+ *   O(changed bins) (@ref value_after), but applying the changes recomputes
+ *   the prefix sums after the first changed bin, O(bins).
+ * - A segment tree with lazy shifts of s: both cost O(changed bins *
+ *   log(bins)). A prefix-sum (Fenwick) tree alone is not enough: the squares
+ *   of s_j change with the shift, and have to be kept per subtree.
+ *
+ * In the simulated annealing most of the steps are rejected, so the value of
+ * a step is computed with @ref value_after, and the changes are only applied
+ * with @ref add when the step is accepted.
+ *
+ * The total counts N and F_optimized are fixed at @ref reset, the changes are
+ * expected to keep N constant, as the update steps of
+ * @ref simulated_annealing_generator do (old values are removed and the same
+ * number of new values are added).
+ *
+ * The tree is rebuilt from the counts every rebuild_period changes, to
+ * avoid the accumulation of rounding errors of the lazy shifts. The prefix
+ * sums are always recomputed from the counts.
+ *
+ * Counts of histograms are unsigned: if a bin is decreased below zero, its
+ * count wraps around and @ref cramer_von_mises_test_optimized returns a huge
+ * value, so the step is rejected. In that case value() returns infinity.
+ */
+class cramer_von_mises_incremental {
+  public:
+    cramer_von_mises_incremental() = default;
+
+    /**
+     * Build the tree from the current counts.
+     *
+     * @param histo_counts counts of each bin
+     * @param F_optimized target_cumulative_distro_at_histogram_bin_centers *
+     * total_counts + 0.5, @sa cramer_von_mises_test_optimized
+     * @param bin_weights optional, weight of each bin to keep
+     * sum_i bin_weights_i * m_i up to date (@sa weighted_counts). For example,
+     * the bin centers to compute the mean of the histogram.
+     */
+    template <typename TVectorInt>
+    void reset(const TVectorInt &histo_counts,
+               const std::vector<double> &F_optimized,
+               const std::vector<double> &bin_weights = {}) {
+        std::vector<long> counts(std::begin(histo_counts),
+                                 std::end(histo_counts));
+        this->reset_counts(counts, F_optimized, bin_weights);
+    }
+
+    /**
+     * Add delta to the counts of bin.
+     *
+     * @param bin index of the bin
+     * @param delta positive or negative change of the counts.
+     */
+    void add(const size_t &bin, const long &delta);
+
+    /** Pair of bin and delta of its counts. */
+    using BinChange = std::pair<size_t, long>;
+    /**
+     * Add the changes of multiple bins in a single traversal of the tree.
+     * Faster than calling @ref add for each bin, the nodes shared by the
+     * changed bins are only visited once.
+     *
+     * @param changes bins and deltas, sorted by bin, without repeated bins.
+     */
+    void add(const std::vector<BinChange> &changes);
+
+    /** @return same than cramer_von_mises_test_optimized with the current
+     * counts and the total_counts given in @ref reset, or infinity if any
+     * count is negative. */
+    double value() const;
+    /**
+     * @return the value that @ref value would return after add(changes),
+     * without applying them.
+     *
+     * @param changes bins and deltas, sorted by bin, without repeated bins.
+     */
+    double value_after(const std::vector<BinChange> &changes) const;
+
+    /** @return sum_i bin_weights_i * m_i, 0.0 if bin_weights were empty. */
+    double weighted_counts() const;
+    /** @return weighted_counts after add(changes), without applying them. */
+    double weighted_counts_after(const std::vector<BinChange> &changes) const;
+
+    size_t bins() const { return bins_; }
+    size_t total_counts() const { return total_counts_; }
+    long count(const size_t &bin) const { return counts_[bin]; }
+
+    /** Recompute the tree from the counts. */
+    void rebuild();
+
+    /** Number of changes between automatic calls to @ref rebuild. */
+    size_t rebuild_period = 1u << 20u;
+    /**
+     * Histograms with at least this number of bins use the segment tree,
+     * the others use the prefix sums. Read in @ref reset.
+     * With ~15% of the changes applied, as in the simulated annealing, the
+     * prefix sums are faster below ~2000 bins.
+     */
+    size_t tree_min_bins = 2048;
+    /** @return true if the segment tree is used, false for prefix sums. */
+    bool uses_tree() const { return use_tree_; }
+
+    /** Boost serialization of the full state, including the rounding errors
+     * accumulated since the last rebuild. Used in the checkpoints of
+     * simulated_annealing_generator. */
+    template <class Archive>
+    void serialize(Archive &ar, const unsigned int /*version*/) {
+        ar &rebuild_period;
+        ar &tree_min_bins;
+        ar &use_tree_;
+        ar &bins_;
+        ar &total_counts_;
+        ar &changes_since_rebuild_;
+        ar &negative_bins_;
+        ar &counts_;
+        ar &F_optimized_;
+        ar &bin_weights_;
+        ar &tree_;
+        ar &s_;
+        ar &prefix_cubic_;
+        ar &prefix_quadratic_;
+        ar &prefix_quadratic_s_;
+        ar &prefix_m_;
+        ar &prefix_m_s_;
+        ar &prefix_m_s2_;
+        ar &prefix_weighted_m_;
+    }
+
+  private:
+    struct Node {
+        /** sum m (m + 1) (2 m + 1) / 6 */
+        double sum_cubic = 0.0;
+        /** sum m (m + 1) */
+        double sum_quadratic = 0.0;
+        /** sum m (m + 1) s */
+        double sum_quadratic_s = 0.0;
+        /** sum m */
+        double sum_m = 0.0;
+        /** sum m s */
+        double sum_m_s = 0.0;
+        /** sum m s^2 */
+        double sum_m_s2 = 0.0;
+        /** sum weight m */
+        double sum_weighted_m = 0.0;
+        /** pending shift of s of the children */
+        double lazy_shift = 0.0;
+        /** s of the bin, only used in leaves */
+        double s = 0.0;
+        template <class Archive>
+        void serialize(Archive &ar, const unsigned int /*version*/) {
+            ar &sum_cubic;
+            ar &sum_quadratic;
+            ar &sum_quadratic_s;
+            ar &sum_m;
+            ar &sum_m_s;
+            ar &sum_m_s2;
+            ar &sum_weighted_m;
+            ar &lazy_shift;
+            ar &s;
+        }
+    };
+
+    void reset_counts(const std::vector<long> &counts,
+                      const std::vector<double> &F_optimized,
+                      const std::vector<double> &bin_weights);
+    void build(const size_t &node,
+               const size_t &begin,
+               const size_t &end,
+               const std::vector<double> &s);
+    void set_leaf(Node &leaf, const size_t &bin) const;
+    void pull(const size_t &node);
+    void apply_shift(const size_t &node, const double &shift);
+    void push(const size_t &node);
+    /**
+     * Set the leaves of the changed bins from counts_, and shift s in the
+     * bins after them by the sum of the deltas of the changed bins before.
+     *
+     * @param first,last changes in [begin, end)
+     * @param shift sum of the deltas of the changed bins before begin
+     */
+    void update(const size_t &node,
+                const size_t &begin,
+                const size_t &end,
+                const BinChange *first,
+                const BinChange *last,
+                const double &shift);
+    /** Sums of the test of a subtree, or of a range of bins. */
+    struct Sums {
+        double cubic = 0.0;
+        double quadratic_s = 0.0;
+        double m_s2 = 0.0;
+    };
+    /**
+     * Sums of the subtree node after the changes in [first, last), without
+     * modifying the tree.
+     *
+     * @param shift shift of s of the subtree: pending lazy shifts of the
+     * ancestors plus the sum of the deltas of the changed bins before begin.
+     */
+    Sums query(const size_t &node,
+               const size_t &begin,
+               const size_t &end,
+               const BinChange *first,
+               const BinChange *last,
+               const double &shift) const;
+    /** Recompute the prefix sums from bin to the end, from the counts. */
+    void update_prefix_sums(const size_t &bin);
+    /** Update counts_ and the number of negative bins. */
+    void change_count(const size_t &bin, const long &delta);
+    /** @return true if any count would be negative after the changes. */
+    bool any_negative_after(const std::vector<BinChange> &changes) const;
+    /** @return the value of the test from the sums of all the bins. */
+    double value_from_sums(const Sums &sums) const;
+
+    size_t bins_ = 0;
+    size_t total_counts_ = 0;
+    size_t changes_since_rebuild_ = 0;
+    size_t negative_bins_ = 0;
+    std::vector<long> counts_;
+    std::vector<double> F_optimized_;
+    std::vector<double> bin_weights_;
+    bool use_tree_ = true;
+    std::vector<Node> tree_;
+    /** Used without tree: s of each bin, and prefix sums of the bins,
+     * prefix_x_[i] is the sum of x over the bins [0, i). */
+    std::vector<double> s_;
+    std::vector<double> prefix_cubic_;
+    std::vector<double> prefix_quadratic_;
+    std::vector<double> prefix_quadratic_s_;
+    std::vector<double> prefix_m_;
+    std::vector<double> prefix_m_s_;
+    std::vector<double> prefix_m_s2_;
+    std::vector<double> prefix_weighted_m_;
+};
+
+} // namespace SG
+#endif
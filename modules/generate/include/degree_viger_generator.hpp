@@ -22,6 +22,7 @@
 #define DEGREE_VIGER_GENERATOR_HPP
 
 #include "spatial_graph.hpp"
+#include <memory>
 #include <vector>
 
 namespace SG {
@@ -62,7 +63,22 @@ class degree_viger_generator {
         OPTIMAL_HEURISTICS = 3,
         BRUTE_FORCE_HEURISTICS = 4
     };
-    /// Connected Shuffle
+    /**
+     * Connected Shuffle. Edge swaps are performed in windows, and the graph
+     * is restored to the start of the window if it is not connected at the
+     * end of it.
+     * Connectivity is certified with a spanning tree of the graph: only the
+     * swaps that remove a tree edge need a check, and the check only
+     * searches the subtrees detached from the tree. The result is the same
+     * as a full search after each window.
+     *
+     * @param times number of validated swaps to perform
+     * @param max_times max number of swap attempts
+     * @param shuffle_type heuristics to choose the size of the windows
+     * @param verbose print progress and a summary
+     *
+     * @return number of validated swaps
+     */
     unsigned long shuffle(unsigned long times,
                           unsigned long max_times,
                           ShuffleType shuffle_type,
@@ -103,6 +119,8 @@ class degree_viger_generator {
 
     // Backup graph [sizeof(int) bytes per edge]
     std::unique_ptr<int[]> backup();
+    // Backup graph into b, with arcs_ / 2 elements
+    void backup(int *b) const;
     // Restore from backup
     void restore(int *back);
     /// Optimal window for the gkantsidis heuristics
@@ -121,16 +139,62 @@ class degree_viger_generator {
     inline int *random_neighbour(const int v) const;
     // is edge ?
     inline bool is_edge(int a, int b) const;
-    // Test if graph is connected
-    bool is_connected() const;
+    /** Test if graph is connected.
+     * Uses the spanning tree if it is valid, builds it otherwise. */
+    bool is_connected();
     // Test if vertex is in an isolated component of size<K
     bool isolated(int v, int K, int *Kbuff, bool *visited) const;
     // Depth-first search.
     int depth_search(bool *visited, int *buff, int v0 = 0) const;
 
+    /** Build a BFS spanning tree from vertex 0, with the preorder interval
+     * of each subtree. Return false (and the tree is not valid) if the graph
+     * is not connected. */
+    bool build_spanning_tree();
+    /** Mark the tree edge (a,b) as removed, if (a,b) is a tree edge. */
+    inline void cut_tree_edge(int a, int b);
+    /** Test connectivity searching only the subtrees detached by the cut
+     * tree edges. Requires a valid tree. */
+    bool is_connected_from_cuts();
+    /** Start of a window of swaps that might be restored. */
+    void begin_tree_window();
+    /** The graph was restored to the start of the window: unmark the tree
+     * edges cut in the window, or invalidate the tree if it was rebuilt. */
+    void restore_tree_window();
+
     // Add edge (a,b). Return FALSE if vertex a is already full.
     // WARNING : only to be used by havelhakimi(), restore() or constructors
     inline bool add_edge(int a, int b, const std::vector<int> &realdeg);
+
+    // Buffers reused between the windows of shuffle.
+    std::unique_ptr<int[]> backup_buffer_;
+    std::vector<int> restore_degrees_;
+
+    // Spanning tree certifying the connectivity of the graph.
+    // All the tree edges that are not cut are edges of the graph.
+    bool tree_valid_ = false;
+    /** Parent of each vertex in the tree, -1 for the root. */
+    std::vector<int> tree_parent_;
+    /** Subtree of v is tree_order_[tree_begin_[v], tree_end_[v]). */
+    std::vector<int> tree_begin_;
+    std::vector<int> tree_end_;
+    std::vector<int> tree_order_;
+    /** tree_cut_[v] is 1 if the edge (v, tree_parent_[v]) was removed. */
+    std::vector<char> tree_cut_;
+    /** Vertices v with tree_cut_[v], in the order they were cut. */
+    std::vector<int> tree_cuts_;
+    size_t tree_builds_ = 0;
+    size_t tree_window_cuts_ = 0;
+    size_t tree_window_builds_ = 0;
+    /** Vertices visited by is_connected_from_cuts since the last build. */
+    size_t tree_check_work_ = 0;
+    // Buffers of build_spanning_tree and is_connected_from_cuts.
+    std::vector<int> tree_buffer_;
+    std::vector<int> tree_sorted_cuts_;
+    std::vector<int> tree_enclosing_;
+    std::vector<int> tree_queue_;
+    std::vector<char> tree_visited_;
+    std::vector<char> tree_connected_;
 };
 
 GraphType
@@ -0,0 +1,102 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+#ifndef ENSEMBLE_GENERATOR_HPP
+#define ENSEMBLE_GENERATOR_HPP
+
+#include "simulated_annealing_generator.hpp"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace SG {
+
+struct ensemble_parameters {
+    /** Seed of the first run. Run i uses the seed first_seed + i. */
+    size_t first_seed = 1;
+    /** Number of independent simulated_annealing_generator to run. */
+    size_t num_runs = 1;
+    /** Number of threads running the generators. 0 uses all the hardware
+     * threads. */
+    size_t num_threads = 0;
+    /**
+     * If not empty, the graph of each finished run is written to
+     * output_prefix + "_seed_<seed>.dot", and a line with its
+     * transition_parameters is appended to output_prefix + "_summary.tsv".
+     * Empty keeps the results in memory only.
+     */
+    std::string output_prefix;
+};
+
+struct ensemble_run_result {
+    size_t seed = 0;
+    /** transition_params of the generator after engine. */
+    transition_parameters transition_params;
+    /** File with the graph, empty if ensemble_parameters::output_prefix
+     * is empty. */
+    std::string output_file;
+};
+
+struct ensemble_result {
+    /** Result of each run, in seed order (not in completion order). */
+    std::vector<ensemble_run_result> runs;
+    /** Wall time of the whole ensemble, in seconds. */
+    double time_elapsed = 0.0;
+    /** Sum of the steps performed by all the runs. */
+    size_t steps_performed = 0;
+    double runs_per_second() const {
+        return time_elapsed > 0.0 ? runs.size() / time_elapsed : 0.0;
+    }
+    double steps_per_second() const {
+        return time_elapsed > 0.0 ? steps_performed / time_elapsed : 0.0;
+    }
+};
+
+/**
+ * Generate an ensemble of independent networks with the same parameters.
+ *
+ * Each run creates a simulated_annealing_generator from tree and calls its
+ * engine, with the thread_local RNG::engine seeded with the seed of the run.
+ * Runs are distributed between num_threads threads, and only one generator
+ * per thread is alive at any time. Because each run only depends on its
+ * seed, the results do not depend on num_threads.
+ *
+ * Finished runs are written to disk as soon as they finish (@sa
+ * ensemble_parameters::output_prefix), so the lines of the summary are in
+ * completion order.
+ *
+ * @param tree parameters of all the runs.
+ * @param params seeds, threads and output of the ensemble.
+ *
+ * @return transition_parameters of each run and aggregate throughput.
+ */
+ensemble_result generate_ensemble(
+        const simulated_annealing_generator_config_tree &tree,
+        const ensemble_parameters &params = ensemble_parameters());
+
+/** Header of the summary file written by generate_ensemble. */
+void write_ensemble_summary_header(std::ostream &os);
+/** One line of the summary file written by generate_ensemble. */
+void write_ensemble_summary_line(std::ostream &os,
+                                 const ensemble_run_result &run);
+
+} // namespace SG
+#endif
@@ -68,6 +68,16 @@ PointType generate_random_array(const double &max_modulus);
  */
 std::vector<double> cosine_directors_from_connected_edges(
         const std::vector<VectorType> &outgoing_edges);
+/**
+ * Append the cosine_directors of pairs of outgoing_edges to cosine_directors.
+ * Used by the update steps to reuse the memory of cosine_directors.
+ *
+ * @param outgoing_edges vector of VectorTypes
+ * @param cosine_directors output, values are appended to it.
+ */
+void cosine_directors_from_connected_edges(
+        const std::vector<VectorType> &outgoing_edges,
+        std::vector<double> &cosine_directors);
 
 /**
  * Cosine director between target edge and a vector of edges.
@@ -83,6 +93,14 @@ std::vector<double> cosine_directors_from_connected_edges(
 std::vector<double> cosine_directors_between_edges_and_target_edge(
         const std::vector<VectorType> &outgoing_edges,
         const VectorType &outgoing_target_edge);
+/**
+ * Append the cosine directors between outgoing_edges and
+ * outgoing_target_edge to cosine_directors.
+ */
+void cosine_directors_between_edges_and_target_edge(
+        const std::vector<VectorType> &outgoing_edges,
+        const VectorType &outgoing_target_edge,
+        std::vector<double> &cosine_directors);
 
 /**
  * Returns the edge arrays (mathematical vectors)
@@ -100,6 +118,16 @@ std::vector<VectorType> get_adjacent_edges_from_source(
         const GraphType::vertex_descriptor ignore_node,
         const GraphType &graph,
         const ArrayUtilities::boundary_condition &boundary_condition);
+/**
+ * Same than above, but the edge arrays are stored in adj_edges, which is
+ * cleared first. Used by the update steps to reuse the memory of adj_edges.
+ */
+void get_adjacent_edges_from_source(
+        const GraphType::vertex_descriptor source,
+        const GraphType::vertex_descriptor ignore_node,
+        const GraphType &graph,
+        const ArrayUtilities::boundary_condition &boundary_condition,
+        std::vector<VectorType> &adj_edges);
 /**
  * Compute cosine_directors of all the edges adjacent to source (except
  * the one specied by ignore_node) versus the vector defined by:
@@ -0,0 +1,152 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+#ifndef PARALLEL_TEMPERING_GENERATOR_HPP
+#define PARALLEL_TEMPERING_GENERATOR_HPP
+
+#include "simulated_annealing_generator.hpp"
+
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace SG {
+
+struct parallel_tempering_parameters {
+    /** Number of independent simulated_annealing_generator. */
+    size_t num_replicas = 4;
+    /** The initial temperature of replica r is
+     * temp_initial * temp_ladder_ratio^r, where temp_initial is the one
+     * chosen by simulated_annealing_generator::engine for the first replica.
+     */
+    double temp_ladder_ratio = 2.0;
+    /** Steps performed by each replica between replica exchanges. */
+    size_t steps_between_exchanges = 1000;
+    /** Number of threads running the replicas. 0 uses all the hardware
+     * threads. */
+    size_t num_threads = 0;
+    /** Seed of the random engine of replica r is seed + r. 0 uses a random
+     * seed. With a fixed seed, the result does not depend on num_threads. */
+    size_t seed = 0;
+};
+
+/** Statistics of each replica after parallel_tempering_generator::engine */
+struct replica_statistics {
+    double energy = 0.0;
+    double energy_initial = 0.0;
+    double temp_initial = 0.0;
+    double temp_current = 0.0;
+    size_t steps_performed = 0;
+    size_t accepted_transitions = 0;
+    size_t rejected_transitions = 0;
+    size_t high_temp_transitions = 0;
+    size_t exchanges_attempted = 0;
+    size_t exchanges_accepted = 0;
+    /** time spent in simulated_annealing_generator::engine */
+    double time_elapsed = 0.0;
+};
+
+struct parallel_tempering_result {
+    /** Graph with the lowest energy found, at any exchange round. */
+    GraphType graph;
+    double energy = 0.0;
+    /** Replica where graph was found. */
+    size_t replica = 0;
+    std::vector<replica_statistics> replicas;
+};
+
+/**
+ * Parallel tempering (replica exchange) of simulated_annealing_generator.
+ *
+ * num_replicas independent generators are created from the same parameters,
+ * each one with its own graph_, histograms and random engine, and a
+ * different temperature from a geometric ladder. The replicas run in
+ * parallel for steps_between_exchanges steps, and then neighbor replicas in
+ * the temperature ladder try to exchange their temperatures, with
+ * probability min(1, exp((1/T_i - 1/T_j) (E_i - E_j))). Exchanging the
+ * temperatures is equivalent to exchanging the graphs, but without copying
+ * them.
+ *
+ * The temperatures of the ladder are fixed: the temp_cooling_rate of the
+ * replicas is set to 1, so the replicas only change temperature by
+ * exchanges, and the set of temperatures is the initial ladder at any time.
+ *
+ * The simulation stops when any replica converges
+ * (transition_parameters::ENERGY_CONVERGENCE), when all of them reach
+ * transition_parameters::MAX_CONSECUTIVE_FAILURES, or when each replica
+ * has performed transition_parameters::MAX_ENGINE_ITERATIONS.
+ *
+ * The global RNG::engine is thread_local: each replica keeps its own engine,
+ * that is swapped into the thread running the replica.
+ */
+class parallel_tempering_generator {
+  public:
+    /**
+     * Create and initialize the replicas in parallel.
+     *
+     * @param tree parameters shared by all the replicas.
+     * @param input_params parallel tempering parameters.
+     */
+    parallel_tempering_generator(
+            const simulated_annealing_generator_config_tree &tree,
+            const parallel_tempering_parameters &input_params =
+                    parallel_tempering_parameters());
+
+    /**
+     * Run all the replicas until one of the stop criteria is met.
+     *
+     * @return best graph found, and statistics of each replica.
+     */
+    parallel_tempering_result engine();
+
+    size_t num_replicas() const { return replicas_.size(); }
+    simulated_annealing_generator &replica(const size_t &index) {
+        return *replicas_[index];
+    }
+    const simulated_annealing_generator &replica(const size_t &index) const {
+        return *replicas_[index];
+    }
+
+    const parallel_tempering_parameters params;
+
+  private:
+    /**
+     * Call func(replica_index) for each replica, in params.num_threads
+     * threads, with the random engine of the replica. Exceptions thrown
+     * by func are re-thrown in the calling thread.
+     */
+    void run_replicas(const std::function<void(const size_t &)> &func);
+    /**
+     * Try to exchange the temperatures of neighbor replicas in the ladder.
+     * Even rounds try the pairs (0,1), (2,3)..., odd rounds (1,2), (3,4)...
+     */
+    void exchange_temperatures(const size_t &round);
+
+    std::vector<std::unique_ptr<simulated_annealing_generator>> replicas_;
+    std::vector<std::mt19937> replica_engines_;
+    std::mt19937 exchange_engine_;
+    std::vector<replica_statistics> statistics_;
+    /** MAX_ENGINE_ITERATIONS of the replicas at construction. */
+    size_t max_engine_iterations_ = 0;
+};
+
+} // namespace SG
+#endif
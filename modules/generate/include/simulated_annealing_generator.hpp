@@ -2,11 +2,15 @@
 #define SIMULATEDANNEALING_HPP
 
 #include "boundary_conditions.hpp" // for boundary_condition
+#include "cramer_von_mises_incremental.hpp"
 #include "generate_common.hpp"     // for Histogram
+#include "simulated_annealing_generator_checkpoint.hpp"
 #include "simulated_annealing_generator_config_tree.hpp"
 #include "simulated_annealing_generator_parameters.hpp"
 #include "update_step_move_node.hpp"
 #include "update_step_swap_edges.hpp"
+#include <exception>
+#include <thread>
 
 namespace SG {
 /**
@@ -28,6 +32,8 @@ class simulated_annealing_generator {
     simulated_annealing_generator(
             const simulated_annealing_generator_config_tree &tree);
     simulated_annealing_generator(const std::string &input_parameters_file);
+    /** Wait for the checkpoint being written, if any. */
+    ~simulated_annealing_generator();
     void init_parameters();
     void set_parameters_from_file(const std::string &input_file);
     void save_parameters_to_file(const std::string &output_file) const;
@@ -61,14 +67,56 @@ class simulated_annealing_generator {
     Histogram histo_cosines_;
     std::vector<double> target_cumulative_distro_histo_ete_distances_;
     std::vector<double> target_cumulative_distro_histo_cosines_;
-    // TODO(optimization): update_steps can be a vector to parallelize the
-    // update. The condition would be:
-    // - The selected randomized nodes/edges do not have neighbors in common.
-    //   In the case of move_node, this includes neighbors of all the nodes
-    //   connected to the moved node.
     update_step_move_node step_move_node_;
     update_step_swap_edges step_swap_edges_;
     bool verbose = false;
+    /** Print the energies periodically in @ref engine. */
+    bool show_progress = true;
+    /**
+     * @ref engine uses the incremental energy (@sa compute_energy_incremental)
+     * when the histograms have at least this number of bins. With fewer bins,
+     * recomputing the tests over all the bins is as fast as binning the
+     * changes of each step for the incremental tests.
+     */
+    size_t incremental_energy_min_bins = 128;
+    /**
+     * Number of update steps drawn at once by @ref engine. The vertices
+     * modified by the steps of a batch, and their neighbors, are all
+     * different, so the steps do not interfere: their histogram changes are
+     * computed in parallel (if the parallel STL is available), and then they
+     * are accepted or rejected one by one. Steps in conflict with the
+     * previous steps of the batch are discarded.
+     * 1 performs a single step at a time.
+     */
+    size_t update_steps_batch_size = 1;
+    /**
+     * Write a checkpoint to checkpoint_file every checkpoint_every_steps
+     * steps of @ref engine. 0 disables the checkpoints.
+     * The state is copied between steps, and written to disk by a
+     * background thread while the simulation continues.
+     * @sa load_checkpoint
+     */
+    size_t checkpoint_every_steps = 0;
+    std::string checkpoint_file;
+
+    /**
+     * Copy of the current state of the simulation.
+     * Inside @ref engine, the edges of the graph are stored in the order of
+     * the edge index used to select random edges.
+     */
+    simulated_annealing_generator_checkpoint make_checkpoint() const;
+    /**
+     * Set the state of the simulation from a checkpoint. The next call to
+     * @ref engine continues the simulation where the checkpoint was made:
+     * steps, energy and temperature are not reset, whatever the parameters
+     * of engine. The result is the same than the uninterrupted
+     * simulation.
+     */
+    void restore_checkpoint(const simulated_annealing_generator_checkpoint &cp);
+    /** make_checkpoint and write it to output_file. */
+    void save_checkpoint(const std::string &output_file) const;
+    /** Read a checkpoint from input_file and restore it. */
+    void load_checkpoint(const std::string &input_file);
 
     /**
      * Create a random graph from a degree distribution (@sa
@@ -150,6 +198,24 @@ class simulated_annealing_generator {
      * @return the result of the test.
      */
     double compute_energy() const;
+    /**
+     * Same than @ref compute_energy, but using the incremental tests, that are
+     * updated with the changes of the histograms of each accepted update step
+     * in @ref engine, instead of recomputing the tests over all the bins.
+     * Used by @ref engine if there are enough bins, @sa
+     * incremental_energy_min_bins.
+     *
+     * @sa reset_incremental_energy
+     *
+     * @return the energy of the current histograms.
+     */
+    double compute_energy_incremental() const;
+    /**
+     * Set the incremental tests from the current histograms.
+     * Called by @ref populate_histogram_ete_distances,
+     * @ref populate_histogram_cosines and at the start of @ref engine.
+     */
+    void reset_incremental_energy();
     /**
      * cramer_von_mises_test for the ete_distances histogram
      * plus @energy_ete_distances_extra_penalty
@@ -192,13 +258,26 @@ class simulated_annealing_generator {
      * if false, it just continues from whatever the value of that parameter.
      * steps_performed defaults to zero, but this would allow to continue a
      * simulation that was stopped.
+     * @param reset_temperature if true, set transition_params.energy_initial
+     * to the current energy, and the temperatures from it. If false, keep
+     * transition_params.temp_current, for example to continue a simulation,
+     * or when the temperature is set externally (@sa
+     * parallel_tempering_generator).
      *
      * As output, the transition parameters are populated with the
      * simulation results and the graph_ is modified to follow the input
      * distributions.
      */
-    void engine(const bool &reset_steps = false);
+    void engine(const bool &reset_steps = false,
+                const bool &reset_temperature = true);
     simulated_annealing_generator::transition check_transition();
+    /**
+     * Accept or reject the transition to a state with energy_new.
+     *
+     * @param energy_new energy after the update step.
+     */
+    simulated_annealing_generator::transition
+    check_transition(const double &energy_new);
     void set_boundary_condition(const ArrayUtilities::boundary_condition &bc);
     void print(std::ostream &os, int spaces = 35) const;
     void print_histo_and_target_distribution(
@@ -220,6 +299,73 @@ class simulated_annealing_generator {
     std::vector<double> LUT_cumulative_histo_cosines_;
     size_t total_counts_ete_distances_ = 0;
     size_t total_counts_cosines_ = 0;
+    /** cramer_von_mises_test of the histograms, updated with each step.
+     * The weights are the bin centers, to compute the mean. */
+    cramer_von_mises_incremental incremental_test_ete_distances_;
+    cramer_von_mises_incremental incremental_test_cosines_;
+    /** Net change of counts of each bin in the last step, and the bins
+     * changed. Values moving inside the same bin cancel out.
+     * Applied to the incremental tests only if the step is accepted. */
+    std::vector<long> step_deltas_ete_distances_;
+    std::vector<long> step_deltas_cosines_;
+    std::vector<cramer_von_mises_incremental::BinChange>
+            step_changes_ete_distances_;
+    std::vector<cramer_von_mises_incremental::BinChange> step_changes_cosines_;
+    /** All the edges of graph_, used by the swap steps inside engine. */
+    std::vector<GraphType::edge_descriptor> edge_index_;
+    /** Steps of the batch, @sa update_steps_batch_size */
+    std::vector<update_step_move_node> batch_steps_move_node_;
+    std::vector<update_step_swap_edges> batch_steps_swap_edges_;
+    std::vector<update_step_with_distance_and_cosine_histograms *> batch_;
+    /** Vertices are claimed by the current batch if their mark is
+     * batch_mark_. */
+    std::vector<size_t> batch_vertex_marks_;
+    size_t batch_mark_ = 0;
+    std::vector<GraphType::vertex_descriptor> batch_selected_vertices_;
+    /** The next engine() continues from a restored checkpoint. */
+    bool resume_from_checkpoint_ = false;
+    std::thread checkpoint_writer_;
+    std::exception_ptr checkpoint_writer_error_;
+    /**
+     * Make a checkpoint and write it to checkpoint_file in
+     * checkpoint_writer_. Waits for the previous checkpoint if it is still
+     * being written.
+     */
+    void write_checkpoint_in_background();
+    /** Join checkpoint_writer_, and rethrow its error if any. */
+    void wait_for_checkpoint_writer();
+    /**
+     * Claim the vertices and their neighbors for the current batch.
+     *
+     * @return false if any of them was already claimed, nothing is claimed
+     * then.
+     */
+    bool claim_neighborhood(
+            const std::vector<GraphType::vertex_descriptor> &vertices);
+    /**
+     * Draw up to update_steps_batch_size steps without conflicts into
+     * batch_, and compute their histogram changes.
+     */
+    void prepare_batch();
+    /**
+     * Accept or reject a step that has already updated the histograms.
+     * If rejected the step is undone, if accepted the graph is updated.
+     */
+    simulated_annealing_generator::transition evaluate_performed_step(
+            update_step_with_distance_and_cosine_histograms &step,
+            const bool &use_incremental_energy);
+    /**
+     * Collect the changes of the histograms done by the last perform() of
+     * step in step_changes_ete_distances_ and step_changes_cosines_.
+     * The incremental tests are not modified.
+     */
+    void collect_incremental_energy_changes(
+            const update_step_with_distance_and_cosine_histograms &step);
+    /**
+     * Same than @ref compute_energy_incremental, after applying the changes
+     * collected by @ref collect_incremental_energy_changes.
+     */
+    double compute_energy_incremental_after_step() const;
 };
 } // namespace SG
 #endif
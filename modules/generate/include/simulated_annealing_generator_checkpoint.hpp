@@ -0,0 +1,76 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+#ifndef SIMULATED_ANNEALING_GENERATOR_CHECKPOINT_HPP
+#define SIMULATED_ANNEALING_GENERATOR_CHECKPOINT_HPP
+
+#include "cramer_von_mises_incremental.hpp"
+#include "simulated_annealing_generator_config_tree.hpp"
+#include "spatial_graph.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace SG {
+
+/**
+ * State of a simulated_annealing_generator in the middle of engine, to
+ * continue the simulation from it, with the same result than an
+ * uninterrupted simulation.
+ *
+ * @sa simulated_annealing_generator::make_checkpoint
+ * @sa simulated_annealing_generator::restore_checkpoint
+ */
+struct simulated_annealing_generator_checkpoint {
+    /** All the parameters, including transition_params with the current
+     * energy, temperature and steps_performed. */
+    simulated_annealing_generator_config_tree parameters;
+    /** Edges are stored in the order of the edge index used by engine to
+     * select random edges. */
+    GraphType graph;
+    std::vector<size_t> counts_ete_distances;
+    std::vector<size_t> counts_cosines;
+    cramer_von_mises_incremental incremental_test_ete_distances;
+    cramer_von_mises_incremental incremental_test_cosines;
+    size_t incremental_energy_min_bins = 0;
+    size_t update_steps_batch_size = 1;
+    double move_node_max_step_distance = 0.0;
+    /** State of RNG::engine(), as written by operator<< */
+    std::string rng_state;
+};
+
+/* Binary boost archives. The files are not portable between platforms. */
+void write_checkpoint(std::ostream &os,
+                      const simulated_annealing_generator_checkpoint &cp);
+/**
+ * Write the checkpoint to output_file.
+ * The checkpoint is written first to output_file + ".tmp", and then renamed,
+ * so output_file always holds a complete checkpoint, even if the process is
+ * killed while writing.
+ */
+void write_checkpoint(const std::string &output_file,
+                      const simulated_annealing_generator_checkpoint &cp);
+void read_checkpoint(std::istream &is,
+                     simulated_annealing_generator_checkpoint &cp);
+simulated_annealing_generator_checkpoint
+read_checkpoint(const std::string &input_file);
+
+} // namespace SG
+#endif
@@ -74,6 +74,54 @@ class update_step_with_distance_and_cosine_histograms : public update_step {
                                   const std::vector<double> &old_cosines,
                                   const std::vector<double> &new_cosines) const;
     void print(std::ostream &os) const;
+
+    /**
+     * Perform in three stages, to compute multiple update steps in parallel.
+     * perform() is equivalent to:
+     * randomize_movement(); compute_histogram_changes(); update_histograms();
+     *
+     * Draw the random parameters of the step (the selection, if
+     * randomized_flag is false, and the movement), without modifying the
+     * graph or the histograms.
+     */
+    virtual void randomize_movement() = 0;
+    /**
+     * Compute the values to remove and add to the histograms for the
+     * movement drawn in randomize_movement(). It only reads the graph, and
+     * can be run in parallel with other update steps if their
+     * selected_vertices do not share neighbors.
+     */
+    virtual void compute_histogram_changes() = 0;
+    /**
+     * Remove the old values and add the new values to the histograms, as
+     * perform() does after computing them. undo() reverts it.
+     */
+    inline void update_histograms() {
+        this->update_distances_histogram(*histo_distances_, old_distances_,
+                                         new_distances_);
+        this->update_cosines_histogram(*histo_cosines_, old_cosines_,
+                                       new_cosines_);
+        randomized_flag_ = false;
+    }
+    /**
+     * Vertices modified by the step (moved, or with edges swapped).
+     * The histogram changes of the step depend on these vertices and their
+     * neighbors.
+     */
+    virtual void selected_vertices(
+            std::vector<GraphType::vertex_descriptor> &vertices) const = 0;
+
+    /** Values removed from and added to the histograms by the last perform().
+     * Cleared by undo(). */
+    const std::vector<double> &get_old_distances() const {
+        return old_distances_;
+    }
+    const std::vector<double> &get_new_distances() const {
+        return new_distances_;
+    }
+    const std::vector<double> &get_old_cosines() const { return old_cosines_; }
+    const std::vector<double> &get_new_cosines() const { return new_cosines_; }
+
     GraphType *graph_;
     Histogram *histo_distances_;
     Histogram *histo_cosines_;
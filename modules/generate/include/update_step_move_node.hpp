@@ -89,6 +89,41 @@ class update_step_move_node
                       old_cosines_, new_distances_, new_cosines_);
     }
 
+    /**
+     * Compute the distances and cosines affected by moving selected_node from
+     * old_node_position to new_node_position. Histograms and graph are not
+     * modified.
+     */
+    void compute_histogram_changes(
+            // in parameters
+            const GraphType &graph,
+            const GraphType::vertex_descriptor &selected_node,
+            const PointType &old_node_position,
+            const PointType &new_node_position,
+            // out parameters
+            std::vector<double> &old_distances,
+            std::vector<double> &old_cosines,
+            std::vector<double> &new_distances,
+            std::vector<double> &new_cosines) const;
+
+    /**
+     * Random position at a distance [0, max_step_distance) from
+     * old_node_position, taking into account the boundary_condition.
+     */
+    PointType random_new_position(const PointType &old_node_position,
+                                  const double &max_step_distance) const;
+    void randomize_movement() override;
+    inline void compute_histogram_changes() override {
+        this->compute_histogram_changes(
+                *graph_, selected_node_, old_node_position_,
+                new_node_position_, old_distances_, old_cosines_,
+                new_distances_, new_cosines_);
+    }
+    inline void selected_vertices(std::vector<GraphType::vertex_descriptor>
+                                          &vertices) const override {
+        vertices.assign(1, selected_node_);
+    }
+
     void update_graph() override {
         if (selected_node_ ==
             std::numeric_limits<decltype(selected_node_)>::max()) {
@@ -114,6 +149,13 @@ class update_step_move_node
             std::numeric_limits<decltype(selected_node_)>::max();
     PointType old_node_position_;
     PointType new_node_position_;
+
+  protected:
+    /** Scratch buffers of compute_histogram_changes. They are cleared in each
+     * step but keep their capacity, so steps do not allocate memory. */
+    mutable std::vector<VectorType> old_edges_buffer_;
+    mutable std::vector<VectorType> new_edges_buffer_;
+    mutable std::vector<VectorType> adjacent_edges_buffer_;
 };
 } // namespace SG
 #endif
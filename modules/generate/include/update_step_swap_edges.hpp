@@ -3,6 +3,7 @@
 
 #include "generate_common.hpp" // for Histogram
 #include "update_step.hpp"
+#include <array>
 #include <utility> // for std::pair
 
 namespace SG {
@@ -47,8 +48,22 @@ class update_step_swap_edges
     void randomize(const GraphType &graph,
                    edge_descriptor_pair &selected_edges,
                    bool &randomized_flag) const;
+    /**
+     * Select the edges from edge_index, instead of walking the edges of the
+     * graph. The position of the selected edges in edge_index are stored in
+     * selected_edges_position.
+     */
+    void randomize(const std::vector<edge_descriptor> &edge_index,
+                   edge_descriptor_pair &selected_edges,
+                   std::pair<size_t, size_t> &selected_edges_position,
+                   bool &randomized_flag) const;
     inline void randomize() {
-        this->randomize(*graph_, selected_edges_, randomized_flag_);
+        if (edge_index_) {
+            this->randomize(*edge_index_, selected_edges_,
+                            selected_edges_position_, randomized_flag_);
+        } else {
+            this->randomize(*graph_, selected_edges_, randomized_flag_);
+        }
     }
 
     void perform(
@@ -72,6 +87,37 @@ class update_step_swap_edges
                       new_edges_, old_distances_, old_cosines_, new_distances_,
                       new_cosines_);
     }
+    /**
+     * Compute the distances and cosines affected by swapping selected_edges.
+     * Histograms and graph are not modified.
+     */
+    void compute_histogram_changes(
+            // in parameters
+            const GraphType &graph,
+            const edge_descriptor_pair &selected_edges,
+            const bool &is_swap_parallel,
+            // out parameters
+            edge_descriptor_pair &new_edges,
+            std::vector<double> &old_distances,
+            std::vector<double> &old_cosines,
+            std::vector<double> &new_distances,
+            std::vector<double> &new_cosines) const;
+
+    void randomize_movement() override;
+    inline void compute_histogram_changes() override {
+        this->compute_histogram_changes(*graph_, selected_edges_,
+                                        is_swap_parallel_, new_edges_,
+                                        old_distances_, old_cosines_,
+                                        new_distances_, new_cosines_);
+    }
+    inline void selected_vertices(std::vector<GraphType::vertex_descriptor>
+                                          &vertices) const override {
+        vertices.assign({selected_edges_.first.m_source,
+                         selected_edges_.first.m_target,
+                         selected_edges_.second.m_source,
+                         selected_edges_.second.m_target});
+    }
+
     void update_graph() override {
         if (selected_edges_.first.m_source ==
                     std::numeric_limits<vertex_descriptor>::max() ||
@@ -84,7 +130,12 @@ class update_step_swap_edges
             throw std::logic_error("update_graph() has to be called after "
                                    "perform(), not before.");
         }
-        this->update_graph(*graph_, selected_edges_, is_swap_parallel_);
+        const auto added_edges = this->update_graph(*graph_, selected_edges_,
+                                                    is_swap_parallel_);
+        if (edge_index_) {
+            this->update_edge_index(*edge_index_, selected_edges_,
+                                    selected_edges_position_, added_edges);
+        }
     };
     /**
      * Update Graph, given the selected edges and if the swap is parallel. If
@@ -93,14 +144,34 @@ class update_step_swap_edges
      * @param graph
      * @param selected_edges
      * @param is_swap_parallel
+     *
+     * @return the edges added to the graph
+     */
+    edge_descriptor_pair update_graph(GraphType &graph,
+                                      const edge_descriptor_pair &selected_edges,
+                                      const bool &is_swap_parallel) const;
+    /**
+     * Replace the removed selected_edges by the added_edges in edge_index.
+     * selected_edges_position is only a hint, if the edges are not there
+     * (the selection was not made from edge_index) they are searched.
      */
-    void update_graph(GraphType &graph,
-                      const edge_descriptor_pair &selected_edges,
-                      const bool &is_swap_parallel) const;
+    void update_edge_index(
+            std::vector<edge_descriptor> &edge_index,
+            const edge_descriptor_pair &selected_edges,
+            const std::pair<size_t, size_t> &selected_edges_position,
+            const edge_descriptor_pair &added_edges) const;
 
     edge_descriptor_pair selected_edges_;
     edge_descriptor_pair new_edges_;
     bool is_swap_parallel_;
+    /**
+     * Optional dense index of the edges of graph_, to select random edges in
+     * O(1). The edges of GraphType are stored in a list, and
+     * select_random_edge has to walk it. The index is not owned, and it is
+     * kept updated by update_graph(). nullptr uses select_random_edge.
+     */
+    std::vector<edge_descriptor> *edge_index_ = nullptr;
+    std::pair<size_t, size_t> selected_edges_position_;
 
   public:
     /**
@@ -117,6 +188,20 @@ class update_step_swap_edges
     std::pair<edge_descriptor, edge_descriptor>
     select_two_valid_edges(const GraphType &graph,
                            int recursive_count = 0) const;
+    /**
+     * Same than above, but selecting the edges from edge_index.
+     *
+     * @param edge_index all the edges of the graph
+     * @param selected_edges_position output, position of the edges in
+     * edge_index
+     * @param recursive_count
+     *
+     * @return
+     */
+    std::pair<edge_descriptor, edge_descriptor>
+    select_two_valid_edges(const std::vector<edge_descriptor> &edge_index,
+                           std::pair<size_t, size_t> &selected_edges_position,
+                           int recursive_count = 0) const;
 
     /**
      * Depending on the boolean is_swap_parallel returns the source and targets
@@ -161,6 +246,11 @@ class update_step_swap_edges
                                const edge_descriptor &edge2,
                                const GraphType &graph) const;
 
+  protected:
+    /** Scratch buffers of compute_histogram_changes with the adjacent edges
+     * of the four nodes of the selected edges. They are cleared in each step
+     * but keep their capacity, so steps do not allocate memory. */
+    mutable std::array<std::vector<VectorType>, 4> adjacent_edges_buffers_;
 }; // namespace SG
 } // namespace SG
 #endif
@@ -32,5 +32,11 @@ contour_length_generator::generate_contour_length(
     return SG::generate_contour_length(start_point, end_point, k_bending,
                                        monomers);
 }
+
+std::vector<double> contour_length_generator::generate_contour_lengths(
+        const double &k_bending,
+        const size_t &monomers) {
+    return SG::generate_contour_lengths(graph_, k_bending, monomers);
+}
 } // namespace SG
 
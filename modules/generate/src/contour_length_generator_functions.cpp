@@ -23,45 +23,36 @@
 
 namespace SG {
 
-std::pair<PointContainer, double>
-generate_contour_length(const PointType &start_point,
-                        const PointType &end_point,
-                        const double &k_bending,
-                        const size_t &monomers) {
-    auto edge_points = PointContainer();
-
-    // Perform a PERM with input number of monomers
-    const size_t max_tries = 1000;
-    const auto lattice = perm::lattice_3D_26n;
+namespace {
+perm::parameters_in_t make_perm_parameters(const double &k_bending,
+                                           const size_t &monomers) {
     perm::parameters_in_t parameters_in;
     parameters_in.monomers = monomers;
-    parameters_in.max_tries = max_tries;
-    parameters_in.lattice = lattice;
+    parameters_in.max_tries = 1000;
+    parameters_in.lattice = perm::lattice_3D_26n;
     parameters_in.energy_grow_func =
             [k = k_bending](const perm::single_chain_t<int> &input_chain,
                             const perm::vec3D_t<int> &new_monomer) {
                 return perm::energy_grow_bending(input_chain, new_monomer, k);
             };
-    // std::cout << "Parameters = " << std::endl;
-    // parameters_in.print(std::cout);
-    auto chain_weight_pair = perm::mc_saw_perm(parameters_in);
-    auto &chain = chain_weight_pair.first;
-    chain.print(std::cout);
+    return parameters_in;
+}
+
+/**
+ * Transform the lattice chain into the simulation space, and write the
+ * points between start and end into edge_points.
+ *
+ * @return ratio between contour length and end to end distance of the chain
+ */
+double chain_to_edge_points(const perm::single_chain_t<int> &chain,
+                            const PointType &start_point,
+                            const PointType &end_point,
+                            PointContainer &edge_points) {
     // lattice distances are in a square/cubic grid of unit spacing
     // lattice_start_point is always {0,0,0}
-    // Compute distance between start and end in lattice space (for PERM)
-    auto real_ete_vector = ArrayUtilities::minus(end_point, start_point);
-    auto lattice_ete_vector = perm::end_to_end_vector(chain);
-    std::cout << "lattice_ete_vector" << std::endl;
-    std::cout << lattice_ete_vector.x << ", " << lattice_ete_vector.y
-              << ", " << lattice_ete_vector.z << std::endl;
-    // for(const auto & l : lattice_ete_vector.e) {
-    //     std::cout << l << ", ";
-    // }
-    // std::cout << std::endl;
-    // auto dist_lattice = perm::end_to_end_distance(chain);
+    const auto real_ete_vector = ArrayUtilities::minus(end_point, start_point);
+    const auto lattice_ete_vector = perm::end_to_end_vector(chain);
     ArrayUtilities::Array3D scaling_factor_lattice_to_real = {{0, 0, 0}};
-
     for (size_t d = 0; d < real_ete_vector.size(); d++) {
         if (lattice_ete_vector[d] == 0) {
             scaling_factor_lattice_to_real[d] = 1;
@@ -71,35 +62,51 @@ generate_contour_length(const PointType &start_point,
         }
     }
 
-    size_t num_chain_points = chain.points.size();
-    edge_points.resize(num_chain_points);
-    edge_points[0] = start_point;
-
-    for (size_t i = 1; i < num_chain_points; i++) {
-        auto lattice_monomer_vector =
+    // The first and last points of the chain are the source/target nodes.
+    const size_t num_chain_points = chain.points.size();
+    edge_points.resize(num_chain_points < 2 ? 0 : num_chain_points - 2);
+    PointType point = start_point;
+    for (size_t i = 1; i + 1 < num_chain_points; i++) {
+        const auto lattice_monomer_vector =
                 perm::minus(chain.points[i], chain.points[i - 1]);
         for (size_t d = 0; d < 3; d++) {
-            edge_points[i][d] = edge_points[i - 1][d] +
-                                lattice_monomer_vector[d] *
-                                        scaling_factor_lattice_to_real[d];
+            point[d] += lattice_monomer_vector[d] *
+                        scaling_factor_lattice_to_real[d];
         }
+        edge_points[i - 1] = point;
     }
-    std::cout << "scaling_factor: "
-              << ArrayUtilities::to_string(scaling_factor_lattice_to_real)
-              << std::endl;
-    print_edge_points(edge_points, std::cout);
-    // Remove first and last points of edge_points (these are the
-    // source/target nodes)
+    return perm::contour_length(chain) / perm::end_to_end_distance(chain);
+}
+} // namespace
 
-    edge_points.erase(std::begin(edge_points));
-    edge_points.pop_back();
-    std::cout << "After deletion" << std::endl;
-    print_edge_points(edge_points, std::cout);
-    double contour_end_to_end_ratio =
-            perm::contour_length(chain) / perm::end_to_end_distance(chain);
+std::pair<PointContainer, double>
+generate_contour_length(const PointType &start_point,
+                        const PointType &end_point,
+                        const double &k_bending,
+                        const size_t &monomers) {
+    const auto parameters_in = make_perm_parameters(k_bending, monomers);
+    const auto chain_weight_pair = perm::mc_saw_perm(parameters_in);
+    auto edge_points = PointContainer();
+    const double contour_end_to_end_ratio = chain_to_edge_points(
+            chain_weight_pair.first, start_point, end_point, edge_points);
     return std::make_pair(edge_points, contour_end_to_end_ratio);
 }
 
+std::vector<double> generate_contour_lengths(GraphType &graph,
+                                             const double &k_bending,
+                                             const size_t &monomers) {
+    std::vector<double> ratios;
+    ratios.reserve(boost::num_edges(graph));
+    // The PERM parameters are shared by all the edges.
+    const auto parameters_in = make_perm_parameters(k_bending, monomers);
+    const auto edges = boost::edges(graph);
+    for (auto ei = edges.first; ei != edges.second; ++ei) {
+        const auto chain_weight_pair = perm::mc_saw_perm(parameters_in);
+        ratios.push_back(chain_to_edge_points(
+                chain_weight_pair.first, graph[boost::source(*ei, graph)].pos,
+                graph[boost::target(*ei, graph)].pos, graph[*ei].edge_points));
+    }
+    return ratios;
+}
 
 } // end ns SG
-
@@ -0,0 +1,419 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+
+#include "cramer_von_mises_incremental.hpp"
+
+#include <limits>
+#include <stdexcept>
+
+namespace SG {
+
+namespace {
+/** Terms of the test of a bin with count m and shift s. */
+struct BinTerms {
+    BinTerms(const double &m, const double &s)
+            : cubic(m * (m + 1) * (2 * m + 1) / 6.0),
+              quadratic(m * (m + 1)),
+              quadratic_s(quadratic * s),
+              m_s(m * s),
+              m_s2(m * s * s) {}
+    double cubic;
+    double quadratic;
+    double quadratic_s;
+    double m_s;
+    double m_s2;
+};
+} // namespace
+
+void cramer_von_mises_incremental::reset_counts(
+        const std::vector<long> &counts,
+        const std::vector<double> &F_optimized,
+        const std::vector<double> &bin_weights) {
+    if (counts.size() != F_optimized.size() ||
+        (!bin_weights.empty() && bin_weights.size() != counts.size())) {
+        throw std::runtime_error("cramer_von_mises_incremental: histo_counts, "
+                                 "F_optimized and bin_weights must have the "
+                                 "same size.");
+    }
+    bins_ = counts.size();
+    counts_ = counts;
+    F_optimized_ = F_optimized;
+    bin_weights_ = bin_weights;
+    total_counts_ = 0;
+    negative_bins_ = 0;
+    for (const auto &c : counts_) {
+        total_counts_ += c;
+        negative_bins_ += c < 0;
+    }
+    use_tree_ = bins_ >= tree_min_bins;
+    if (use_tree_) {
+        tree_.assign(4 * bins_, Node());
+        s_.clear();
+        for (auto *prefix :
+             {&prefix_cubic_, &prefix_quadratic_, &prefix_quadratic_s_,
+              &prefix_m_, &prefix_m_s_, &prefix_m_s2_, &prefix_weighted_m_}) {
+            prefix->clear();
+        }
+    } else {
+        tree_.clear();
+        s_.assign(bins_, 0.0);
+        for (auto *prefix :
+             {&prefix_cubic_, &prefix_quadratic_, &prefix_quadratic_s_,
+              &prefix_m_, &prefix_m_s_, &prefix_m_s2_, &prefix_weighted_m_}) {
+            prefix->assign(bins_ + 1, 0.0);
+        }
+    }
+    this->rebuild();
+}
+
+void cramer_von_mises_incremental::rebuild() {
+    changes_since_rebuild_ = 0;
+    if (bins_ == 0) {
+        return;
+    }
+    if (!use_tree_) {
+        this->update_prefix_sums(0);
+        return;
+    }
+    std::vector<double> s(bins_);
+    long cumulative_counts_exclusive = 0;
+    for (size_t i = 0; i < bins_; ++i) {
+        s[i] = cumulative_counts_exclusive - F_optimized_[i];
+        cumulative_counts_exclusive += counts_[i];
+    }
+    this->build(1, 0, bins_, s);
+}
+
+void cramer_von_mises_incremental::build(const size_t &node,
+                                         const size_t &begin,
+                                         const size_t &end,
+                                         const std::vector<double> &s) {
+    auto &current = tree_[node];
+    current.lazy_shift = 0.0;
+    if (end - begin == 1) {
+        current.s = s[begin];
+        this->set_leaf(current, begin);
+        return;
+    }
+    const size_t middle = (begin + end) / 2;
+    this->build(2 * node, begin, middle, s);
+    this->build(2 * node + 1, middle, end, s);
+    this->pull(node);
+}
+
+void cramer_von_mises_incremental::set_leaf(Node &leaf,
+                                            const size_t &bin) const {
+    const double m = counts_[bin];
+    const BinTerms terms(m, leaf.s);
+    leaf.sum_cubic = terms.cubic;
+    leaf.sum_quadratic = terms.quadratic;
+    leaf.sum_quadratic_s = terms.quadratic_s;
+    leaf.sum_m = m;
+    leaf.sum_m_s = terms.m_s;
+    leaf.sum_m_s2 = terms.m_s2;
+    leaf.sum_weighted_m = bin_weights_.empty() ? 0.0 : bin_weights_[bin] * m;
+}
+
+void cramer_von_mises_incremental::update_prefix_sums(const size_t &bin) {
+    // Cumulative counts are integers, exact in a double.
+    double cumulative_counts_exclusive = prefix_m_[bin];
+    for (size_t i = bin; i < bins_; ++i) {
+        const double m = counts_[i];
+        s_[i] = cumulative_counts_exclusive - F_optimized_[i];
+        const BinTerms terms(m, s_[i]);
+        prefix_cubic_[i + 1] = prefix_cubic_[i] + terms.cubic;
+        prefix_quadratic_[i + 1] = prefix_quadratic_[i] + terms.quadratic;
+        prefix_quadratic_s_[i + 1] =
+                prefix_quadratic_s_[i] + terms.quadratic_s;
+        prefix_m_[i + 1] = prefix_m_[i] + m;
+        prefix_m_s_[i + 1] = prefix_m_s_[i] + terms.m_s;
+        prefix_m_s2_[i + 1] = prefix_m_s2_[i] + terms.m_s2;
+        prefix_weighted_m_[i + 1] =
+                prefix_weighted_m_[i] +
+                (bin_weights_.empty() ? 0.0 : bin_weights_[i] * m);
+        cumulative_counts_exclusive += m;
+    }
+}
+
+void cramer_von_mises_incremental::pull(const size_t &node) {
+    auto &current = tree_[node];
+    const auto &left = tree_[2 * node];
+    const auto &right = tree_[2 * node + 1];
+    current.sum_cubic = left.sum_cubic + right.sum_cubic;
+    current.sum_quadratic = left.sum_quadratic + right.sum_quadratic;
+    current.sum_quadratic_s = left.sum_quadratic_s + right.sum_quadratic_s;
+    current.sum_m = left.sum_m + right.sum_m;
+    current.sum_m_s = left.sum_m_s + right.sum_m_s;
+    current.sum_m_s2 = left.sum_m_s2 + right.sum_m_s2;
+    current.sum_weighted_m = left.sum_weighted_m + right.sum_weighted_m;
+}
+
+void cramer_von_mises_incremental::apply_shift(const size_t &node,
+                                               const double &shift) {
+    auto &current = tree_[node];
+    // sum m (s + shift)^2 uses sum m s before shifting it.
+    current.sum_m_s2 +=
+            2 * shift * current.sum_m_s + shift * shift * current.sum_m;
+    current.sum_m_s += shift * current.sum_m;
+    current.sum_quadratic_s += shift * current.sum_quadratic;
+    current.lazy_shift += shift;
+    current.s += shift;
+}
+
+void cramer_von_mises_incremental::push(const size_t &node) {
+    auto &current = tree_[node];
+    if (current.lazy_shift != 0.0) {
+        this->apply_shift(2 * node, current.lazy_shift);
+        this->apply_shift(2 * node + 1, current.lazy_shift);
+        current.lazy_shift = 0.0;
+    }
+}
+
+void cramer_von_mises_incremental::update(const size_t &node,
+                                          const size_t &begin,
+                                          const size_t &end,
+                                          const BinChange *first,
+                                          const BinChange *last,
+                                          const double &shift) {
+    if (first == last) {
+        if (shift != 0.0) {
+            this->apply_shift(node, shift);
+        }
+        return;
+    }
+    if (end - begin == 1) {
+        auto &leaf = tree_[node];
+        leaf.s += shift;
+        this->set_leaf(leaf, begin);
+        return;
+    }
+    this->push(node);
+    const size_t middle = (begin + end) / 2;
+    const BinChange *split = first;
+    double shift_right = shift;
+    while (split != last && split->first < middle) {
+        shift_right += split->second;
+        ++split;
+    }
+    this->update(2 * node, begin, middle, first, split, shift);
+    this->update(2 * node + 1, middle, end, split, last, shift_right);
+    this->pull(node);
+}
+
+void cramer_von_mises_incremental::change_count(const size_t &bin,
+                                                const long &delta) {
+    const bool was_negative = counts_[bin] < 0;
+    counts_[bin] += delta;
+    const bool is_negative = counts_[bin] < 0;
+    if (was_negative != is_negative) {
+        is_negative ? ++negative_bins_ : --negative_bins_;
+    }
+}
+
+void cramer_von_mises_incremental::add(const size_t &bin, const long &delta) {
+    if (delta == 0) {
+        return;
+    }
+    const BinChange change(bin, delta);
+    this->change_count(bin, delta);
+    if (!use_tree_) {
+        this->update_prefix_sums(bin);
+        return;
+    }
+    if (++changes_since_rebuild_ >= rebuild_period) {
+        this->rebuild();
+        return;
+    }
+    this->update(1, 0, bins_, &change, &change + 1, 0.0);
+}
+
+void cramer_von_mises_incremental::add(const std::vector<BinChange> &changes) {
+    if (changes.empty()) {
+        return;
+    }
+    for (const auto &change : changes) {
+        this->change_count(change.first, change.second);
+    }
+    if (!use_tree_) {
+        this->update_prefix_sums(changes.front().first);
+        return;
+    }
+    changes_since_rebuild_ += changes.size();
+    if (changes_since_rebuild_ >= rebuild_period) {
+        this->rebuild();
+        return;
+    }
+    this->update(1, 0, bins_, changes.data(), changes.data() + changes.size(),
+                 0.0);
+}
+
+cramer_von_mises_incremental::Sums cramer_von_mises_incremental::query(
+        const size_t &node,
+        const size_t &begin,
+        const size_t &end,
+        const BinChange *first,
+        const BinChange *last,
+        const double &shift) const {
+    const auto &current = tree_[node];
+    Sums sums;
+    if (first == last) {
+        sums.cubic = current.sum_cubic;
+        sums.quadratic_s = current.sum_quadratic_s + shift * current.sum_quadratic;
+        sums.m_s2 = current.sum_m_s2 + 2 * shift * current.sum_m_s +
+                    shift * shift * current.sum_m;
+        return sums;
+    }
+    if (end - begin == 1) {
+        const BinTerms terms(counts_[begin] + first->second,
+                             current.s + shift);
+        sums.cubic = terms.cubic;
+        sums.quadratic_s = terms.quadratic_s;
+        sums.m_s2 = terms.m_s2;
+        return sums;
+    }
+    const size_t middle = (begin + end) / 2;
+    const BinChange *split = first;
+    const double shift_left = shift + current.lazy_shift;
+    double shift_right = shift_left;
+    while (split != last && split->first < middle) {
+        shift_right += split->second;
+        ++split;
+    }
+    const auto left =
+            this->query(2 * node, begin, middle, first, split, shift_left);
+    const auto right =
+            this->query(2 * node + 1, middle, end, split, last, shift_right);
+    sums.cubic = left.cubic + right.cubic;
+    sums.quadratic_s = left.quadratic_s + right.quadratic_s;
+    sums.m_s2 = left.m_s2 + right.m_s2;
+    return sums;
+}
+
+bool cramer_von_mises_incremental::any_negative_after(
+        const std::vector<BinChange> &changes) const {
+    size_t negative_bins = negative_bins_;
+    for (const auto &change : changes) {
+        const long &count = counts_[change.first];
+        const bool was_negative = count < 0;
+        const bool is_negative = count + change.second < 0;
+        if (was_negative != is_negative) {
+            is_negative ? ++negative_bins : --negative_bins;
+        }
+    }
+    return negative_bins > 0;
+}
+
+double cramer_von_mises_incremental::value_from_sums(const Sums &sums) const {
+    const double inverse_square_total_counts =
+            1.0 / (total_counts_ * total_counts_);
+    return 1.0 / (12 * total_counts_) +
+           inverse_square_total_counts *
+                   (sums.cubic + sums.quadratic_s + sums.m_s2);
+}
+
+double cramer_von_mises_incremental::value() const {
+    if (bins_ == 0) {
+        return 0.0;
+    }
+    if (negative_bins_ > 0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    Sums sums;
+    if (use_tree_) {
+        const auto &root = tree_[1];
+        sums.cubic = root.sum_cubic;
+        sums.quadratic_s = root.sum_quadratic_s;
+        sums.m_s2 = root.sum_m_s2;
+    } else {
+        sums.cubic = prefix_cubic_[bins_];
+        sums.quadratic_s = prefix_quadratic_s_[bins_];
+        sums.m_s2 = prefix_m_s2_[bins_];
+    }
+    return this->value_from_sums(sums);
+}
+
+double cramer_von_mises_incremental::value_after(
+        const std::vector<BinChange> &changes) const {
+    if (changes.empty()) {
+        return this->value();
+    }
+    if (this->any_negative_after(changes)) {
+        return std::numeric_limits<double>::infinity();
+    }
+    if (use_tree_) {
+        return this->value_from_sums(this->query(
+                1, 0, bins_, changes.data(), changes.data() + changes.size(),
+                0.0));
+    }
+    Sums sums;
+    sums.cubic = prefix_cubic_[bins_];
+    sums.quadratic_s = prefix_quadratic_s_[bins_];
+    sums.m_s2 = prefix_m_s2_[bins_];
+    // The bins between two changed bins are all shifted by the same amount:
+    // sum m (m + 1) (s + shift) = sum m (m + 1) s + shift sum m (m + 1)
+    // sum m (s + shift)^2 = sum m s^2 + 2 shift sum m s + shift^2 sum m
+    const auto shift_range = [&](const size_t &begin, const size_t &end,
+                                 const double &shift) {
+        if (shift == 0.0 || begin >= end) {
+            return;
+        }
+        sums.quadratic_s +=
+                shift * (prefix_quadratic_[end] - prefix_quadratic_[begin]);
+        sums.m_s2 += 2 * shift * (prefix_m_s_[end] - prefix_m_s_[begin]) +
+                     shift * shift * (prefix_m_[end] - prefix_m_[begin]);
+    };
+    double shift = 0.0;
+    size_t begin = 0;
+    for (const auto &change : changes) {
+        const size_t &bin = change.first;
+        shift_range(begin, bin, shift);
+        const double m = counts_[bin];
+        const BinTerms old_terms(m, s_[bin]);
+        const BinTerms new_terms(m + change.second, s_[bin] + shift);
+        sums.cubic += new_terms.cubic - old_terms.cubic;
+        sums.quadratic_s += new_terms.quadratic_s - old_terms.quadratic_s;
+        sums.m_s2 += new_terms.m_s2 - old_terms.m_s2;
+        shift += change.second;
+        begin = bin + 1;
+    }
+    shift_range(begin, bins_, shift);
+    return this->value_from_sums(sums);
+}
+
+double cramer_von_mises_incremental::weighted_counts() const {
+    if (bins_ == 0) {
+        return 0.0;
+    }
+    return use_tree_ ? tree_[1].sum_weighted_m : prefix_weighted_m_[bins_];
+}
+
+double cramer_von_mises_incremental::weighted_counts_after(
+        const std::vector<BinChange> &changes) const {
+    double weighted_counts = this->weighted_counts();
+    if (!bin_weights_.empty()) {
+        for (const auto &change : changes) {
+            weighted_counts += bin_weights_[change.first] * change.second;
+        }
+    }
+    return weighted_counts;
+}
+
+} // namespace SG
@@ -20,6 +20,7 @@
 
 #include "degree_viger_generator.hpp"
 #include "degree_viger_generator_hash.hpp"
+#include <algorithm>
 #include <iterator>
 
 namespace SG {
@@ -425,11 +426,15 @@ unsigned long degree_viger_generator::shuffle(unsigned long times,
     double avg_T = 0;
     unsigned long next = times;
     next = 0;
+    backup_buffer_ = std::unique_ptr<int[]>{new int[arcs_ / 2]};
+    // The graph might have changed since the last shuffle.
+    tree_valid_ = false;
 
     // Shuffle: while #edge swap attempts validated by connectivity < times ...
     while (times > nb_swaps && max_times > all_swaps) {
         // Backup graph
-        auto save = backup();
+        backup(backup_buffer_.get());
+        begin_tree_window();
         // Prepare counters, K, T
         unsigned long swaps = 0;
         int K_int = 0;
@@ -479,7 +484,8 @@ unsigned long degree_viger_generator::shuffle(unsigned long times,
         if (ok) {
             nb_swaps += swaps;
         } else {
-            restore(save.get());
+            restore(backup_buffer_.get());
+            restore_tree_window();
             next = nb_swaps;
         }
         // Adjust K and T following the heuristics.
@@ -517,6 +523,8 @@ unsigned long degree_viger_generator::shuffle(unsigned long times,
                 }
             } else {
                 K *= 1.35;
+                Kbuff_up = std::unique_ptr<int[]>{new int[int(K) + 1]{}};
+                Kbuff = Kbuff_up.get();
             }
             break;
         case ShuffleType::OPTIMAL_HEURISTICS:
@@ -526,6 +534,8 @@ unsigned long degree_viger_generator::shuffle(unsigned long times,
             break;
         case ShuffleType::BRUTE_FORCE_HEURISTICS:
             K *= 2;
+            Kbuff_up = std::unique_ptr<int[]>{new int[int(K) + 1]{}};
+            Kbuff = Kbuff_up.get();
             break;
         default:
             throw std::logic_error(
@@ -535,7 +545,7 @@ unsigned long degree_viger_generator::shuffle(unsigned long times,
         }
     }
 
-    if (max_times <= all_swaps) {
+    if (times > nb_swaps && max_times <= all_swaps) {
         std::cerr << "WARNING: Cannot shuffle graph, maybe there is only a "
                      "single one?"
                   << std::endl;
@@ -685,7 +695,8 @@ void degree_viger_generator::restore(int *b) {
     for (int i = 0; i < arcs_; i++) {
         links_[i] = HASH_NONE;
     }
-    auto dd = deg_;
+    restore_degrees_ = deg_;
+    const auto &dd = restore_degrees_;
     for (int i = 0; i < num_vertices_; i++) {
         deg_[i] = 0;
     }
@@ -756,6 +767,7 @@ bool degree_viger_generator::try_shuffle(int T, int K, int *backup_graph) {
     }
     auto backup_unique = (backup_graph == nullptr) ? backup() : nullptr;
     int *back = (backup_graph == nullptr) ? backup_unique.release() : backup_graph;
+    begin_tree_window();
     // perform T edge swap attempts
     while (T--) { //NOLINT
         random_edge_swap(K, Kbuff, visited);
@@ -766,6 +778,7 @@ bool degree_viger_generator::try_shuffle(int T, int K, int *backup_graph) {
     // check & restore
     bool yo = is_connected();
     restore(back);
+    restore_tree_window();
     // cannot avoid this delete[] without changing api of this function.
     if (backup_graph == nullptr) {
         delete[] back;
@@ -774,9 +787,13 @@ bool degree_viger_generator::try_shuffle(int T, int K, int *backup_graph) {
 }
 
 std::unique_ptr<int[]> degree_viger_generator::backup() {
-    using namespace generator;
     auto b = std::unique_ptr<int[]>{new int[arcs_ / 2]};
-    auto *br = b.get();
+    backup(b.get());
+    return b;
+}
+
+void degree_viger_generator::backup(int *br) const {
+    using namespace generator;
     int *p = links_;
     for (int i = 0; i < num_vertices_; i++) {
         for (int d = HASH_SIZE(deg_[i]); d--; p++) { //NOLINT
@@ -785,8 +802,6 @@ std::unique_ptr<int[]> degree_viger_generator::backup() {
             }
         }
     }
-    // assert(b == std::begin(b) + (arcs_ / 2));
-    return b;
 }
 
 int degree_viger_generator::random_edge_swap(int K, int *Kbuff, bool *visited) {
@@ -816,10 +831,10 @@ int degree_viger_generator::random_edge_swap(int K, int *Kbuff, bool *visited) {
     int *t1f2 = H_rpl(neigh_[t1], deg_[t1], f1, f2);
     int *t2f1 = H_rpl(neigh_[t2], deg_[t2], f2, f1);
     // isolation test
-    if (K <= 2) {
-        return 1;
-    }
-    if (!isolated(f1, K, Kbuff, visited) && !isolated(f2, K, Kbuff, visited)) {
+    if (K <= 2 || (!isolated(f1, K, Kbuff, visited) &&
+                   !isolated(f2, K, Kbuff, visited))) {
+        cut_tree_edge(f1, t1);
+        cut_tree_edge(f2, t2);
         return 1;
     }
     // undo swap
@@ -856,13 +871,193 @@ bool degree_viger_generator::is_edge(int a, int b) const {
     return H_is(neigh_[b], deg_[b], a);
 }
 
-bool degree_viger_generator::is_connected() const {
-    auto visited_up = std::unique_ptr<bool[]>{new bool[num_vertices_]{}};
-    auto *visited = visited_up.get();
-    auto buff_up = std::unique_ptr<int[]>{new int[num_vertices_]{}};
-    auto *buff = buff_up.get();
-    int comp_size = depth_search(visited, buff);
-    return (comp_size == num_vertices_);
+bool degree_viger_generator::is_connected() {
+    if (!tree_valid_) {
+        return build_spanning_tree();
+    }
+    if (tree_cuts_.empty()) {
+        return true;
+    }
+    return is_connected_from_cuts();
+}
+
+bool degree_viger_generator::build_spanning_tree() {
+    using namespace generator;
+    tree_valid_ = false;
+    tree_cuts_.clear();
+    tree_check_work_ = 0;
+    if (num_vertices_ == 0) {
+        return true;
+    }
+    ++tree_builds_;
+    tree_parent_.assign(num_vertices_, -2);
+    tree_begin_.resize(num_vertices_);
+    tree_end_.resize(num_vertices_);
+    tree_order_.resize(num_vertices_);
+    tree_cut_.assign(num_vertices_, 0);
+    // Breadth-first search, tree_order_ is the queue.
+    auto &bfs = tree_order_;
+    int tail = 0;
+    tree_parent_[0] = -1;
+    bfs[tail++] = 0;
+    for (int head = 0; head < tail; head++) {
+        const int v = bfs[head];
+        int *ww = neigh_[v];
+        for (int k = HASH_SIZE(deg_[v]); k--; ww++) { //NOLINT
+            const int w = *ww;
+            if (w != HASH_NONE && tree_parent_[w] == -2) {
+                tree_parent_[w] = v;
+                bfs[tail++] = w;
+            }
+        }
+    }
+    if (tail != num_vertices_) {
+        return false;
+    }
+    // Subtree sizes in tree_end_, children are after their parent in bfs.
+    std::fill(tree_end_.begin(), tree_end_.end(), 1);
+    for (int i = num_vertices_ - 1; i > 0; i--) {
+        tree_end_[tree_parent_[bfs[i]]] += tree_end_[bfs[i]];
+    }
+    // Preorder intervals, tree_buffer_ is the next free position of the
+    // children of each vertex.
+    tree_buffer_.resize(num_vertices_);
+    tree_begin_[0] = 0;
+    tree_buffer_[0] = 1;
+    for (int i = 1; i < num_vertices_; i++) {
+        const int v = bfs[i];
+        const int p = tree_parent_[v];
+        tree_begin_[v] = tree_buffer_[p];
+        tree_buffer_[p] += tree_end_[v];
+        tree_buffer_[v] = tree_begin_[v] + 1;
+    }
+    for (int v = 0; v < num_vertices_; v++) {
+        tree_end_[v] += tree_begin_[v];
+        tree_order_[tree_begin_[v]] = v;
+    }
+    tree_valid_ = true;
+    return true;
+}
+
+void degree_viger_generator::cut_tree_edge(int a, int b) {
+    if (!tree_valid_) {
+        return;
+    }
+    const int child = (tree_parent_[a] == b) ? a
+                      : (tree_parent_[b] == a) ? b
+                                               : -1;
+    if (child != -1 && !tree_cut_[child]) {
+        tree_cut_[child] = 1;
+        tree_cuts_.push_back(child);
+    }
+}
+
+bool degree_viger_generator::is_connected_from_cuts() {
+    using namespace generator;
+    // Each cut vertex roots a fragment: its subtree minus the subtrees of
+    // the cut vertices below it. The fragment 0 is the one of the root.
+    // The vertices of a fragment are connected by tree edges, search from
+    // each fragment until reaching a fragment connected to the root.
+    auto &cuts = tree_sorted_cuts_;
+    cuts = tree_cuts_;
+    std::sort(cuts.begin(), cuts.end(), [this](const int a, const int b) {
+        return tree_begin_[a] < tree_begin_[b];
+    });
+    const int ncuts = static_cast<int>(cuts.size());
+    // Enclosing cut of each cut (index in cuts, -1 if top-level).
+    auto &enclosing = tree_enclosing_;
+    enclosing.resize(ncuts);
+    auto &stack = tree_queue_;
+    stack.clear();
+    for (int i = 0; i < ncuts; i++) {
+        const int c = cuts[i];
+        while (!stack.empty() &&
+               tree_end_[cuts[stack.back()]] <= tree_begin_[c]) {
+            stack.pop_back();
+        }
+        enclosing[i] = stack.empty() ? -1 : stack.back();
+        stack.push_back(i);
+    }
+    const auto fragment_of = [&](const int v) {
+        const int pos = tree_begin_[v];
+        int i = static_cast<int>(
+                        std::upper_bound(cuts.begin(), cuts.end(), pos,
+                                         [this](const int p, const int c) {
+                                             return p < tree_begin_[c];
+                                         }) -
+                        cuts.begin()) -
+                1;
+        while (i >= 0 && pos >= tree_end_[cuts[i]]) {
+            i = enclosing[i];
+        }
+        return i + 1;
+    };
+    auto &connected = tree_connected_;
+    connected.assign(ncuts + 1, 0);
+    connected[0] = 1;
+    tree_visited_.resize(num_vertices_);
+    size_t work = ncuts;
+    auto &queue = tree_queue_;
+    for (int i = 0; i < ncuts; i++) {
+        if (connected[i + 1]) {
+            continue;
+        }
+        // Breadth-first search from the fragment, it only visits vertices
+        // of fragments that are not known to be connected.
+        queue.clear();
+        queue.push_back(cuts[i]);
+        tree_visited_[cuts[i]] = 1;
+        bool reached = false;
+        for (size_t head = 0; head < queue.size() && !reached; head++) {
+            const int v = queue[head];
+            int *ww = neigh_[v];
+            for (int k = HASH_SIZE(deg_[v]); k--; ww++) { //NOLINT
+                const int w = *ww;
+                if (w == HASH_NONE || tree_visited_[w]) {
+                    continue;
+                }
+                if (connected[fragment_of(w)]) {
+                    reached = true;
+                    break;
+                }
+                tree_visited_[w] = 1;
+                queue.push_back(w);
+            }
+        }
+        for (const int v : queue) {
+            tree_visited_[v] = 0;
+            if (reached) {
+                connected[fragment_of(v)] = 1;
+            }
+        }
+        if (!reached) {
+            return false;
+        }
+        work += queue.size();
+    }
+    // Rebuild the tree when the searches since the last build are as
+    // expensive as a build.
+    tree_check_work_ += work;
+    if (tree_check_work_ > static_cast<size_t>(num_vertices_)) {
+        return build_spanning_tree();
+    }
+    return true;
+}
+
+void degree_viger_generator::begin_tree_window() {
+    tree_window_cuts_ = tree_cuts_.size();
+    tree_window_builds_ = tree_builds_;
+}
+
+void degree_viger_generator::restore_tree_window() {
+    if (tree_builds_ != tree_window_builds_) {
+        tree_valid_ = false;
+        return;
+    }
+    for (size_t i = tree_window_cuts_; i < tree_cuts_.size(); i++) {
+        tree_cut_[tree_cuts_[i]] = 0;
+    }
+    tree_cuts_.resize(tree_window_cuts_);
 }
 
 int degree_viger_generator::depth_search(bool *visited,
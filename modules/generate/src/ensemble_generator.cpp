@@ -0,0 +1,144 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+#include "ensemble_generator.hpp"
+#include "rng.hpp"
+#include "spatial_graph_io.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace SG {
+
+void write_ensemble_summary_header(std::ostream &os) {
+    os << "seed\tenergy\tenergy_initial\tsteps_performed\t"
+          "accepted_transitions\trejected_transitions\t"
+          "high_temp_transitions\tconsecutive_failures\ttemp_initial\t"
+          "temp_current\ttime_elapsed\toutput_file\n";
+}
+
+void write_ensemble_summary_line(std::ostream &os,
+                                 const ensemble_run_result &run) {
+    const auto &tp = run.transition_params;
+    const auto precision = os.precision();
+    os.precision(std::numeric_limits<double>::max_digits10);
+    os << run.seed << '\t' << tp.energy << '\t' << tp.energy_initial << '\t'
+       << tp.steps_performed << '\t' << tp.accepted_transitions << '\t'
+       << tp.rejected_transitions << '\t' << tp.high_temp_transitions << '\t'
+       << tp.consecutive_failures << '\t' << tp.temp_initial << '\t'
+       << tp.temp_current << '\t' << tp.time_elapsed << '\t'
+       << run.output_file << '\n';
+    os.precision(precision);
+}
+
+ensemble_result
+generate_ensemble(const simulated_annealing_generator_config_tree &tree,
+                  const ensemble_parameters &params) {
+    const auto t_start = std::chrono::high_resolution_clock::now();
+    const size_t num_runs = params.num_runs;
+    const size_t available_threads =
+            params.num_threads == 0
+                    ? std::max(1u, std::thread::hardware_concurrency())
+                    : params.num_threads;
+    const size_t threads = std::min(available_threads, num_runs);
+    const bool write_output = !params.output_prefix.empty();
+
+    std::ofstream summary;
+    if (write_output) {
+        const std::string summary_file = params.output_prefix + "_summary.tsv";
+        summary.open(summary_file);
+        if (!summary.is_open()) {
+            throw std::runtime_error(
+                    "generate_ensemble: failed to open summary file: " +
+                    summary_file);
+        }
+        write_ensemble_summary_header(summary);
+        summary.flush();
+    }
+
+    ensemble_result output;
+    output.runs.resize(num_runs);
+    std::mutex summary_mutex;
+    std::atomic<size_t> next_run(0);
+    std::atomic<bool> failed(false);
+    std::vector<std::exception_ptr> errors(std::max<size_t>(threads, 1));
+    const auto worker = [&](const size_t &thread_index) {
+        // Each run seeds the thread_local engine, restore it afterwards.
+        const auto thread_engine = RNG::engine();
+        try {
+            for (size_t i = next_run++; i < num_runs && !failed;
+                 i = next_run++) {
+                auto &run = output.runs[i];
+                run.seed = params.first_seed + i;
+                RNG::engine().seed(run.seed);
+                auto gen = simulated_annealing_generator(tree);
+                gen.show_progress = false;
+                gen.engine();
+                run.transition_params = gen.transition_params;
+                if (write_output) {
+                    run.output_file = params.output_prefix + "_seed_" +
+                                      std::to_string(run.seed) + ".dot";
+                    write_graphviz_sg(run.output_file, gen.graph_);
+                    std::lock_guard<std::mutex> lock(summary_mutex);
+                    write_ensemble_summary_line(summary, run);
+                    summary.flush();
+                }
+            }
+        } catch (...) {
+            failed = true;
+            errors[thread_index] = std::current_exception();
+        }
+        RNG::engine() = thread_engine;
+    };
+    if (threads <= 1) {
+        worker(0);
+    } else {
+        std::vector<std::thread> workers;
+        workers.reserve(threads);
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back(worker, t);
+        }
+        for (auto &w : workers) {
+            w.join();
+        }
+    }
+    for (const auto &error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    for (const auto &run : output.runs) {
+        output.steps_performed += run.transition_params.steps_performed;
+    }
+    const std::chrono::duration<double> elapsed =
+            std::chrono::high_resolution_clock::now() - t_start;
+    output.time_elapsed = elapsed.count();
+    return output;
+}
+
+} // namespace SG
@@ -20,7 +20,6 @@
 
 #include "generate_common.hpp"
 #include "rng.hpp"
-#include "spatial_graph_utilities.hpp" // for AdjacentVerticesPositions
 #include <tuple>                       // for std::tie
 
 namespace SG {
@@ -59,6 +58,13 @@ PointType generate_random_array(const double &max_modulus) {
 std::vector<double> cosine_directors_from_connected_edges(
         const std::vector<VectorType> &outgoing_edges) {
     std::vector<double> cosine_directors;
+    cosine_directors_from_connected_edges(outgoing_edges, cosine_directors);
+    return cosine_directors;
+}
+
+void cosine_directors_from_connected_edges(
+        const std::vector<VectorType> &outgoing_edges,
+        std::vector<double> &cosine_directors) {
     for (auto first = outgoing_edges.begin(); first != outgoing_edges.end();
          ++first) {
         for (auto second = first + 1; second != outgoing_edges.end();
@@ -68,7 +74,6 @@ std::vector<double> cosine_directors_from_connected_edges(
                     ArrayUtilities::cos_director(*first, *second));
         }
     }
-    return cosine_directors;
 }
 
 std::vector<double> cosine_directors_between_edges_and_target_edge(
@@ -76,11 +81,19 @@ std::vector<double> cosine_directors_between_edges_and_target_edge(
         const VectorType &outgoing_target_edge) {
     std::vector<double> cosine_directors;
     cosine_directors.reserve(outgoing_edges.size());
+    cosine_directors_between_edges_and_target_edge(
+            outgoing_edges, outgoing_target_edge, cosine_directors);
+    return cosine_directors;
+}
+
+void cosine_directors_between_edges_and_target_edge(
+        const std::vector<VectorType> &outgoing_edges,
+        const VectorType &outgoing_target_edge,
+        std::vector<double> &cosine_directors) {
     for(const auto & out_edge : outgoing_edges) {
         cosine_directors.emplace_back(
                 ArrayUtilities::cos_director(out_edge, outgoing_target_edge));
     }
-    return cosine_directors;
 }
 
 std::vector<double> get_all_end_to_end_distances_of_edges(
@@ -139,20 +152,25 @@ std::vector<VectorType> get_adjacent_edges_from_source(
         const ArrayUtilities::boundary_condition &boundary_condition) {
 
     std::vector<VectorType> adj_edges; // output
+    get_adjacent_edges_from_source(source, ignore_node, graph,
+                                   boundary_condition, adj_edges);
+    return adj_edges;
+}
 
-    AdjacentVerticesPositions adjacents =
-            get_adjacent_vertices_positions(source, graph);
-    const auto source_pos = graph[source].pos;
-
-    for (size_t neigh_index = 0;
-         neigh_index < adjacents.neighbours_descriptors.size(); ++neigh_index) {
-
-        if (adjacents.neighbours_descriptors[neigh_index] == ignore_node) {
+void get_adjacent_edges_from_source(
+        const GraphType::vertex_descriptor source,
+        const GraphType::vertex_descriptor ignore_node,
+        const GraphType &graph,
+        const ArrayUtilities::boundary_condition &boundary_condition,
+        std::vector<VectorType> &adj_edges) {
+    adj_edges.clear();
+    const auto &source_pos = graph[source].pos;
+    const auto neighbours = boost::adjacent_vertices(source, graph);
+    for (auto ni = neighbours.first; ni != neighbours.second; ++ni) {
+        if (*ni == ignore_node) {
             continue;
         }
-
-        auto neigh_pos_image = adjacents.neighbours_positions[neigh_index];
-
+        auto neigh_pos_image = graph[*ni].pos;
         if (boundary_condition ==
             ArrayUtilities::boundary_condition::PERIODIC) {
             neigh_pos_image = ArrayUtilities::closest_image_from_reference(
@@ -160,7 +178,6 @@ std::vector<VectorType> get_adjacent_edges_from_source(
         }
         adj_edges.push_back(ArrayUtilities::minus(neigh_pos_image, source_pos));
     }
-    return adj_edges;
 }
 
 std::vector<double> compute_cosine_directors_from_source(
@@ -0,0 +1,230 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+#include "parallel_tempering_generator.hpp"
+#include "rng.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+namespace SG {
+
+namespace {
+bool is_finished(const transition_parameters &tp,
+                 const size_t &max_engine_iterations) {
+    return tp.consecutive_failures >= tp.MAX_CONSECUTIVE_FAILURES ||
+           tp.steps_performed >= max_engine_iterations ||
+           tp.energy < tp.ENERGY_CONVERGENCE;
+}
+} // namespace
+
+parallel_tempering_generator::parallel_tempering_generator(
+        const simulated_annealing_generator_config_tree &tree,
+        const parallel_tempering_parameters &input_params)
+        : params(input_params) {
+    if (params.num_replicas == 0) {
+        throw std::runtime_error(
+                "parallel_tempering_generator: num_replicas must be > 0.");
+    }
+    if (params.steps_between_exchanges == 0) {
+        throw std::runtime_error("parallel_tempering_generator: "
+                                 "steps_between_exchanges must be > 0.");
+    }
+    const size_t num_replicas = params.num_replicas;
+    const size_t seed =
+            params.seed == 0 ? std::random_device{}() : params.seed;
+    replica_engines_.resize(num_replicas);
+    for (size_t r = 0; r < num_replicas; ++r) {
+        replica_engines_[r].seed(seed + r);
+    }
+    exchange_engine_.seed(seed + num_replicas);
+    statistics_.resize(num_replicas);
+    replicas_.resize(num_replicas);
+    max_engine_iterations_ = tree.transition_params.MAX_ENGINE_ITERATIONS;
+
+    // The initial graph of each replica uses its own random engine.
+    this->run_replicas([this, &tree](const size_t &r) {
+        replicas_[r] = std::make_unique<simulated_annealing_generator>(tree);
+        replicas_[r]->show_progress = false;
+    });
+
+    // Geometric temperature ladder, from the temperature that engine would
+    // choose for the first replica. The ladder is fixed: the replicas do
+    // not cool down, the exchange criterion assumes constant temperatures.
+    const double energy_first = replicas_[0]->compute_energy();
+    const double temp_first =
+            energy_first / boost::num_vertices(replicas_[0]->graph_);
+    double temp = temp_first;
+    for (size_t r = 0; r < num_replicas; ++r) {
+        auto &tp = replicas_[r]->transition_params;
+        tp.energy_initial = replicas_[r]->compute_energy();
+        tp.energy = tp.energy_initial;
+        tp.temp_initial = temp;
+        tp.temp_current = temp;
+        tp.temp_cooling_rate = 1.0;
+        temp *= params.temp_ladder_ratio;
+    }
+}
+
+void parallel_tempering_generator::run_replicas(
+        const std::function<void(const size_t &)> &func) {
+    const size_t num_replicas = replica_engines_.size();
+    const size_t available_threads =
+            params.num_threads == 0
+                    ? std::max(1u, std::thread::hardware_concurrency())
+                    : params.num_threads;
+    const size_t threads = std::min(available_threads, num_replicas);
+
+    std::atomic<size_t> next_replica(0);
+    std::vector<std::exception_ptr> errors(threads);
+    const auto worker = [&](const size_t &thread_index) {
+        try {
+            for (size_t r = next_replica++; r < num_replicas;
+                 r = next_replica++) {
+                std::swap(RNG::engine(), replica_engines_[r]);
+                try {
+                    func(r);
+                } catch (...) {
+                    std::swap(RNG::engine(), replica_engines_[r]);
+                    throw;
+                }
+                std::swap(RNG::engine(), replica_engines_[r]);
+            }
+        } catch (...) {
+            errors[thread_index] = std::current_exception();
+        }
+    };
+    if (threads == 1) {
+        worker(0);
+    } else {
+        std::vector<std::thread> workers;
+        workers.reserve(threads);
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back(worker, t);
+        }
+        for (auto &w : workers) {
+            w.join();
+        }
+    }
+    for (const auto &error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+void parallel_tempering_generator::exchange_temperatures(
+        const size_t &round) {
+    const size_t num_replicas = replicas_.size();
+    std::vector<size_t> ladder(num_replicas);
+    for (size_t r = 0; r < num_replicas; ++r) {
+        ladder[r] = r;
+    }
+    std::sort(std::begin(ladder), std::end(ladder),
+              [this](const size_t &a, const size_t &b) {
+                  return replicas_[a]->transition_params.temp_current <
+                         replicas_[b]->transition_params.temp_current;
+              });
+    std::uniform_real_distribution<double> rand01(0.0, 1.0);
+    for (size_t k = round % 2; k + 1 < num_replicas; k += 2) {
+        auto &cold = replicas_[ladder[k]]->transition_params;
+        auto &hot = replicas_[ladder[k + 1]]->transition_params;
+        if (!(cold.temp_current > 0.0) || !(hot.temp_current > 0.0)) {
+            continue;
+        }
+        statistics_[ladder[k]].exchanges_attempted++;
+        statistics_[ladder[k + 1]].exchanges_attempted++;
+        const double exponent =
+                (1.0 / cold.temp_current - 1.0 / hot.temp_current) *
+                (cold.energy - hot.energy);
+        if (exponent >= 0.0 || rand01(exchange_engine_) < std::exp(exponent)) {
+            std::swap(cold.temp_current, hot.temp_current);
+            statistics_[ladder[k]].exchanges_accepted++;
+            statistics_[ladder[k + 1]].exchanges_accepted++;
+        }
+    }
+}
+
+parallel_tempering_result parallel_tempering_generator::engine() {
+    parallel_tempering_result result;
+    result.energy = std::numeric_limits<double>::infinity();
+    const size_t num_replicas = replicas_.size();
+    const auto update_best = [&]() {
+        for (size_t r = 0; r < num_replicas; ++r) {
+            const double energy = replicas_[r]->transition_params.energy;
+            if (energy < result.energy) {
+                result.energy = energy;
+                result.replica = r;
+                result.graph = replicas_[r]->graph_;
+            }
+        }
+    };
+    update_best();
+
+    for (size_t round = 0;; ++round) {
+        bool all_finished = true;
+        bool any_converged = false;
+        for (const auto &replica : replicas_) {
+            const auto &tp = replica->transition_params;
+            all_finished &= is_finished(tp, max_engine_iterations_);
+            any_converged |= tp.energy < tp.ENERGY_CONVERGENCE;
+        }
+        if (all_finished || any_converged) {
+            break;
+        }
+        this->run_replicas([this](const size_t &r) {
+            auto &gen = *replicas_[r];
+            auto &tp = gen.transition_params;
+            if (is_finished(tp, max_engine_iterations_)) {
+                return;
+            }
+            tp.MAX_ENGINE_ITERATIONS =
+                    std::min(tp.steps_performed +
+                                     params.steps_between_exchanges,
+                             max_engine_iterations_);
+            gen.engine(false, false);
+            statistics_[r].time_elapsed += tp.time_elapsed;
+        });
+        update_best();
+        this->exchange_temperatures(round);
+    }
+
+    for (size_t r = 0; r < num_replicas; ++r) {
+        const auto &tp = replicas_[r]->transition_params;
+        auto &stats = statistics_[r];
+        stats.energy = tp.energy;
+        stats.energy_initial = tp.energy_initial;
+        stats.temp_initial = tp.temp_initial;
+        stats.temp_current = tp.temp_current;
+        stats.steps_performed = tp.steps_performed;
+        stats.accepted_transitions = tp.accepted_transitions;
+        stats.rejected_transitions = tp.rejected_transitions;
+        stats.high_temp_transitions = tp.high_temp_transitions;
+    }
+    result.replicas = statistics_;
+    return result;
+}
+
+} // namespace SG
@@ -5,14 +5,27 @@
 #include "degree_viger_generator.hpp"
 #include "generate_common.hpp"
 #include "rng.hpp"
+#include <algorithm>
 #include <boost/graph/graphviz.hpp> // for print_graph
 #include <chrono>
+#include <memory>
+#include <numeric>
+#include <sstream>
+#ifdef WITH_PARALLEL_STL
+#include <execution>
+#endif
 
 namespace SG {
 simulated_annealing_generator::simulated_annealing_generator()
             : step_move_node_(graph_, histo_ete_distances_, histo_cosines_),
               step_swap_edges_(graph_, histo_ete_distances_, histo_cosines_) {}
 
+simulated_annealing_generator::~simulated_annealing_generator() {
+    if (checkpoint_writer_.joinable()) {
+        checkpoint_writer_.join();
+    }
+}
+
 simulated_annealing_generator::simulated_annealing_generator(
         const size_t &num_vertices)
         : simulated_annealing_generator() {
@@ -215,6 +228,9 @@ void simulated_annealing_generator::populate_histogram_ete_distances() {
                        return static_cast<double>(total_counts) * x + 0.5;
                    });
     total_counts_ete_distances_ = total_counts;
+    incremental_test_ete_distances_.reset(
+            histo_ete_distances_.counts, LUT,
+            histo_ete_distances_.ComputeBinCenters());
 }
 
 void simulated_annealing_generator::populate_histogram_cosines() {
@@ -235,6 +251,7 @@ void simulated_annealing_generator::populate_histogram_cosines() {
                        return static_cast<double>(total_counts) * x + 0.5;
                    });
     total_counts_cosines_ = total_counts;
+    incremental_test_cosines_.reset(histo_cosines_.counts, LUT);
 }
 void simulated_annealing_generator::init_histograms(
         const size_t &num_bins_ete_distances, const size_t &num_bins_cosines) {
@@ -264,10 +281,14 @@ void simulated_annealing_generator::init_histograms(
             histo_cosines_.ComputeBinCenters(), cosines_cumulative_func);
     this->populate_histogram_cosines();
 }
-void simulated_annealing_generator::engine(const bool &reset_steps) {
+void simulated_annealing_generator::engine(const bool &reset_steps,
+                                           const bool &reset_temperature) {
     const auto t_start = std::chrono::high_resolution_clock::now();
     auto & steps = transition_params.steps_performed;
-    if(reset_steps) { steps = 0; }
+    // A restored checkpoint already has the state of the running simulation.
+    const bool resume = resume_from_checkpoint_;
+    resume_from_checkpoint_ = false;
+    if(reset_steps && !resume) { steps = 0; }
     /****** For reporting progress **********/
     const double log_size =
             std::log10(transition_params.MAX_ENGINE_ITERATIONS) - 2;
@@ -276,23 +297,58 @@ void simulated_annealing_generator::engine(const bool &reset_steps) {
         1;
     size_t progress_count = 0;
     /****/
-    const double energy_initial = compute_energy();
-    transition_params.energy_initial = energy_initial;
-    transition_params.energy = energy_initial;
-    transition_params.temp_initial =
-            transition_params.energy_initial / boost::num_vertices(graph_);
-    transition_params.temp_current = transition_params.temp_initial;
+    const bool use_incremental_energy =
+            std::max(histo_ete_distances_.bins, histo_cosines_.bins) >=
+            incremental_energy_min_bins;
+    if (!resume) {
+        if (use_incremental_energy) {
+            this->reset_incremental_energy();
+        }
+        const double energy_initial = compute_energy();
+        transition_params.energy = energy_initial;
+        if (reset_temperature) {
+            transition_params.energy_initial = energy_initial;
+            transition_params.temp_initial = transition_params.energy_initial /
+                                             boost::num_vertices(graph_);
+            transition_params.temp_current = transition_params.temp_initial;
+        }
+    }
+    if (checkpoint_every_steps > 0 && checkpoint_file.empty()) {
+        throw std::runtime_error("engine: checkpoint_every_steps is set, but "
+                                 "checkpoint_file is empty.");
+    }
+    size_t last_checkpoint_steps = steps;
     // const double energy_diff = energy_new - transition_params.energy;
     // transition_params.temp_initial = std::abs(energy_diff /
     // log(0.5));
-    while (transition_params.consecutive_failures !=
-                   transition_params.MAX_CONSECUTIVE_FAILURES &&
-           steps != transition_params.MAX_ENGINE_ITERATIONS &&
-           transition_params.energy >= transition_params.ENERGY_CONVERGENCE) {
+    // Dense index of the edges to select random edges in O(1), kept updated
+    // by the swap steps while the engine runs.
+    const auto graph_edges = boost::edges(graph_);
+    edge_index_.assign(graph_edges.first, graph_edges.second);
+    step_swap_edges_.edge_index_ = &edge_index_;
+    const bool use_batch = update_steps_batch_size > 1;
+    if (use_batch) {
+        batch_steps_move_node_.assign(update_steps_batch_size,
+                                      step_move_node_);
+        batch_steps_swap_edges_.assign(update_steps_batch_size,
+                                       step_swap_edges_);
+        batch_vertex_marks_.assign(boost::num_vertices(graph_), 0);
+        batch_mark_ = 0;
+    }
+    const auto is_running = [&tp = transition_params, &steps]() {
+        return tp.consecutive_failures != tp.MAX_CONSECUTIVE_FAILURES &&
+               steps != tp.MAX_ENGINE_ITERATIONS &&
+               tp.energy >= tp.ENERGY_CONVERGENCE;
+    };
+    while (is_running()) {
+        if (checkpoint_every_steps > 0 &&
+            steps - last_checkpoint_steps >= checkpoint_every_steps) {
+            this->write_checkpoint_in_background();
+            last_checkpoint_steps = steps;
+        }
         if (verbose) {
             std::cout << "Step #: " << steps << std::endl;
         }
-        const bool show_progress = true;
         if (show_progress) {
             if (progress_count == report_every) {
                 progress_count = 0;
@@ -304,7 +360,21 @@ void simulated_annealing_generator::engine(const bool &reset_steps) {
             }
             progress_count++;
         }
-        simulated_annealing_generator::transition transition;
+
+        if (use_batch) {
+            this->prepare_batch();
+            for (auto *step : batch_) {
+                if (!is_running()) {
+                    // Histograms are not modified yet, just discard it.
+                    step->randomized_flag_ = false;
+                    continue;
+                }
+                step->update_histograms();
+                this->evaluate_performed_step(*step, use_incremental_energy);
+                steps++;
+            }
+            continue;
+        }
 
         if (RNG::rand01() <
             transition_params.UPDATE_STEP_MOVE_NODE_PROBABILITY) {
@@ -313,33 +383,215 @@ void simulated_annealing_generator::engine(const bool &reset_steps) {
             }
             step_move_node_.randomize();
             step_move_node_.perform();
-            transition = check_transition();
-            if (transition == transition::REJECTED) {
-                step_move_node_.undo();
-            } else if (transition == transition::ACCEPTED ||
-                       transition == transition::ACCEPTED_HIGH_TEMP) {
-                step_move_node_.update_graph();
-            }
-
+            this->evaluate_performed_step(step_move_node_,
+                                          use_incremental_energy);
         } else {
             step_swap_edges_.randomize();
             step_swap_edges_.perform();
-            transition = check_transition();
-            if (transition == transition::REJECTED) {
-                step_swap_edges_.undo();
-            } else if (transition == transition::ACCEPTED ||
-                       transition == transition::ACCEPTED_HIGH_TEMP) {
-                step_swap_edges_.update_graph();
-            }
+            this->evaluate_performed_step(step_swap_edges_,
+                                          use_incremental_energy);
         }
         steps++;
     }
+    // graph_ is public, the index would be invalid if graph_ is modified.
+    step_swap_edges_.edge_index_ = nullptr;
+    this->wait_for_checkpoint_writer();
 
     const auto t_final = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> elapsed = t_final - t_start;
     transition_params.time_elapsed = elapsed.count();
 } // namespace SG
 
+simulated_annealing_generator_checkpoint
+simulated_annealing_generator::make_checkpoint() const {
+    simulated_annealing_generator_checkpoint cp;
+    cp.parameters = this->save_parameters_to_configuration_tree();
+    // Add the edges in the order of the edge index, if engine is running.
+    const bool is_engine_running = step_swap_edges_.edge_index_ != nullptr;
+    cp.graph = GraphType(boost::num_vertices(graph_));
+    const auto vertices = boost::vertices(graph_);
+    for (auto vi = vertices.first; vi != vertices.second; ++vi) {
+        cp.graph[*vi] = graph_[*vi];
+    }
+    const auto add_edge = [&cp, this](const GraphType::edge_descriptor &e) {
+        boost::add_edge(boost::source(e, graph_), boost::target(e, graph_),
+                        graph_[e], cp.graph);
+    };
+    if (is_engine_running) {
+        std::for_each(std::begin(edge_index_), std::end(edge_index_),
+                      add_edge);
+    } else {
+        const auto edges = boost::edges(graph_);
+        std::for_each(edges.first, edges.second, add_edge);
+    }
+    cp.counts_ete_distances = histo_ete_distances_.counts;
+    cp.counts_cosines = histo_cosines_.counts;
+    cp.incremental_test_ete_distances = incremental_test_ete_distances_;
+    cp.incremental_test_cosines = incremental_test_cosines_;
+    cp.incremental_energy_min_bins = incremental_energy_min_bins;
+    cp.update_steps_batch_size = update_steps_batch_size;
+    cp.move_node_max_step_distance = step_move_node_.max_step_distance_;
+    std::ostringstream rng_state;
+    rng_state << RNG::engine();
+    cp.rng_state = rng_state.str();
+    return cp;
+}
+
+void simulated_annealing_generator::restore_checkpoint(
+        const simulated_annealing_generator_checkpoint &cp) {
+    this->set_parameters_from_configuration_tree(cp.parameters);
+    this->set_boundary_condition(domain_params.boundary_condition);
+    step_move_node_.max_step_distance_ = cp.move_node_max_step_distance;
+    incremental_energy_min_bins = cp.incremental_energy_min_bins;
+    update_steps_batch_size = cp.update_steps_batch_size;
+    graph_ = cp.graph;
+    // Histograms and target distributions from the parameters.
+    this->init_histograms(ete_distance_params.num_bins,
+                          cosine_params.num_bins);
+    if (cp.counts_ete_distances.size() != histo_ete_distances_.counts.size() ||
+        cp.counts_cosines.size() != histo_cosines_.counts.size()) {
+        throw std::runtime_error("restore_checkpoint: the bins of the "
+                                 "histograms do not match the parameters.");
+    }
+    // The counts are not recomputed from the graph, to continue exactly
+    // with the counts of the checkpoint.
+    histo_ete_distances_.counts = cp.counts_ete_distances;
+    histo_cosines_.counts = cp.counts_cosines;
+    if (std::accumulate(std::begin(cp.counts_ete_distances),
+                        std::end(cp.counts_ete_distances),
+                        static_cast<size_t>(0)) !=
+                total_counts_ete_distances_ ||
+        std::accumulate(std::begin(cp.counts_cosines),
+                        std::end(cp.counts_cosines),
+                        static_cast<size_t>(0)) != total_counts_cosines_) {
+        throw std::runtime_error("restore_checkpoint: the counts of the "
+                                 "histograms do not match the graph.");
+    }
+    incremental_test_ete_distances_ = cp.incremental_test_ete_distances;
+    incremental_test_cosines_ = cp.incremental_test_cosines;
+    std::istringstream rng_state(cp.rng_state);
+    rng_state >> RNG::engine();
+    resume_from_checkpoint_ = true;
+}
+
+void simulated_annealing_generator::save_checkpoint(
+        const std::string &output_file) const {
+    write_checkpoint(output_file, this->make_checkpoint());
+}
+
+void simulated_annealing_generator::load_checkpoint(
+        const std::string &input_file) {
+    this->restore_checkpoint(read_checkpoint(input_file));
+}
+
+void simulated_annealing_generator::write_checkpoint_in_background() {
+    // Only the copy of the state stalls the simulation.
+    auto cp = std::make_shared<simulated_annealing_generator_checkpoint>(
+            this->make_checkpoint());
+    this->wait_for_checkpoint_writer();
+    checkpoint_writer_ = std::thread([this, cp, file = checkpoint_file]() {
+        try {
+            write_checkpoint(file, *cp);
+        } catch (...) {
+            checkpoint_writer_error_ = std::current_exception();
+        }
+    });
+}
+
+void simulated_annealing_generator::wait_for_checkpoint_writer() {
+    if (checkpoint_writer_.joinable()) {
+        checkpoint_writer_.join();
+    }
+    if (checkpoint_writer_error_) {
+        auto error = checkpoint_writer_error_;
+        checkpoint_writer_error_ = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+simulated_annealing_generator::transition
+simulated_annealing_generator::evaluate_performed_step(
+        update_step_with_distance_and_cosine_histograms &step,
+        const bool &use_incremental_energy) {
+    simulated_annealing_generator::transition transition;
+    if (use_incremental_energy) {
+        // The incremental tests are only modified if the step is accepted.
+        collect_incremental_energy_changes(step);
+        transition = check_transition(compute_energy_incremental_after_step());
+    } else {
+        transition = check_transition();
+    }
+    if (transition == transition::REJECTED) {
+        step.undo();
+    } else if (transition == transition::ACCEPTED ||
+               transition == transition::ACCEPTED_HIGH_TEMP) {
+        if (use_incremental_energy) {
+            incremental_test_ete_distances_.add(step_changes_ete_distances_);
+            incremental_test_cosines_.add(step_changes_cosines_);
+        }
+        step.update_graph();
+    }
+    return transition;
+}
+
+bool simulated_annealing_generator::claim_neighborhood(
+        const std::vector<GraphType::vertex_descriptor> &vertices) {
+    for (const auto &v : vertices) {
+        if (batch_vertex_marks_[v] == batch_mark_) {
+            return false;
+        }
+        const auto neighbors = boost::adjacent_vertices(v, graph_);
+        for (auto ni = neighbors.first; ni != neighbors.second; ++ni) {
+            if (batch_vertex_marks_[*ni] == batch_mark_) {
+                return false;
+            }
+        }
+    }
+    for (const auto &v : vertices) {
+        batch_vertex_marks_[v] = batch_mark_;
+        const auto neighbors = boost::adjacent_vertices(v, graph_);
+        for (auto ni = neighbors.first; ni != neighbors.second; ++ni) {
+            batch_vertex_marks_[*ni] = batch_mark_;
+        }
+    }
+    return true;
+}
+
+void simulated_annealing_generator::prepare_batch() {
+    batch_.clear();
+    ++batch_mark_;
+    // Random draws are sequential, the computation of the histogram changes
+    // is parallel.
+    for (size_t k = 0; k < update_steps_batch_size; ++k) {
+        update_step_with_distance_and_cosine_histograms *step;
+        if (RNG::rand01() <
+            transition_params.UPDATE_STEP_MOVE_NODE_PROBABILITY) {
+            batch_steps_move_node_[k].randomize();
+            step = &batch_steps_move_node_[k];
+        } else {
+            batch_steps_swap_edges_[k].randomize();
+            step = &batch_steps_swap_edges_[k];
+        }
+        step->selected_vertices(batch_selected_vertices_);
+        if (!this->claim_neighborhood(batch_selected_vertices_)) {
+            step->randomized_flag_ = false;
+            continue;
+        }
+        step->randomize_movement();
+        batch_.push_back(step);
+    }
+    const auto compute = [](update_step_with_distance_and_cosine_histograms
+                                    *batch_step) {
+        batch_step->compute_histogram_changes();
+    };
+#ifdef WITH_PARALLEL_STL
+    std::for_each(std::execution::par, std::begin(batch_), std::end(batch_),
+                  compute);
+#else
+    std::for_each(std::begin(batch_), std::end(batch_), compute);
+#endif
+}
+
 double simulated_annealing_generator::energy_ete_distances() const {
     // return cramer_von_mises_test(histo_ete_distances_.counts,
     //                              target_cumulative_distro_histo_ete_distances_);
@@ -386,9 +638,109 @@ double simulated_annealing_generator::compute_energy() const {
     return test_ete_distances + test_cosines;
 }
 
+void simulated_annealing_generator::reset_incremental_energy() {
+    incremental_test_ete_distances_.reset(
+            histo_ete_distances_.counts, LUT_cumulative_histo_ete_distances_,
+            histo_ete_distances_.ComputeBinCenters());
+    incremental_test_cosines_.reset(histo_cosines_.counts,
+                                    LUT_cumulative_histo_cosines_);
+}
+
+namespace {
+/**
+ * Accumulate the changes of counts per bin, and collect the non-zero ones in
+ * changes, sorted by bin. deltas are all zeros after the call.
+ */
+void collect_net_deltas(
+        const Histogram &histo,
+        const std::vector<double> &added_values,
+        const std::vector<double> &removed_values,
+        std::vector<long> &deltas,
+        std::vector<cramer_von_mises_incremental::BinChange> &changes) {
+    if (deltas.size() != histo.bins) {
+        deltas.assign(histo.bins, 0);
+    }
+    changes.clear();
+    const auto accumulate = [&](const std::vector<double> &values,
+                                const long &delta) {
+        for (const auto &value : values) {
+            const auto bin = histo.IndexFromValue(value);
+            if (deltas[bin] == 0) {
+                changes.emplace_back(bin, 0);
+            }
+            deltas[bin] += delta;
+        }
+    };
+    accumulate(added_values, 1);
+    accumulate(removed_values, -1);
+    // A bin can be added twice if its delta went back to zero in between.
+    std::sort(std::begin(changes), std::end(changes));
+    changes.erase(std::unique(std::begin(changes), std::end(changes)),
+                  std::end(changes));
+    auto last = std::begin(changes);
+    for (const auto &change : changes) {
+        const auto bin = change.first;
+        if (deltas[bin] != 0) {
+            *last++ = {bin, deltas[bin]};
+            deltas[bin] = 0;
+        }
+    }
+    changes.erase(last, std::end(changes));
+}
+} // namespace
+
+void simulated_annealing_generator::collect_incremental_energy_changes(
+        const update_step_with_distance_and_cosine_histograms &step) {
+    collect_net_deltas(histo_ete_distances_, step.get_new_distances(),
+                       step.get_old_distances(), step_deltas_ete_distances_,
+                       step_changes_ete_distances_);
+    collect_net_deltas(histo_cosines_, step.get_new_cosines(),
+                       step.get_old_cosines(), step_deltas_cosines_,
+                       step_changes_cosines_);
+}
+
+double simulated_annealing_generator::compute_energy_incremental() const {
+    // Same penalties than energy_ete_distances and energy_cosines
+    const double mean_ete_distances =
+            incremental_test_ete_distances_.weighted_counts() /
+            histo_ete_distances_.bins;
+    const double penalize_long_fibers = std::abs(
+            mean_ete_distances / ete_distance_params.normalized_normal_mean -
+            1);
+    const double last_bin_penalty =
+            histo_cosines_.counts.back() /
+            static_cast<double>(histo_cosines_.bins);
+    return penalize_long_fibers + incremental_test_ete_distances_.value() +
+           last_bin_penalty + incremental_test_cosines_.value();
+}
+
+double
+simulated_annealing_generator::compute_energy_incremental_after_step() const {
+    const double mean_ete_distances =
+            incremental_test_ete_distances_.weighted_counts_after(
+                    step_changes_ete_distances_) /
+            histo_ete_distances_.bins;
+    const double penalize_long_fibers = std::abs(
+            mean_ete_distances / ete_distance_params.normalized_normal_mean -
+            1);
+    // histo_cosines_ is already updated by the step.
+    const double last_bin_penalty =
+            histo_cosines_.counts.back() /
+            static_cast<double>(histo_cosines_.bins);
+    return penalize_long_fibers +
+           incremental_test_ete_distances_.value_after(
+                   step_changes_ete_distances_) +
+           last_bin_penalty +
+           incremental_test_cosines_.value_after(step_changes_cosines_);
+}
+
 simulated_annealing_generator::transition
 simulated_annealing_generator::check_transition() {
-    const double energy_new = compute_energy();
+    return this->check_transition(compute_energy());
+}
+
+simulated_annealing_generator::transition
+simulated_annealing_generator::check_transition(const double &energy_new) {
     const double energy_diff = energy_new - transition_params.energy;
 
     if (energy_diff <= 0.0) {
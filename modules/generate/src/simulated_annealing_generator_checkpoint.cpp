@@ -0,0 +1,177 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+#include "simulated_annealing_generator_checkpoint.hpp"
+
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/graph/adj_list_serialize.hpp>
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/vector.hpp>
+#include <cstdio> // for std::rename
+#include <fstream>
+
+namespace boost {
+namespace serialization {
+template <class Archive>
+void serialize(Archive &ar, SG::domain_parameters &p, unsigned /*version*/) {
+    ar &p.boundary_condition;
+    ar &p.domain;
+}
+template <class Archive>
+void serialize(Archive &ar,
+               SG::physical_scaling_parameters &p,
+               unsigned /*version*/) {
+    ar &p.num_vertices;
+    ar &p.node_density;
+    ar &p.length_scaling_factor;
+}
+template <class Archive>
+void serialize(Archive &ar,
+               SG::transition_parameters &p,
+               unsigned /*version*/) {
+    ar &p.energy;
+    ar &p.steps_performed;
+    ar &p.energy_initial;
+    ar &p.accepted_transitions;
+    ar &p.rejected_transitions;
+    ar &p.high_temp_transitions;
+    ar &p.consecutive_failures;
+    ar &p.time_elapsed;
+    ar &p.temp_current;
+    ar &p.temp_initial;
+    ar &p.temp_cooling_rate;
+    ar &p.MAX_CONSECUTIVE_FAILURES;
+    ar &p.MAX_ENGINE_ITERATIONS;
+    ar &p.ENERGY_CONVERGENCE;
+    ar &p.UPDATE_STEP_MOVE_NODE_PROBABILITY;
+    ar &p.update_step_move_node_max_step_distance;
+}
+template <class Archive>
+void serialize(Archive &ar,
+               SG::degree_distribution_parameters &p,
+               unsigned /*version*/) {
+    ar &p.mean;
+    ar &p.min_degree;
+    ar &p.max_degree;
+    ar &p.percentage_of_one_degree_nodes;
+}
+template <class Archive>
+void serialize(Archive &ar,
+               SG::end_to_end_distances_distribution_parameters &p,
+               unsigned /*version*/) {
+    ar &p.physical_normal_mean;
+    ar &p.physical_normal_std_deviation;
+    ar &p.normalized_normal_mean;
+    ar &p.normalized_normal_std_deviation;
+    ar &p.normalized_log_std_deviation;
+    ar &p.normalized_log_mean;
+    ar &p.num_bins;
+}
+template <class Archive>
+void serialize(Archive &ar,
+               SG::cosine_directors_distribution_parameters &p,
+               unsigned /*version*/) {
+    ar &p.b1;
+    ar &p.b2;
+    ar &p.b3;
+    ar &p.num_bins;
+}
+template <class Archive>
+void serialize(Archive &ar,
+               SG::simulated_annealing_generator_config_tree &tree,
+               unsigned /*version*/) {
+    ar &tree.transition_params;
+    ar &tree.degree_params;
+    ar &tree.ete_distance_params;
+    ar &tree.cosine_params;
+    ar &tree.domain_params;
+    ar &tree.physical_scaling_params;
+}
+template <class Archive>
+void serialize(Archive &ar,
+               SG::simulated_annealing_generator_checkpoint &cp,
+               unsigned /*version*/) {
+    ar &cp.parameters;
+    ar &cp.graph;
+    ar &cp.counts_ete_distances;
+    ar &cp.counts_cosines;
+    ar &cp.incremental_test_ete_distances;
+    ar &cp.incremental_test_cosines;
+    ar &cp.incremental_energy_min_bins;
+    ar &cp.update_steps_batch_size;
+    ar &cp.move_node_max_step_distance;
+    ar &cp.rng_state;
+}
+} // namespace serialization
+} // namespace boost
+
+namespace SG {
+
+void write_checkpoint(std::ostream &os,
+                      const simulated_annealing_generator_checkpoint &cp) {
+    boost::archive::binary_oarchive arch(os);
+    arch << cp;
+}
+
+void write_checkpoint(const std::string &output_file,
+                      const simulated_annealing_generator_checkpoint &cp) {
+    const std::string tmp_file = output_file + ".tmp";
+    {
+        std::ofstream os(tmp_file, std::fstream::binary | std::fstream::out);
+        if (!os.is_open()) {
+            throw std::runtime_error("Failed to open checkpoint file: " +
+                                     tmp_file + ".");
+        }
+        write_checkpoint(os, cp);
+        if (!os.good()) {
+            throw std::runtime_error("Failed to write checkpoint file: " +
+                                     tmp_file + ".");
+        }
+    }
+    if (std::rename(tmp_file.c_str(), output_file.c_str()) != 0) {
+        // Some platforms do not replace an existing file.
+        std::remove(output_file.c_str());
+        if (std::rename(tmp_file.c_str(), output_file.c_str()) != 0) {
+            throw std::runtime_error("Failed to rename checkpoint file: " +
+                                     tmp_file + " to " + output_file + ".");
+        }
+    }
+}
+
+void read_checkpoint(std::istream &is,
+                     simulated_annealing_generator_checkpoint &cp) {
+    boost::archive::binary_iarchive arch(is);
+    arch >> cp;
+}
+
+simulated_annealing_generator_checkpoint
+read_checkpoint(const std::string &input_file) {
+    std::ifstream ifile(input_file, std::fstream::binary | std::fstream::in);
+    if (!ifile.is_open()) {
+        throw std::runtime_error("Failed to read input_file: " + input_file +
+                                 ".");
+    }
+    simulated_annealing_generator_checkpoint cp;
+    read_checkpoint(ifile, cp);
+    return cp;
+}
+
+} // namespace SG
@@ -40,27 +40,64 @@ void update_step_move_node::perform(const double &max_step_distance,
     // std::cout << "SELECTED_NODE: " << selected_node << std::endl;
     // std::cout << "POSITION: "; SG::print_pos(std::cout, old_node_position);
     // std::cout << std::endl;
-    if (boundary_condition == ArrayUtilities::boundary_condition::NONE) {
-        new_node_position = ArrayUtilities::plus(
+    new_node_position =
+            this->random_new_position(old_node_position, max_step_distance);
+
+    this->compute_histogram_changes(graph, selected_node, old_node_position,
+                                    new_node_position, old_distances,
+                                    old_cosines, new_distances, new_cosines);
+    // Update Histograms:
+    //  Remove old_distances and old_cosines and
+    //  add new_distances, new_cosines
+    this->update_distances_histogram(histo_distances, old_distances,
+                                     new_distances);
+    this->update_cosines_histogram(histo_cosines, old_cosines, new_cosines);
+    // clear flag
+    randomized_flag = false;
+}
+
+PointType update_step_move_node::random_new_position(
+        const PointType &old_node_position,
+        const double &max_step_distance) const {
+    if (boundary_condition == ArrayUtilities::boundary_condition::PERIODIC) {
+        return ArrayUtilities::plus_with_boundary_condition_periodic(
                 old_node_position, generate_random_array(max_step_distance));
-    } else if (boundary_condition ==
-               ArrayUtilities::boundary_condition::PERIODIC) {
-        new_node_position =
-                ArrayUtilities::plus_with_boundary_condition_periodic(
-                        old_node_position,
-                        generate_random_array(max_step_distance));
     }
+    return ArrayUtilities::plus(old_node_position,
+                                generate_random_array(max_step_distance));
+}
 
-    AdjacentVerticesPositions adjacent_vertices_positions =
-            get_adjacent_vertices_positions(selected_node, graph);
+void update_step_move_node::randomize_movement() {
+    if (!randomized_flag_) {
+        this->randomize();
+    }
+    old_node_position_ = (*graph_)[selected_node_].pos;
+    new_node_position_ =
+            this->random_new_position(old_node_position_, max_step_distance_);
+}
 
-    std::vector<VectorType> old_edges;
-    std::vector<VectorType> new_edges;
-    const auto num_neighbors =
-            adjacent_vertices_positions.neighbours_positions.size();
-    for (size_t i = 0; i < num_neighbors; i++) {
-        const auto &p = adjacent_vertices_positions.neighbours_positions[i];
-        const auto &vd = adjacent_vertices_positions.neighbours_descriptors[i];
+void update_step_move_node::compute_histogram_changes(
+        // in parameters
+        const GraphType &graph,
+        const GraphType::vertex_descriptor &selected_node,
+        const PointType &old_node_position,
+        const PointType &new_node_position,
+        // out parameters
+        std::vector<double> &old_distances,
+        std::vector<double> &old_cosines,
+        std::vector<double> &new_distances,
+        std::vector<double> &new_cosines) const {
+    this->clear_stored_parameters(old_distances, old_cosines, new_distances,
+                                  new_cosines);
+    auto &old_edges = old_edges_buffer_;
+    auto &new_edges = new_edges_buffer_;
+    auto &adjacent_arrays_target = adjacent_edges_buffer_;
+    old_edges.clear();
+    new_edges.clear();
+    const auto neighbours = boost::adjacent_vertices(selected_node, graph);
+    for (auto ni = neighbours.first; ni != neighbours.second; ++ni) {
+        const auto &vd = *ni;
+        const auto &p = graph[vd].pos;
         auto p_image_old = p;
         auto p_image_new = p;
         if (boundary_condition ==
@@ -90,35 +127,19 @@ void update_step_move_node::perform(const double &max_step_distance,
         new_edges.push_back(new_array);
         // Moving a node affects the angles from the edges having as source the
         // moved node, but also those edges having it as target.
-        const auto adjacent_arrays_target = get_adjacent_edges_from_source(
-                vd, selected_node /*ignore */, graph, boundary_condition);
+        get_adjacent_edges_from_source(vd, selected_node /*ignore */, graph,
+                                       boundary_condition,
+                                       adjacent_arrays_target);
 
-        const auto old_target_cosines =
-                cosine_directors_between_edges_and_target_edge(
-                        adjacent_arrays_target, old_array);
-        old_cosines.insert(std::end(old_cosines),
-                           std::begin(old_target_cosines),
-                           std::end(old_target_cosines));
-
-        const auto new_target_cosines =
-                cosine_directors_between_edges_and_target_edge(
-                        adjacent_arrays_target, new_array);
-        new_cosines.insert(std::end(new_cosines),
-                           std::begin(new_target_cosines),
-                           std::end(new_target_cosines));
+        cosine_directors_between_edges_and_target_edge(
+                adjacent_arrays_target, old_array, old_cosines);
+        cosine_directors_between_edges_and_target_edge(
+                adjacent_arrays_target, new_array, new_cosines);
     }
 
     // Cosines from old and new edges
-    const auto old_cosines_between_edges_sharing_moved_node =
-            cosine_directors_from_connected_edges(old_edges);
-    const auto new_cosines_between_edges_sharing_moved_node =
-            cosine_directors_from_connected_edges(new_edges);
-    old_cosines.insert(std::end(old_cosines),
-                       std::begin(old_cosines_between_edges_sharing_moved_node),
-                       std::end(old_cosines_between_edges_sharing_moved_node));
-    new_cosines.insert(std::end(new_cosines),
-                       std::begin(new_cosines_between_edges_sharing_moved_node),
-                       std::end(new_cosines_between_edges_sharing_moved_node));
+    cosine_directors_from_connected_edges(old_edges, old_cosines);
+    cosine_directors_from_connected_edges(new_edges, new_cosines);
 
 #if !defined(NDEBUG)
     const bool verbose = false;
@@ -141,14 +162,6 @@ void update_step_move_node::perform(const double &max_step_distance,
         std::cout << std::endl;
     }
 #endif
-    // Update Histograms:
-    //  Remove old_distances and old_cosines and
-    //  add new_distances, new_cosines
-    this->update_distances_histogram(histo_distances, old_distances,
-                                     new_distances);
-    this->update_cosines_histogram(histo_cosines, old_cosines, new_cosines);
-    // clear flag
-    randomized_flag = false;
 }
 
 void update_step_move_node::clear_move_node_parameters(
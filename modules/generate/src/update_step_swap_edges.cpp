@@ -6,10 +6,30 @@
 #include "spatial_graph.hpp"
 #include "spatial_graph_utilities.hpp"
 #include "spatial_node.hpp"
+#include <algorithm>
 #include <iostream>
 
 namespace SG {
 
+namespace {
+/** True if the edges share any source or target. */
+bool edges_are_adjacent(const GraphType::edge_descriptor &edge1,
+                        const GraphType::edge_descriptor &edge2) {
+    std::array<GraphType::vertex_descriptor, 4> edge_nodes{
+            edge1.m_source, edge1.m_target, edge2.m_source, edge2.m_target};
+    std::sort(std::begin(edge_nodes), std::end(edge_nodes));
+    return std::adjacent_find(std::begin(edge_nodes), std::end(edge_nodes)) !=
+           std::end(edge_nodes);
+}
+
+/** Random position of edge_index, same draw than select_random_edge. */
+size_t select_random_edge_position(
+        const std::vector<GraphType::edge_descriptor> &edge_index) {
+    assert(!edge_index.empty());
+    return RNG::rand_range_int(0, static_cast<int>(edge_index.size() - 1));
+}
+} // namespace
+
 void update_step_swap_edges::randomize(const GraphType &graph,
                                        edge_descriptor_pair &selected_edges,
                                        bool &randomized_flag) const {
@@ -17,6 +37,16 @@ void update_step_swap_edges::randomize(const GraphType &graph,
     randomized_flag = true;
 }
 
+void update_step_swap_edges::randomize(
+        const std::vector<edge_descriptor> &edge_index,
+        edge_descriptor_pair &selected_edges,
+        std::pair<size_t, size_t> &selected_edges_position,
+        bool &randomized_flag) const {
+    selected_edges =
+            this->select_two_valid_edges(edge_index, selected_edges_position);
+    randomized_flag = true;
+}
+
 void update_step_swap_edges::perform(
         // in/out parameters
         GraphType &graph,
@@ -34,12 +64,45 @@ void update_step_swap_edges::perform(
 
     this->clear_stored_parameters(old_distances, old_cosines, new_distances,
                                   new_cosines);
-    const bool is_periodic = (boundary_condition ==
-                              ArrayUtilities::boundary_condition::PERIODIC);
     // select two valid edges to swap at random
     if (!randomized_flag) {
         this->randomize(graph, selected_edges, randomized_flag);
     }
+    // Flip a coin to decide what kind of swap.
+    is_swap_parallel = RNG::random_bool(0.5);
+    this->compute_histogram_changes(graph, selected_edges, is_swap_parallel,
+                                    new_edges, old_distances, old_cosines,
+                                    new_distances, new_cosines);
+
+    // update histograms
+    this->update_distances_histogram(histo_distances, old_distances,
+                                     new_distances);
+    this->update_cosines_histogram(histo_cosines, old_cosines, new_cosines);
+    // clear flag
+    randomized_flag = false;
+}
+void update_step_swap_edges::randomize_movement() {
+    if (!randomized_flag_) {
+        this->randomize();
+    }
+    is_swap_parallel_ = RNG::random_bool(0.5);
+}
+
+void update_step_swap_edges::compute_histogram_changes(
+        // in parameters
+        const GraphType &graph,
+        const edge_descriptor_pair &selected_edges,
+        const bool &is_swap_parallel,
+        // out parameters
+        edge_descriptor_pair &new_edges,
+        std::vector<double> &old_distances,
+        std::vector<double> &old_cosines,
+        std::vector<double> &new_distances,
+        std::vector<double> &new_cosines) const {
+    this->clear_stored_parameters(old_distances, old_cosines, new_distances,
+                                  new_cosines);
+    const bool is_periodic = (boundary_condition ==
+                              ArrayUtilities::boundary_condition::PERIODIC);
     auto edge1 = selected_edges.first;
     auto edge2 = selected_edges.second;
     // get positions of nodes of both edges
@@ -67,14 +130,22 @@ void update_step_swap_edges::perform(
     old_distances.push_back(
             ArrayUtilities::distance(edge2_source_pos, edge2_target_image_pos));
 
-    const auto adjacent_arrays_edge1_source = get_adjacent_edges_from_source(
-            edge1.m_source, edge1.m_target, graph, boundary_condition);
-    const auto adjacent_arrays_edge1_target = get_adjacent_edges_from_source(
-            edge1.m_target, edge1.m_source, graph, boundary_condition);
-    const auto adjacent_arrays_edge2_source = get_adjacent_edges_from_source(
-            edge2.m_source, edge2.m_target, graph, boundary_condition);
-    const auto adjacent_arrays_edge2_target = get_adjacent_edges_from_source(
-            edge2.m_target, edge2.m_source, graph, boundary_condition);
+    auto &adjacent_arrays_edge1_source = adjacent_edges_buffers_[0];
+    auto &adjacent_arrays_edge1_target = adjacent_edges_buffers_[1];
+    auto &adjacent_arrays_edge2_source = adjacent_edges_buffers_[2];
+    auto &adjacent_arrays_edge2_target = adjacent_edges_buffers_[3];
+    get_adjacent_edges_from_source(edge1.m_source, edge1.m_target, graph,
+                                   boundary_condition,
+                                   adjacent_arrays_edge1_source);
+    get_adjacent_edges_from_source(edge1.m_target, edge1.m_source, graph,
+                                   boundary_condition,
+                                   adjacent_arrays_edge1_target);
+    get_adjacent_edges_from_source(edge2.m_source, edge2.m_target, graph,
+                                   boundary_condition,
+                                   adjacent_arrays_edge2_source);
+    get_adjacent_edges_from_source(edge2.m_target, edge2.m_source, graph,
+                                   boundary_condition,
+                                   adjacent_arrays_edge2_target);
 
     const auto old_fixed_edge1_out_source =
             ArrayUtilities::minus(edge1_target_image_pos, edge1_source_pos);
@@ -86,29 +157,18 @@ void update_step_swap_edges::perform(
             ArrayUtilities::minus(edge2_source_image_pos, edge2_target_pos);
 
     // get old cosines
-    const auto old_cosines1_source =
-            cosine_directors_between_edges_and_target_edge(
-                    adjacent_arrays_edge1_source, old_fixed_edge1_out_source);
-    old_cosines.insert(std::end(old_cosines), std::begin(old_cosines1_source),
-                       std::end(old_cosines1_source));
-
-    const auto old_cosines1_target =
-            cosine_directors_between_edges_and_target_edge(
-                    adjacent_arrays_edge1_target, old_fixed_edge1_out_target);
-    old_cosines.insert(std::end(old_cosines), std::begin(old_cosines1_target),
-                       std::end(old_cosines1_target));
-
-    const auto old_cosines2_source =
-            cosine_directors_between_edges_and_target_edge(
-                    adjacent_arrays_edge2_source, old_fixed_edge2_out_source);
-    old_cosines.insert(std::end(old_cosines), std::begin(old_cosines2_source),
-                       std::end(old_cosines2_source));
-
-    const auto old_cosines2_target =
-            cosine_directors_between_edges_and_target_edge(
-                    adjacent_arrays_edge2_target, old_fixed_edge2_out_target);
-    old_cosines.insert(std::end(old_cosines), std::begin(old_cosines2_target),
-                       std::end(old_cosines2_target));
+    cosine_directors_between_edges_and_target_edge(
+            adjacent_arrays_edge1_source, old_fixed_edge1_out_source,
+            old_cosines);
+    cosine_directors_between_edges_and_target_edge(
+            adjacent_arrays_edge1_target, old_fixed_edge1_out_target,
+            old_cosines);
+    cosine_directors_between_edges_and_target_edge(
+            adjacent_arrays_edge2_source, old_fixed_edge2_out_source,
+            old_cosines);
+    cosine_directors_between_edges_and_target_edge(
+            adjacent_arrays_edge2_target, old_fixed_edge2_out_target,
+            old_cosines);
     // swap edges
     // The swap has two possibilies, from the initial state:
     // - S1-T1; S2-T2 to "parallel" or "crossed"
@@ -117,8 +177,6 @@ void update_step_swap_edges::perform(
                |  |      |   |      .
     S2 --- T2  |  S2     T2  |  S2_/ \_T2
     */
-    // Flip a coin to decide what kind of swap.
-    is_swap_parallel = RNG::random_bool(0.5);
     // Get positions of vertices of the new edges
     const auto [nedge1_source, nedge1_target, nedge2_source, nedge2_target] =
             get_sources_and_targets_of_new_edges(is_swap_parallel, edge1,
@@ -176,37 +234,20 @@ void update_step_swap_edges::perform(
             ArrayUtilities::minus(nedge2_source_image_pos, nedge2_target_pos);
 
     // get new cosines
-    const auto new_cosines1_source =
-            cosine_directors_between_edges_and_target_edge(
-                    adjacent_arrays_edge1_source, new_fixed_edge1_out_source);
-    new_cosines.insert(std::end(new_cosines), std::begin(new_cosines1_source),
-                       std::end(new_cosines1_source));
-
-    const auto new_cosines1_target =
-            cosine_directors_between_edges_and_target_edge(
-                    adjacent_arrays_edge1_target, new_fixed_edge1_out_target);
-    new_cosines.insert(std::end(new_cosines), std::begin(new_cosines1_target),
-                       std::end(new_cosines1_target));
-
-    const auto new_cosines2_source =
-            cosine_directors_between_edges_and_target_edge(
-                    adjacent_arrays_edge2_source, new_fixed_edge2_out_source);
-    new_cosines.insert(std::end(new_cosines), std::begin(new_cosines2_source),
-                       std::end(new_cosines2_source));
-
-    const auto new_cosines2_target =
-            cosine_directors_between_edges_and_target_edge(
-                    adjacent_arrays_edge2_target, new_fixed_edge2_out_target);
-    new_cosines.insert(std::end(new_cosines), std::begin(new_cosines2_target),
-                       std::end(new_cosines2_target));
-
-    // update histograms
-    this->update_distances_histogram(histo_distances, old_distances,
-                                     new_distances);
-    this->update_cosines_histogram(histo_cosines, old_cosines, new_cosines);
-    // clear flag
-    randomized_flag = false;
+    cosine_directors_between_edges_and_target_edge(
+            adjacent_arrays_edge1_source, new_fixed_edge1_out_source,
+            new_cosines);
+    cosine_directors_between_edges_and_target_edge(
+            adjacent_arrays_edge1_target, new_fixed_edge1_out_target,
+            new_cosines);
+    cosine_directors_between_edges_and_target_edge(
+            adjacent_arrays_edge2_source, new_fixed_edge2_out_source,
+            new_cosines);
+    cosine_directors_between_edges_and_target_edge(
+            adjacent_arrays_edge2_target, new_fixed_edge2_out_target,
+            new_cosines);
 }
+
 void update_step_swap_edges::clear_selected_edges(
         edge_descriptor_pair &selected_edges,
         edge_descriptor_pair &new_edges) const {
@@ -240,7 +281,8 @@ void update_step_swap_edges::undo(
     this->clear_selected_edges(selected_edges, new_edges);
 }
 
-void update_step_swap_edges::update_graph(
+update_step_swap_edges::edge_descriptor_pair
+update_step_swap_edges::update_graph(
         GraphType &graph,
         const edge_descriptor_pair &selected_edges,
         const bool &is_swap_parallel) const {
@@ -259,8 +301,37 @@ void update_step_swap_edges::update_graph(
     boost::remove_edge(edge1, graph);
     boost::remove_edge(edge2, graph);
     // add the new edges
-    boost::add_edge(nedge1_source, nedge1_target, graph);
-    boost::add_edge(nedge2_source, nedge2_target, graph);
+    const auto added_edge1 =
+            boost::add_edge(nedge1_source, nedge1_target, graph).first;
+    const auto added_edge2 =
+            boost::add_edge(nedge2_source, nedge2_target, graph).first;
+    return std::make_pair(added_edge1, added_edge2);
+}
+
+void update_step_swap_edges::update_edge_index(
+        std::vector<edge_descriptor> &edge_index,
+        const edge_descriptor_pair &selected_edges,
+        const std::pair<size_t, size_t> &selected_edges_position,
+        const edge_descriptor_pair &added_edges) const {
+    const auto replace = [&edge_index](const edge_descriptor &removed,
+                                       const size_t &position,
+                                       const edge_descriptor &added) {
+        if (position < edge_index.size() && edge_index[position] == removed) {
+            edge_index[position] = added;
+            return;
+        }
+        const auto it = std::find(std::begin(edge_index),
+                                  std::end(edge_index), removed);
+        if (it == std::end(edge_index)) {
+            throw std::logic_error("update_edge_index: the removed edge is "
+                                   "not in the edge_index.");
+        }
+        *it = added;
+    };
+    replace(selected_edges.first, selected_edges_position.first,
+            added_edges.first);
+    replace(selected_edges.second, selected_edges_position.second,
+            added_edges.second);
 }
 
 std::pair<update_step_swap_edges::edge_descriptor,
@@ -292,18 +363,54 @@ update_step_swap_edges::select_two_valid_edges(const GraphType &graph,
 
     // Check that edges are not adjacent. Just comparing if any source or
     // target of the two edges are repeated
-    std::vector<GraphType::vertex_descriptor> edge_nodes{
-            edge1.m_source, edge1.m_target, edge2.m_source, edge2.m_target};
-    std::sort(std::begin(edge_nodes), std::end(edge_nodes));
-    auto pos = std::adjacent_find(std::begin(edge_nodes), std::end(edge_nodes));
-    const bool duplicate_exist = (pos != std::end(edge_nodes));
-    if (duplicate_exist) {
+    if (edges_are_adjacent(edge1, edge2)) {
         // try again
         return select_two_valid_edges(graph, ++recursive_count);
     }
     return std::make_pair(edge1, edge2);
 }
 
+std::pair<update_step_swap_edges::edge_descriptor,
+          update_step_swap_edges::edge_descriptor>
+update_step_swap_edges::select_two_valid_edges(
+        const std::vector<edge_descriptor> &edge_index,
+        std::pair<size_t, size_t> &selected_edges_position,
+        int recursive_count) const {
+    if (recursive_count > 10) {
+        throw std::runtime_error("select_two_valid_edges() is not able to find "
+                                 "two valid (non-adjacent) edges."
+
+                                 " recursive_count too high: " +
+                                 std::to_string(recursive_count) +
+                                 ".\nMaybe the graph is too "
+                                 "small? or over-connected?");
+    }
+    // select two edges to swap at random
+    auto &position1 = selected_edges_position.first;
+    auto &position2 = selected_edges_position.second;
+    position1 = select_random_edge_position(edge_index);
+    position2 = select_random_edge_position(edge_index);
+
+    if (edge_index.size() <= 1) {
+        throw std::logic_error("select_two_valid_edges in "
+                               "update_step_swap_edges needs graph "
+                               "with more than"
+                               "one edge");
+    }
+    while (position1 == position2) {
+        position2 = select_random_edge_position(edge_index);
+    }
+
+    const auto &edge1 = edge_index[position1];
+    const auto &edge2 = edge_index[position2];
+    if (edges_are_adjacent(edge1, edge2)) {
+        // try again
+        return select_two_valid_edges(edge_index, selected_edges_position,
+                                      ++recursive_count);
+    }
+    return std::make_pair(edge1, edge2);
+}
+
 std::array<GraphType::vertex_descriptor, 4>
 update_step_swap_edges::get_sources_and_targets_of_new_edges(
         const bool &is_swap_parallel,
@@ -0,0 +1,81 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+/**
+ * Micro-benchmark of the update steps of simulated_annealing_generator.
+ * Not part of the tests, run it manually:
+ *   benchmark_update_steps [num_vertices] [num_steps]
+ *
+ * swap_edges is measured selecting the random edges walking the edge list
+ * of the graph (baseline), and from the dense edge index used by
+ * simulated_annealing_generator::engine.
+ */
+
+#include "rng.hpp"
+#include "simulated_annealing_generator.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+template <typename TUpdateStep>
+double steps_per_second(TUpdateStep &step, const size_t &num_steps) {
+    const auto t_start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < num_steps; ++i) {
+        step.randomize();
+        step.perform();
+        step.undo();
+    }
+    const std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - t_start;
+    return num_steps / elapsed.count();
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+    const size_t num_vertices = argc > 1 ? std::strtoul(argv[1], nullptr, 10)
+                                         : 5000;
+    const size_t num_steps = argc > 2 ? std::strtoul(argv[2], nullptr, 10)
+                                      : 200000;
+    RNG::engine().seed(10);
+    auto gen = SG::simulated_annealing_generator(num_vertices);
+    gen.show_progress = false;
+    std::cout << "num_vertices: " << num_vertices
+              << ", num_steps: " << num_steps << std::endl;
+    std::cout << "move_node steps/s: "
+              << steps_per_second(gen.step_move_node_, num_steps)
+              << std::endl;
+    gen.step_swap_edges_.edge_index_ = nullptr;
+    const double baseline =
+            steps_per_second(gen.step_swap_edges_, num_steps);
+    const auto graph_edges = boost::edges(gen.graph_);
+    std::vector<SG::GraphType::edge_descriptor> edge_index(graph_edges.first,
+                                                           graph_edges.second);
+    gen.step_swap_edges_.edge_index_ = &edge_index;
+    const double with_edge_index =
+            steps_per_second(gen.step_swap_edges_, num_steps);
+    gen.step_swap_edges_.edge_index_ = nullptr;
+    std::cout << "swap_edges steps/s, baseline (edge list): " << baseline
+              << std::endl;
+    std::cout << "swap_edges steps/s, edge index: " << with_edge_index
+              << " (x" << with_edge_index / baseline << ")" << std::endl;
+    return EXIT_SUCCESS;
+}
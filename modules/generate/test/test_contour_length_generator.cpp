@@ -19,6 +19,7 @@
  * *******************************************************************/
 
 #include "contour_length_generator.hpp"
+#include "contour_length_generator_functions.hpp"
 #include "rng.hpp"
 #include "gmock/gmock.h"
 
@@ -45,3 +46,27 @@ TEST_F(ContourLengthGeneratorFixture, perm_works) {
     auto &edge_points01 = pair_edge_points01_ratio.first;
     SG::print_edge_points(edge_points01, std::cout);
 }
+
+TEST_F(ContourLengthGeneratorFixture, generate_contour_lengths) {
+    const size_t monomers = 20;
+    auto graph_all = graph_;
+    RNG::engine().seed(10);
+    auto cl_gen = SG::contour_length_generator(graph_all);
+    const auto ratios = cl_gen.generate_contour_lengths(k_bending_, monomers);
+
+    // Same random stream as generating each edge in order.
+    RNG::engine().seed(10);
+    EXPECT_EQ(ratios.size(), boost::num_edges(graph_));
+    size_t edge_index = 0;
+    const auto edges = boost::edges(graph_all);
+    for (auto ei = edges.first; ei != edges.second; ++ei, ++edge_index) {
+        const auto edge_points_ratio = SG::generate_contour_length(
+                graph_[boost::source(*ei, graph_)].pos,
+                graph_[boost::target(*ei, graph_)].pos, k_bending_, monomers);
+        const auto &edge_points = graph_all[*ei].edge_points;
+        EXPECT_FALSE(edge_points.empty());
+        EXPECT_EQ(edge_points, edge_points_ratio.first);
+        EXPECT_EQ(ratios[edge_index], edge_points_ratio.second);
+        EXPECT_GE(ratios[edge_index], 1.0);
+    }
+}
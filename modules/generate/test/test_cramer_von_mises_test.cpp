@@ -18,11 +18,16 @@
  *
  * *******************************************************************/
 
+#include "cramer_von_mises_incremental.hpp"
 #include "cramer_von_mises_test.hpp"
 #include "cumulative_distribution_functions.hpp"
 #include "generate_common.hpp" // For Histogram
 #include "gmock/gmock.h"
 
+#include <limits>
+#include <numeric>
+#include <random>
+
 using namespace ::testing;
 
 class CramerVonMisesTestFixture : public ::testing::Test {
@@ -256,3 +261,151 @@ TEST_F(CramerVonMisesUniformDistributionTestFixture, compute_T) {
     }
     std::cout << std::endl;
 }
+
+TEST_F(CramerVonMisesUniformDistributionTestFixture,
+       incremental_is_equal_to_full_computation) {
+    // Prefix sums and segment tree.
+    for (const size_t tree_min_bins :
+         {size_t(0), std::numeric_limits<size_t>::max()}) {
+        SCOPED_TRACE("tree_min_bins: " + std::to_string(tree_min_bins));
+        auto incremental = SG::cramer_von_mises_incremental();
+        incremental.tree_min_bins = tree_min_bins;
+        incremental.reset(histogram.counts, LUT_uniform);
+        EXPECT_EQ(incremental.uses_tree(), tree_min_bins == 0);
+        EXPECT_EQ(incremental.total_counts(), total_counts);
+        const auto initial_value = SG::cramer_von_mises_test_optimized(
+                histogram.counts, LUT_uniform, total_counts);
+        EXPECT_NEAR(incremental.value(), initial_value, 1e-12 * initial_value);
+        // Move counts between bins, keeping the total constant, as the update
+        // steps of the simulated annealing.
+        auto counts = histogram.counts;
+        std::mt19937 gen(10);
+        std::uniform_int_distribution<size_t> random_bin(0, histo_bins - 1);
+        for (size_t step = 0; step < 2000; ++step) {
+            size_t from = random_bin(gen);
+            while (counts[from] == 0) {
+                from = random_bin(gen);
+            }
+            const size_t to = random_bin(gen);
+            counts[to]++;
+            counts[from]--;
+            if (step % 2 == 0 || from == to) {
+                incremental.add(to, 1);
+                incremental.add(from, -1);
+            } else {
+                // Both changes in a single traversal, sorted by bin.
+                using BinChange = SG::cramer_von_mises_incremental::BinChange;
+                incremental.add(from < to ? std::vector<BinChange>{{from, -1},
+                                                                   {to, 1}}
+                                          : std::vector<BinChange>{{to, 1},
+                                                                   {from, -1}});
+            }
+            const auto expected = SG::cramer_von_mises_test_optimized(
+                    counts, LUT_uniform, total_counts);
+            ASSERT_NEAR(incremental.value(), expected, 1e-12 * expected)
+                    << "step: " << step;
+        }
+        for (size_t bin = 0; bin < histo_bins; ++bin) {
+            EXPECT_EQ(incremental.count(bin), static_cast<long>(counts[bin]));
+        }
+    }
+}
+
+TEST_F(CramerVonMisesUniformDistributionTestFixture,
+       incremental_value_after_does_not_modify_the_test) {
+    using BinChange = SG::cramer_von_mises_incremental::BinChange;
+    const auto centers = histogram.ComputeBinCenters();
+    for (const size_t tree_min_bins :
+         {size_t(0), std::numeric_limits<size_t>::max()}) {
+        SCOPED_TRACE("tree_min_bins: " + std::to_string(tree_min_bins));
+        auto incremental = SG::cramer_von_mises_incremental();
+        incremental.tree_min_bins = tree_min_bins;
+        incremental.reset(histogram.counts, LUT_uniform, centers);
+        auto counts = histogram.counts;
+        std::mt19937 gen(20);
+        std::uniform_int_distribution<size_t> random_bin(0, histo_bins - 1);
+        for (size_t step = 0; step < 500; ++step) {
+            // Move two values, as a step moving a node of degree two.
+            std::vector<long> deltas(histo_bins, 0);
+            for (size_t moved = 0; moved < 2; ++moved) {
+                size_t from = random_bin(gen);
+                while (static_cast<long>(counts[from]) + deltas[from] <= 0) {
+                    from = random_bin(gen);
+                }
+                deltas[from]--;
+                deltas[random_bin(gen)]++;
+            }
+            std::vector<BinChange> changes;
+            auto candidate_counts = counts;
+            for (size_t bin = 0; bin < histo_bins; ++bin) {
+                if (deltas[bin] != 0) {
+                    changes.emplace_back(bin, deltas[bin]);
+                    candidate_counts[bin] += deltas[bin];
+                }
+            }
+            const auto expected = SG::cramer_von_mises_test_optimized(
+                    candidate_counts, LUT_uniform, total_counts);
+            ASSERT_NEAR(incremental.value_after(changes), expected,
+                        1e-12 * expected)
+                    << "step: " << step;
+            const double expected_weighted_counts = std::inner_product(
+                    std::begin(centers), std::end(centers),
+                    std::begin(candidate_counts), 0.0);
+            ASSERT_NEAR(incremental.weighted_counts_after(changes),
+                        expected_weighted_counts,
+                        1e-12 * expected_weighted_counts);
+            // Accept only half of the steps, as the simulated annealing.
+            if (step % 2 == 0) {
+                incremental.add(changes);
+                counts = candidate_counts;
+            }
+            const auto current = SG::cramer_von_mises_test_optimized(
+                    counts, LUT_uniform, total_counts);
+            ASSERT_NEAR(incremental.value(), current, 1e-12 * current);
+        }
+        // Negative counts.
+        EXPECT_EQ(incremental.value_after(
+                          {{0, -static_cast<long>(counts[0]) - 1},
+                           {1, static_cast<long>(counts[0]) + 1}}),
+                  std::numeric_limits<double>::infinity());
+    }
+}
+
+TEST_F(CramerVonMisesUniformDistributionTestFixture,
+       incremental_weighted_counts_and_rebuild) {
+    const auto centers = histogram.ComputeBinCenters();
+    auto incremental = SG::cramer_von_mises_incremental();
+    incremental.rebuild_period = 7;
+    incremental.reset(histogram.counts, LUT_uniform, centers);
+    auto counts = histogram.counts;
+    for (size_t step = 0; step < 20; ++step) {
+        const size_t from = step % histo_bins;
+        const size_t to = (3 * step + 1) % histo_bins;
+        counts[to]++;
+        incremental.add(to, 1);
+        counts[from]--;
+        incremental.add(from, -1);
+    }
+    const auto expected = SG::cramer_von_mises_test_optimized(
+            counts, LUT_uniform, total_counts);
+    EXPECT_NEAR(incremental.value(), expected, 1e-12 * expected);
+    const double expected_weighted_counts = std::inner_product(
+            std::begin(centers), std::end(centers), std::begin(counts), 0.0);
+    EXPECT_NEAR(incremental.weighted_counts(), expected_weighted_counts,
+                1e-12 * expected_weighted_counts);
+}
+
+TEST_F(CramerVonMisesUniformDistributionTestFixture,
+       incremental_is_infinity_with_negative_counts) {
+    auto incremental = SG::cramer_von_mises_incremental();
+    incremental.reset(histogram.counts, LUT_uniform);
+    incremental.add(1, 3);
+    incremental.add(0, -3);
+    EXPECT_EQ(incremental.value(), std::numeric_limits<double>::infinity());
+    incremental.add(0, 3);
+    incremental.add(1, -3);
+    EXPECT_NEAR(incremental.value(),
+                SG::cramer_von_mises_test_optimized(histogram.counts,
+                                                    LUT_uniform, total_counts),
+                1e-12);
+}
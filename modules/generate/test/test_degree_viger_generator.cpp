@@ -21,6 +21,8 @@
 #include "spatial_graph_utilities.hpp"
 #include "degree_viger_generator.hpp"
 #include "gmock/gmock.h"
+#include <boost/graph/connected_components.hpp>
+#include <set>
 
 using namespace ::testing;
 
@@ -46,3 +48,43 @@ TEST_F(RandomGraphFromDegreesFixture, fully_connected) {
     EXPECT_EQ(boost::num_vertices(graph), std::size(degree_sequence));
     EXPECT_EQ(boost::num_edges(graph), 6);
 }
+
+TEST_F(RandomGraphFromDegreesFixture, shuffle_keeps_degrees_and_connectivity) {
+    // Sparse graph, most of the swaps remove edges of the spanning tree that
+    // certifies the connectivity.
+    const size_t num_vertices = 2000;
+    std::vector<int> degree_sequence(num_vertices, 3);
+    for (size_t i = 0; i < num_vertices; i += 4) {
+        degree_sequence[i] = 1;
+        degree_sequence[i + 1] = 2;
+    }
+    using ShuffleType = SG::degree_viger_generator::ShuffleType;
+    for (const auto type :
+         {ShuffleType::FINAL_HEURISTICS, ShuffleType::GKAN_HEURISTICS,
+          ShuffleType::FAB_HEURISTICS,
+          ShuffleType::BRUTE_FORCE_HEURISTICS}) {
+        SCOPED_TRACE("shuffle type " + std::to_string(static_cast<int>(type)));
+        SG::degree_viger_generator gen(degree_sequence);
+        ASSERT_TRUE(gen.havel_hakimi());
+        ASSERT_TRUE(gen.make_connected());
+        const auto swaps =
+                gen.shuffle(gen.arcs_, 10 * gen.arcs_, type, false);
+        EXPECT_GT(swaps, 0);
+        auto graph = SG::convert_degree_viger_generator_to_graph_type(gen);
+        ASSERT_EQ(boost::num_vertices(graph), num_vertices);
+        std::set<std::pair<size_t, size_t>> edges;
+        for (size_t v = 0; v < num_vertices; ++v) {
+            EXPECT_EQ(boost::out_degree(v, graph), degree_sequence[v]);
+            for (const auto &e :
+                 boost::make_iterator_range(boost::out_edges(v, graph))) {
+                const auto target = boost::target(e, graph);
+                EXPECT_NE(target, v); // no self-loops
+                edges.emplace(v, target);
+            }
+        }
+        // no parallel edges
+        EXPECT_EQ(edges.size(), 2 * boost::num_edges(graph));
+        std::vector<int> component(num_vertices);
+        EXPECT_EQ(boost::connected_components(graph, component.data()), 1);
+    }
+}
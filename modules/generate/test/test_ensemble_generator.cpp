@@ -0,0 +1,98 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+#include "gmock/gmock.h"
+
+#include "ensemble_generator.hpp"
+#include "rng.hpp"
+#include "spatial_graph_io.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+struct EnsembleGeneratorFixture : public ::testing::Test {
+    void SetUp() override {
+        tree.physical_scaling_params.num_vertices = 100;
+        tree.transition_params.MAX_ENGINE_ITERATIONS = 1000;
+        tree.transition_params.ENERGY_CONVERGENCE = 0.0;
+        tree.ete_distance_params.num_bins = 100;
+        tree.cosine_params.num_bins = 100;
+        params.first_seed = 10;
+        params.num_runs = 5;
+    }
+    SG::simulated_annealing_generator_config_tree tree;
+    SG::ensemble_parameters params;
+};
+
+TEST_F(EnsembleGeneratorFixture, runs_are_equal_to_a_single_generator) {
+    params.num_threads = 2;
+    const auto result = SG::generate_ensemble(tree, params);
+    ASSERT_EQ(result.runs.size(), params.num_runs);
+    EXPECT_EQ(result.steps_performed,
+              params.num_runs * tree.transition_params.MAX_ENGINE_ITERATIONS);
+    EXPECT_GT(result.steps_per_second(), 0.0);
+    for (size_t i = 0; i < params.num_runs; ++i) {
+        EXPECT_EQ(result.runs[i].seed, params.first_seed + i);
+        EXPECT_TRUE(result.runs[i].output_file.empty());
+    }
+    const auto &run = result.runs[3];
+    RNG::engine().seed(run.seed);
+    auto gen = SG::simulated_annealing_generator(tree);
+    gen.show_progress = false;
+    gen.engine();
+    EXPECT_EQ(run.transition_params.energy, gen.transition_params.energy);
+    EXPECT_EQ(run.transition_params.accepted_transitions,
+              gen.transition_params.accepted_transitions);
+}
+
+TEST_F(EnsembleGeneratorFixture, result_does_not_depend_on_num_threads) {
+    params.num_threads = 1;
+    const auto result_serial = SG::generate_ensemble(tree, params);
+    params.num_threads = 3;
+    const auto result_parallel = SG::generate_ensemble(tree, params);
+    for (size_t i = 0; i < params.num_runs; ++i) {
+        EXPECT_EQ(result_serial.runs[i].transition_params.energy,
+                  result_parallel.runs[i].transition_params.energy);
+        EXPECT_EQ(result_serial.runs[i].transition_params.temp_current,
+                  result_parallel.runs[i].transition_params.temp_current);
+    }
+}
+
+TEST_F(EnsembleGeneratorFixture, writes_graphs_and_summary) {
+    params.num_threads = 2;
+    params.output_prefix = ::testing::TempDir() + "sg_ensemble";
+    const auto result = SG::generate_ensemble(tree, params);
+    for (const auto &run : result.runs) {
+        const auto graph = SG::read_graphviz_sg(run.output_file);
+        EXPECT_EQ(boost::num_vertices(graph),
+                  tree.physical_scaling_params.num_vertices);
+        std::remove(run.output_file.c_str());
+    }
+    const std::string summary_file = params.output_prefix + "_summary.tsv";
+    std::ifstream summary(summary_file);
+    size_t num_lines = 0;
+    for (std::string line; std::getline(summary, line);) {
+        ++num_lines;
+    }
+    EXPECT_EQ(num_lines, params.num_runs + 1);
+    summary.close();
+    std::remove(summary_file.c_str());
+}
@@ -0,0 +1,105 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+#include "gmock/gmock.h"
+
+#include "parallel_tempering_generator.hpp"
+
+#include <algorithm>
+#include <vector>
+
+struct ParallelTemperingGeneratorFixture : public ::testing::Test {
+    void SetUp() override {
+        tree.physical_scaling_params.num_vertices = 100;
+        tree.transition_params.MAX_ENGINE_ITERATIONS = 2000;
+        tree.transition_params.ENERGY_CONVERGENCE = 0.0;
+        tree.transition_params.UPDATE_STEP_MOVE_NODE_PROBABILITY = 0.5;
+        tree.ete_distance_params.num_bins = 100;
+        tree.cosine_params.num_bins = 100;
+        params.num_replicas = 4;
+        params.steps_between_exchanges = 200;
+        params.seed = 10;
+    }
+    SG::simulated_annealing_generator_config_tree tree;
+    SG::parallel_tempering_parameters params;
+};
+
+TEST_F(ParallelTemperingGeneratorFixture, engine_works) {
+    auto gen = SG::parallel_tempering_generator(tree, params);
+    EXPECT_EQ(gen.num_replicas(), params.num_replicas);
+    EXPECT_DOUBLE_EQ(gen.replica(1).transition_params.temp_initial,
+                     params.temp_ladder_ratio *
+                             gen.replica(0).transition_params.temp_initial);
+    const auto result = gen.engine();
+    ASSERT_EQ(result.replicas.size(), params.num_replicas);
+    EXPECT_EQ(boost::num_vertices(result.graph),
+              tree.physical_scaling_params.num_vertices);
+    for (size_t r = 0; r < gen.num_replicas(); ++r) {
+        const auto &stats = result.replicas[r];
+        EXPECT_EQ(stats.steps_performed,
+                  tree.transition_params.MAX_ENGINE_ITERATIONS);
+        EXPECT_GT(stats.exchanges_attempted, 0);
+        EXPECT_LE(result.energy, stats.energy);
+        const double energy = gen.replica(r).compute_energy();
+        EXPECT_NEAR(stats.energy, energy, 1e-9 * energy);
+    }
+    EXPECT_LT(result.energy, result.replicas[result.replica].energy_initial);
+}
+
+TEST_F(ParallelTemperingGeneratorFixture,
+       result_does_not_depend_on_num_threads) {
+    params.num_threads = 1;
+    auto gen_serial = SG::parallel_tempering_generator(tree, params);
+    const auto result_serial = gen_serial.engine();
+    params.num_threads = 4;
+    auto gen_parallel = SG::parallel_tempering_generator(tree, params);
+    const auto result_parallel = gen_parallel.engine();
+    EXPECT_EQ(result_serial.energy, result_parallel.energy);
+    EXPECT_EQ(result_serial.replica, result_parallel.replica);
+    for (size_t r = 0; r < params.num_replicas; ++r) {
+        EXPECT_EQ(result_serial.replicas[r].energy,
+                  result_parallel.replicas[r].energy);
+        EXPECT_EQ(result_serial.replicas[r].temp_current,
+                  result_parallel.replicas[r].temp_current);
+        EXPECT_EQ(result_serial.replicas[r].exchanges_accepted,
+                  result_parallel.replicas[r].exchanges_accepted);
+    }
+}
+
+TEST_F(ParallelTemperingGeneratorFixture, temperature_ladder_is_fixed) {
+    tree.transition_params.temp_cooling_rate = 0.9;
+    auto gen = SG::parallel_tempering_generator(tree, params);
+    std::vector<double> ladder;
+    for (size_t r = 0; r < gen.num_replicas(); ++r) {
+        EXPECT_EQ(gen.replica(r).transition_params.temp_cooling_rate, 1.0);
+        ladder.push_back(gen.replica(r).transition_params.temp_initial);
+    }
+    const auto result = gen.engine();
+    // The replicas only exchange the temperatures of the ladder.
+    std::vector<double> temps;
+    size_t exchanges_accepted = 0;
+    for (const auto &stats : result.replicas) {
+        temps.push_back(stats.temp_current);
+        exchanges_accepted += stats.exchanges_accepted;
+    }
+    std::sort(std::begin(temps), std::end(temps));
+    EXPECT_EQ(temps, ladder);
+    EXPECT_GT(exchanges_accepted, 0);
+}
@@ -24,7 +24,9 @@
 #include "simulated_annealing_generator.hpp"
 #include "spatial_graph.hpp"
 #include <boost/graph/graphviz.hpp>
+#include <cstdio>
 #include <iostream>
+#include <numeric>
 
 struct SimulatedAnnealingGeneratorFixture : public ::testing::Test {
 
@@ -111,3 +113,126 @@ TEST_F(SimulatedAnnealingGeneratorFixture, config_tree_constructor_works) {
     gen.engine();
     gen.print(std::cout);
 }
+
+TEST_F(SimulatedAnnealingGeneratorFixture,
+       incremental_energy_is_equal_to_full_computation) {
+    auto gen = SG::simulated_annealing_generator(100);
+    gen.transition_params.UPDATE_STEP_MOVE_NODE_PROBABILITY = 0.5;
+    gen.transition_params.MAX_ENGINE_ITERATIONS = 200;
+    gen.incremental_energy_min_bins = 0;
+    for (size_t run = 0; run < 5; ++run) {
+        gen.engine();
+        const double energy = gen.compute_energy();
+        EXPECT_NEAR(gen.compute_energy_incremental(), energy, 1e-9 * energy);
+        EXPECT_NEAR(gen.transition_params.energy, energy, 1e-9 * energy);
+        gen.transition_params.MAX_ENGINE_ITERATIONS += 200;
+    }
+}
+
+TEST_F(SimulatedAnnealingGeneratorFixture,
+       batch_of_update_steps_keeps_histograms_consistent) {
+    auto gen = SG::simulated_annealing_generator(500);
+    gen.transition_params.UPDATE_STEP_MOVE_NODE_PROBABILITY = 0.5;
+    gen.transition_params.MAX_ENGINE_ITERATIONS = 2000;
+    gen.transition_params.ENERGY_CONVERGENCE = 0.0;
+    gen.update_steps_batch_size = 32;
+    for (const size_t min_bins : {size_t(0), size_t(1000)}) {
+        gen.incremental_energy_min_bins = min_bins;
+        gen.engine();
+        EXPECT_EQ(gen.transition_params.steps_performed,
+                  gen.transition_params.MAX_ENGINE_ITERATIONS);
+        const double energy = gen.compute_energy();
+        EXPECT_NEAR(gen.transition_params.energy, energy, 1e-9 * energy);
+        const auto counts_ete_distances = gen.histo_ete_distances_.counts;
+        const auto counts_cosines = gen.histo_cosines_.counts;
+        // Histograms computed from scratch with the final graph.
+        gen.populate_histogram_ete_distances();
+        gen.populate_histogram_cosines();
+        EXPECT_EQ(gen.histo_ete_distances_.counts, counts_ete_distances);
+        EXPECT_EQ(std::accumulate(std::begin(gen.histo_cosines_.counts),
+                                  std::end(gen.histo_cosines_.counts), 0UL),
+                  std::accumulate(std::begin(counts_cosines),
+                                  std::end(counts_cosines), 0UL));
+        gen.transition_params.energy = gen.compute_energy();
+        gen.transition_params.MAX_ENGINE_ITERATIONS += 2000;
+    }
+}
+
+TEST_F(SimulatedAnnealingGeneratorFixture,
+       undone_update_steps_keep_histograms) {
+    // Performance is measured in benchmark_update_steps.
+    auto gen = SG::simulated_annealing_generator(500);
+    gen.show_progress = false;
+    const auto perform_and_undo = [](auto &step) {
+        for (size_t i = 0; i < 2000; ++i) {
+            step.randomize();
+            step.perform();
+            step.undo();
+        }
+    };
+    const auto counts_ete_distances = gen.histo_ete_distances_.counts;
+    const auto counts_cosines = gen.histo_cosines_.counts;
+    perform_and_undo(gen.step_move_node_);
+    perform_and_undo(gen.step_swap_edges_);
+    const auto graph_edges = boost::edges(gen.graph_);
+    std::vector<SG::GraphType::edge_descriptor> edge_index(graph_edges.first,
+                                                           graph_edges.second);
+    gen.step_swap_edges_.edge_index_ = &edge_index;
+    perform_and_undo(gen.step_swap_edges_);
+    gen.step_swap_edges_.edge_index_ = nullptr;
+    EXPECT_EQ(gen.histo_ete_distances_.counts, counts_ete_distances);
+    EXPECT_EQ(gen.histo_cosines_.counts, counts_cosines);
+    gen.populate_histogram_ete_distances();
+    gen.populate_histogram_cosines();
+    EXPECT_EQ(gen.histo_ete_distances_.counts, counts_ete_distances);
+    EXPECT_EQ(gen.histo_cosines_.counts, counts_cosines);
+}
+
+TEST_F(SimulatedAnnealingGeneratorFixture,
+       resume_from_checkpoint_is_bit_identical) {
+    const std::string checkpoint_file =
+            ::testing::TempDir() + "sg_annealing_checkpoint.bin";
+    for (const size_t min_bins : {size_t(0), size_t(1000)}) {
+        RNG::engine().seed(10);
+        auto gen = SG::simulated_annealing_generator(200);
+        gen.show_progress = false;
+        gen.incremental_energy_min_bins = min_bins;
+        gen.transition_params.ENERGY_CONVERGENCE = 0.0;
+        gen.transition_params.MAX_ENGINE_ITERATIONS = 2000;
+        gen.checkpoint_every_steps = 500;
+        gen.checkpoint_file = checkpoint_file;
+        gen.engine();
+        // The last checkpoint is written at step 1500.
+        auto resumed = SG::simulated_annealing_generator();
+        resumed.show_progress = false;
+        resumed.load_checkpoint(checkpoint_file);
+        EXPECT_EQ(resumed.transition_params.steps_performed, 1500UL);
+        resumed.engine();
+        const auto &tp = gen.transition_params;
+        const auto &resumed_tp = resumed.transition_params;
+        EXPECT_EQ(resumed_tp.steps_performed, tp.steps_performed);
+        EXPECT_EQ(resumed_tp.accepted_transitions, tp.accepted_transitions);
+        EXPECT_EQ(resumed_tp.rejected_transitions, tp.rejected_transitions);
+        EXPECT_EQ(resumed_tp.energy, tp.energy);
+        EXPECT_EQ(resumed_tp.temp_current, tp.temp_current);
+        EXPECT_EQ(resumed.histo_ete_distances_.counts,
+                  gen.histo_ete_distances_.counts);
+        EXPECT_EQ(resumed.histo_cosines_.counts, gen.histo_cosines_.counts);
+        ASSERT_EQ(boost::num_vertices(resumed.graph_),
+                  boost::num_vertices(gen.graph_));
+        ASSERT_EQ(boost::num_edges(resumed.graph_),
+                  boost::num_edges(gen.graph_));
+        for (size_t v = 0; v < boost::num_vertices(gen.graph_); ++v) {
+            EXPECT_EQ(resumed.graph_[v].pos, gen.graph_[v].pos);
+        }
+    }
+    std::remove(checkpoint_file.c_str());
+}
+
+TEST_F(SimulatedAnnealingGeneratorFixture,
+       checkpoint_every_steps_requires_a_file) {
+    auto gen = SG::simulated_annealing_generator(50);
+    gen.show_progress = false;
+    gen.checkpoint_every_steps = 10;
+    EXPECT_THROW(gen.engine(), std::runtime_error);
+}
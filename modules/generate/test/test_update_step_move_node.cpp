@@ -94,3 +94,27 @@ TEST_F(UpdateStepMoveNodeFixture, update_graph_works) {
         EXPECT_NE(g[step.selected_node_].pos, p2);
     }
 }
+
+TEST_F(UpdateStepMoveNodeFixture, staged_perform_is_equal_to_perform) {
+    auto histo_distances_staged = histo_distances;
+    auto histo_cosines_staged = histo_cosines;
+    auto step = SG::update_step_move_node(g, histo_distances, histo_cosines);
+    auto step_staged = SG::update_step_move_node(g, histo_distances_staged,
+                                                 histo_cosines_staged);
+    step.max_step_distance_ = 0.2;
+    step_staged.max_step_distance_ = 0.2;
+    RNG::engine().seed(5);
+    step.perform();
+    RNG::engine().seed(5);
+    step_staged.randomize_movement();
+    step_staged.compute_histogram_changes();
+    step_staged.update_histograms();
+    EXPECT_EQ(step_staged.selected_node_, step.selected_node_);
+    EXPECT_EQ(step_staged.new_node_position_, step.new_node_position_);
+    EXPECT_EQ(histo_distances_staged.counts, histo_distances.counts);
+    EXPECT_EQ(histo_cosines_staged.counts, histo_cosines.counts);
+    std::vector<SG::GraphType::vertex_descriptor> vertices;
+    step_staged.selected_vertices(vertices);
+    EXPECT_EQ(vertices.size(), 1);
+    EXPECT_EQ(vertices[0], step.selected_node_);
+}
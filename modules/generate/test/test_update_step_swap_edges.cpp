@@ -5,6 +5,7 @@
 #include "spatial_graph_utilities.hpp"
 #include "update_step_swap_edges.hpp"
 #include "gmock/gmock.h"
+#include <algorithm>
 
 using namespace ::testing;
 
@@ -143,3 +144,56 @@ TEST_F(UpdateStepSwapEdgesFixture,
     EXPECT_EQ(step.new_edges_.second.m_source, 2);
     EXPECT_EQ(step.new_edges_.second.m_target, 1);
 }
+
+TEST_F(UpdateStepSwapEdgesFixture, staged_perform_is_equal_to_perform) {
+    auto histo_distances_staged = histo_distances;
+    auto histo_cosines_staged = histo_cosines;
+    auto step = SG::update_step_swap_edges(g, histo_distances, histo_cosines);
+    auto step_staged = SG::update_step_swap_edges(g, histo_distances_staged,
+                                                  histo_cosines_staged);
+    RNG::engine().seed(5);
+    step.perform();
+    RNG::engine().seed(5);
+    step_staged.randomize_movement();
+    step_staged.compute_histogram_changes();
+    step_staged.update_histograms();
+    EXPECT_EQ(step_staged.is_swap_parallel_, step.is_swap_parallel_);
+    EXPECT_EQ(step_staged.new_edges_, step.new_edges_);
+    EXPECT_EQ(histo_distances_staged.counts, histo_distances.counts);
+    EXPECT_EQ(histo_cosines_staged.counts, histo_cosines.counts);
+    std::vector<SG::GraphType::vertex_descriptor> vertices;
+    step_staged.selected_vertices(vertices);
+    EXPECT_EQ(vertices.size(), 4);
+}
+
+TEST_F(UpdateStepSwapEdgesFixture, edge_index_is_updated_with_the_graph) {
+    const auto graph_edges = boost::edges(g);
+    std::vector<SG::GraphType::edge_descriptor> edge_index(graph_edges.first,
+                                                           graph_edges.second);
+    auto step = SG::update_step_swap_edges(g, histo_distances, histo_cosines);
+    auto step_indexed =
+            SG::update_step_swap_edges(g, histo_distances, histo_cosines);
+    step_indexed.edge_index_ = &edge_index;
+    // Same random draws selecting from the graph or from the index.
+    RNG::engine().seed(5);
+    step.randomize();
+    RNG::engine().seed(5);
+    step_indexed.randomize();
+    EXPECT_EQ(step_indexed.selected_edges_, step.selected_edges_);
+
+    step_indexed.perform();
+    step_indexed.update_graph();
+    ASSERT_EQ(edge_index.size(), boost::num_edges(g));
+    const auto edge_pairs = [this](auto first, auto last) {
+        std::vector<std::pair<size_t, size_t>> pairs;
+        for (; first != last; ++first) {
+            pairs.emplace_back(std::minmax(boost::source(*first, g),
+                                           boost::target(*first, g)));
+        }
+        std::sort(std::begin(pairs), std::end(pairs));
+        return pairs;
+    };
+    const auto new_graph_edges = boost::edges(g);
+    EXPECT_EQ(edge_pairs(std::begin(edge_index), std::end(edge_index)),
+              edge_pairs(new_graph_edges.first, new_graph_edges.second));
+}
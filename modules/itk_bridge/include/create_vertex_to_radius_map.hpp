@@ -21,6 +21,7 @@
 #ifndef SG_CREATE_VERTEX_TO_RADIUS_MAP_HPP
 #define SG_CREATE_VERTEX_TO_RADIUS_MAP_HPP
 
+#include "distance_sampler.hpp"
 #include "image_types.hpp" // for image types
 #include "spatial_graph.hpp"
 #include "transform_to_physical_point.hpp" // for physical_space_array_to_index_array
@@ -34,27 +35,19 @@ namespace SG {
 using VertexToRadiusMap =
         std::unordered_map<typename GraphType::vertex_descriptor, double>;
 
+namespace detail {
 /**
- * Create a vertex to local radius map from a distance map and a graph.
- *
- * @tparam TGraph to work with filter_graphs as well.
- *
- * @param distance_map_image obtained from a binary image @sa
- * create_distance_map_function
- * @param input_graph input spatial graph to get the vertices/nodes
- * @param spatial_nodes_position_are_in_physical_space flag to check if
- *  position of nodes were already converted to physical space, or are still in index space.
- *  false indicates that positions are in index space. See @sa transform_to_physical_point
- * @param verbose extra information at execution
- *
- * @return vertex to local radius map using the distance map
+ * Implementation of @ref create_vertex_to_radius_map for any distance map
+ * type providing the read interface of FloatImageType: ImageDimension,
+ * IndexType, GetPixel and TransformPhysicalPointToIndex.
+ * For example: FloatImageType or DistanceSampler.
  */
-template<typename TGraph>
-VertexToRadiusMap create_vertex_to_radius_map(
-        const typename FloatImageType::Pointer &distance_map_image,
+template<typename TDistanceMap, typename TGraph>
+VertexToRadiusMap create_vertex_to_radius_map_generic(
+        const TDistanceMap *distance_map_image,
         const TGraph &input_graph,
-        const bool spatial_nodes_position_are_in_physical_space = false,
-        const bool verbose = false)
+        const bool spatial_nodes_position_are_in_physical_space,
+        const bool verbose)
 {
     boost::ignore_unused(verbose);
     VertexToRadiusMap vertex_to_local_radius_map;
@@ -68,11 +61,11 @@ VertexToRadiusMap create_vertex_to_radius_map(
         const auto spatial_node_position_index_space =
                 spatial_nodes_position_are_in_physical_space
                         ? physical_space_array_to_index_array(
-                                  input_graph[*vi].pos, distance_map_image.GetPointer())
+                                  input_graph[*vi].pos, distance_map_image)
                         : input_graph[*vi].pos;
 
         // Transform index_position to ITK IndexType
-        typename FloatImageType::IndexType pixel_index;
+        typename TDistanceMap::IndexType pixel_index;
         for (size_t i = 0; i < 3; i++) {
             pixel_index[i] = spatial_node_position_index_space[i];
         }
@@ -84,6 +77,59 @@ VertexToRadiusMap create_vertex_to_radius_map(
 
     return vertex_to_local_radius_map;
 }
+} // end namespace detail
+
+/**
+ * Create a vertex to local radius map from a distance map and a graph.
+ *
+ * @tparam TGraph to work with filter_graphs as well.
+ *
+ * @param distance_map_image obtained from a binary image @sa
+ * create_distance_map_function
+ * @param input_graph input spatial graph to get the vertices/nodes
+ * @param spatial_nodes_position_are_in_physical_space flag to check if
+ *  position of nodes were already converted to physical space, or are still in index space.
+ *  false indicates that positions are in index space. See @sa transform_to_physical_point
+ * @param verbose extra information at execution
+ *
+ * @return vertex to local radius map using the distance map
+ */
+template<typename TGraph>
+VertexToRadiusMap create_vertex_to_radius_map(
+        const typename FloatImageType::Pointer &distance_map_image,
+        const TGraph &input_graph,
+        const bool spatial_nodes_position_are_in_physical_space = false,
+        const bool verbose = false)
+{
+    return detail::create_vertex_to_radius_map_generic(
+            distance_map_image.GetPointer(), input_graph,
+            spatial_nodes_position_are_in_physical_space, verbose);
+}
+
+/**
+ * Create a vertex to local radius map computing the distances lazily, only at
+ * the position of the nodes, from a binary image.
+ * No distance map image is required, @sa DistanceSampler.
+ *
+ * @param distance_sampler sampler constructed from the binary image
+ * @param input_graph input spatial graph to get the vertices/nodes
+ * @param spatial_nodes_position_are_in_physical_space flag to check if
+ *  position of nodes were already converted to physical space.
+ * @param verbose extra information at execution
+ *
+ * @return vertex to local radius map
+ */
+template<typename TGraph>
+VertexToRadiusMap create_vertex_to_radius_map(
+        const DistanceSampler &distance_sampler,
+        const TGraph &input_graph,
+        const bool spatial_nodes_position_are_in_physical_space = false,
+        const bool verbose = false)
+{
+    return detail::create_vertex_to_radius_map_generic(
+            &distance_sampler, input_graph,
+            spatial_nodes_position_are_in_physical_space, verbose);
+}
 
 // explicit instantiation in create_vertex_to_radius_map.cpp
 extern template VertexToRadiusMap create_vertex_to_radius_map<GraphType>(
@@ -91,6 +137,11 @@ extern template VertexToRadiusMap create_vertex_to_radius_map<GraphType>(
         const GraphType &input_graph,
         const bool spatial_nodes_position_are_in_physical_space,
         const bool /*verbose*/);
+extern template VertexToRadiusMap create_vertex_to_radius_map<GraphType>(
+        const DistanceSampler &distance_sampler,
+        const GraphType &input_graph,
+        const bool spatial_nodes_position_are_in_physical_space,
+        const bool /*verbose*/);
 
 } // end namespace SG
 #endif
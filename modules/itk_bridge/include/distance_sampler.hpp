@@ -0,0 +1,168 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+#ifndef SG_DISTANCE_SAMPLER_HPP
+#define SG_DISTANCE_SAMPLER_HPP
+
+#include "image_types.hpp"
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace SG {
+
+/**
+ * Lazy alternative to a full distance map image (@sa
+ * create_distance_map_function).
+ *
+ * Computes on demand the exact euclidean distance from a foreground voxel to
+ * its nearest background voxel, only at the queried indices.
+ * The binary image is packed into a bit occupancy grid (one bit per voxel)
+ * at construction, and each query performs a local search in expanding cubic
+ * shells around the index, stopping as soon as no unvisited voxel can be
+ * closer than the best background voxel found so far. Results are cached, so
+ * repeated queries (for example, a node shared by multiple edges) are O(1).
+ *
+ * The returned values match the DGtal distance map (in voxel units) used by
+ * default in create_distance_map_function: background voxels have distance 0,
+ * and foreground voxels adjacent to the background have distance 1.
+ * If use_image_spacing is true, distances are in physical units instead.
+ *
+ * It mimics the read-only interface of FloatImageType that the functions
+ * accepting a distance map use (GetPixel, TransformPhysicalPointToIndex, etc),
+ * so it can be used where a distance map is accepted, see
+ * create_vertex_to_radius_map, tree_generation and
+ * reconstruct_from_distance_map.
+ *
+ * For sparse structures (i.e. vascular trees) this avoids computing and
+ * storing the distance of every voxel in the image.
+ *
+ * Queries are thread-safe.
+ */
+class DistanceSampler {
+  public:
+    static constexpr unsigned int ImageDimension = BinaryImageDimension;
+    using PixelType = FloatImagePixelType;
+    using IndexType = BinaryImageType::IndexType;
+    using PointType = BinaryImageType::PointType;
+    using SpacingType = BinaryImageType::SpacingType;
+    using DirectionType = BinaryImageType::DirectionType;
+    using RegionType = BinaryImageType::RegionType;
+    using WordType = uint64_t;
+    static constexpr size_t word_bits = 64;
+
+    /**
+     * @param binary_image input binary image, foreground are non-zero voxels.
+     * The image is only read at construction, it can be released afterwards.
+     * @param use_image_spacing compute distances in physical units, instead
+     * of voxel units.
+     * @param max_search_radius maximum radius (in voxels) of the local search.
+     * If no background voxel is found inside it, the max_search_radius itself
+     * is returned. 0 means no limit (the largest dimension of the image).
+     */
+    explicit DistanceSampler(const BinaryImageType::Pointer &binary_image,
+                             const bool use_image_spacing = false,
+                             const size_t max_search_radius = 0);
+
+    /**
+     * Distance from index to the nearest background voxel.
+     * Indices outside the image return 0.
+     */
+    PixelType GetPixel(const IndexType &index) const;
+    /**
+     * Distance at a physical point. Returns 0 if point is outside the image.
+     */
+    PixelType GetPixelAtPhysicalPoint(const PointType &point) const;
+
+    bool is_foreground(const IndexType &index) const;
+    bool is_inside(const IndexType &index) const;
+
+    template <typename TCoordRep>
+    bool TransformPhysicalPointToIndex(
+            const itk::Point<TCoordRep, ImageDimension> &point,
+            IndexType &index) const {
+        return m_reference_image->TransformPhysicalPointToIndex(point, index);
+    }
+    template <typename TCoordRep>
+    void TransformIndexToPhysicalPoint(
+            const IndexType &index,
+            itk::Point<TCoordRep, ImageDimension> &point) const {
+        m_reference_image->TransformIndexToPhysicalPoint(index, point);
+    }
+
+    const PointType &GetOrigin() const {
+        return m_reference_image->GetOrigin();
+    }
+    const SpacingType &GetSpacing() const {
+        return m_reference_image->GetSpacing();
+    }
+    const DirectionType &GetDirection() const {
+        return m_reference_image->GetDirection();
+    }
+    const RegionType &GetLargestPossibleRegion() const {
+        return m_reference_image->GetLargestPossibleRegion();
+    }
+
+    /** True if distances are in physical units, false if in voxel units. */
+    bool use_image_spacing() const { return m_use_image_spacing; }
+    /** Number of distances computed so far (size of the cache). */
+    size_t cache_size() const;
+    void clear_cache() const;
+    /** Memory used by the bit-packed occupancy grid, in bytes. */
+    size_t occupancy_grid_bytes() const {
+        return m_bits.size() * sizeof(WordType);
+    }
+
+  private:
+    /** Squared distance (in voxel or physical units) to nearest background */
+    double compute_squared_distance(const long x,
+                                    const long y,
+                                    const long z) const;
+    /**
+     * Look for the nearest background voxel to cx in the row (y, z), in
+     * the range [cx - radius, cx + radius].
+     *
+     * @return the minimum |dx| found, or -1 if all the range is foreground.
+     */
+    long nearest_background_in_row(const long cx,
+                                   const long y,
+                                   const long z,
+                                   const long radius) const;
+    bool bit_at(const long x, const long y, const long z) const;
+    size_t linear_index(const long x, const long y, const long z) const;
+
+    /** Image with the same metadata than the input, but empty buffer. */
+    BinaryImageType::Pointer m_reference_image;
+    std::vector<WordType> m_bits;
+    long m_start[ImageDimension];
+    long m_size[ImageDimension];
+    size_t m_words_per_row;
+    double m_weights[ImageDimension]; // squared spacing, or 1.0
+    double m_min_weight;
+    bool m_use_image_spacing;
+    long m_max_search_radius;
+    mutable std::unordered_map<size_t, PixelType> m_cache;
+    mutable std::mutex m_cache_mutex;
+};
+
+} // end namespace SG
+#endif
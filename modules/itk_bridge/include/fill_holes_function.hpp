@@ -49,5 +49,61 @@ BinaryImageType::Pointer fill_holes_voting_iterative_function(
         const size_t & iterations = 1000,
         bool verbose = false
         );
+
+/**
+ * Same result than @ref fill_holes_voting_iterative_function, but after the
+ * first iteration, only the background voxels in the neighborhood of the
+ * voxels changed in the previous iteration are visited (the active front).
+ * The iterations stop when no voxel changes.
+ *
+ * The foreground value is the maximum intensity of the input, the background
+ * value is zero.
+ *
+ * @param input binary image to with holes to fill
+ * @param radius to define the neighborhood.
+ * @param majority number of pixels over 50% in the neighborhood
+ * of an OFF pixel needed to turn it into ON.
+ * @param iterations max number of iterations.
+ * @param num_threads number of threads, 0 to use the ITK default.
+ * @param verbose extra info to cout
+ *
+ * @return binary image
+ */
+BinaryImageType::Pointer fill_holes_voting_front_function(
+        const BinaryImageType::Pointer & input,
+        const int & radius = 1,
+        const int & majority = 3,
+        const size_t & iterations = 1000,
+        const size_t & num_threads = 0,
+        bool verbose = false
+        );
+
+/**
+ * Fill the cavities of the binary image: background voxels that are not
+ * connected to the border of the image are set to foreground.
+ *
+ * The connected components of the background are computed on runs of
+ * consecutive background voxels along x, with union-find. Slabs along z are
+ * labeled in parallel, and merged at the seams. No iterations are needed.
+ *
+ * The foreground value is the maximum intensity of the input, the background
+ * value is zero.
+ *
+ * @param input binary image with cavities.
+ * @param fully_connected if false (default), background voxels are
+ * connected only to their face neighbors (6-connectivity), the dual of a fully
+ * connected foreground. If true, background voxels are also connected
+ * through edges and corners (26-connectivity).
+ * @param num_threads number of threads, 0 to use the ITK default.
+ * @param verbose extra info to cout
+ *
+ * @return binary image
+ */
+BinaryImageType::Pointer fill_holes_cavities_function(
+        const BinaryImageType::Pointer & input,
+        bool fully_connected = false,
+        const size_t & num_threads = 0,
+        bool verbose = false
+        );
 } // end ns SG
 #endif
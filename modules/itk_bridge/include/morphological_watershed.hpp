@@ -22,6 +22,8 @@
 #define SG_MORPHOLOGICAL_WATERSHED_HPP
 
 #include "image_types.hpp"
+#include "spatial_graph.hpp"
+#include "spatial_graph_io.hpp" // for vertex_to_label_map_t
 
 namespace SG {
 
@@ -40,5 +42,52 @@ BinaryImageType::Pointer
 morphological_watershed(const BinaryImageType::Pointer &original_binary_image,
                         const BinaryImageType::Pointer &marker_image);
 
+/**
+ * Label the foreground of original_binary_image from the labels of the nodes
+ * and edges of a spatial graph, usually obtained from the same image.
+ *
+ * This is a geodesic label propagation, not a watershed: there is no
+ * priority on a distance map or gradient, each foreground voxel takes the
+ * label of the closest seed measured in steps inside the foreground.
+ * It is an alternative to @ref morphological_watershed with the marker image
+ * from @ref voxelize_graph_rasterized, which floods the flat inverted binary
+ * image, without creating the marker image, the inverted image, or flooding
+ * the background. Ties are broken differently, so the outputs can differ at
+ * the boundaries between labels.
+ *
+ * The labeled voxels of the graph (@ref detail::rasterize_graph_labels) inside
+ * the foreground are the seeds. The labels are propagated in parallel, in
+ * breadth first fronts, only through the foreground voxels (fully connected).
+ * If two labels reach a voxel in the same step, the greatest label wins, so
+ * the output does not depend on the number of threads.
+ * The labels must fit in BinaryImagePixelType, a std::runtime_error is
+ * thrown otherwise.
+ *
+ * The cost is proportional to the number of foreground voxels reached from
+ * the seeds, not to the size of the image.
+ * Unlike @ref morphological_watershed, foreground components without any
+ * seed keep the label 0.
+ *
+ * @param original_binary_image original binary image
+ * @param graph spatial graph
+ * @param vertex_to_label_map vertex_descriptor -> label
+ * @param edge_to_label_map edge_descriptor -> label
+ * @sa create_edge_to_label_map_from_vertex_to_label_map
+ * @param graph_positions_are_in_physical_space
+ * @param draw_segments seed also the voxels between consecutive points of the
+ * edges, not only the points.
+ * @param num_threads number of threads, 0 uses the default of ITK.
+ *
+ * @return label image, with the metadata of original_binary_image
+ */
+BinaryImageType::Pointer geodesic_label_propagation_from_graph(
+        const BinaryImageType::Pointer &original_binary_image,
+        const GraphType &graph,
+        const vertex_to_label_map_t &vertex_to_label_map,
+        const edge_to_label_map_t &edge_to_label_map,
+        const bool &graph_positions_are_in_physical_space = true,
+        const bool &draw_segments = true,
+        const size_t &num_threads = 0);
+
 } // end namespace SG
 #endif
@@ -30,7 +30,78 @@
 #include <itkNearestNeighborInterpolateImageFunction.h>
 #include <itkResampleImageFilter.h>
 
+#include <string>
+
 namespace SG {
+/**
+ * Rule to set the value of an output voxel in @ref resample_binary_image.
+ *
+ * nearest_neighbor: value of the input voxel closest to the center of the
+ * output voxel, same result than itk::NearestNeighborInterpolateImageFunction.
+ *
+ * partial_volume: the output voxel is foreground if the fraction of its
+ * volume covered by foreground input voxels is at least a threshold.
+ * Thin structures are not lost when downsampling, unlike nearest_neighbor.
+ */
+enum class BinaryResampleRule { nearest_neighbor, partial_volume };
+
+/**
+ * Resample a binary image to a new spacing and size, keeping the origin and
+ * direction of the input.
+ *
+ * Specialized alternative to itk::ResampleImageFilter with an identity
+ * transform: output voxels are computed directly from the input buffer, in
+ * parallel over z slabs of the output, without interpolators or intermediate
+ * images. Memory is the input, the output, and a coarse occupancy grid of the
+ * input (blocks of 8x8x8 voxels) used to skip empty regions.
+ *
+ * Output voxels have the value of the input voxel (nearest_neighbor) or the
+ * maximum value of the foreground voxels under them (partial_volume).
+ *
+ * @param input binary image
+ * @param output_spacing spacing of the output image
+ * @param output_size size of the output image
+ * @param rule nearest_neighbor or partial_volume
+ * @param partial_volume_threshold minimum fraction of foreground in an output
+ * voxel to be foreground, only used with partial_volume.
+ * @param num_threads number of threads, 0 uses the default of ITK.
+ *
+ * @return resampled image, with index starting at 0.
+ */
+BinaryImageType::Pointer resample_binary_image(
+        const BinaryImageType::Pointer &input,
+        const BinaryImageType::SpacingType &output_spacing,
+        const BinaryImageType::SizeType &output_size,
+        const BinaryResampleRule &rule = BinaryResampleRule::nearest_neighbor,
+        const double &partial_volume_threshold = 0.5,
+        const size_t &num_threads = 0);
+
+/**
+ * Same than @ref resample_binary_image, but the output is written to a file
+ * in slabs of planes_per_slab z planes, without holding the whole output in
+ * memory. Memory is the input, one slab of the output, and the occupancy
+ * grid.
+ *
+ * The slabs are pasted in the file, the image format has to support streamed
+ * writing, as MetaImage (.mha, .mhd). The file is written uncompressed, and
+ * replaced if it exists.
+ * Throws std::runtime_error if the format does not support streamed writing.
+ *
+ * @param output_filename file to write the resampled image
+ * @param planes_per_slab number of z planes of the output per write
+ *
+ * For the rest of parameters @sa resample_binary_image
+ */
+void resample_binary_image_to_file(
+        const BinaryImageType::Pointer &input,
+        const BinaryImageType::SpacingType &output_spacing,
+        const BinaryImageType::SizeType &output_size,
+        const std::string &output_filename,
+        const BinaryResampleRule &rule = BinaryResampleRule::nearest_neighbor,
+        const double &partial_volume_threshold = 0.5,
+        const size_t &num_threads = 0,
+        const size_t &planes_per_slab = 64);
+
 /**
  * Resample binary image.
  *
@@ -44,13 +115,17 @@ namespace SG {
  * @param shrink_factor value greater than 0 to downsample or upsample the
  * image.
  * @param verbose extra info to std::cout
+ * @param rule nearest_neighbor or partial_volume, @sa resample_binary_image
+ * @param num_threads number of threads, 0 uses the default of ITK.
  *
  * @return resampled image
  */
-BinaryImageType::Pointer
-resample_image_function(const BinaryImageType::Pointer &input,
-                        const double &shrink_factor,
-                        bool verbose);
+BinaryImageType::Pointer resample_image_function(
+        const BinaryImageType::Pointer &input,
+        const double &shrink_factor,
+        bool verbose,
+        const BinaryResampleRule &rule = BinaryResampleRule::nearest_neighbor,
+        const size_t &num_threads = 0);
 
 enum class Interpolator { wise, linear, bspline, nearest_neighbor };
 
@@ -156,6 +231,15 @@ make_isotropic(const typename TImage::Pointer &input,
         }
     }
 
+    // Binary images with the same axis only need a change of spacing.
+    if constexpr (std::is_same<TImage, BinaryImageType>()) {
+        if (!need_standardize_axis &&
+            (interpolator_method == Interpolator::wise ||
+             interpolator_method == Interpolator::nearest_neighbor)) {
+            return resample_binary_image(input, new_spacing, new_size);
+        }
+    }
+
     using TransformType =
             itk::IdentityTransform<double, TImage::ImageDimension>;
     auto transform = TransformType::New();
@@ -0,0 +1,333 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+#ifndef SG_RUN_LENGTH_COMPONENTS_HPP
+#define SG_RUN_LENGTH_COMPONENTS_HPP
+
+#include <itkMultiThreaderBase.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace SG {
+
+/**
+ * Connected components of a 3D image, stored as runs of consecutive pixels
+ * along x. Only the runs are stored, not a label per pixel.
+ *
+ * @sa label_run_length_components
+ */
+struct RunLengthComponents {
+    /** Consecutive pixels in a row (along x): [begin, end) */
+    struct Run {
+        uint32_t begin;
+        uint32_t end;
+    };
+    size_t nx = 0;
+    size_t ny = 0;
+    size_t nz = 0;
+    /** The runs of the row (y, z) are [row_offsets[r], row_offsets[r + 1]),
+     * with r = y + ny * z. */
+    std::vector<size_t> row_offsets;
+    std::vector<Run> runs;
+    /** Component of each run, identified by its first run (in raster order).
+     */
+    std::vector<size_t> component;
+
+    size_t number_of_runs() const { return runs.size(); }
+    size_t row(const size_t y, const size_t z) const { return y + ny * z; }
+};
+
+namespace detail {
+/** Union-find over runs. Roots are always the smallest index of the set. */
+inline size_t find_root(std::vector<size_t> &parent, size_t i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+inline void union_runs(std::vector<size_t> &parent,
+                       const size_t a,
+                       const size_t b) {
+    const size_t ra = find_root(parent, a);
+    const size_t rb = find_root(parent, b);
+    if (ra < rb) {
+        parent[rb] = ra;
+    } else if (rb < ra) {
+        parent[ra] = rb;
+    }
+}
+} // namespace detail
+
+/**
+ * Build @ref RunLengthComponents adding the z planes of the image in order,
+ * a group of planes at a time. Only the planes being added have to be
+ * available, so the image can be read in slabs.
+ *
+ * The planes of each call are processed in z slabs in parallel: the runs of
+ * each slab are labeled independently with a union-find, and then the slabs
+ * are merged at the seams, and with the last plane of the previous call.
+ * Because roots are always the smallest run of the set, the unions of
+ * different slabs never touch the same runs.
+ *
+ * Memory is proportional to the number of runs and rows, not to the number of
+ * pixels.
+ *
+ * @sa label_run_length_components
+ */
+class RunLengthComponentsBuilder {
+  public:
+    /**
+     * @param nx,ny,nz size of the image
+     * @param fully_connected false for face connectivity (6 in 3D), true to
+     * also connect pixels by edges and corners (26 in 3D)
+     */
+    RunLengthComponentsBuilder(const size_t nx,
+                               const size_t ny,
+                               const size_t nz,
+                               const bool fully_connected)
+            : m_fully_connected(fully_connected) {
+        m_output.nx = nx;
+        m_output.ny = ny;
+        m_output.nz = nz;
+        m_output.row_offsets.assign(ny * nz + 1, 0);
+    }
+
+    /** First plane of the next call to add_planes. */
+    size_t next_plane() const { return m_next_plane; }
+
+    /**
+     * Add the next num_planes planes of the image.
+     * is_in(offset) is true for the pixels that belong to the components,
+     * with offset = x + nx * (y + ny * (z - next_plane())), relative to the
+     * first plane added. is_in is called twice per pixel.
+     *
+     * @tparam TPredicate callable with signature bool(size_t offset)
+     * @param threader threader to parallelize the slabs
+     */
+    template <typename TPredicate>
+    void add_planes(const size_t num_planes,
+                    TPredicate &&is_in,
+                    itk::MultiThreaderBase *threader);
+
+    /** Flatten the components, after adding all the planes. */
+    RunLengthComponents finish() {
+        auto &parent = m_output.component;
+        // Roots have the smallest index of the set, flatten in ascending
+        // order.
+        for (size_t i = 0; i < parent.size(); ++i) {
+            parent[i] = parent[parent[i]];
+        }
+        return std::move(m_output);
+    }
+
+  private:
+    /**
+     * Connect runs of two neighbor rows.
+     * expand = 1 also connects runs touching diagonally.
+     */
+    void connect_rows(const size_t row_a,
+                      const size_t row_b,
+                      const uint32_t expand) {
+        const auto &row_offsets = m_output.row_offsets;
+        const auto &runs = m_output.runs;
+        size_t i = row_offsets[row_a];
+        size_t j = row_offsets[row_b];
+        const size_t end_a = row_offsets[row_a + 1];
+        const size_t end_b = row_offsets[row_b + 1];
+        while (i < end_a && j < end_b) {
+            const auto &a = runs[i];
+            const auto &b = runs[j];
+            if (a.begin < b.end + expand && b.begin < a.end + expand) {
+                detail::union_runs(m_output.component, i, j);
+            }
+            if (a.end < b.end) {
+                ++i;
+            } else {
+                ++j;
+            }
+        }
+    }
+
+    /** Rows already visited (lower z, or lower y) connected to row (y, z). */
+    void connect_to_previous_rows(const size_t y,
+                                  const size_t z,
+                                  const size_t z_min) {
+        const size_t ny = m_output.ny;
+        const size_t row = y + ny * z;
+        if (!m_fully_connected) {
+            if (y > 0) {
+                connect_rows(row, row - 1, 0);
+            }
+            if (z > z_min) {
+                connect_rows(row, row - ny, 0);
+            }
+            return;
+        }
+        if (y > 0) {
+            connect_rows(row, row - 1, 1);
+        }
+        if (z > z_min) {
+            connect_rows(row, row - ny, 1);
+            if (y > 0) {
+                connect_rows(row, row - ny - 1, 1);
+            }
+            if (y + 1 < ny) {
+                connect_rows(row, row - ny + 1, 1);
+            }
+        }
+    }
+
+    RunLengthComponents m_output;
+    bool m_fully_connected;
+    size_t m_next_plane = 0;
+};
+
+template <typename TPredicate>
+void RunLengthComponentsBuilder::add_planes(const size_t num_planes,
+                                            TPredicate &&is_in,
+                                            itk::MultiThreaderBase *threader) {
+    const size_t nx = m_output.nx;
+    const size_t ny = m_output.ny;
+    const size_t z_first = m_next_plane;
+    const size_t z_last = std::min(z_first + num_planes, m_output.nz);
+    m_next_plane = z_last;
+    if (z_last == z_first || nx * ny == 0) {
+        return;
+    }
+    auto &row_offsets = m_output.row_offsets;
+    auto &runs = m_output.runs;
+    auto &parent = m_output.component;
+
+    const size_t num_slabs = std::min<size_t>(
+            z_last - z_first, 4 * threader->GetNumberOfWorkUnits());
+    const size_t slab_depth = (z_last - z_first + num_slabs - 1) / num_slabs;
+    const auto slab_range = [&](const size_t slab) {
+        const size_t z_begin = std::min(z_first + slab * slab_depth, z_last);
+        return std::make_pair(z_begin, std::min(z_begin + slab_depth, z_last));
+    };
+    // Offset of the first pixel of a row, relative to the first plane added.
+    const auto row_pixel_offset = [&](const size_t row) {
+        return (row - z_first * ny) * nx;
+    };
+
+    // Count the runs of each row.
+    threader->ParallelizeArray(
+            0, num_slabs,
+            [&](itk::SizeValueType slab) {
+                const auto z_range = slab_range(slab);
+                for (size_t row = z_range.first * ny;
+                     row < z_range.second * ny; ++row) {
+                    const size_t row_offset = row_pixel_offset(row);
+                    size_t row_runs = 0;
+                    bool previous_is_in = false;
+                    for (size_t x = 0; x < nx; ++x) {
+                        const bool pixel_is_in = is_in(row_offset + x);
+                        row_runs += pixel_is_in && !previous_is_in;
+                        previous_is_in = pixel_is_in;
+                    }
+                    row_offsets[row + 1] = row_runs;
+                }
+            },
+            nullptr);
+    for (size_t row = z_first * ny; row < z_last * ny; ++row) {
+        row_offsets[row + 1] += row_offsets[row];
+    }
+    const size_t num_runs = row_offsets[z_last * ny];
+    runs.resize(num_runs);
+    parent.resize(num_runs);
+
+    // Fill the runs, and label each slab independently. Unions inside a slab
+    // only touch the runs of that slab, so slabs do not interfere.
+    threader->ParallelizeArray(
+            0, num_slabs,
+            [&](itk::SizeValueType slab) {
+                const auto z_range = slab_range(slab);
+                for (size_t z = z_range.first; z < z_range.second; ++z) {
+                    for (size_t y = 0; y < ny; ++y) {
+                        const size_t row = y + ny * z;
+                        const size_t row_offset = row_pixel_offset(row);
+                        size_t run = row_offsets[row];
+                        for (size_t x = 0; x < nx; ++x) {
+                            if (!is_in(row_offset + x)) {
+                                continue;
+                            }
+                            const size_t begin = x;
+                            while (x < nx && is_in(row_offset + x)) {
+                                ++x;
+                            }
+                            runs[run] = {static_cast<uint32_t>(begin),
+                                         static_cast<uint32_t>(x)};
+                            parent[run] = run;
+                            ++run;
+                        }
+                        connect_to_previous_rows(y, z, z_range.first);
+                    }
+                }
+            },
+            nullptr);
+    // Merge the slabs at the seams, the first one with the previous planes.
+    for (size_t slab = 0; slab < num_slabs; ++slab) {
+        const size_t z = slab_range(slab).first;
+        if (z == 0 || z >= z_last) {
+            continue;
+        }
+        for (size_t y = 0; y < ny; ++y) {
+            connect_to_previous_rows(y, z, z - 1);
+        }
+    }
+}
+
+/**
+ * Label the connected components of the pixels of a 3D image for which
+ * is_in(offset) is true, where offset = x + nx * (y + ny * z).
+ *
+ * All the planes are added at once to a @ref RunLengthComponentsBuilder.
+ * Memory is proportional to the number of runs and rows, not to the number of
+ * pixels. is_in is called twice per pixel.
+ *
+ * @tparam TPredicate callable with signature bool(size_t offset)
+ * @param nx,ny,nz size of the image
+ * @param is_in pixels that belong to the components
+ * @param fully_connected false for face connectivity (6 in 3D), true to
+ * also connect pixels by edges and corners (26 in 3D)
+ * @param threader threader to parallelize the slabs
+ *
+ * @return runs and the component of each run
+ */
+template <typename TPredicate>
+RunLengthComponents
+label_run_length_components(const size_t nx,
+                            const size_t ny,
+                            const size_t nz,
+                            TPredicate &&is_in,
+                            const bool fully_connected,
+                            itk::MultiThreaderBase *threader) {
+    RunLengthComponentsBuilder builder(nx, ny, nz, fully_connected);
+    builder.add_planes(nz, std::forward<TPredicate>(is_in), threader);
+    return builder.finish();
+}
+
+} // end namespace SG
+#endif
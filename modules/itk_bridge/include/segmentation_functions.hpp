@@ -28,6 +28,8 @@
 #include <itkMinimumMaximumImageFilter.h>
 #include <itkThresholdImageFilter.h>
 
+#include <string>
+
 // Template functions which are instantiated for
 // BinaryImageType and FloatImageType in the .cpp file.
 // You can use them for any other ImageType.
@@ -168,6 +170,120 @@ struct ConnectedComponentsOutput {
 ConnectedComponentsOutput
 connected_components(const BinaryImageType *input_binary_image);
 
+/**
+ * Fused binarize_with_threshold and connected_components.
+ *
+ * The binarization is not stored: the foreground, pixels in the range
+ * [lower_threshold, upper_threshold], is labeled on the fly in z slabs
+ * in parallel, using runs of pixels along x (@sa label_run_length_components).
+ * Apart from the output image, memory is proportional to the number of
+ * runs, instead of the full intermediate images of the ITK pipeline.
+ *
+ * The output is the same than:
+ * ```
+ * connected_components(binarize_with_threshold(input, lower, upper))
+ * ```
+ * Labels are sorted by size (label 1 is the largest object). Only 255
+ * labels fit in the output image, so it throws if there are more objects,
+ * unless only_largest_component is true.
+ *
+ * Instantiated for BinaryImageType and FloatImageType.
+ *
+ * @tparam AnyImageType any itk::Image
+ * @param any_input_image input image
+ * @param lower_threshold pixels with value lower than this won't be ON.
+ * @param upper_threshold pixels with value greater than this won't be ON.
+ * @param fully_connected false: face connectivity, true: connect also
+ * pixels by edges and corners. Defaults to false, like
+ * itk::ConnectedComponentImageFilter.
+ * @param only_largest_component if true, label_image is a binary image
+ * (with value 255) with only the largest object.
+ * number_of_labels and size_of_labels still describe all the objects.
+ * @param num_threads number of threads, 0 uses the default of ITK.
+ *
+ * @return ConnectedComponentsOutput
+ */
+template <typename AnyImageType>
+ConnectedComponentsOutput connected_components_with_threshold(
+        const AnyImageType *any_input_image,
+        const typename AnyImageType::PixelType &lower_threshold,
+        const typename AnyImageType::PixelType &upper_threshold,
+        const bool fully_connected = false,
+        const bool only_largest_component = false,
+        const size_t num_threads = 0);
+
+/**
+ * Fused binarize_with_percentage and connected_components.
+ *
+ * The min and max values of the image are computed in one parallel pass,
+ * then the pixels greater or equal than
+ *  lower_threshold = min_value + (max_value - min_value) * (1 - percentage)
+ * are labeled as in @see connected_components_with_threshold.
+ *
+ * Instantiated for BinaryImageType and FloatImageType.
+ *
+ * @tparam AnyImageType any itk::Image
+ * @param any_input_image input image
+ * @param percentage percentage of pixels (with highest value) that will be ON
+ * @param fully_connected false: face connectivity, true: full connectivity.
+ * @param only_largest_component if true, label_image is a binary image
+ * with only the largest object.
+ * @param num_threads number of threads, 0 uses the default of ITK.
+ *
+ * @return ConnectedComponentsOutput
+ */
+template <typename AnyImageType>
+ConnectedComponentsOutput connected_components_with_percentage(
+        const AnyImageType *any_input_image,
+        const double percentage = 0.05,
+        const bool fully_connected = false,
+        const bool only_largest_component = false,
+        const size_t num_threads = 0);
+
+/**
+ * Same than @ref connected_components_with_threshold, but reading the input
+ * image from a file in slabs of planes_per_slab z planes, with
+ * itk::ImageFileReader and a requested region per slab. The input image is
+ * never fully in memory: only one slab, the runs of the foreground, and
+ * the output label image.
+ *
+ * The file format has to support streamed reading (MetaImage .mha/.mhd,
+ * VTK, ...). Otherwise the reader loads the whole image, and the result is
+ * the same but without the memory savings.
+ *
+ * Instantiated for BinaryImageType and FloatImageType.
+ *
+ * @param input_filename file with the input image
+ * @param planes_per_slab number of z planes read at a time
+ *
+ * For the rest of parameters @sa connected_components_with_threshold
+ */
+template <typename AnyImageType>
+ConnectedComponentsOutput connected_components_with_threshold_from_file(
+        const std::string &input_filename,
+        const typename AnyImageType::PixelType &lower_threshold,
+        const typename AnyImageType::PixelType &upper_threshold,
+        const bool fully_connected = false,
+        const bool only_largest_component = false,
+        const size_t num_threads = 0,
+        const size_t planes_per_slab = 64);
+
+/**
+ * Same than @ref connected_components_with_percentage, but reading the input
+ * image from a file in slabs, as
+ * @ref connected_components_with_threshold_from_file.
+ * The slabs are read twice, first for the min and max values of the image,
+ * and then to label the pixels.
+ */
+template <typename AnyImageType>
+ConnectedComponentsOutput connected_components_with_percentage_from_file(
+        const std::string &input_filename,
+        const double percentage = 0.05,
+        const bool fully_connected = false,
+        const bool only_largest_component = false,
+        const size_t num_threads = 0,
+        const size_t planes_per_slab = 64);
+
 BinaryImageType::
         Pointer
         /**
@@ -305,6 +421,13 @@ struct binarize_with_level_set_parameters {
     unsigned int level_set_iterations = 20;
     FloatImageType::PixelType binary_upper_threshold = 1.41;
     BinaryImageType::PixelType binary_inside_value = 255;
+    /** Evolve the level set only in a narrow band around the surface of the
+     * initial binary image, in float precision.
+     * @see binarize_with_level_set_narrow_band */
+    bool use_narrow_band = false;
+    /** Width (in pixels) of the narrow band at each side of the initial
+     * surface. If 0, level_set_iterations + 3 is used. */
+    unsigned int narrow_band_width = 0;
 };
 void print_binarize_with_level_set_parameters(
         const binarize_with_level_set_parameters &parameters, std::ostream &os);
@@ -332,6 +455,8 @@ struct binarize_with_level_set_output {
  * to improve the input initial binarization using level sets.
  * The initial binarization should not contain false positives.
  * Use @see binarize_with_threshold_percentage with a low percentage for this.
+ * If parameters.use_narrow_band is true, it runs
+ * @see binarize_with_level_set_narrow_band instead.
  * Pipeline:
  *  gradient (from float_image). Parameters: gradient_sigma
  *  sigmoid (from gradient). Parameters: sigmoid_alpha
@@ -344,6 +469,8 @@ struct binarize_with_level_set_output {
  * @param input_parameters parameters for all the filters of the pipeline
  * @param save_intermediate_results if true, the output will store
  * images from the intermediate filters.
+ * @param num_threads number of threads, only used when
+ * parameters.use_narrow_band is true. 0 uses the default of ITK.
  *
  * @return struct storing the resulting binarization, input parameters
  * and optionally, images from intermediate filters of the pipeline.
@@ -353,7 +480,48 @@ binarize_with_level_set_output binarize_with_level_set(
         const BinaryImageType *binary_image_safe,
         const binarize_with_level_set_parameters &input_parameters =
                 binarize_with_level_set_parameters(),
-        const bool save_intermediate_results = false);
+        const bool save_intermediate_results = false,
+        const size_t num_threads = 0);
+
+/**
+ * Narrow band version of @see binarize_with_level_set, used when
+ * parameters.use_narrow_band is true.
+ *
+ * The dense pipeline allocates full images in double precision for the
+ * sigmoid, the signed distance and the level set, besides the gradient.
+ * Here, the image is split in blocks of 8x8x8 pixels, and only the blocks
+ * closer than parameters.narrow_band_width to the surface of
+ * binary_image_safe are stored, in float precision.
+ * The gradient magnitude (gaussian), the sigmoid and the initial signed
+ * distance are only computed in those blocks, reading from input_float_image
+ * only the neighborhood of each block.
+ * The level set evolves with the terms of the geodesic active contour:
+ *  phi_t = -propagation g |grad(phi)| + curvature g k |grad(phi)|
+ *          + advection grad(g) . grad(phi)
+ * where g is the sigmoid. The front moves less than a pixel per iteration,
+ * so it does not reach the boundary of the band with the default
+ * narrow_band_width.
+ *
+ * The intermediate images are only allocated if save_intermediate_results is
+ * true. The gradient and sigmoid images are zero outside the band.
+ *
+ * @param input_float_image input image to binarize
+ * @param binary_image_safe safe binarization, same size than input_float_image
+ * @param input_parameters parameters for the pipeline
+ * @param save_intermediate_results if true, the output will store
+ * images from the intermediate steps.
+ * @param num_threads number of threads, 0 uses the default of ITK.
+ *
+ * @return struct storing the resulting binarization, the parameters used,
+ * and optionally, images from intermediate steps.
+ */
+binarize_with_level_set_output binarize_with_level_set_narrow_band(
+        const FloatImageType *input_float_image,
+        const BinaryImageType *binary_image_safe,
+        const binarize_with_level_set_parameters &input_parameters =
+                binarize_with_level_set_parameters(),
+        const bool save_intermediate_results = false,
+        const size_t num_threads = 0);
 
 // Explicitly instantiated in segmentation_functions.cpp
 extern template std::pair<BinaryImageType::PixelType,
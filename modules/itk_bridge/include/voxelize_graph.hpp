@@ -21,11 +21,14 @@
 #ifndef SG_VOXELIZE_GRAPH_HPP
 #define SG_VOXELIZE_GRAPH_HPP
 
+#include "create_vertex_to_radius_map.hpp" // for VertexToRadiusMap
 #include "image_types.hpp"
 #include "spatial_graph.hpp"
 #include "spatial_graph_io.hpp" // for vertex_to_label_map_t
 #include <functional>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace SG {
 
@@ -129,5 +132,88 @@ voxelize_graph(const GraphType &graph,
                const vertex_to_label_map_t &vertex_to_label_map,
                const edge_to_label_map_t &edge_to_label_map,
                const bool &graph_positions_are_in_physical_space = true);
+
+/**
+ * Rasterize the input graph into a label image, processing the edges in
+ * parallel.
+ *
+ * Similar to @ref voxelize_graph, but:
+ * - If draw_segments is true, the voxels of the 3D line segments between
+ *   consecutive points of an edge (source node, edge points, target node)
+ *   are also labeled, not only the voxels at the points positions.
+ * - If vertex_to_radius_map is not empty, the nodes are voxelized as balls
+ *   and the edges as tubes, with a radius linearly interpolated from source
+ *   to target along the edge. Radius are in voxel (index) units, as the ones
+ *   obtained from the default distance map, @sa create_vertex_to_radius_map
+ * - The physical point to index transform is computed once, not per point.
+ * - When different labels write the same voxel, the greatest label wins.
+ *   The output does not depend on the number of threads.
+ *
+ * Voxels falling outside the reference_image are ignored.
+ * Labels that do not fit in BinaryImagePixelType (greater than 255) throw a
+ * std::runtime_error instead of being truncated.
+ *
+ * @param graph input spatial graph
+ * @param reference_image ITK binary image
+ * @param vertex_to_label_map vertex_descriptor -> size_t
+ * @param edge_to_label_map edge_descriptor -> size_t
+ * @param graph_positions_are_in_physical_space
+ * @param draw_segments label the line segments between consecutive points
+ * @param vertex_to_radius_map vertex_descriptor -> radius (in voxels)
+ * @param num_threads number of threads, 0 uses the default of ITK.
+ *
+ * @return label image
+ */
+BinaryImageType::Pointer voxelize_graph_rasterized(
+        const GraphType &graph,
+        const BinaryImageType::Pointer &reference_image,
+        const vertex_to_label_map_t &vertex_to_label_map,
+        const edge_to_label_map_t &edge_to_label_map,
+        const bool &graph_positions_are_in_physical_space = true,
+        const bool &draw_segments = true,
+        const VertexToRadiusMap &vertex_to_radius_map = VertexToRadiusMap(),
+        const size_t &num_threads = 0);
+
+namespace detail {
+/**
+ * Voxels (in index space) of the 3D digital line between start and end, both
+ * included. Uses a 3D Bresenham algorithm, consecutive voxels are
+ * 26-connected.
+ */
+std::vector<BinaryImageType::IndexType>
+rasterize_segment(const BinaryImageType::IndexType &start,
+                  const BinaryImageType::IndexType &end);
+
+/**
+ * Write the labels of @ref voxelize_graph_rasterized into output_image.
+ *
+ * The nodes and edges are turned into primitives (voxels, segments and
+ * tubes) in parallel, and then each z slab of output_image is written by one
+ * work unit, the greatest label wins. No voxel list is stored, memory is
+ * proportional to the number of primitives, not to their volume.
+ *
+ * Throws std::runtime_error if a label does not fit in BinaryImagePixelType.
+ *
+ * @param output_image image to write, it also provides the index to physical
+ * space transform. Existing labels are kept if they are greater.
+ * @param any_label_is_zero output, true if any label used is zero.
+ * @param mask if not null, buffer with the region of output_image, only the
+ * voxels with non-zero mask are written.
+ * @param first_labeled_offsets if not null, the buffer offsets of the voxels
+ * that were zero and got a non-zero label are appended, without repetitions.
+ */
+void rasterize_graph_labels(const GraphType &graph,
+                            const BinaryImageType::Pointer &output_image,
+                            const vertex_to_label_map_t &vertex_to_label_map,
+                            const edge_to_label_map_t &edge_to_label_map,
+                            const bool &graph_positions_are_in_physical_space,
+                            const bool &draw_segments,
+                            const VertexToRadiusMap &vertex_to_radius_map,
+                            const size_t &num_threads,
+                            bool &any_label_is_zero,
+                            const BinaryImagePixelType *mask = nullptr,
+                            std::vector<size_t> *first_labeled_offsets =
+                                    nullptr);
+} // end namespace detail
 } // end namespace SG
 #endif
@@ -0,0 +1,280 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+#include "distance_sampler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace SG {
+
+namespace {
+using WordType = DistanceSampler::WordType;
+
+inline unsigned int count_trailing_zeros(WordType word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned int>(__builtin_ctzll(word));
+#else
+    unsigned int n = 0;
+    while ((word & WordType(1)) == 0) {
+        word >>= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+/** Position of the most significant bit set. */
+inline unsigned int highest_bit(WordType word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63u - static_cast<unsigned int>(__builtin_clzll(word));
+#else
+    unsigned int n = 0;
+    while (word >>= 1) {
+        ++n;
+    }
+    return n;
+#endif
+}
+} // namespace
+
+DistanceSampler::DistanceSampler(const BinaryImageType::Pointer &binary_image,
+                                 const bool use_image_spacing,
+                                 const size_t max_search_radius)
+        : m_use_image_spacing(use_image_spacing) {
+    const auto &region = binary_image->GetBufferedRegion();
+    const auto &region_size = region.GetSize();
+    const auto &region_index = region.GetIndex();
+    long max_size = 0;
+    for (size_t i = 0; i < ImageDimension; ++i) {
+        m_start[i] = region_index[i];
+        m_size[i] = static_cast<long>(region_size[i]);
+        max_size = std::max(max_size, m_size[i]);
+    }
+
+    m_reference_image = BinaryImageType::New();
+    m_reference_image->CopyInformation(binary_image);
+    m_reference_image->SetRegions(region);
+
+    const auto &spacing = binary_image->GetSpacing();
+    m_min_weight = std::numeric_limits<double>::max();
+    for (size_t i = 0; i < ImageDimension; ++i) {
+        m_weights[i] = use_image_spacing ? spacing[i] * spacing[i] : 1.0;
+        m_min_weight = std::min(m_min_weight, m_weights[i]);
+    }
+    m_max_search_radius = max_search_radius == 0
+                                  ? max_size
+                                  : static_cast<long>(max_search_radius);
+
+    // Pack the image, one bit per voxel. Rows (x) are padded to full words.
+    m_words_per_row = (m_size[0] + word_bits - 1) / word_bits;
+    m_bits.assign(m_words_per_row * m_size[1] * m_size[2], 0);
+    const BinaryImagePixelType *buffer = binary_image->GetBufferPointer();
+    for (long z = 0; z < m_size[2]; ++z) {
+        for (long y = 0; y < m_size[1]; ++y) {
+            WordType *row =
+                    m_bits.data() + (z * m_size[1] + y) * m_words_per_row;
+            const BinaryImagePixelType *row_buffer =
+                    buffer + (z * m_size[1] + y) * m_size[0];
+            for (long x = 0; x < m_size[0]; ++x) {
+                if (row_buffer[x] > 0) {
+                    row[x / word_bits] |= WordType(1) << (x % word_bits);
+                }
+            }
+        }
+    }
+}
+
+size_t DistanceSampler::linear_index(const long x,
+                                     const long y,
+                                     const long z) const {
+    return static_cast<size_t>((z * m_size[1] + y) * m_size[0] + x);
+}
+
+bool DistanceSampler::bit_at(const long x, const long y, const long z) const {
+    const WordType &word =
+            m_bits[(z * m_size[1] + y) * m_words_per_row + x / word_bits];
+    return (word >> (x % word_bits)) & WordType(1);
+}
+
+bool DistanceSampler::is_inside(const IndexType &index) const {
+    for (size_t i = 0; i < ImageDimension; ++i) {
+        const long local = index[i] - m_start[i];
+        if (local < 0 || local >= m_size[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DistanceSampler::is_foreground(const IndexType &index) const {
+    if (!is_inside(index)) {
+        return false;
+    }
+    return bit_at(index[0] - m_start[0], index[1] - m_start[1],
+                  index[2] - m_start[2]);
+}
+
+long DistanceSampler::nearest_background_in_row(const long cx,
+                                                const long y,
+                                                const long z,
+                                                const long radius) const {
+    const long lo = std::max(cx - radius, 0L);
+    const long hi = std::min(cx + radius, m_size[0] - 1);
+    const WordType *row =
+            m_bits.data() + (z * m_size[1] + y) * m_words_per_row;
+    long best = -1;
+    // Right side: [cx, hi]. Background bits are zeros, scan the inverted word.
+    for (long x = std::max(cx, lo); x <= hi;) {
+        const long bit = x % word_bits;
+        const long span = std::min<long>(word_bits - bit, hi - x + 1);
+        WordType inv = ~row[x / word_bits] >> bit;
+        if (span < static_cast<long>(word_bits)) {
+            inv &= (WordType(1) << span) - 1;
+        }
+        if (inv) {
+            best = x + count_trailing_zeros(inv) - cx;
+            break;
+        }
+        x += span;
+    }
+    // Left side: [lo, cx - 1], only if it can improve the right side.
+    const long left_limit = best < 0 ? lo : std::max(lo, cx - best + 1);
+    for (long x = std::min(cx - 1, hi); x >= left_limit;) {
+        const long bit = x % word_bits;
+        const long word_start = x - bit;
+        const long lo_bit = std::max(left_limit - word_start, 0L);
+        WordType mask = bit == static_cast<long>(word_bits) - 1
+                                ? ~WordType(0)
+                                : (WordType(1) << (bit + 1)) - 1;
+        mask &= ~((WordType(1) << lo_bit) - 1);
+        const WordType inv = ~row[x / word_bits] & mask;
+        if (inv) {
+            const long dx = cx - (word_start + highest_bit(inv));
+            best = best < 0 ? dx : std::min(best, dx);
+            break;
+        }
+        x = word_start - 1;
+    }
+    return best;
+}
+
+double DistanceSampler::compute_squared_distance(const long cx,
+                                                 const long cy,
+                                                 const long cz) const {
+    if (!bit_at(cx, cy, cz)) {
+        return 0.0;
+    }
+    double best = std::numeric_limits<double>::max();
+    for (long r = 1; r <= m_max_search_radius; ++r) {
+        // All the voxels not visited yet are at least at distance r.
+        if (best <= static_cast<double>(r * r) * m_min_weight) {
+            break;
+        }
+        for (long dz = -r; dz <= r; ++dz) {
+            const long z = cz + dz;
+            if (z < 0 || z >= m_size[2]) {
+                continue;
+            }
+            for (long dy = -r; dy <= r; ++dy) {
+                const long y = cy + dy;
+                if (y < 0 || y >= m_size[1]) {
+                    continue;
+                }
+                const double base =
+                        static_cast<double>(dy * dy) * m_weights[1] +
+                        static_cast<double>(dz * dz) * m_weights[2];
+                if (base >= best) {
+                    continue;
+                }
+                const bool is_shell_face =
+                        std::abs(dy) == r || std::abs(dz) == r;
+                if (is_shell_face) {
+                    // The whole row [cx - r, cx + r] belongs to the shell.
+                    const long dx = nearest_background_in_row(cx, y, z, r);
+                    if (dx >= 0) {
+                        const double candidate =
+                                base + static_cast<double>(dx * dx) *
+                                               m_weights[0];
+                        best = std::min(best, candidate);
+                    }
+                } else {
+                    // Only the two ends of the row belong to the shell.
+                    const double candidate =
+                            base + static_cast<double>(r * r) * m_weights[0];
+                    if ((cx - r >= 0 && !bit_at(cx - r, y, z)) ||
+                        (cx + r < m_size[0] && !bit_at(cx + r, y, z))) {
+                        best = std::min(best, candidate);
+                    }
+                }
+            }
+        }
+    }
+    if (best == std::numeric_limits<double>::max()) {
+        return static_cast<double>(m_max_search_radius * m_max_search_radius) *
+               m_min_weight;
+    }
+    return best;
+}
+
+DistanceSampler::PixelType
+DistanceSampler::GetPixel(const IndexType &index) const {
+    if (!is_inside(index)) {
+        return 0;
+    }
+    const long x = index[0] - m_start[0];
+    const long y = index[1] - m_start[1];
+    const long z = index[2] - m_start[2];
+    const size_t key = linear_index(x, y, z);
+    {
+        std::lock_guard<std::mutex> lock(m_cache_mutex);
+        const auto found = m_cache.find(key);
+        if (found != m_cache.end()) {
+            return found->second;
+        }
+    }
+    const auto distance = static_cast<PixelType>(
+            std::sqrt(compute_squared_distance(x, y, z)));
+    std::lock_guard<std::mutex> lock(m_cache_mutex);
+    m_cache.emplace(key, distance);
+    return distance;
+}
+
+DistanceSampler::PixelType
+DistanceSampler::GetPixelAtPhysicalPoint(const PointType &point) const {
+    IndexType index;
+    if (!TransformPhysicalPointToIndex(point, index)) {
+        return 0;
+    }
+    return GetPixel(index);
+}
+
+size_t DistanceSampler::cache_size() const {
+    std::lock_guard<std::mutex> lock(m_cache_mutex);
+    return m_cache.size();
+}
+
+void DistanceSampler::clear_cache() const {
+    std::lock_guard<std::mutex> lock(m_cache_mutex);
+    m_cache.clear();
+}
+
+} // end namespace SG
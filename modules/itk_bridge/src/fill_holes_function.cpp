@@ -19,9 +19,16 @@
  * *******************************************************************/
 
 #include "fill_holes_function.hpp"
+#include "run_length_components.hpp"
 // Module ITKLabelVoting
 #include <itkVotingBinaryIterativeHoleFillingImageFilter.h>
 #include <itkStatisticsImageFilter.h>
+#include <itkMultiThreaderBase.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <vector>
 
 namespace SG {
 BinaryImageType::Pointer fill_holes_voting_iterative_function(
@@ -61,4 +68,261 @@ BinaryImageType::Pointer fill_holes_voting_iterative_function(
 
   return filler->GetOutput();
 }
+
+namespace {
+/** Output image with the same metadata and content than the input. */
+BinaryImageType::Pointer copy_binary_image(
+    const BinaryImageType::Pointer & input)
+{
+  auto output = BinaryImageType::New();
+  output->CopyInformation(input);
+  output->SetRegions(input->GetBufferedRegion());
+  output->Allocate();
+  const auto num_pixels = input->GetBufferedRegion().GetNumberOfPixels();
+  std::copy(input->GetBufferPointer(),
+            input->GetBufferPointer() + num_pixels,
+            output->GetBufferPointer());
+  return output;
+}
+
+itk::MultiThreaderBase::Pointer create_threader(const size_t & num_threads)
+{
+  auto threader = itk::MultiThreaderBase::New();
+  if(num_threads > 0) {
+    threader->SetMaximumNumberOfThreads(num_threads);
+    threader->SetNumberOfWorkUnits(num_threads);
+  }
+  return threader;
+}
+} // namespace
+
+BinaryImageType::Pointer fill_holes_voting_front_function(
+        const BinaryImageType::Pointer & input,
+        const int & radius,
+        const int & majority,
+        const size_t & iterations,
+        const size_t & num_threads,
+        bool verbose
+        )
+{
+  auto output = copy_binary_image(input);
+  const auto & size = output->GetBufferedRegion().GetSize();
+  const long nx = size[0];
+  const long ny = size[1];
+  const long nz = size[2];
+  const size_t num_pixels = output->GetBufferedRegion().GetNumberOfPixels();
+  BinaryImagePixelType * buffer = output->GetBufferPointer();
+  if(num_pixels == 0) {
+    return output;
+  }
+  const BinaryImagePixelType background = 0;
+  const BinaryImagePixelType foreground =
+      *std::max_element(buffer, buffer + num_pixels);
+  if(foreground == background) {
+    return output;
+  }
+  const long r = radius;
+  const long neighborhood_size = (2 * r + 1) * (2 * r + 1) * (2 * r + 1);
+  const long birth_threshold = (neighborhood_size - 1) / 2 + majority;
+  if(verbose) {
+    std::cout << "Majority: " << majority << std::endl;
+    std::cout << "Iterations: " << iterations << std::endl;
+    std::cout << "Radius: (" << radius << ", " << radius << ", " << radius
+              << ")" << std::endl;
+  }
+
+  // Count foreground voxels in the neighborhood, out of bounds voxels
+  // take the value of the closest voxel (as the default boundary condition
+  // of the ITK filter).
+  const auto clamp = [](const long v, const long n) {
+    return v < 0 ? 0 : (v >= n ? n - 1 : v);
+  };
+  const auto turns_on = [&](const long x, const long y, const long z) {
+    long count = 0;
+    for(long dz = -r; dz <= r; ++dz) {
+      const long zz = clamp(z + dz, nz);
+      for(long dy = -r; dy <= r; ++dy) {
+        const BinaryImagePixelType * row =
+            buffer + (zz * ny + clamp(y + dy, ny)) * nx;
+        for(long dx = -r; dx <= r; ++dx) {
+          count += row[clamp(x + dx, nx)] == foreground;
+        }
+      }
+    }
+    return count >= birth_threshold;
+  };
+
+  auto threader = create_threader(num_threads);
+  const size_t num_chunks = 4 * threader->GetNumberOfWorkUnits();
+  std::vector<std::vector<size_t>> chunk_changed(num_chunks);
+  std::vector<size_t> changed;
+  std::vector<size_t> front;
+  std::vector<unsigned char> in_front(num_pixels, 0);
+  size_t total_changed = 0;
+  for(size_t iteration = 0; iteration < iterations; ++iteration) {
+    // Evaluate: the first iteration visits all the image, the rest only
+    // the front. The image is not modified during the evaluation.
+    const size_t num_items =
+        iteration == 0 ? static_cast<size_t>(nz) : front.size();
+    const size_t chunk_size = (num_items + num_chunks - 1) / num_chunks;
+    threader->ParallelizeArray(
+        0, num_chunks,
+        [&](itk::SizeValueType chunk) {
+          auto & chunk_output = chunk_changed[chunk];
+          chunk_output.clear();
+          const size_t begin = chunk * chunk_size;
+          const size_t end = std::min(begin + chunk_size, num_items);
+          for(size_t item = begin; item < end; ++item) {
+            if(iteration == 0) {
+              const long z = item;
+              for(long y = 0; y < ny; ++y) {
+                for(long x = 0; x < nx; ++x) {
+                  const size_t offset = (z * ny + y) * nx + x;
+                  if(buffer[offset] == background && turns_on(x, y, z)) {
+                    chunk_output.push_back(offset);
+                  }
+                }
+              }
+            } else {
+              const size_t offset = front[item];
+              const long x = offset % nx;
+              const long y = (offset / nx) % ny;
+              const long z = offset / (nx * ny);
+              if(turns_on(x, y, z)) {
+                chunk_output.push_back(offset);
+              }
+            }
+          }
+        },
+        nullptr);
+    changed.clear();
+    for(const auto & chunk_output : chunk_changed) {
+      changed.insert(changed.end(), chunk_output.begin(), chunk_output.end());
+    }
+    if(verbose) {
+      std::cout << "Iteration " << iteration << ": "
+                << changed.size() << " pixels changed." << std::endl;
+    }
+    if(changed.empty()) {
+      break;
+    }
+    total_changed += changed.size();
+    for(const auto & offset : changed) {
+      buffer[offset] = foreground;
+    }
+    // New front: background voxels with a changed voxel in the neighborhood
+    front.clear();
+    for(const auto & offset : changed) {
+      const long x = offset % nx;
+      const long y = (offset / nx) % ny;
+      const long z = offset / (nx * ny);
+      for(long zz = std::max(z - r, 0L); zz <= std::min(z + r, nz - 1); ++zz) {
+        for(long yy = std::max(y - r, 0L); yy <= std::min(y + r, ny - 1);
+            ++yy) {
+          for(long xx = std::max(x - r, 0L); xx <= std::min(x + r, nx - 1);
+              ++xx) {
+            const size_t neighbor = (zz * ny + yy) * nx + xx;
+            if(buffer[neighbor] == background && !in_front[neighbor]) {
+              in_front[neighbor] = 1;
+              front.push_back(neighbor);
+            }
+          }
+        }
+      }
+    }
+    for(const auto & offset : front) {
+      in_front[offset] = 0;
+    }
+  }
+  if(verbose) {
+    std::cout << "Total pixels changed: " << total_changed << std::endl;
+  }
+  return output;
+}
+
+BinaryImageType::Pointer fill_holes_cavities_function(
+        const BinaryImageType::Pointer & input,
+        bool fully_connected,
+        const size_t & num_threads,
+        bool verbose
+        )
+{
+  auto output = copy_binary_image(input);
+  const auto & size = output->GetBufferedRegion().GetSize();
+  const size_t nx = size[0];
+  const size_t ny = size[1];
+  const size_t nz = size[2];
+  BinaryImagePixelType * buffer = output->GetBufferPointer();
+  if(output->GetBufferedRegion().GetNumberOfPixels() == 0) {
+    return output;
+  }
+
+  auto threader = create_threader(num_threads);
+  // Max intensity, it will be used as foreground.
+  std::vector<BinaryImagePixelType> slab_max(nz, 0);
+  threader->ParallelizeArray(
+      0, nz,
+      [&](itk::SizeValueType z) {
+        const BinaryImagePixelType * pixels = buffer + z * nx * ny;
+        slab_max[z] = *std::max_element(pixels, pixels + nx * ny);
+      },
+      nullptr);
+  const BinaryImagePixelType foreground =
+      *std::max_element(slab_max.begin(), slab_max.end());
+  if(foreground == 0) {
+    // All is background, there are no cavities.
+    return output;
+  }
+
+  // Connected components of the background
+  const auto background = label_run_length_components(
+      nx, ny, nz,
+      [buffer](const size_t offset) { return buffer[offset] == 0; },
+      fully_connected, threader.GetPointer());
+  const auto & row_offsets = background.row_offsets;
+  const auto & runs = background.runs;
+  const auto & parent = background.component;
+  const size_t num_runs = background.number_of_runs();
+
+  // Components touching the border of the image are not cavities.
+  std::vector<unsigned char> touches_border(num_runs, 0);
+  for(size_t z = 0; z < nz; ++z) {
+    for(size_t y = 0; y < ny; ++y) {
+      const size_t row = y + ny * z;
+      const bool border_row = z == 0 || z + 1 == nz || y == 0 || y + 1 == ny;
+      for(size_t i = row_offsets[row]; i < row_offsets[row + 1]; ++i) {
+        if(border_row || runs[i].begin == 0 || runs[i].end == nx) {
+          touches_border[parent[i]] = 1;
+        }
+      }
+    }
+  }
+
+  std::vector<size_t> slab_filled(nz, 0);
+  threader->ParallelizeArray(
+      0, nz,
+      [&](itk::SizeValueType slab) {
+        // A slab is a z plane.
+        for(size_t row = slab * ny; row < (slab + 1) * ny; ++row) {
+          BinaryImagePixelType * pixels = buffer + row * nx;
+          for(size_t i = row_offsets[row]; i < row_offsets[row + 1]; ++i) {
+            if(!touches_border[parent[i]]) {
+              std::fill(pixels + runs[i].begin, pixels + runs[i].end,
+                        foreground);
+              slab_filled[slab] += runs[i].end - runs[i].begin;
+            }
+          }
+        }
+      },
+      nullptr);
+  if(verbose) {
+    size_t filled = 0;
+    for(const auto & slab_count : slab_filled) {
+      filled += slab_count;
+    }
+    std::cout << "Background runs: " << num_runs << std::endl;
+    std::cout << "Total pixels filled: " << filled << std::endl;
+  }
+  return output;
+}
 } // end ns SG
@@ -0,0 +1,1005 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+#include "segmentation_functions.hpp"
+
+#include <itkMultiThreaderBase.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace SG {
+
+namespace {
+constexpr long block_bits = 3;
+constexpr long block_side = 1L << block_bits; // 8
+constexpr long block_mask = block_side - 1;
+constexpr size_t block_voxels = block_side * block_side * block_side;
+constexpr size_t histogram_bins = 128;
+
+/**
+ * Storage of the narrow band.
+ *
+ * The image is split in blocks of block_side^3 voxels, and only the blocks
+ * close to the surface of the initial binary image are allocated (active).
+ * Values of the active blocks are stored contiguously, block after block.
+ * Voxels outside the band have a constant level set value: -far_value
+ * inside the initial binary image, +far_value outside.
+ */
+struct NarrowBand {
+    std::array<long, 3> size;
+    std::array<long, 3> blocks;
+    std::array<double, 3> spacing;
+    /** -1 for inactive blocks, position in active_blocks otherwise. */
+    std::vector<int32_t> block_table;
+    /** Linear index (in the block grid) of the active blocks. */
+    std::vector<size_t> active_blocks;
+    const BinaryImagePixelType *binary = nullptr;
+    float far_value = 0;
+
+    std::vector<float> phi;
+    std::vector<float> speed;
+    std::vector<float> speed_gradient_x;
+    std::vector<float> speed_gradient_y;
+    std::vector<float> speed_gradient_z;
+
+    size_t image_offset(const long x, const long y, const long z) const {
+        return static_cast<size_t>((z * size[1] + y) * size[0] + x);
+    }
+    size_t block_linear_index(const long bx, const long by,
+                              const long bz) const {
+        return static_cast<size_t>((bz * blocks[1] + by) * blocks[0] + bx);
+    }
+    /** Position of the voxel in the band arrays, -1 if it is not in the band.
+     */
+    long band_position(const long x, const long y, const long z) const {
+        const int32_t active = block_table[block_linear_index(
+                x >> block_bits, y >> block_bits, z >> block_bits)];
+        if (active < 0) {
+            return -1;
+        }
+        return static_cast<long>(active) * static_cast<long>(block_voxels) +
+               (((z & block_mask) << (2 * block_bits)) |
+                ((y & block_mask) << block_bits) | (x & block_mask));
+    }
+    /** Image coordinates of the voxel at local_offset of active block. */
+    std::array<long, 3> coordinates(const size_t active,
+                                    const size_t local_offset) const {
+        const size_t block = active_blocks[active];
+        const long bx = static_cast<long>(block % blocks[0]);
+        const long by = static_cast<long>((block / blocks[0]) % blocks[1]);
+        const long bz = static_cast<long>(block / (blocks[0] * blocks[1]));
+        return {(bx << block_bits) + static_cast<long>(local_offset & block_mask),
+                (by << block_bits) +
+                        static_cast<long>((local_offset >> block_bits) &
+                                          block_mask),
+                (bz << block_bits) +
+                        static_cast<long>(local_offset >> (2 * block_bits))};
+    }
+    bool is_inside_image(const std::array<long, 3> &p) const {
+        return p[0] < size[0] && p[1] < size[1] && p[2] < size[2];
+    }
+    /** Level set value, with zero-flux at the image boundaries. */
+    float phi_at(long x, long y, long z) const {
+        x = std::min(std::max(x, 0L), size[0] - 1);
+        y = std::min(std::max(y, 0L), size[1] - 1);
+        z = std::min(std::max(z, 0L), size[2] - 1);
+        const long position = band_position(x, y, z);
+        if (position >= 0) {
+            return phi[position];
+        }
+        return binary[image_offset(x, y, z)] ? -far_value : far_value;
+    }
+    float speed_at(long x, long y, long z, const float default_value) const {
+        if (x < 0 || y < 0 || z < 0 || x >= size[0] || y >= size[1] ||
+            z >= size[2]) {
+            return default_value;
+        }
+        const long position = band_position(x, y, z);
+        return position >= 0 ? speed[position] : default_value;
+    }
+};
+
+itk::MultiThreaderBase::Pointer create_threader(const size_t num_threads) {
+    auto threader = itk::MultiThreaderBase::New();
+    if (num_threads > 0) {
+        threader->SetMaximumNumberOfThreads(num_threads);
+        threader->SetNumberOfWorkUnits(num_threads);
+    }
+    return threader;
+}
+
+/**
+ * Call function(begin, end, chunk) for num_chunks contiguous ranges covering
+ * [0, num_items).
+ */
+template <typename TFunction>
+void parallel_chunks(itk::MultiThreaderBase *threader,
+                     const size_t num_items,
+                     const size_t num_chunks,
+                     TFunction &&function) {
+    const size_t chunk_size = (num_items + num_chunks - 1) / num_chunks;
+    threader->ParallelizeArray(
+            0, num_chunks,
+            [&](itk::SizeValueType chunk) {
+                const size_t begin = std::min(chunk * chunk_size, num_items);
+                const size_t end = std::min(begin + chunk_size, num_items);
+                function(begin, end, static_cast<size_t>(chunk));
+            },
+            nullptr);
+}
+
+/** True if the voxel has a face neighbor with different binary value. */
+bool is_surface(const NarrowBand &band,
+                const long x,
+                const long y,
+                const long z) {
+    const bool value = band.binary[band.image_offset(x, y, z)];
+    auto differs = [&](const long nx, const long ny, const long nz) {
+        if (nx < 0 || ny < 0 || nz < 0 || nx >= band.size[0] ||
+            ny >= band.size[1] || nz >= band.size[2]) {
+            return false;
+        }
+        return static_cast<bool>(band.binary[band.image_offset(nx, ny, nz)]) !=
+               value;
+    };
+    return differs(x - 1, y, z) || differs(x + 1, y, z) ||
+           differs(x, y - 1, z) || differs(x, y + 1, z) ||
+           differs(x, y, z - 1) || differs(x, y, z + 1);
+}
+
+/**
+ * Activate the blocks closer than band_width (in voxels) to the surface of
+ * the binary image (voxels with a face neighbor of different value).
+ */
+void activate_blocks(NarrowBand &band,
+                     const long band_width,
+                     itk::MultiThreaderBase *threader) {
+    const auto &size = band.size;
+    const auto &blocks = band.blocks;
+    const size_t num_blocks = blocks[0] * blocks[1] * blocks[2];
+    std::vector<unsigned char> has_surface(num_blocks, 0);
+    // Each work unit only writes the blocks of its own block layers (bz).
+    threader->ParallelizeArray(
+            0, blocks[2],
+            [&](itk::SizeValueType bz) {
+                const long z_end = std::min(
+                        static_cast<long>(bz + 1) * block_side, size[2]);
+                for (long z = static_cast<long>(bz) * block_side; z < z_end;
+                     ++z) {
+                    for (long y = 0; y < size[1]; ++y) {
+                        for (long x = 0; x < size[0]; ++x) {
+                            if (is_surface(band, x, y, z)) {
+                                has_surface[band.block_linear_index(
+                                        x >> block_bits, y >> block_bits,
+                                        bz)] = 1;
+                            }
+                        }
+                    }
+                }
+            },
+            nullptr);
+
+    // Dilate the blocks with surface, separable max filter in each direction.
+    const long radius = (band_width + block_side - 1) / block_side;
+    std::vector<unsigned char> dilated(num_blocks, 0);
+    const std::array<long, 3> strides = {1, blocks[0], blocks[0] * blocks[1]};
+    for (size_t axis = 0; axis < 3; ++axis) {
+        std::fill(dilated.begin(), dilated.end(), 0);
+        for (long bz = 0; bz < blocks[2]; ++bz) {
+            for (long by = 0; by < blocks[1]; ++by) {
+                for (long bx = 0; bx < blocks[0]; ++bx) {
+                    const size_t block = band.block_linear_index(bx, by, bz);
+                    if (!has_surface[block]) {
+                        continue;
+                    }
+                    const std::array<long, 3> b = {bx, by, bz};
+                    const long lo = std::max(b[axis] - radius, 0L);
+                    const long hi = std::min(b[axis] + radius, blocks[axis] - 1);
+                    for (long i = lo; i <= hi; ++i) {
+                        dilated[block + (i - b[axis]) * strides[axis]] = 1;
+                    }
+                }
+            }
+        }
+        std::swap(has_surface, dilated);
+    }
+
+    band.block_table.assign(num_blocks, -1);
+    band.active_blocks.clear();
+    for (size_t block = 0; block < num_blocks; ++block) {
+        if (has_surface[block]) {
+            band.block_table[block] =
+                    static_cast<int32_t>(band.active_blocks.size());
+            band.active_blocks.push_back(block);
+        }
+    }
+}
+
+/**
+ * Signed distance (in physical units) to the surface of the binary image,
+ * negative inside. The zero level set lies between the two sides of the
+ * surface.
+ *
+ * Each voxel propagates its nearest voxel of the other side to the neighbors
+ * of its same side (vector propagation), restricted to the band.
+ */
+void initialize_signed_distance(NarrowBand &band) {
+    const size_t num_band_voxels = band.active_blocks.size() * block_voxels;
+    const auto &spacing = band.spacing;
+    const double min_spacing =
+            std::min(spacing[0], std::min(spacing[1], spacing[2]));
+    std::vector<double> squared_distance(
+            num_band_voxels, std::numeric_limits<double>::infinity());
+    std::vector<std::array<long, 3>> nearest(num_band_voxels);
+    std::deque<std::array<long, 3>> queue;
+    const std::array<std::array<long, 3>, 6> face_neighbors = {
+            {{{-1, 0, 0}},
+             {{1, 0, 0}},
+             {{0, -1, 0}},
+             {{0, 1, 0}},
+             {{0, 0, -1}},
+             {{0, 0, 1}}}};
+    auto is_in_image = [&band](const std::array<long, 3> &p) {
+        return p[0] >= 0 && p[1] >= 0 && p[2] >= 0 && p[0] < band.size[0] &&
+               p[1] < band.size[1] && p[2] < band.size[2];
+    };
+    auto squared_norm = [&spacing](const std::array<long, 3> &a,
+                                   const std::array<long, 3> &b) {
+        double sum = 0.0;
+        for (size_t i = 0; i < 3; ++i) {
+            const double d = (a[i] - b[i]) * spacing[i];
+            sum += d * d;
+        }
+        return sum;
+    };
+
+    // Seeds: voxels of the surface, their nearest is the closest neighbor of
+    // the other side.
+    for (size_t active = 0; active < band.active_blocks.size(); ++active) {
+        for (size_t local = 0; local < block_voxels; ++local) {
+            const auto p = band.coordinates(active, local);
+            if (!band.is_inside_image(p)) {
+                continue;
+            }
+            const bool value =
+                    band.binary[band.image_offset(p[0], p[1], p[2])];
+            const size_t position = active * block_voxels + local;
+            for (const auto &offset : face_neighbors) {
+                const std::array<long, 3> n = {
+                        p[0] + offset[0], p[1] + offset[1], p[2] + offset[2]};
+                if (!is_in_image(n) ||
+                    static_cast<bool>(band.binary[band.image_offset(
+                            n[0], n[1], n[2])]) == value) {
+                    continue;
+                }
+                const double d2 = squared_norm(p, n);
+                if (d2 < squared_distance[position]) {
+                    squared_distance[position] = d2;
+                    nearest[position] = n;
+                }
+            }
+            if (squared_distance[position] <
+                std::numeric_limits<double>::infinity()) {
+                queue.push_back(p);
+            }
+        }
+    }
+
+    while (!queue.empty()) {
+        const auto p = queue.front();
+        queue.pop_front();
+        const long position = band.band_position(p[0], p[1], p[2]);
+        const bool value = band.binary[band.image_offset(p[0], p[1], p[2])];
+        const auto site = nearest[position];
+        for (const auto &offset : face_neighbors) {
+            const std::array<long, 3> n = {p[0] + offset[0], p[1] + offset[1],
+                                           p[2] + offset[2]};
+            if (!is_in_image(n)) {
+                continue;
+            }
+            const long n_position = band.band_position(n[0], n[1], n[2]);
+            if (n_position < 0 ||
+                static_cast<bool>(band.binary[band.image_offset(
+                        n[0], n[1], n[2])]) != value) {
+                continue;
+            }
+            const double d2 = squared_norm(n, site);
+            if (d2 < squared_distance[n_position]) {
+                squared_distance[n_position] = d2;
+                nearest[n_position] = site;
+                queue.push_back(n);
+            }
+        }
+    }
+
+    band.phi.assign(num_band_voxels, band.far_value);
+    for (size_t active = 0; active < band.active_blocks.size(); ++active) {
+        for (size_t local = 0; local < block_voxels; ++local) {
+            const auto p = band.coordinates(active, local);
+            if (!band.is_inside_image(p)) {
+                continue;
+            }
+            const size_t position = active * block_voxels + local;
+            const bool value =
+                    band.binary[band.image_offset(p[0], p[1], p[2])];
+            const double distance =
+                    std::isinf(squared_distance[position])
+                            ? band.far_value
+                            : std::min<double>(
+                                      std::sqrt(squared_distance[position]) -
+                                              0.5 * min_spacing,
+                                      band.far_value);
+            band.phi[position] = static_cast<float>(value ? -distance
+                                                          : distance);
+        }
+    }
+}
+
+/** Sampled gaussian (or its first derivative) kernel, in voxel units. */
+std::vector<float> gaussian_kernel(const double sigma, const bool derivative) {
+    const long radius = std::max(1L, static_cast<long>(std::ceil(3 * sigma)));
+    std::vector<double> weights(2 * radius + 1);
+    for (long i = -radius; i <= radius; ++i) {
+        weights[i + radius] = std::exp(-0.5 * i * i / (sigma * sigma));
+    }
+    // Smoothing: sum of weights is 1.
+    // Derivative: weights i * g(i), exact for a linear ramp.
+    double normalization = 0.0;
+    for (long i = -radius; i <= radius; ++i) {
+        if (derivative) {
+            weights[i + radius] *= i;
+            normalization += i * weights[i + radius];
+        } else {
+            normalization += weights[i + radius];
+        }
+    }
+    std::vector<float> kernel(weights.size());
+    for (size_t i = 0; i < weights.size(); ++i) {
+        kernel[i] = static_cast<float>(weights[i] / normalization);
+    }
+    return kernel;
+}
+
+/**
+ * Correlate a box (dims) along axis with kernel. The output box is reduced
+ * by the kernel radius at both sides of axis.
+ */
+void correlate_axis(const std::vector<float> &input,
+                    const std::array<long, 3> &dims,
+                    const size_t axis,
+                    const std::vector<float> &kernel,
+                    std::vector<float> &output,
+                    std::array<long, 3> &output_dims) {
+    const long radius = static_cast<long>(kernel.size() / 2);
+    output_dims = dims;
+    output_dims[axis] -= 2 * radius;
+    output.assign(output_dims[0] * output_dims[1] * output_dims[2], 0.0f);
+    const std::array<long, 3> strides = {1, dims[0], dims[0] * dims[1]};
+    const long stride = strides[axis];
+    size_t out = 0;
+    for (long z = 0; z < output_dims[2]; ++z) {
+        for (long y = 0; y < output_dims[1]; ++y) {
+            for (long x = 0; x < output_dims[0]; ++x, ++out) {
+                std::array<long, 3> p = {x, y, z};
+                p[axis] += radius;
+                const long center = p[0] + p[1] * strides[1] + p[2] * strides[2];
+                float sum = 0.0f;
+                for (long k = -radius; k <= radius; ++k) {
+                    sum += kernel[k + radius] * input[center + k * stride];
+                }
+                output[out] = sum;
+            }
+        }
+    }
+}
+
+/**
+ * Gradient magnitude (physical units) of the gaussian smoothed input, for all
+ * the voxels of the active blocks. Only a box around each block is read.
+ */
+void compute_gradient_magnitude(const FloatImageType *input,
+                                const double sigma,
+                                NarrowBand &band,
+                                std::vector<float> &gradient_magnitude,
+                                itk::MultiThreaderBase *threader) {
+    std::array<std::vector<float>, 3> smooth_kernels;
+    std::array<std::vector<float>, 3> derivative_kernels;
+    std::array<long, 3> radius;
+    for (size_t axis = 0; axis < 3; ++axis) {
+        const double sigma_voxels = sigma / band.spacing[axis];
+        smooth_kernels[axis] = gaussian_kernel(sigma_voxels, false);
+        derivative_kernels[axis] = gaussian_kernel(sigma_voxels, true);
+        for (auto &w : derivative_kernels[axis]) {
+            w /= static_cast<float>(band.spacing[axis]);
+        }
+        radius[axis] = static_cast<long>(smooth_kernels[axis].size() / 2);
+    }
+    const FloatImagePixelType *buffer = input->GetBufferPointer();
+    const auto &size = band.size;
+    gradient_magnitude.assign(band.active_blocks.size() * block_voxels, 0.0f);
+    const size_t num_chunks = 4 * threader->GetNumberOfWorkUnits();
+    parallel_chunks(
+            threader, band.active_blocks.size(), num_chunks,
+            [&](const size_t begin, const size_t end, const size_t) {
+                std::vector<float> box, a, b, c, e, gx, gy, gz;
+                std::array<long, 3> dims_a, dims_b, dims_c, dims_e, dims_out;
+                for (size_t active = begin; active < end; ++active) {
+                    const auto origin = band.coordinates(active, 0);
+                    const std::array<long, 3> box_dims = {
+                            block_side + 2 * radius[0],
+                            block_side + 2 * radius[1],
+                            block_side + 2 * radius[2]};
+                    box.resize(box_dims[0] * box_dims[1] * box_dims[2]);
+                    size_t i = 0;
+                    for (long z = 0; z < box_dims[2]; ++z) {
+                        const long iz = std::min(
+                                std::max(origin[2] + z - radius[2], 0L),
+                                size[2] - 1);
+                        for (long y = 0; y < box_dims[1]; ++y) {
+                            const long iy = std::min(
+                                    std::max(origin[1] + y - radius[1], 0L),
+                                    size[1] - 1);
+                            for (long x = 0; x < box_dims[0]; ++x, ++i) {
+                                const long ix = std::min(
+                                        std::max(origin[0] + x - radius[0],
+                                                 0L),
+                                        size[0] - 1);
+                                box[i] = buffer[band.image_offset(ix, iy, iz)];
+                            }
+                        }
+                    }
+                    // x component: deriv_x, smooth_y, smooth_z
+                    correlate_axis(box, box_dims, 0, derivative_kernels[0], a,
+                                   dims_a);
+                    correlate_axis(a, dims_a, 1, smooth_kernels[1], c, dims_c);
+                    correlate_axis(c, dims_c, 2, smooth_kernels[2], gx,
+                                   dims_out);
+                    // y and z components share smooth_x
+                    correlate_axis(box, box_dims, 0, smooth_kernels[0], b,
+                                   dims_b);
+                    correlate_axis(b, dims_b, 1, derivative_kernels[1], e,
+                                   dims_e);
+                    correlate_axis(e, dims_e, 2, smooth_kernels[2], gy,
+                                   dims_out);
+                    correlate_axis(b, dims_b, 1, smooth_kernels[1], c, dims_c);
+                    correlate_axis(c, dims_c, 2, derivative_kernels[2], gz,
+                                   dims_out);
+                    float *output =
+                            gradient_magnitude.data() + active * block_voxels;
+                    for (size_t local = 0; local < block_voxels; ++local) {
+                        output[local] = std::sqrt(gx[local] * gx[local] +
+                                                  gy[local] * gy[local] +
+                                                  gz[local] * gz[local]);
+                    }
+                }
+            });
+}
+
+/**
+ * Two thresholds multi-level Otsu of the values.
+ * Returns the lowest threshold, equivalent to
+ * OtsuMultipleThresholdsImageFilter::GetThresholds()[0].
+ */
+double otsu_lowest_of_two_thresholds(const std::vector<size_t> &histogram,
+                                     const double min_value,
+                                     const double bin_width) {
+    const size_t bins = histogram.size();
+    std::vector<double> cumulative_count(bins + 1, 0.0);
+    std::vector<double> cumulative_sum(bins + 1, 0.0);
+    for (size_t i = 0; i < bins; ++i) {
+        const double center = min_value + (i + 0.5) * bin_width;
+        cumulative_count[i + 1] = cumulative_count[i] + histogram[i];
+        cumulative_sum[i + 1] = cumulative_sum[i] + histogram[i] * center;
+    }
+    auto class_variance_term = [&](const size_t begin, const size_t end) {
+        const double count = cumulative_count[end] - cumulative_count[begin];
+        if (count <= 0.0) {
+            return 0.0;
+        }
+        const double sum = cumulative_sum[end] - cumulative_sum[begin];
+        return sum * sum / count;
+    };
+    double best = -1.0;
+    size_t best_first = 0;
+    for (size_t first = 1; first + 1 < bins; ++first) {
+        for (size_t second = first + 1; second < bins; ++second) {
+            const double between = class_variance_term(0, first) +
+                                   class_variance_term(first, second) +
+                                   class_variance_term(second, bins);
+            if (between > best) {
+                best = between;
+                best_first = first;
+            }
+        }
+    }
+    return min_value + best_first * bin_width;
+}
+
+/**
+ * Speed (sigmoid of the gradient magnitude) and its gradient for the voxels
+ * in the band.
+ */
+void compute_speed(const binarize_with_level_set_parameters &parameters,
+                   const std::vector<float> &gradient_magnitude,
+                   NarrowBand &band,
+                   itk::MultiThreaderBase *threader) {
+    const size_t num_active = band.active_blocks.size();
+    const size_t num_chunks = 4 * threader->GetNumberOfWorkUnits();
+    // Range of the gradient inside the band
+    std::vector<float> chunk_min(num_chunks, std::numeric_limits<float>::max());
+    std::vector<float> chunk_max(num_chunks,
+                                 std::numeric_limits<float>::lowest());
+    parallel_chunks(threader, num_active, num_chunks,
+                    [&](const size_t begin, const size_t end,
+                        const size_t chunk) {
+                        for (size_t active = begin; active < end; ++active) {
+                            for (size_t local = 0; local < block_voxels;
+                                 ++local) {
+                                if (!band.is_inside_image(
+                                            band.coordinates(active, local))) {
+                                    continue;
+                                }
+                                const float value =
+                                        gradient_magnitude[active *
+                                                                   block_voxels +
+                                                           local];
+                                chunk_min[chunk] =
+                                        std::min(chunk_min[chunk], value);
+                                chunk_max[chunk] =
+                                        std::max(chunk_max[chunk], value);
+                            }
+                        }
+                    });
+    const double min_value =
+            *std::min_element(chunk_min.begin(), chunk_min.end());
+    const double max_value =
+            *std::max_element(chunk_max.begin(), chunk_max.end());
+    const double bin_width =
+            max_value > min_value ? (max_value - min_value) / histogram_bins
+                                  : 1.0;
+    std::vector<std::vector<size_t>> chunk_histogram(
+            num_chunks, std::vector<size_t>(histogram_bins, 0));
+    parallel_chunks(
+            threader, num_active, num_chunks,
+            [&](const size_t begin, const size_t end, const size_t chunk) {
+                auto &histogram = chunk_histogram[chunk];
+                for (size_t active = begin; active < end; ++active) {
+                    for (size_t local = 0; local < block_voxels; ++local) {
+                        if (!band.is_inside_image(
+                                    band.coordinates(active, local))) {
+                            continue;
+                        }
+                        const double value =
+                                gradient_magnitude[active * block_voxels +
+                                                   local];
+                        const size_t bin = std::min(
+                                static_cast<size_t>((value - min_value) /
+                                                    bin_width),
+                                histogram_bins - 1);
+                        ++histogram[bin];
+                    }
+                }
+            });
+    std::vector<size_t> histogram(histogram_bins, 0);
+    for (const auto &partial : chunk_histogram) {
+        for (size_t i = 0; i < histogram_bins; ++i) {
+            histogram[i] += partial[i];
+        }
+    }
+    const double beta =
+            otsu_lowest_of_two_thresholds(histogram, min_value, bin_width);
+    const double alpha = parameters.sigmoid_alpha;
+
+    const size_t num_band_voxels = num_active * block_voxels;
+    band.speed.resize(num_band_voxels);
+    for (size_t i = 0; i < num_band_voxels; ++i) {
+        band.speed[i] = static_cast<float>(
+                1.0 / (1.0 + std::exp(-(gradient_magnitude[i] - beta) /
+                                      alpha)));
+    }
+
+    // Central differences of the speed, one-sided at the band boundaries.
+    band.speed_gradient_x.assign(num_band_voxels, 0.0f);
+    band.speed_gradient_y.assign(num_band_voxels, 0.0f);
+    band.speed_gradient_z.assign(num_band_voxels, 0.0f);
+    std::array<std::vector<float> *, 3> speed_gradient = {
+            &band.speed_gradient_x, &band.speed_gradient_y,
+            &band.speed_gradient_z};
+    parallel_chunks(
+            threader, num_active, num_chunks,
+            [&](const size_t begin, const size_t end, const size_t) {
+                for (size_t active = begin; active < end; ++active) {
+                    for (size_t local = 0; local < block_voxels; ++local) {
+                        const auto p = band.coordinates(active, local);
+                        if (!band.is_inside_image(p)) {
+                            continue;
+                        }
+                        const size_t position = active * block_voxels + local;
+                        const float center = band.speed[position];
+                        for (size_t axis = 0; axis < 3; ++axis) {
+                            auto previous = p;
+                            auto next = p;
+                            --previous[axis];
+                            ++next[axis];
+                            const float value_previous =
+                                    band.speed_at(previous[0], previous[1],
+                                                  previous[2], center);
+                            const float value_next = band.speed_at(
+                                    next[0], next[1], next[2], center);
+                            (*speed_gradient[axis])[position] = static_cast<
+                                    float>(
+                                    (value_next - value_previous) /
+                                    (2.0 * band.spacing[axis]));
+                        }
+                    }
+                }
+            });
+}
+
+/**
+ * Geodesic active contour evolution of band.phi, using the same terms than
+ * itk::GeodesicActiveContourLevelSetFunction:
+ * phi_t = -P g |grad(phi)| + C g k |grad(phi)| + A grad(g) . grad(phi)
+ *
+ * Upwind differences for the propagation and advection terms, central
+ * differences for the curvature.
+ *
+ * @return number of iterations performed
+ */
+size_t evolve_level_set(const binarize_with_level_set_parameters &parameters,
+                        NarrowBand &band,
+                        itk::MultiThreaderBase *threader) {
+    const size_t num_active = band.active_blocks.size();
+    const size_t num_band_voxels = num_active * block_voxels;
+    const size_t num_chunks = 4 * threader->GetNumberOfWorkUnits();
+    const double propagation = parameters.level_set_propagation_scaling;
+    const double curvature = parameters.level_set_curvature_scaling;
+    const double advection = parameters.level_set_advection_scaling;
+    const auto &h = band.spacing;
+    const double min_spacing = std::min(h[0], std::min(h[1], h[2]));
+    const double max_spacing = std::max(h[0], std::max(h[1], h[2]));
+
+    // Only the pixels close to the front are updated, the rest keep the
+    // initial signed distance until the front gets closer.
+    const double active_width = 3 * max_spacing;
+
+    std::vector<float> update(num_band_voxels, 0.0f);
+    std::vector<double> chunk_squared_change(num_chunks);
+    std::vector<size_t> chunk_front_voxels(num_chunks);
+    std::vector<double> chunk_hyperbolic_speed(num_chunks);
+    std::vector<double> chunk_parabolic_speed(num_chunks);
+    size_t iteration = 0;
+    for (; iteration < parameters.level_set_iterations; ++iteration) {
+        std::fill(chunk_squared_change.begin(), chunk_squared_change.end(),
+                  0.0);
+        std::fill(chunk_front_voxels.begin(), chunk_front_voxels.end(), 0);
+        std::fill(chunk_hyperbolic_speed.begin(), chunk_hyperbolic_speed.end(),
+                  0.0);
+        std::fill(chunk_parabolic_speed.begin(), chunk_parabolic_speed.end(),
+                  0.0);
+        // Rate of change of phi
+        parallel_chunks(
+                threader, num_active, num_chunks,
+                [&](const size_t begin, const size_t end, const size_t chunk) {
+                    for (size_t active = begin; active < end; ++active) {
+                        for (size_t local = 0; local < block_voxels; ++local) {
+                            const auto p = band.coordinates(active, local);
+                            const size_t position =
+                                    active * block_voxels + local;
+                            if (!band.is_inside_image(p)) {
+                                update[position] = 0.0f;
+                                continue;
+                            }
+                            const long x = p[0];
+                            const long y = p[1];
+                            const long z = p[2];
+                            const double center = band.phi[position];
+                            const double xm = band.phi_at(x - 1, y, z);
+                            const double xp = band.phi_at(x + 1, y, z);
+                            const double ym = band.phi_at(x, y - 1, z);
+                            const double yp = band.phi_at(x, y + 1, z);
+                            const double zm = band.phi_at(x, y, z - 1);
+                            const double zp = band.phi_at(x, y, z + 1);
+                            // The pixels next to an active pixel become
+                            // active, so the active region follows the front.
+                            const double closest_to_front = std::min(
+                                    {std::abs(center), std::abs(xm),
+                                     std::abs(xp), std::abs(ym), std::abs(yp),
+                                     std::abs(zm), std::abs(zp)});
+                            if (closest_to_front > active_width) {
+                                update[position] = 0.0f;
+                                continue;
+                            }
+                            const std::array<double, 3> backward = {
+                                    (center - xm) / h[0], (center - ym) / h[1],
+                                    (center - zm) / h[2]};
+                            const std::array<double, 3> forward = {
+                                    (xp - center) / h[0], (yp - center) / h[1],
+                                    (zp - center) / h[2]};
+                            const double g = band.speed[position];
+                            const std::array<double, 3> grad_g = {
+                                    band.speed_gradient_x[position],
+                                    band.speed_gradient_y[position],
+                                    band.speed_gradient_z[position]};
+                            chunk_hyperbolic_speed[chunk] = std::max(
+                                    chunk_hyperbolic_speed[chunk],
+                                    std::abs(propagation) * g +
+                                            std::abs(advection) *
+                                                    std::sqrt(grad_g[0] *
+                                                                      grad_g[0] +
+                                                              grad_g[1] *
+                                                                      grad_g[1] +
+                                                              grad_g[2] *
+                                                                      grad_g[2]));
+                            chunk_parabolic_speed[chunk] =
+                                    std::max(chunk_parabolic_speed[chunk],
+                                             std::abs(curvature) * g);
+
+                            double change = 0.0;
+                            // Propagation, Osher-Sethian upwind
+                            const double propagation_speed = propagation * g;
+                            if (propagation_speed != 0.0) {
+                                double squared = 0.0;
+                                for (size_t i = 0; i < 3; ++i) {
+                                    if (propagation_speed > 0) {
+                                        squared += std::pow(
+                                                std::max(backward[i], 0.0), 2) +
+                                                   std::pow(std::min(forward[i],
+                                                                     0.0),
+                                                            2);
+                                    } else {
+                                        squared += std::pow(
+                                                std::min(backward[i], 0.0), 2) +
+                                                   std::pow(std::max(forward[i],
+                                                                     0.0),
+                                                            2);
+                                    }
+                                }
+                                change -= propagation_speed * std::sqrt(squared);
+                            }
+                            // Advection with velocity -A grad(g), upwind
+                            for (size_t i = 0; i < 3; ++i) {
+                                const double velocity = -advection * grad_g[i];
+                                change -= velocity * (velocity > 0
+                                                              ? backward[i]
+                                                              : forward[i]);
+                            }
+                            // Mean curvature times |grad(phi)|
+                            if (curvature != 0.0) {
+                                const double dx = (xp - xm) / (2 * h[0]);
+                                const double dy = (yp - ym) / (2 * h[1]);
+                                const double dz = (zp - zm) / (2 * h[2]);
+                                const double dxx =
+                                        (xp - 2 * center + xm) / (h[0] * h[0]);
+                                const double dyy =
+                                        (yp - 2 * center + ym) / (h[1] * h[1]);
+                                const double dzz =
+                                        (zp - 2 * center + zm) / (h[2] * h[2]);
+                                const double dxy =
+                                        (band.phi_at(x + 1, y + 1, z) -
+                                         band.phi_at(x + 1, y - 1, z) -
+                                         band.phi_at(x - 1, y + 1, z) +
+                                         band.phi_at(x - 1, y - 1, z)) /
+                                        (4 * h[0] * h[1]);
+                                const double dxz =
+                                        (band.phi_at(x + 1, y, z + 1) -
+                                         band.phi_at(x + 1, y, z - 1) -
+                                         band.phi_at(x - 1, y, z + 1) +
+                                         band.phi_at(x - 1, y, z - 1)) /
+                                        (4 * h[0] * h[2]);
+                                const double dyz =
+                                        (band.phi_at(x, y + 1, z + 1) -
+                                         band.phi_at(x, y + 1, z - 1) -
+                                         band.phi_at(x, y - 1, z + 1) +
+                                         band.phi_at(x, y - 1, z - 1)) /
+                                        (4 * h[1] * h[2]);
+                                const double squared_norm =
+                                        dx * dx + dy * dy + dz * dz;
+                                if (squared_norm > 1e-12) {
+                                    const double numerator =
+                                            (dyy + dzz) * dx * dx +
+                                            (dxx + dzz) * dy * dy +
+                                            (dxx + dyy) * dz * dz -
+                                            2 * dx * dy * dxy -
+                                            2 * dx * dz * dxz -
+                                            2 * dy * dz * dyz;
+                                    change += curvature * g * numerator /
+                                              squared_norm;
+                                }
+                            }
+                            update[position] = static_cast<float>(change);
+                        }
+                    }
+                });
+        // Time step from the CFL condition.
+        const double hyperbolic_speed = *std::max_element(
+                chunk_hyperbolic_speed.begin(), chunk_hyperbolic_speed.end());
+        const double parabolic_speed = *std::max_element(
+                chunk_parabolic_speed.begin(), chunk_parabolic_speed.end());
+        double dt = std::numeric_limits<double>::max();
+        if (hyperbolic_speed > 0.0) {
+            dt = std::min(dt, 0.5 * min_spacing / hyperbolic_speed);
+        }
+        if (parabolic_speed > 0.0) {
+            dt = std::min(dt,
+                          min_spacing * min_spacing / (6.0 * parabolic_speed));
+        }
+        if (dt == std::numeric_limits<double>::max()) {
+            break;
+        }
+        // Apply the update (Jacobi), and measure the change near the front.
+        parallel_chunks(
+                threader, num_band_voxels, num_chunks,
+                [&](const size_t begin, const size_t end, const size_t chunk) {
+                    for (size_t i = begin; i < end; ++i) {
+                        const double change = dt * update[i];
+                        if (std::abs(band.phi[i]) <= max_spacing) {
+                            chunk_squared_change[chunk] += change * change;
+                            ++chunk_front_voxels[chunk];
+                        }
+                        band.phi[i] = std::min(
+                                std::max(band.phi[i] +
+                                                 static_cast<float>(change),
+                                         -band.far_value),
+                                band.far_value);
+                    }
+                });
+        double squared_change = 0.0;
+        size_t front_voxels = 0;
+        for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+            squared_change += chunk_squared_change[chunk];
+            front_voxels += chunk_front_voxels[chunk];
+        }
+        const double rms_change =
+                front_voxels ? std::sqrt(squared_change / front_voxels) : 0.0;
+        if (rms_change <= parameters.level_set_maximum_RMS_error) {
+            ++iteration;
+            break;
+        }
+    }
+    return iteration;
+}
+
+/** Dense float image with the values of the band, default_value outside. */
+FloatImageType::Pointer
+band_to_image(const FloatImageType *reference,
+              const NarrowBand &band,
+              const std::vector<float> &values,
+              const float default_value,
+              const bool use_sign_of_binary = false) {
+    auto image = FloatImageType::New();
+    image->CopyInformation(reference);
+    image->SetRegions(reference->GetBufferedRegion());
+    image->Allocate();
+    FloatImagePixelType *buffer = image->GetBufferPointer();
+    for (long z = 0; z < band.size[2]; ++z) {
+        for (long y = 0; y < band.size[1]; ++y) {
+            for (long x = 0; x < band.size[0]; ++x) {
+                const size_t offset = band.image_offset(x, y, z);
+                const long position = band.band_position(x, y, z);
+                if (position >= 0) {
+                    buffer[offset] = values[position];
+                } else {
+                    buffer[offset] = (use_sign_of_binary && band.binary[offset])
+                                             ? -default_value
+                                             : default_value;
+                }
+            }
+        }
+    }
+    return image;
+}
+} // namespace
+
+binarize_with_level_set_output binarize_with_level_set_narrow_band(
+        const FloatImageType *input_float_image,
+        const BinaryImageType *binary_image_safe,
+        const binarize_with_level_set_parameters &input_parameters,
+        const bool save_intermediate_results,
+        const size_t num_threads) {
+    binarize_with_level_set_output output_struct;
+    output_struct.parameters = input_parameters; // copy
+    auto &parameters = output_struct.parameters; // alias
+    if (parameters.gradient_sigma == -999) {
+        parameters.gradient_sigma = 0.5 * input_float_image->GetSpacing()[0];
+    }
+    if (parameters.narrow_band_width == 0) {
+        parameters.narrow_band_width = parameters.level_set_iterations + 3;
+    }
+
+    const auto &region = input_float_image->GetBufferedRegion();
+    const auto &binary_region = binary_image_safe->GetBufferedRegion();
+    NarrowBand band;
+    for (size_t i = 0; i < 3; ++i) {
+        if (region.GetSize()[i] != binary_region.GetSize()[i]) {
+            throw std::runtime_error(
+                    "binarize_with_level_set_narrow_band: input_float_image "
+                    "and binary_image_safe must have the same size.");
+        }
+        band.size[i] = static_cast<long>(region.GetSize()[i]);
+        band.blocks[i] = (band.size[i] + block_side - 1) / block_side;
+        band.spacing[i] = input_float_image->GetSpacing()[i];
+    }
+    band.binary = binary_image_safe->GetBufferPointer();
+    const long band_width = parameters.narrow_band_width;
+    const double max_spacing = std::max(
+            band.spacing[0], std::max(band.spacing[1], band.spacing[2]));
+    // Value of the voxels outside the band, further than any voxel in it.
+    band.far_value =
+            static_cast<float>((band_width + 2 * block_side) * max_spacing);
+
+    auto threader = create_threader(num_threads);
+    activate_blocks(band, band_width, threader.GetPointer());
+    initialize_signed_distance(band);
+    std::vector<float> gradient_magnitude;
+    if (!band.active_blocks.empty()) {
+        compute_gradient_magnitude(input_float_image, parameters.gradient_sigma,
+                                   band, gradient_magnitude,
+                                   threader.GetPointer());
+        compute_speed(parameters, gradient_magnitude, band,
+                      threader.GetPointer());
+        evolve_level_set(parameters, band, threader.GetPointer());
+    }
+
+    // Threshold the level set
+    auto output_binary_image = BinaryImageType::New();
+    output_binary_image->CopyInformation(input_float_image);
+    output_binary_image->SetRegions(region);
+    output_binary_image->Allocate();
+    BinaryImagePixelType *output_buffer =
+            output_binary_image->GetBufferPointer();
+    const double upper_threshold = parameters.binary_upper_threshold;
+    const auto inside_value = parameters.binary_inside_value;
+    threader->ParallelizeArray(
+            0, band.size[2],
+            [&](itk::SizeValueType z) {
+                for (long y = 0; y < band.size[1]; ++y) {
+                    for (long x = 0; x < band.size[0]; ++x) {
+                        const long lz = static_cast<long>(z);
+                        output_buffer[band.image_offset(x, y, lz)] =
+                                band.phi_at(x, y, lz) <= upper_threshold
+                                        ? inside_value
+                                        : 0;
+                    }
+                }
+            },
+            nullptr);
+    output_struct.output_binary_image = output_binary_image;
+
+    if (save_intermediate_results) {
+        output_struct.gradient_image = band_to_image(
+                input_float_image, band, gradient_magnitude, 0.0f);
+        output_struct.sigmoid_image =
+                band_to_image(input_float_image, band, band.speed, 0.0f);
+        output_struct.level_set_image = band_to_image(
+                input_float_image, band, band.phi, band.far_value, true);
+    }
+
+    return output_struct;
+}
+
+} // end namespace SG
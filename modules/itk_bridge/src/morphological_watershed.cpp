@@ -19,9 +19,17 @@
  * *******************************************************************/
 
 #include "morphological_watershed.hpp"
+#include "voxelize_graph.hpp"
+
 #include <itkInvertIntensityImageFilter.h>
 #include <itkMaskImageFilter.h>
 #include <itkMorphologicalWatershedFromMarkersImageFilter.h>
+#include <itkMultiThreaderBase.h>
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <vector>
 
 namespace SG {
 
@@ -61,4 +69,128 @@ morphological_watershed(const BinaryImageType::Pointer &original_binary_image,
     return mask_filter->GetOutput();
 }
 
+BinaryImageType::Pointer geodesic_label_propagation_from_graph(
+        const BinaryImageType::Pointer &original_binary_image,
+        const GraphType &graph,
+        const vertex_to_label_map_t &vertex_to_label_map,
+        const edge_to_label_map_t &edge_to_label_map,
+        const bool &graph_positions_are_in_physical_space,
+        const bool &draw_segments,
+        const size_t &num_threads) {
+    const auto &region = original_binary_image->GetLargestPossibleRegion();
+    auto output = BinaryImageType::New();
+    output->CopyInformation(original_binary_image);
+    output->SetRegions(region);
+    output->Allocate();
+    output->FillBuffer(0);
+
+    const BinaryImagePixelType *mask =
+            original_binary_image->GetBufferPointer();
+    BinaryImagePixelType *labels = output->GetBufferPointer();
+    // Seeds in the foreground, the greatest label wins.
+    bool any_label_is_zero = false;
+    std::vector<size_t> front;
+    detail::rasterize_graph_labels(
+            graph, output, vertex_to_label_map, edge_to_label_map,
+            graph_positions_are_in_physical_space, draw_segments,
+            VertexToRadiusMap(), num_threads, any_label_is_zero, mask, &front);
+    if (any_label_is_zero) {
+        std::cerr << "Warning in geodesic_label_propagation_from_graph: the maps "
+                     "have one or more labels equal to zero, these seeds are "
+                     "ignored. Ignore this warning if expected."
+                  << std::endl;
+    }
+
+    const long nx = region.GetSize()[0];
+    const long ny = region.GetSize()[1];
+    const long nz = region.GetSize()[2];
+    std::vector<std::array<long, 3>> neighbors;
+    for (long dz = -1; dz <= 1; ++dz) {
+        for (long dy = -1; dy <= 1; ++dy) {
+            for (long dx = -1; dx <= 1; ++dx) {
+                if (dx != 0 || dy != 0 || dz != 0) {
+                    neighbors.push_back({dx, dy, dz});
+                }
+            }
+        }
+    }
+
+    auto threader = itk::MultiThreaderBase::New();
+    if (num_threads > 0) {
+        threader->SetMaximumNumberOfThreads(num_threads);
+        threader->SetNumberOfWorkUnits(num_threads);
+    }
+    // The voxels reached in a step are grouped by z slab, so each slab can be
+    // written by one work unit.
+    const size_t num_chunks = 4 * threader->GetNumberOfWorkUnits();
+    const size_t num_slabs = std::min<size_t>(nz, num_chunks);
+    const size_t slab_depth = (nz + num_slabs - 1) / num_slabs;
+    const size_t plane_size = nx * ny;
+    using OffsetLabel = std::pair<size_t, BinaryImagePixelType>;
+    std::vector<std::vector<std::vector<OffsetLabel>>> reached(
+            num_chunks, std::vector<std::vector<OffsetLabel>>(num_slabs));
+    std::vector<std::vector<size_t>> slab_front(num_slabs);
+    while (!front.empty()) {
+        // Unlabeled foreground neighbors of the front. labels is only read.
+        const size_t chunk_size = (front.size() + num_chunks - 1) / num_chunks;
+        threader->ParallelizeArray(
+                0, num_chunks,
+                [&](itk::SizeValueType chunk) {
+                    auto &chunk_reached = reached[chunk];
+                    for (auto &slab_reached : chunk_reached) {
+                        slab_reached.clear();
+                    }
+                    const size_t begin =
+                            std::min(chunk * chunk_size, front.size());
+                    const size_t end =
+                            std::min(begin + chunk_size, front.size());
+                    for (size_t i = begin; i < end; ++i) {
+                        const size_t offset = front[i];
+                        const BinaryImagePixelType label = labels[offset];
+                        const long x = offset % nx;
+                        const long y = (offset / nx) % ny;
+                        const long z = offset / plane_size;
+                        for (const auto &n : neighbors) {
+                            const long X = x + n[0];
+                            const long Y = y + n[1];
+                            const long Z = z + n[2];
+                            if (X < 0 || Y < 0 || Z < 0 || X >= nx ||
+                                Y >= ny || Z >= nz) {
+                                continue;
+                            }
+                            const size_t neighbor =
+                                    (Z * ny + Y) * nx + X;
+                            if (mask[neighbor] && labels[neighbor] == 0) {
+                                chunk_reached[Z / slab_depth].emplace_back(
+                                        neighbor, label);
+                            }
+                        }
+                    }
+                },
+                nullptr);
+        // Write the labels of the new front, one work unit per slab.
+        threader->ParallelizeArray(
+                0, num_slabs,
+                [&](itk::SizeValueType slab) {
+                    auto &new_front = slab_front[slab];
+                    new_front.clear();
+                    for (const auto &chunk_reached : reached) {
+                        for (const auto &offset_label : chunk_reached[slab]) {
+                            auto &label = labels[offset_label.first];
+                            if (label == 0) {
+                                new_front.push_back(offset_label.first);
+                            }
+                            label = std::max(label, offset_label.second);
+                        }
+                    }
+                },
+                nullptr);
+        front.clear();
+        for (const auto &new_front : slab_front) {
+            front.insert(front.end(), new_front.begin(), new_front.end());
+        }
+    }
+    return output;
+}
+
 } // end namespace SG
@@ -19,15 +19,446 @@
  * *******************************************************************/
 
 #include "resample_image_function.hpp"
-#include <itkIdentityTransform.h>
-#include <itkNearestNeighborInterpolateImageFunction.h>
-#include <itkResampleImageFilter.h>
+#include <itkImageFileWriter.h>
+#include <itkImageIOFactory.h>
+#include <itkMultiThreaderBase.h>
+#include "itksys/SystemTools.hxx"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 namespace SG {
+
+namespace {
+constexpr size_t occupancy_block_size = 8;
+
+/**
+ * Number of foreground voxels in blocks of the input image, stored as a
+ * summed volume table, so the number of foreground voxels of any box of
+ * blocks is computed in constant time.
+ */
+struct BlockOccupancy {
+    std::array<size_t, 3> num_blocks;
+    /** Size (num_blocks + 1) in each dimension, first layer is zero. */
+    std::vector<size_t> summed;
+
+    size_t at(const size_t bx, const size_t by, const size_t bz) const {
+        return summed[(bz * (num_blocks[1] + 1) + by) * (num_blocks[0] + 1) +
+                      bx];
+    }
+    /** True if any voxel in the blocks [b_begin, b_end) is foreground. */
+    bool any(const std::array<size_t, 3> &b_begin,
+             const std::array<size_t, 3> &b_end) const {
+        const auto &b0 = b_begin;
+        const auto &b1 = b_end;
+        const size_t count = at(b1[0], b1[1], b1[2]) - at(b0[0], b1[1], b1[2]) -
+                             at(b1[0], b0[1], b1[2]) - at(b1[0], b1[1], b0[2]) +
+                             at(b0[0], b0[1], b1[2]) + at(b0[0], b1[1], b0[2]) +
+                             at(b1[0], b0[1], b0[2]) - at(b0[0], b0[1], b0[2]);
+        return count > 0;
+    }
+    /** True if any voxel in the input box [begin, end) is foreground. */
+    bool any_voxel(const std::array<size_t, 3> &begin,
+                   const std::array<size_t, 3> &end) const {
+        std::array<size_t, 3> b_begin;
+        std::array<size_t, 3> b_end;
+        for (size_t d = 0; d < 3; ++d) {
+            if (begin[d] >= end[d]) {
+                return false;
+            }
+            b_begin[d] = begin[d] / occupancy_block_size;
+            b_end[d] = (end[d] - 1) / occupancy_block_size + 1;
+        }
+        return any(b_begin, b_end);
+    }
+};
+
+BlockOccupancy
+compute_block_occupancy(const BinaryImagePixelType *buffer,
+                        const std::array<size_t, 3> &size,
+                        itk::MultiThreaderBase *threader) {
+    BlockOccupancy occupancy;
+    for (size_t d = 0; d < 3; ++d) {
+        occupancy.num_blocks[d] =
+                (size[d] + occupancy_block_size - 1) / occupancy_block_size;
+    }
+    const size_t sx = occupancy.num_blocks[0] + 1;
+    const size_t sy = occupancy.num_blocks[1] + 1;
+    const size_t sz = occupancy.num_blocks[2] + 1;
+    occupancy.summed.assign(sx * sy * sz, 0);
+    // Count each block, one layer of blocks per work item.
+    threader->ParallelizeArray(
+            0, occupancy.num_blocks[2],
+            [&](itk::SizeValueType bz) {
+                const size_t z_end =
+                        std::min((bz + 1) * occupancy_block_size, size[2]);
+                for (size_t z = bz * occupancy_block_size; z < z_end; ++z) {
+                    for (size_t y = 0; y < size[1]; ++y) {
+                        const BinaryImagePixelType *row =
+                                buffer + (z * size[1] + y) * size[0];
+                        const size_t by = y / occupancy_block_size;
+                        size_t *counts =
+                                occupancy.summed.data() +
+                                ((bz + 1) * sy + by + 1) * sx + 1;
+                        for (size_t x = 0; x < size[0]; ++x) {
+                            counts[x / occupancy_block_size] += row[x] > 0;
+                        }
+                    }
+                }
+            },
+            nullptr);
+    for (size_t z = 1; z < sz; ++z) {
+        for (size_t y = 1; y < sy; ++y) {
+            for (size_t x = 1; x < sx; ++x) {
+                occupancy.summed[(z * sy + y) * sx + x] +=
+                        occupancy.summed[(z * sy + y) * sx + x - 1] +
+                        occupancy.summed[(z * sy + y - 1) * sx + x] +
+                        occupancy.summed[((z - 1) * sy + y) * sx + x] -
+                        occupancy.summed[(z * sy + y - 1) * sx + x - 1] -
+                        occupancy.summed[((z - 1) * sy + y) * sx + x - 1] -
+                        occupancy.summed[((z - 1) * sy + y - 1) * sx + x] +
+                        occupancy.summed[((z - 1) * sy + y - 1) * sx + x - 1];
+            }
+        }
+    }
+    return occupancy;
+}
+
+/**
+ * Input voxels under each output voxel along one axis, with the length of
+ * their overlap (in input voxels). Input voxel j covers [j - 0.5, j + 0.5) in
+ * input index space, output voxel i covers [(i - 0.5) r, (i + 0.5) r).
+ */
+struct AxisFootprint {
+    /** First input voxel (buffer index) of each output voxel. */
+    std::vector<size_t> begin;
+    /** Weights of output voxel i are [offsets[i], offsets[i + 1]). */
+    std::vector<size_t> offsets;
+    std::vector<double> weights;
+    /** Length of the footprint, in input voxels. */
+    double length;
+
+    size_t end(const size_t i) const {
+        return begin[i] + offsets[i + 1] - offsets[i];
+    }
+};
+
+AxisFootprint compute_axis_footprint(const size_t output_size,
+                                     const double ratio,
+                                     const long input_start,
+                                     const size_t input_size) {
+    AxisFootprint footprint;
+    footprint.length = ratio;
+    footprint.begin.resize(output_size);
+    footprint.offsets.assign(1, 0);
+    for (size_t i = 0; i < output_size; ++i) {
+        // Footprint relative to the first voxel of the buffer.
+        const double low = (i - 0.5) * ratio - input_start;
+        const double high = (i + 0.5) * ratio - input_start;
+        const long j_begin = std::max(0L, std::lround(std::floor(low + 0.5)));
+        const long j_end = std::min(static_cast<long>(input_size),
+                                    std::lround(std::ceil(high + 0.5)));
+        footprint.begin[i] = j_begin;
+        for (long j = j_begin; j < j_end; ++j) {
+            footprint.weights.push_back(
+                    std::max(0.0, std::min(high, j + 0.5) -
+                                          std::max(low, j - 0.5)));
+        }
+        footprint.offsets.push_back(footprint.weights.size());
+        if (j_end <= j_begin) {
+            footprint.begin[i] = 0;
+            footprint.offsets.back() = footprint.offsets[i];
+        }
+    }
+    return footprint;
+}
+
+/**
+ * Nearest input voxel (buffer index) to each output voxel along one axis,
+ * -1 if outside the input. Rounds half up, as itk::Math::RoundHalfIntegerUp.
+ */
+std::vector<long> compute_axis_nearest(const size_t output_size,
+                                       const double ratio,
+                                       const long input_start,
+                                       const size_t input_size) {
+    std::vector<long> nearest(output_size);
+    for (size_t i = 0; i < output_size; ++i) {
+        const long j =
+                static_cast<long>(std::floor(i * ratio + 0.5)) - input_start;
+        nearest[i] = (j >= 0 && j < static_cast<long>(input_size)) ? j : -1;
+    }
+    return nearest;
+}
+/**
+ * Computes the planes of the output of @ref resample_binary_image from the
+ * input buffer. The input, the axis tables and the occupancy are computed
+ * once, and any range of output planes can be written.
+ */
+class BinaryResampler {
+  public:
+    BinaryResampler(const BinaryImageType::Pointer &input,
+                    const BinaryImageType::SpacingType &output_spacing,
+                    const BinaryImageType::SizeType &output_size,
+                    const BinaryResampleRule &rule,
+                    const double &partial_volume_threshold,
+                    const size_t &num_threads)
+            : m_input(input), m_rule(rule) {
+        const auto &input_region = input->GetBufferedRegion();
+        const auto &input_spacing = input->GetSpacing();
+        std::array<long, 3> in_start;
+        std::array<double, 3> ratio;
+        for (size_t d = 0; d < 3; ++d) {
+            if (!(output_spacing[d] > 0)) {
+                throw std::runtime_error("resample_binary_image: "
+                                         "output_spacing must be positive.");
+            }
+            m_in_size[d] = input_region.GetSize()[d];
+            in_start[d] = input_region.GetIndex()[d];
+            m_out_size[d] = output_size[d];
+            ratio[d] = output_spacing[d] / input_spacing[d];
+        }
+        m_threader = itk::MultiThreaderBase::New();
+        if (num_threads > 0) {
+            m_threader->SetMaximumNumberOfThreads(num_threads);
+            m_threader->SetNumberOfWorkUnits(num_threads);
+        }
+        m_occupancy = compute_block_occupancy(
+                input->GetBufferPointer(), m_in_size, m_threader.GetPointer());
+        if (rule == BinaryResampleRule::nearest_neighbor) {
+            for (size_t d = 0; d < 3; ++d) {
+                m_nearest[d] = compute_axis_nearest(
+                        m_out_size[d], ratio[d], in_start[d], m_in_size[d]);
+            }
+        } else {
+            for (size_t d = 0; d < 3; ++d) {
+                m_footprints[d] = compute_axis_footprint(
+                        m_out_size[d], ratio[d], in_start[d], m_in_size[d]);
+            }
+            m_min_foreground_volume =
+                    partial_volume_threshold * m_footprints[0].length *
+                    m_footprints[1].length * m_footprints[2].length;
+        }
+    }
+
+    const std::array<size_t, 3> &output_size() const { return m_out_size; }
+
+    /**
+     * Write the output planes [z_begin, z_end) in out, a zero filled buffer
+     * starting at plane z_begin. Planes are processed in parallel.
+     */
+    void resample_planes(const size_t &z_begin,
+                         const size_t &z_end,
+                         BinaryImagePixelType *out) const {
+        const size_t num_planes = z_end - z_begin;
+        const size_t num_slabs = std::min<size_t>(
+                num_planes, 4 * m_threader->GetNumberOfWorkUnits());
+        if (num_slabs == 0) {
+            return;
+        }
+        const size_t slab_depth = (num_planes + num_slabs - 1) / num_slabs;
+        const size_t plane_size = m_out_size[0] * m_out_size[1];
+        m_threader->ParallelizeArray(
+                0, num_slabs,
+                [&](itk::SizeValueType slab) {
+                    const size_t slab_begin = z_begin + slab * slab_depth;
+                    const size_t slab_end =
+                            std::min(slab_begin + slab_depth, z_end);
+                    for (size_t z = slab_begin; z < slab_end; ++z) {
+                        BinaryImagePixelType *out_plane =
+                                out + (z - z_begin) * plane_size;
+                        if (m_rule == BinaryResampleRule::nearest_neighbor) {
+                            resample_plane_nearest(z, out_plane);
+                        } else {
+                            resample_plane_partial_volume(z, out_plane);
+                        }
+                    }
+                },
+                nullptr);
+    }
+
+  private:
+    void resample_plane_nearest(const size_t &z,
+                                BinaryImagePixelType *out_plane) const {
+        const BinaryImagePixelType *in = m_input->GetBufferPointer();
+        const long jz = m_nearest[2][z];
+        if (jz < 0) {
+            return;
+        }
+        for (size_t y = 0; y < m_out_size[1]; ++y) {
+            const long jy = m_nearest[1][y];
+            if (jy < 0) {
+                continue;
+            }
+            // Skip empty input rows.
+            const std::array<size_t, 3> begin = {
+                    0, static_cast<size_t>(jy), static_cast<size_t>(jz)};
+            const std::array<size_t, 3> end = {m_in_size[0], begin[1] + 1,
+                                               begin[2] + 1};
+            if (!m_occupancy.any_voxel(begin, end)) {
+                continue;
+            }
+            const BinaryImagePixelType *in_row =
+                    in + (jz * m_in_size[1] + jy) * m_in_size[0];
+            BinaryImagePixelType *out_row = out_plane + y * m_out_size[0];
+            for (size_t x = 0; x < m_out_size[0]; ++x) {
+                const long jx = m_nearest[0][x];
+                if (jx >= 0) {
+                    out_row[x] = in_row[jx];
+                }
+            }
+        }
+    }
+
+    void resample_plane_partial_volume(const size_t &z,
+                                       BinaryImagePixelType *out_plane) const {
+        const BinaryImagePixelType *in = m_input->GetBufferPointer();
+        const auto &fx = m_footprints[0];
+        const auto &fy = m_footprints[1];
+        const auto &fz = m_footprints[2];
+        for (size_t y = 0; y < m_out_size[1]; ++y) {
+            BinaryImagePixelType *out_row = out_plane + y * m_out_size[0];
+            for (size_t x = 0; x < m_out_size[0]; ++x) {
+                const std::array<size_t, 3> begin = {fx.begin[x], fy.begin[y],
+                                                     fz.begin[z]};
+                const std::array<size_t, 3> end = {fx.end(x), fy.end(y),
+                                                   fz.end(z)};
+                if (!m_occupancy.any_voxel(begin, end)) {
+                    continue;
+                }
+                double foreground_volume = 0.0;
+                BinaryImagePixelType max_value = 0;
+                for (size_t jz = begin[2]; jz < end[2]; ++jz) {
+                    const double wz = fz.weights[fz.offsets[z] + jz - begin[2]];
+                    for (size_t jy = begin[1]; jy < end[1]; ++jy) {
+                        const double wzy =
+                                wz * fy.weights[fy.offsets[y] + jy - begin[1]];
+                        const BinaryImagePixelType *in_row =
+                                in + (jz * m_in_size[1] + jy) * m_in_size[0];
+                        for (size_t jx = begin[0]; jx < end[0]; ++jx) {
+                            if (in_row[jx] > 0) {
+                                foreground_volume +=
+                                        wzy * fx.weights[fx.offsets[x] + jx -
+                                                         begin[0]];
+                                max_value = std::max(max_value, in_row[jx]);
+                            }
+                        }
+                    }
+                }
+                if (max_value > 0 &&
+                    foreground_volume >= m_min_foreground_volume) {
+                    out_row[x] = max_value;
+                }
+            }
+        }
+    }
+
+    BinaryImageType::Pointer m_input;
+    BinaryResampleRule m_rule;
+    std::array<size_t, 3> m_in_size;
+    std::array<size_t, 3> m_out_size;
+    itk::MultiThreaderBase::Pointer m_threader;
+    BlockOccupancy m_occupancy;
+    std::array<std::vector<long>, 3> m_nearest;
+    std::array<AxisFootprint, 3> m_footprints;
+    double m_min_foreground_volume = 0.0;
+};
+} // namespace
+
+BinaryImageType::Pointer resample_binary_image(
+        const BinaryImageType::Pointer &input,
+        const BinaryImageType::SpacingType &output_spacing,
+        const BinaryImageType::SizeType &output_size,
+        const BinaryResampleRule &rule,
+        const double &partial_volume_threshold,
+        const size_t &num_threads) {
+    const BinaryResampler resampler(input, output_spacing, output_size, rule,
+                                    partial_volume_threshold, num_threads);
+    auto output = BinaryImageType::New();
+    output->SetOrigin(input->GetOrigin());
+    output->SetDirection(input->GetDirection());
+    output->SetSpacing(output_spacing);
+    output->SetRegions(output_size);
+    output->Allocate();
+    output->FillBuffer(0);
+    resampler.resample_planes(0, resampler.output_size()[2],
+                              output->GetBufferPointer());
+    return output;
+}
+
+void resample_binary_image_to_file(
+        const BinaryImageType::Pointer &input,
+        const BinaryImageType::SpacingType &output_spacing,
+        const BinaryImageType::SizeType &output_size,
+        const std::string &output_filename,
+        const BinaryResampleRule &rule,
+        const double &partial_volume_threshold,
+        const size_t &num_threads,
+        const size_t &planes_per_slab) {
+    if (planes_per_slab == 0) {
+        throw std::runtime_error(
+                "resample_binary_image_to_file: planes_per_slab must be "
+                "positive.");
+    }
+    const BinaryResampler resampler(input, output_spacing, output_size, rule,
+                                    partial_volume_threshold, num_threads);
+    auto image_io = itk::ImageIOFactory::CreateImageIO(
+            output_filename.c_str(), itk::CommonEnums::IOFileMode::WriteMode);
+    if (!image_io || !image_io->CanStreamWrite()) {
+        throw std::runtime_error(
+                "resample_binary_image_to_file: the format of " +
+                output_filename +
+                " does not support streamed writing, use .mha or .mhd");
+    }
+    using WriterType = itk::ImageFileWriter<BinaryImageType>;
+    auto writer = WriterType::New();
+    writer->SetFileName(output_filename);
+    writer->SetImageIO(image_io);
+    writer->UseCompressionOff();
+    // Pasted regions are written in the existing file, start from scratch.
+    if (itksys::SystemTools::FileExists(output_filename.c_str(), true)) {
+        itksys::SystemTools::RemoveFile(output_filename);
+    }
+
+    const BinaryImageType::RegionType output_region(output_size);
+    const size_t nz = resampler.output_size()[2];
+    for (size_t z_begin = 0; z_begin < nz; z_begin += planes_per_slab) {
+        const size_t z_end = std::min(z_begin + planes_per_slab, nz);
+        BinaryImageType::RegionType slab_region = output_region;
+        slab_region.SetIndex(2, z_begin);
+        slab_region.SetSize(2, z_end - z_begin);
+        auto slab = BinaryImageType::New();
+        slab->SetOrigin(input->GetOrigin());
+        slab->SetDirection(input->GetDirection());
+        slab->SetSpacing(output_spacing);
+        slab->SetLargestPossibleRegion(output_region);
+        slab->SetBufferedRegion(slab_region);
+        slab->SetRequestedRegion(slab_region);
+        slab->Allocate();
+        slab->FillBuffer(0);
+        resampler.resample_planes(z_begin, z_end, slab->GetBufferPointer());
+
+        itk::ImageIORegion io_region(BinaryImageType::ImageDimension);
+        for (size_t d = 0; d < BinaryImageType::ImageDimension; ++d) {
+            io_region.SetIndex(d, slab_region.GetIndex()[d]);
+            io_region.SetSize(d, slab_region.GetSize()[d]);
+        }
+        writer->SetInput(slab);
+        writer->SetIORegion(io_region);
+        writer->Update();
+    }
+}
+
 BinaryImageType::Pointer
 resample_image_function(const BinaryImageType::Pointer &input,
-                         const double &shrink_factor,
-                         bool verbose) {
+                        const double &shrink_factor,
+                        bool verbose,
+                        const BinaryResampleRule &rule,
+                        const size_t &num_threads) {
     const auto spacing = input->GetSpacing();
     const auto size = input->GetLargestPossibleRegion().GetSize();
     auto output_spacing = spacing;
@@ -44,28 +475,7 @@ resample_image_function(const BinaryImageType::Pointer &input,
         std::cout << " Resampled Size: " << output_size << std::endl;
     }
 
-    using TransformType =
-            itk::IdentityTransform<double, BinaryImageType::ImageDimension>;
-    auto transform = TransformType::New();
-    transform->SetIdentity();
-    using InterpolatorType =
-            itk::NearestNeighborInterpolateImageFunction<BinaryImageType,
-                                                         double>;
-    auto interpolator = InterpolatorType::New();
-
-    using ResampleFilter =
-            itk::ResampleImageFilter<BinaryImageType, BinaryImageType>;
-    auto resampler = ResampleFilter::New();
-    resampler->SetInput(input);
-    resampler->SetTransform(transform);
-    resampler->SetInterpolator(interpolator);
-    resampler->SetDefaultPixelValue(0);
-    resampler->SetOutputOrigin(input->GetOrigin());
-    resampler->SetOutputSpacing(output_spacing);
-    resampler->SetOutputDirection(input->GetDirection());
-    resampler->SetSize(output_size);
-    resampler->Update();
-
-    return resampler->GetOutput();
+    return resample_binary_image(input, output_spacing, output_size, rule,
+                                 0.5, num_threads);
 }
 } // namespace SG
@@ -19,16 +19,24 @@
  * *******************************************************************/
 
 #include "segmentation_functions.hpp"
+#include "run_length_components.hpp"
 
 #include <itkBinaryThresholdImageFilter.h>
 #include <itkConnectedComponentImageFilter.h>
 #include <itkGeodesicActiveContourLevelSetImageFilter.h>
 #include <itkGradientMagnitudeRecursiveGaussianImageFilter.h>
+#include <itkImageFileReader.h>
+#include <itkMultiThreaderBase.h>
 #include <itkOtsuMultipleThresholdsImageFilter.h>
 #include <itkRelabelComponentImageFilter.h>
 #include <itkSigmoidImageFilter.h>
 #include <itkSignedMaurerDistanceMapImageFilter.h>
 
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <utility>
+
 namespace SG {
 
 void print_binarize_with_level_set_parameters(
@@ -49,13 +57,21 @@ void print_binarize_with_level_set_parameters(
     // uchar is a non-printable ASCII character, cast it before
     os << "binary_inside_value: "
        << static_cast<unsigned int>(self.binary_inside_value) << std::endl;
+    os << "use_narrow_band: " << self.use_narrow_band << std::endl;
+    os << "narrow_band_width: " << self.narrow_band_width << std::endl;
 }
 
 binarize_with_level_set_output binarize_with_level_set(
         const FloatImageType *input_float_image,
         const BinaryImageType *binary_image_safe,
         const binarize_with_level_set_parameters &input_parameters,
-        const bool save_intermediate_results) {
+        const bool save_intermediate_results,
+        const size_t num_threads) {
+    if (input_parameters.use_narrow_band) {
+        return binarize_with_level_set_narrow_band(
+                input_float_image, binary_image_safe, input_parameters,
+                save_intermediate_results, num_threads);
+    }
     binarize_with_level_set_output output_struct;
     // Returns the input parameters.
     // By default gradient_sigma is modified (depends on input image)
@@ -177,6 +193,336 @@ connected_components(const BinaryImageType *input_binary_image) {
     return output;
 }
 
+namespace {
+itk::MultiThreaderBase::Pointer create_threader(const size_t num_threads) {
+    auto threader = itk::MultiThreaderBase::New();
+    if (num_threads > 0) {
+        threader->SetMaximumNumberOfThreads(num_threads);
+        threader->SetNumberOfWorkUnits(num_threads);
+    }
+    return threader;
+}
+
+/**
+ * Write the label image directly from the runs, with labels sorted by size.
+ *
+ * @param reference_image provides the metadata of the label image
+ * @param region region of the label image
+ */
+ConnectedComponentsOutput
+connected_components_output_from_runs(
+        const RunLengthComponents &components,
+        const itk::ImageBase<3> *reference_image,
+        const BinaryImageType::RegionType &region,
+        const bool only_largest_component,
+        itk::MultiThreaderBase *threader) {
+    const size_t nx = components.nx;
+    const size_t ny = components.ny;
+    const size_t nz = components.nz;
+    const auto &runs = components.runs;
+    const auto &root = components.component;
+    const size_t num_runs = components.number_of_runs();
+
+    // Size of each component, and components sorted by size.
+    // Ties keep the raster order, like itk::RelabelComponentImageFilter.
+    std::vector<size_t> component_size(num_runs, 0);
+    std::vector<size_t> roots;
+    for (size_t i = 0; i < num_runs; ++i) {
+        component_size[root[i]] += runs[i].end - runs[i].begin;
+        if (root[i] == i) {
+            roots.push_back(i);
+        }
+    }
+    std::stable_sort(roots.begin(), roots.end(),
+                     [&component_size](const size_t a, const size_t b) {
+                         return component_size[a] > component_size[b];
+                     });
+    auto output = ConnectedComponentsOutput();
+    output.number_of_labels = roots.size();
+    output.size_of_labels.reserve(roots.size());
+    for (const auto &r : roots) {
+        output.size_of_labels.push_back(component_size[r]);
+    }
+    const size_t max_label =
+            std::numeric_limits<BinaryImageType::PixelType>::max();
+    if (!only_largest_component && roots.size() > max_label) {
+        throw std::runtime_error(
+                "Number of connected components (" +
+                std::to_string(roots.size()) +
+                ") greater than the maximum label of the output image (" +
+                std::to_string(max_label) +
+                "). Use only_largest_component, or a different threshold.");
+    }
+    // Reuse component_size to store the label of each root.
+    for (size_t label = 0; label < roots.size(); ++label) {
+        component_size[roots[label]] =
+                only_largest_component ? (label == 0 ? max_label : 0)
+                                       : label + 1;
+    }
+
+    output.label_image = BinaryImageType::New();
+    output.label_image->CopyInformation(reference_image);
+    output.label_image->SetRegions(region);
+    output.label_image->Allocate();
+    BinaryImagePixelType *buffer = output.label_image->GetBufferPointer();
+    threader->ParallelizeArray(
+            0, nz,
+            [&](itk::SizeValueType z) {
+                BinaryImagePixelType *plane = buffer + z * nx * ny;
+                std::fill(plane, plane + nx * ny, 0);
+                for (size_t y = 0; y < ny; ++y) {
+                    const size_t row = components.row(y, z);
+                    BinaryImagePixelType *pixels = plane + y * nx;
+                    for (size_t i = components.row_offsets[row];
+                         i < components.row_offsets[row + 1]; ++i) {
+                        std::fill(pixels + runs[i].begin, pixels + runs[i].end,
+                                  static_cast<BinaryImagePixelType>(
+                                          component_size[root[i]]));
+                    }
+                }
+            },
+            nullptr);
+    return output;
+}
+
+/**
+ * Label the pixels where is_in(offset) is true, and write the label image
+ * directly from the runs, with labels sorted by size.
+ */
+template <typename AnyImageType, typename TPredicate>
+ConnectedComponentsOutput
+connected_components_from_runs(const AnyImageType *any_input_image,
+                               TPredicate &&is_in,
+                               const bool fully_connected,
+                               const bool only_largest_component,
+                               itk::MultiThreaderBase *threader) {
+    const auto &region = any_input_image->GetBufferedRegion();
+    const auto components = label_run_length_components(
+            region.GetSize()[0], region.GetSize()[1], region.GetSize()[2],
+            is_in, fully_connected, threader);
+    return connected_components_output_from_runs(
+            components, any_input_image, region, only_largest_component,
+            threader);
+}
+
+/**
+ * Reader of input_filename, with the information of the image but without
+ * reading the pixels yet.
+ */
+template <typename AnyImageType>
+typename itk::ImageFileReader<AnyImageType>::Pointer
+create_slab_reader(const std::string &input_filename) {
+    auto reader = itk::ImageFileReader<AnyImageType>::New();
+    reader->SetFileName(input_filename);
+    reader->UpdateOutputInformation();
+    return reader;
+}
+
+/**
+ * Read the image in slabs of planes_per_slab z planes, calling
+ * process_slab(buffer, num_planes) for each slab in order, with buffer
+ * pointing to the first pixel of the slab.
+ *
+ * Only the requested slab is read if the ImageIO of the file supports
+ * streamed reading (MetaImage, VTK, ...). Otherwise the reader loads the
+ * whole image once, and the slabs are taken from it.
+ */
+template <typename AnyImageType, typename TProcessSlab>
+void for_each_slab(itk::ImageFileReader<AnyImageType> *reader,
+                   const size_t planes_per_slab,
+                   TProcessSlab &&process_slab) {
+    if (planes_per_slab == 0) {
+        throw std::runtime_error("planes_per_slab must be positive.");
+    }
+    auto image = reader->GetOutput();
+    const auto largest_region = image->GetLargestPossibleRegion();
+    const size_t nz = largest_region.GetSize()[2];
+    for (size_t z_begin = 0; z_begin < nz; z_begin += planes_per_slab) {
+        const size_t num_planes = std::min(planes_per_slab, nz - z_begin);
+        auto slab_region = largest_region;
+        slab_region.SetIndex(2, largest_region.GetIndex()[2] + z_begin);
+        slab_region.SetSize(2, num_planes);
+        if (!image->GetBufferedRegion().IsInside(slab_region)) {
+            image->SetRequestedRegion(slab_region);
+            reader->Update();
+        }
+        // Slabs span the whole x and y, so they are contiguous in the buffer.
+        process_slab(image->GetBufferPointer() +
+                             image->ComputeOffset(slab_region.GetIndex()),
+                     num_planes);
+    }
+}
+
+/**
+ * Label the pixels of the image read by reader for which is_in(value) is
+ * true, reading the image in slabs. Only the runs and one slab of the input
+ * are in memory before writing the label image.
+ */
+template <typename AnyImageType, typename TPredicate>
+ConnectedComponentsOutput connected_components_from_slabs(
+        typename itk::ImageFileReader<AnyImageType>::Pointer reader,
+        TPredicate &&is_in,
+        const bool fully_connected,
+        const bool only_largest_component,
+        const size_t planes_per_slab,
+        itk::MultiThreaderBase *threader) {
+    using PixelType = typename AnyImageType::PixelType;
+    const auto region = reader->GetOutput()->GetLargestPossibleRegion();
+    RunLengthComponentsBuilder builder(region.GetSize()[0], region.GetSize()[1],
+                                       region.GetSize()[2], fully_connected);
+    for_each_slab(reader.GetPointer(), planes_per_slab,
+                  [&](const PixelType *buffer, const size_t num_planes) {
+                      builder.add_planes(
+                              num_planes,
+                              [buffer, &is_in](const size_t offset) {
+                                  return is_in(buffer[offset]);
+                              },
+                              threader);
+                  });
+    const auto components = builder.finish();
+    // Keep the metadata, and release the last slab.
+    auto reference_image = BinaryImageType::New();
+    reference_image->CopyInformation(reader->GetOutput());
+    reader = nullptr;
+    return connected_components_output_from_runs(
+            components, reference_image.GetPointer(), region,
+            only_largest_component, threader);
+}
+} // namespace
+
+template <typename AnyImageType>
+ConnectedComponentsOutput connected_components_with_threshold(
+        const AnyImageType *any_input_image,
+        const typename AnyImageType::PixelType &lower_threshold,
+        const typename AnyImageType::PixelType &upper_threshold,
+        const bool fully_connected,
+        const bool only_largest_component,
+        const size_t num_threads) {
+    auto threader = create_threader(num_threads);
+    const auto *input_buffer = any_input_image->GetBufferPointer();
+    return connected_components_from_runs(
+            any_input_image,
+            [input_buffer, lower_threshold,
+             upper_threshold](const size_t offset) {
+                const auto &value = input_buffer[offset];
+                return lower_threshold <= value && value <= upper_threshold;
+            },
+            fully_connected, only_largest_component, threader.GetPointer());
+}
+
+template <typename AnyImageType>
+ConnectedComponentsOutput connected_components_with_percentage(
+        const AnyImageType *any_input_image,
+        const double percentage,
+        const bool fully_connected,
+        const bool only_largest_component,
+        const size_t num_threads) {
+    if (percentage < 0.0 || percentage > 1.0) {
+        throw std::runtime_error("percentage has to be in the range: [0.0, "
+                                 "1.0]. Actual value: " +
+                                 std::to_string(percentage));
+    }
+    using PixelType = typename AnyImageType::PixelType;
+    auto threader = create_threader(num_threads);
+    const auto &size = any_input_image->GetBufferedRegion().GetSize();
+    const size_t plane_pixels = size[0] * size[1];
+    const size_t nz = size[2];
+    const PixelType *input_buffer = any_input_image->GetBufferPointer();
+    if (plane_pixels * nz == 0) {
+        return connected_components_from_runs(
+                any_input_image, [](const size_t) { return false; },
+                fully_connected, only_largest_component, threader.GetPointer());
+    }
+    // min and max in one pass
+    std::vector<std::pair<PixelType, PixelType>> plane_min_max(nz);
+    threader->ParallelizeArray(
+            0, nz,
+            [&](itk::SizeValueType z) {
+                const auto min_max = std::minmax_element(
+                        input_buffer + z * plane_pixels,
+                        input_buffer + (z + 1) * plane_pixels);
+                plane_min_max[z] = {*min_max.first, *min_max.second};
+            },
+            nullptr);
+    PixelType min_value = plane_min_max[0].first;
+    PixelType max_value = plane_min_max[0].second;
+    for (const auto &min_max : plane_min_max) {
+        min_value = std::min(min_value, min_max.first);
+        max_value = std::max(max_value, min_max.second);
+    }
+    const double lower_threshold =
+            min_value + (max_value - min_value) * (1.0 - percentage);
+    return connected_components_from_runs(
+            any_input_image,
+            [input_buffer, lower_threshold](const size_t offset) {
+                return static_cast<double>(input_buffer[offset]) >=
+                       lower_threshold;
+            },
+            fully_connected, only_largest_component, threader.GetPointer());
+}
+
+template <typename AnyImageType>
+ConnectedComponentsOutput connected_components_with_threshold_from_file(
+        const std::string &input_filename,
+        const typename AnyImageType::PixelType &lower_threshold,
+        const typename AnyImageType::PixelType &upper_threshold,
+        const bool fully_connected,
+        const bool only_largest_component,
+        const size_t num_threads,
+        const size_t planes_per_slab) {
+    using PixelType = typename AnyImageType::PixelType;
+    auto threader = create_threader(num_threads);
+    return connected_components_from_slabs<AnyImageType>(
+            create_slab_reader<AnyImageType>(input_filename),
+            [lower_threshold, upper_threshold](const PixelType &value) {
+                return lower_threshold <= value && value <= upper_threshold;
+            },
+            fully_connected, only_largest_component, planes_per_slab,
+            threader.GetPointer());
+}
+
+template <typename AnyImageType>
+ConnectedComponentsOutput connected_components_with_percentage_from_file(
+        const std::string &input_filename,
+        const double percentage,
+        const bool fully_connected,
+        const bool only_largest_component,
+        const size_t num_threads,
+        const size_t planes_per_slab) {
+    if (percentage < 0.0 || percentage > 1.0) {
+        throw std::runtime_error("percentage has to be in the range: [0.0, "
+                                 "1.0]. Actual value: " +
+                                 std::to_string(percentage));
+    }
+    using PixelType = typename AnyImageType::PixelType;
+    auto threader = create_threader(num_threads);
+    auto reader = create_slab_reader<AnyImageType>(input_filename);
+    const auto size = reader->GetOutput()->GetLargestPossibleRegion().GetSize();
+    const size_t plane_pixels = size[0] * size[1];
+    // min and max in a first pass over the slabs
+    PixelType min_value = itk::NumericTraits<PixelType>::max();
+    PixelType max_value = itk::NumericTraits<PixelType>::NonpositiveMin();
+    for_each_slab(reader.GetPointer(), planes_per_slab,
+                  [&](const PixelType *buffer, const size_t num_planes) {
+                      if (plane_pixels == 0) {
+                          return;
+                      }
+                      const auto min_max = std::minmax_element(
+                              buffer, buffer + num_planes * plane_pixels);
+                      min_value = std::min(min_value, *min_max.first);
+                      max_value = std::max(max_value, *min_max.second);
+                  });
+    const double lower_threshold =
+            min_value + (max_value - min_value) * (1.0 - percentage);
+    return connected_components_from_slabs<AnyImageType>(
+            std::move(reader),
+            [lower_threshold](const PixelType &value) {
+                return static_cast<double>(value) >= lower_threshold;
+            },
+            fully_connected, only_largest_component, planes_per_slab,
+            threader.GetPointer());
+}
+
 BinaryImageType::Pointer
 extract_a_label(const BinaryImageType *input_label_image, const size_t &label) {
     if (label > 255) {
@@ -220,6 +566,72 @@ template BinaryImageType::Pointer
 binarize_with_percentage<FloatImageType>(const FloatImageType *any_input_image,
                                          const double percentage);
 
+// connected_components_with_threshold/percentage instantiations
+template ConnectedComponentsOutput
+connected_components_with_threshold<BinaryImageType>(
+        const BinaryImageType *any_input_image,
+        const BinaryImageType::PixelType &lower_threshold,
+        const BinaryImageType::PixelType &upper_threshold,
+        const bool fully_connected,
+        const bool only_largest_component,
+        const size_t num_threads);
+template ConnectedComponentsOutput
+connected_components_with_threshold<FloatImageType>(
+        const FloatImageType *any_input_image,
+        const FloatImageType::PixelType &lower_threshold,
+        const FloatImageType::PixelType &upper_threshold,
+        const bool fully_connected,
+        const bool only_largest_component,
+        const size_t num_threads);
+template ConnectedComponentsOutput
+connected_components_with_percentage<BinaryImageType>(
+        const BinaryImageType *any_input_image,
+        const double percentage,
+        const bool fully_connected,
+        const bool only_largest_component,
+        const size_t num_threads);
+template ConnectedComponentsOutput
+connected_components_with_percentage<FloatImageType>(
+        const FloatImageType *any_input_image,
+        const double percentage,
+        const bool fully_connected,
+        const bool only_largest_component,
+        const size_t num_threads);
+template ConnectedComponentsOutput
+connected_components_with_threshold_from_file<BinaryImageType>(
+        const std::string &input_filename,
+        const BinaryImageType::PixelType &lower_threshold,
+        const BinaryImageType::PixelType &upper_threshold,
+        const bool fully_connected,
+        const bool only_largest_component,
+        const size_t num_threads,
+        const size_t planes_per_slab);
+template ConnectedComponentsOutput
+connected_components_with_threshold_from_file<FloatImageType>(
+        const std::string &input_filename,
+        const FloatImageType::PixelType &lower_threshold,
+        const FloatImageType::PixelType &upper_threshold,
+        const bool fully_connected,
+        const bool only_largest_component,
+        const size_t num_threads,
+        const size_t planes_per_slab);
+template ConnectedComponentsOutput
+connected_components_with_percentage_from_file<BinaryImageType>(
+        const std::string &input_filename,
+        const double percentage,
+        const bool fully_connected,
+        const bool only_largest_component,
+        const size_t num_threads,
+        const size_t planes_per_slab);
+template ConnectedComponentsOutput
+connected_components_with_percentage_from_file<FloatImageType>(
+        const std::string &input_filename,
+        const double percentage,
+        const bool fully_connected,
+        const bool only_largest_component,
+        const size_t num_threads,
+        const size_t planes_per_slab);
+
 // binarize_with_region_growing instantiation for FloatImageType
 template BinaryImageType::Pointer binarize_with_region_growing<FloatImageType>(
         const FloatImageType *any_input_image,
@@ -19,9 +19,17 @@
  * *******************************************************************/
 
 #include "voxelize_graph.hpp"
+#include "transform_to_physical_point.hpp"
 
+#include <itkMultiThreaderBase.h>
+
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
 
 namespace SG {
 
@@ -97,6 +105,552 @@ voxelize_graph(const GraphType &graph,
     return voxelized_image;
 }
 
+namespace {
+using IndexType = BinaryImageType::IndexType;
+using ContinuousIndexType = ArrayUtilities::Array3D;
+
+/** Round as ITK does in TransformPhysicalPointToIndex */
+IndexType round_to_index(const ContinuousIndexType &continuous_index) {
+    IndexType index;
+    for (size_t i = 0; i < 3; ++i) {
+        index[i] = static_cast<IndexType::IndexValueType>(
+                std::floor(continuous_index[i] + 0.5));
+    }
+    return index;
+}
+
+/**
+ * A labeled shape to rasterize: a digital line segment (a single voxel if
+ * start == end), or a tube (capsule) with axis from p0 to p1 and radius
+ * linearly interpolated from r0 to r1 (a ball if p0 == p1).
+ * Only the geometry is stored, not the voxels.
+ */
+struct LabeledPrimitive {
+    enum class Kind { segment, tube };
+    Kind kind;
+    size_t label;
+    /** Segment, in index space */
+    IndexType start;
+    IndexType end;
+    /** Voxels of the segment that are not labeled (the nodes of the edge) */
+    bool has_excluded = false;
+    IndexType excluded[2];
+    /** Tube, in continuous index space */
+    ContinuousIndexType p0;
+    ContinuousIndexType p1;
+    double r0 = 0.0;
+    double r1 = 0.0;
+    /** Bounding box in index space, inclusive */
+    long lower[3];
+    long upper[3];
+};
+using LabeledPrimitives = std::vector<LabeledPrimitive>;
+
+/**
+ * Write the labels of primitives into a buffer of the region. The greatest
+ * label wins. Only the voxels with z in [z_begin, z_end) are written, so
+ * different threads can write different z slabs of the same buffer.
+ */
+struct LabelRasterizer {
+    explicit LabelRasterizer(const BinaryImageType::RegionType &region) {
+        for (size_t i = 0; i < 3; ++i) {
+            m_start[i] = region.GetIndex()[i];
+            m_size[i] = static_cast<long>(region.GetSize()[i]);
+        }
+    }
+    bool is_inside(const IndexType &index) const {
+        for (size_t i = 0; i < 3; ++i) {
+            const long local = index[i] - m_start[i];
+            if (local < 0 || local >= m_size[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+    size_t offset(const IndexType &index) const {
+        return static_cast<size_t>(
+                ((index[2] - m_start[2]) * m_size[1] + (index[1] - m_start[1])) *
+                        m_size[0] +
+                (index[0] - m_start[0]));
+    }
+    LabeledPrimitive make_segment(const IndexType &start,
+                                  const IndexType &end,
+                                  const size_t label) const {
+        LabeledPrimitive segment;
+        segment.kind = LabeledPrimitive::Kind::segment;
+        segment.label = label;
+        segment.start = start;
+        segment.end = end;
+        for (size_t i = 0; i < 3; ++i) {
+            segment.lower[i] = std::min(start[i], end[i]);
+            segment.upper[i] = std::max(start[i], end[i]);
+        }
+        return segment;
+    }
+    LabeledPrimitive make_tube(const ContinuousIndexType &p0,
+                               const ContinuousIndexType &p1,
+                               const double r0,
+                               const double r1,
+                               const size_t label) const {
+        LabeledPrimitive tube;
+        tube.kind = LabeledPrimitive::Kind::tube;
+        tube.label = label;
+        tube.p0 = p0;
+        tube.p1 = p1;
+        tube.r0 = r0;
+        tube.r1 = r1;
+        const double max_radius = std::max(r0, r1);
+        for (size_t i = 0; i < 3; ++i) {
+            tube.lower[i] = static_cast<long>(
+                    std::floor(std::min(p0[i], p1[i]) - max_radius));
+            tube.upper[i] = static_cast<long>(
+                    std::ceil(std::max(p0[i], p1[i]) + max_radius));
+        }
+        return tube;
+    }
+    /** Clip the bounding box to the region, false if nothing is left. */
+    bool clip(LabeledPrimitive &primitive) const {
+        for (size_t i = 0; i < 3; ++i) {
+            primitive.lower[i] = std::max(primitive.lower[i], m_start[i]);
+            primitive.upper[i] =
+                    std::min(primitive.upper[i], m_start[i] + m_size[i] - 1);
+            if (primitive.lower[i] > primitive.upper[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @param mask if not null, only voxels with a non-zero mask are written.
+     * @param first_labeled output, offsets of the voxels that were zero and
+     * got a non-zero label.
+     */
+    void write(const LabeledPrimitive &primitive,
+               const long z_begin,
+               const long z_end,
+               BinaryImagePixelType *buffer,
+               const BinaryImagePixelType *mask,
+               std::vector<size_t> &first_labeled) const {
+        const auto label = static_cast<BinaryImagePixelType>(primitive.label);
+        const auto write_voxel = [&](const size_t voxel_offset) {
+            if (mask && !mask[voxel_offset]) {
+                return;
+            }
+            auto &pixel = buffer[voxel_offset];
+            if (pixel == 0 && label != 0) {
+                first_labeled.push_back(voxel_offset);
+            }
+            pixel = std::max(pixel, label);
+        };
+        if (primitive.kind == LabeledPrimitive::Kind::segment) {
+            const auto voxels =
+                    detail::rasterize_segment(primitive.start, primitive.end);
+            for (const auto &voxel : voxels) {
+                if (voxel[2] < z_begin || voxel[2] >= z_end ||
+                    !is_inside(voxel)) {
+                    continue;
+                }
+                if (primitive.has_excluded &&
+                    (voxel == primitive.excluded[0] ||
+                     voxel == primitive.excluded[1])) {
+                    continue;
+                }
+                write_voxel(offset(voxel));
+            }
+            return;
+        }
+        const auto &p0 = primitive.p0;
+        const auto &r0 = primitive.r0;
+        const auto &r1 = primitive.r1;
+        const ContinuousIndexType axis = ArrayUtilities::minus(primitive.p1, p0);
+        const double axis_norm2 = ArrayUtilities::dot_product(axis, axis);
+        IndexType index;
+        const long z_first = std::max(primitive.lower[2], z_begin);
+        const long z_last = std::min(primitive.upper[2], z_end - 1);
+        for (index[2] = z_first; index[2] <= z_last; ++index[2]) {
+            for (index[1] = primitive.lower[1]; index[1] <= primitive.upper[1];
+                 ++index[1]) {
+                for (index[0] = primitive.lower[0];
+                     index[0] <= primitive.upper[0]; ++index[0]) {
+                    const ContinuousIndexType voxel = {
+                            static_cast<double>(index[0]),
+                            static_cast<double>(index[1]),
+                            static_cast<double>(index[2])};
+                    const ContinuousIndexType from_p0 =
+                            ArrayUtilities::minus(voxel, p0);
+                    double t = axis_norm2 > 0.0
+                                       ? ArrayUtilities::dot_product(from_p0,
+                                                                     axis) /
+                                                 axis_norm2
+                                       : 0.0;
+                    t = std::min(1.0, std::max(0.0, t));
+                    const ContinuousIndexType closest = ArrayUtilities::plus(
+                            p0, ArrayUtilities::product_scalar(axis, t));
+                    const ContinuousIndexType diff =
+                            ArrayUtilities::minus(voxel, closest);
+                    const double radius = r0 + t * (r1 - r0);
+                    if (ArrayUtilities::dot_product(diff, diff) <=
+                        radius * radius) {
+                        write_voxel(offset(index));
+                    }
+                }
+            }
+        }
+    }
+    long m_start[3];
+    long m_size[3];
+};
+
+/**
+ * Points of an edge (in continuous index space) from source to target,
+ * including them. The edge points might be stored from target to source,
+ * they are reversed in that case.
+ */
+std::vector<ContinuousIndexType> edge_polyline(
+        const GraphType &graph,
+        const GraphType::edge_descriptor &edge,
+        const std::function<ContinuousIndexType(const ArrayUtilities::Array3D &)>
+                &to_continuous_index) {
+    const auto source = boost::source(edge, graph);
+    const auto target = boost::target(edge, graph);
+    const auto &edge_points = graph[edge].edge_points;
+    std::vector<ContinuousIndexType> polyline;
+    polyline.reserve(edge_points.size() + 2);
+    polyline.push_back(to_continuous_index(graph[source].pos));
+    for (const auto &ep : edge_points) {
+        polyline.push_back(to_continuous_index(ep));
+    }
+    polyline.push_back(to_continuous_index(graph[target].pos));
+    if (edge_points.size() > 1) {
+        const auto &source_pos = graph[source].pos;
+        if (ArrayUtilities::distance(source_pos, edge_points.front()) >
+            ArrayUtilities::distance(source_pos, edge_points.back())) {
+            std::reverse(std::next(std::begin(polyline)),
+                         std::prev(std::end(polyline)));
+        }
+    }
+    return polyline;
+}
+} // namespace
+
+namespace detail {
+std::vector<BinaryImageType::IndexType>
+rasterize_segment(const BinaryImageType::IndexType &start,
+                  const BinaryImageType::IndexType &end) {
+    std::vector<BinaryImageType::IndexType> voxels;
+    long delta[3];
+    long step[3];
+    long max_delta = 0;
+    size_t driving_axis = 0;
+    for (size_t i = 0; i < 3; ++i) {
+        delta[i] = std::abs(end[i] - start[i]);
+        step[i] = end[i] >= start[i] ? 1 : -1;
+        if (delta[i] > max_delta) {
+            max_delta = delta[i];
+            driving_axis = i;
+        }
+    }
+    voxels.reserve(max_delta + 1);
+    BinaryImageType::IndexType current = start;
+    voxels.push_back(current);
+    // Bresenham errors of the two axes that are not the driving axis.
+    long error[3] = {0, 0, 0};
+    for (size_t i = 0; i < 3; ++i) {
+        error[i] = 2 * delta[i] - max_delta;
+    }
+    for (long n = 0; n < max_delta; ++n) {
+        current[driving_axis] += step[driving_axis];
+        for (size_t i = 0; i < 3; ++i) {
+            if (i == driving_axis) {
+                continue;
+            }
+            if (error[i] > 0) {
+                current[i] += step[i];
+                error[i] -= 2 * max_delta;
+            }
+            error[i] += 2 * delta[i];
+        }
+        voxels.push_back(current);
+    }
+    return voxels;
+}
+} // end namespace detail
+
+namespace detail {
+void rasterize_graph_labels(const GraphType &graph,
+                            const BinaryImageType::Pointer &output_image,
+                            const vertex_to_label_map_t &vertex_to_label_map,
+                            const edge_to_label_map_t &edge_to_label_map,
+                            const bool &graph_positions_are_in_physical_space,
+                            const bool &draw_segments,
+                            const VertexToRadiusMap &vertex_to_radius_map,
+                            const size_t &num_threads,
+                            bool &any_label_is_zero,
+                            const BinaryImagePixelType *mask,
+                            std::vector<size_t> *first_labeled_offsets) {
+    // Physical point to continuous index, computed once from the metadata
+    const AffineMatrixType physical_to_index = invert_affine(
+            index_to_physical_space_affine(output_image.GetPointer()));
+    const std::function<ContinuousIndexType(const ArrayUtilities::Array3D &)>
+            to_continuous_index =
+                    [&](const ArrayUtilities::Array3D &position) {
+                        return graph_positions_are_in_physical_space
+                                       ? apply_affine(physical_to_index,
+                                                      position)
+                                       : position;
+                    };
+    const auto &region = output_image->GetLargestPossibleRegion();
+    const LabelRasterizer rasterizer(region);
+    const bool use_radius = !vertex_to_radius_map.empty();
+    const auto get_radius = [&vertex_to_radius_map](
+                                    const GraphType::vertex_descriptor &v) {
+        const auto found = vertex_to_radius_map.find(v);
+        return found == vertex_to_radius_map.cend() ? 0.0 : found->second;
+    };
+
+    // Labels are written as BinaryImagePixelType, do not truncate them.
+    const size_t max_label = std::numeric_limits<BinaryImagePixelType>::max();
+    const auto check_label = [&max_label](const size_t &label) {
+        if (label > max_label) {
+            throw std::runtime_error(
+                    "rasterize_graph_labels: label " + std::to_string(label) +
+                    " does not fit in the label image, the maximum is " +
+                    std::to_string(max_label) + ".");
+        }
+    };
+
+    // Gather the work: labeled vertices and labeled edges.
+    std::vector<std::pair<GraphType::vertex_descriptor, size_t>>
+            labeled_vertices;
+    std::vector<std::pair<GraphType::edge_descriptor, size_t>> labeled_edges;
+    any_label_is_zero = false;
+    GraphType::vertex_iterator vi, vi_end;
+    std::tie(vi, vi_end) = boost::vertices(graph);
+    for (; vi != vi_end; ++vi) {
+        const auto find_node_label = vertex_to_label_map.find(*vi);
+        if (find_node_label != vertex_to_label_map.cend()) {
+            any_label_is_zero |= find_node_label->second == 0;
+            check_label(find_node_label->second);
+            labeled_vertices.emplace_back(*vi, find_node_label->second);
+        }
+    }
+    GraphType::edge_iterator ei, ei_end;
+    std::tie(ei, ei_end) = boost::edges(graph);
+    for (; ei != ei_end; ++ei) {
+        const auto find_edge_label = edge_to_label_map.find(*ei);
+        if (find_edge_label != edge_to_label_map.cend()) {
+            any_label_is_zero |= find_edge_label->second == 0;
+            check_label(find_edge_label->second);
+            labeled_edges.emplace_back(*ei, find_edge_label->second);
+        }
+    }
+
+    const auto add_primitive = [&rasterizer](LabeledPrimitive &&primitive,
+                                             LabeledPrimitives &output) {
+        if (rasterizer.clip(primitive)) {
+            output.push_back(std::move(primitive));
+        }
+    };
+    const auto add_voxel = [&](const IndexType &index, const size_t label,
+                               LabeledPrimitives &output) {
+        add_primitive(rasterizer.make_segment(index, index, label), output);
+    };
+
+    const auto rasterize_vertex =
+            [&](const std::pair<GraphType::vertex_descriptor, size_t>
+                        &vertex_label,
+                LabeledPrimitives &output) {
+                const auto center =
+                        to_continuous_index(graph[vertex_label.first].pos);
+                if (use_radius) {
+                    const double radius = get_radius(vertex_label.first);
+                    add_primitive(rasterizer.make_tube(center, center, radius,
+                                                       radius,
+                                                       vertex_label.second),
+                                  output);
+                }
+                add_voxel(round_to_index(center), vertex_label.second, output);
+            };
+
+    const auto rasterize_edge =
+            [&](const std::pair<GraphType::edge_descriptor, size_t>
+                        &edge_label,
+                LabeledPrimitives &output) {
+                const auto &edge = edge_label.first;
+                const auto &label = edge_label.second;
+                if (!draw_segments && !use_radius) {
+                    // Only the edge points, as in voxelize_graph
+                    for (const auto &ep : graph[edge].edge_points) {
+                        add_voxel(round_to_index(to_continuous_index(ep)),
+                                  label, output);
+                    }
+                    return;
+                }
+                const auto polyline =
+                        edge_polyline(graph, edge, to_continuous_index);
+                if (use_radius) {
+                    // Radius interpolated with the arc length of the edge.
+                    const double source_radius =
+                            get_radius(boost::source(edge, graph));
+                    const double target_radius =
+                            get_radius(boost::target(edge, graph));
+                    std::vector<double> arc_length(polyline.size(), 0.0);
+                    for (size_t i = 1; i < polyline.size(); ++i) {
+                        arc_length[i] = arc_length[i - 1] +
+                                        ArrayUtilities::distance(
+                                                polyline[i - 1], polyline[i]);
+                    }
+                    const double total_length = arc_length.back();
+                    const auto radius_at = [&](const size_t i) {
+                        return total_length > 0.0
+                                       ? source_radius +
+                                                 (target_radius -
+                                                  source_radius) *
+                                                         arc_length[i] /
+                                                         total_length
+                                       : source_radius;
+                    };
+                    for (size_t i = 1; i < polyline.size(); ++i) {
+                        add_primitive(rasterizer.make_tube(
+                                              polyline[i - 1], polyline[i],
+                                              radius_at(i - 1), radius_at(i),
+                                              label),
+                                      output);
+                    }
+                }
+                if (draw_segments) {
+                    // The voxels of source and target nodes keep their label.
+                    const auto source_index = round_to_index(polyline.front());
+                    const auto target_index = round_to_index(polyline.back());
+                    for (size_t i = 1; i < polyline.size(); ++i) {
+                        auto segment = rasterizer.make_segment(
+                                round_to_index(polyline[i - 1]),
+                                round_to_index(polyline[i]), label);
+                        segment.has_excluded = true;
+                        segment.excluded[0] = source_index;
+                        segment.excluded[1] = target_index;
+                        add_primitive(std::move(segment), output);
+                    }
+                }
+            };
+
+    const size_t num_items = labeled_vertices.size() + labeled_edges.size();
+    if (num_items == 0) {
+        return;
+    }
+    auto threader = itk::MultiThreaderBase::New();
+    if (num_threads > 0) {
+        threader->SetMaximumNumberOfThreads(num_threads);
+        threader->SetNumberOfWorkUnits(num_threads);
+    }
+    // Primitives of the nodes and edges, in parallel chunks.
+    const size_t num_chunks = std::min<size_t>(
+            num_items, 4 * threader->GetNumberOfWorkUnits());
+    const size_t chunk_size = (num_items + num_chunks - 1) / num_chunks;
+    std::vector<LabeledPrimitives> chunk_primitives(num_chunks);
+    threader->ParallelizeArray(
+            0, num_chunks,
+            [&](itk::SizeValueType chunk) {
+                const size_t begin = std::min(chunk * chunk_size, num_items);
+                const size_t end = std::min(begin + chunk_size, num_items);
+                auto &output = chunk_primitives[chunk];
+                for (size_t item = begin; item < end; ++item) {
+                    if (item < labeled_vertices.size()) {
+                        rasterize_vertex(labeled_vertices[item], output);
+                    } else {
+                        rasterize_edge(
+                                labeled_edges[item - labeled_vertices.size()],
+                                output);
+                    }
+                }
+            },
+            nullptr);
+
+    // Slabs along z, each slab is written by only one work unit.
+    const long start_z = rasterizer.m_start[2];
+    const long size_z = rasterizer.m_size[2];
+    const size_t num_slabs = std::min<size_t>(
+            size_z, 4 * threader->GetNumberOfWorkUnits());
+    if (num_slabs == 0) {
+        return;
+    }
+    const long slab_depth = (size_z + num_slabs - 1) / num_slabs;
+    using PrimitiveReference = std::pair<size_t, size_t>; // (chunk, index)
+    std::vector<std::vector<PrimitiveReference>> slab_primitives(num_slabs);
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+        const auto &primitives = chunk_primitives[chunk];
+        for (size_t p = 0; p < primitives.size(); ++p) {
+            const size_t first_slab =
+                    (primitives[p].lower[2] - start_z) / slab_depth;
+            const size_t last_slab =
+                    (primitives[p].upper[2] - start_z) / slab_depth;
+            for (size_t s = first_slab; s <= last_slab; ++s) {
+                slab_primitives[s].emplace_back(chunk, p);
+            }
+        }
+    }
+
+    BinaryImagePixelType *buffer = output_image->GetBufferPointer();
+    std::vector<std::vector<size_t>> slab_first_labeled(num_slabs);
+    threader->ParallelizeArray(
+            0, num_slabs,
+            [&](itk::SizeValueType slab) {
+                const long slab_begin = start_z + slab * slab_depth;
+                const long slab_end =
+                        std::min(slab_begin + slab_depth, start_z + size_z);
+                for (const auto &reference : slab_primitives[slab]) {
+                    rasterizer.write(
+                            chunk_primitives[reference.first][reference.second],
+                            slab_begin, slab_end, buffer, mask,
+                            slab_first_labeled[slab]);
+                }
+            },
+            nullptr);
+
+    if (first_labeled_offsets) {
+        for (const auto &offsets : slab_first_labeled) {
+            first_labeled_offsets->insert(first_labeled_offsets->end(),
+                                          offsets.begin(), offsets.end());
+        }
+    }
+}
+} // end namespace detail
+
+BinaryImageType::Pointer voxelize_graph_rasterized(
+        const GraphType &graph,
+        const BinaryImageType::Pointer &reference_image,
+        const vertex_to_label_map_t &vertex_to_label_map,
+        const edge_to_label_map_t &edge_to_label_map,
+        const bool &graph_positions_are_in_physical_space,
+        const bool &draw_segments,
+        const VertexToRadiusMap &vertex_to_radius_map,
+        const size_t &num_threads) {
+    BinaryImageType::Pointer voxelized_image = BinaryImageType::New();
+    // Create empty image with same parameters than reference_image
+    voxelized_image->SetRegions(reference_image->GetLargestPossibleRegion());
+    voxelized_image->SetSpacing(reference_image->GetSpacing());
+    voxelized_image->SetOrigin(reference_image->GetOrigin());
+    voxelized_image->SetDirection(reference_image->GetDirection());
+    voxelized_image->Allocate();
+    voxelized_image->FillBuffer(0);
+
+    bool any_label_is_zero = false;
+    detail::rasterize_graph_labels(
+            graph, voxelized_image, vertex_to_label_map, edge_to_label_map,
+            graph_positions_are_in_physical_space, draw_segments,
+            vertex_to_radius_map, num_threads, any_label_is_zero);
+
+    if (any_label_is_zero) {
+        std::cerr << "Warning in voxelize_graph_rasterized: the maps have one "
+                     "or more labels equal to zero, these will be lost in the "
+                     "background of the image. Ignore this warning if expected."
+                  << std::endl;
+    }
+
+    return voxelized_image;
+}
+
 edge_to_label_map_t create_edge_to_label_map_from_vertex_to_label_map(
         const GraphType &graph,
         const vertex_to_label_map_t &vertex_to_label_map,
@@ -0,0 +1,93 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+#include "distance_sampler.hpp"
+
+#include <itkImageFileReader.h>
+#include <itkImageRegionConstIteratorWithIndex.h>
+
+#include "sgext_fixture_images.hpp"
+#include "gmock/gmock.h"
+
+struct DistanceSamplerFixture : public ::testing::Test {
+    SG::BinaryImageType::Pointer binary_image;
+    SG::FloatImageType::Pointer dmap_image;
+    void SetUp() override {
+        const std::string image_name_stem("bX3D_white");
+        const std::string filename =
+                SG::sgext_fixture_images_path + "/" + image_name_stem + ".nrrd";
+        using ReaderType = itk::ImageFileReader<SG::BinaryImageType>;
+        auto reader = ReaderType::New();
+        reader->SetFileName(filename);
+        reader->Update();
+        binary_image = reader->GetOutput();
+
+        // Distance map computed with DGtal (create_distance_map_function)
+        const std::string dmap_filename = SG::sgext_fixture_images_path + "/" +
+                                          image_name_stem + "_DMAP.nrrd";
+        using DistanceMapReaderType =
+                itk::ImageFileReader<SG::FloatImageType>;
+        auto dmap_reader = DistanceMapReaderType::New();
+        dmap_reader->SetFileName(dmap_filename);
+        dmap_reader->Update();
+        dmap_image = dmap_reader->GetOutput();
+    }
+};
+
+TEST_F(DistanceSamplerFixture, matches_distance_map_image) {
+    SG::DistanceSampler sampler(binary_image);
+    using IteratorType =
+            itk::ImageRegionConstIteratorWithIndex<SG::FloatImageType>;
+    IteratorType it(dmap_image, dmap_image->GetLargestPossibleRegion());
+    size_t foreground_voxels = 0;
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it) {
+        const auto &index = it.GetIndex();
+        EXPECT_FLOAT_EQ(sampler.GetPixel(index), it.Get())
+                << "index: " << index;
+        if (sampler.is_foreground(index)) {
+            ++foreground_voxels;
+        }
+    }
+    EXPECT_GT(foreground_voxels, 0);
+    // Only foreground voxels are stored in the cache.
+    EXPECT_LE(sampler.cache_size(),
+              dmap_image->GetLargestPossibleRegion().GetNumberOfPixels());
+}
+
+TEST_F(DistanceSamplerFixture, lazy_and_cached) {
+    SG::DistanceSampler sampler(binary_image);
+    EXPECT_EQ(sampler.cache_size(), 0);
+    SG::BinaryImageType::IndexType index;
+    index[0] = 25;
+    index[1] = 25;
+    index[2] = 4;
+    const auto first = sampler.GetPixel(index);
+    EXPECT_EQ(sampler.cache_size(), 1);
+    EXPECT_FLOAT_EQ(sampler.GetPixel(index), first);
+    EXPECT_EQ(sampler.cache_size(), 1);
+    sampler.clear_cache();
+    EXPECT_EQ(sampler.cache_size(), 0);
+    // Outside of the image
+    index[0] = -1;
+    EXPECT_FLOAT_EQ(sampler.GetPixel(index), 0.0);
+    // Occupancy grid uses one bit per voxel
+    EXPECT_LT(sampler.occupancy_grid_bytes(),
+              binary_image->GetLargestPossibleRegion().GetNumberOfPixels());
+}
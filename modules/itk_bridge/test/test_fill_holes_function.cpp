@@ -0,0 +1,159 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+#include "fill_holes_function.hpp"
+
+#include "gmock/gmock.h"
+
+#include <random>
+
+struct HollowCubeFixture : public ::testing::Test {
+    using IndexType = SG::BinaryImageType::IndexType;
+    SG::BinaryImageType::Pointer image = SG::BinaryImageType::New();
+    const unsigned char foreground = 255;
+
+    void SetUp() override {
+        SG::BinaryImageType::RegionType region;
+        IndexType start;
+        start.Fill(0);
+        SG::BinaryImageType::SizeType size;
+        size[0] = 20;
+        size[1] = 15;
+        size[2] = 12;
+        region.SetIndex(start);
+        region.SetSize(size);
+        image->SetRegions(region);
+        image->Allocate();
+        image->FillBuffer(0);
+        // Hollow cube: walls at [2, 10], cavity [3, 9]
+        for (long z = 2; z <= 10; ++z) {
+            for (long y = 2; y <= 10; ++y) {
+                for (long x = 2; x <= 10; ++x) {
+                    const bool is_wall = x == 2 || x == 10 || y == 2 ||
+                                         y == 10 || z == 2 || z == 10;
+                    set(x, y, z, is_wall ? foreground : 0);
+                }
+            }
+        }
+    }
+    void set(long x, long y, long z, unsigned char value) {
+        IndexType index;
+        index[0] = x;
+        index[1] = y;
+        index[2] = z;
+        image->SetPixel(index, value);
+    }
+    static unsigned char get(const SG::BinaryImageType::Pointer &img,
+                             long x,
+                             long y,
+                             long z) {
+        IndexType index;
+        index[0] = x;
+        index[1] = y;
+        index[2] = z;
+        return img->GetPixel(index);
+    }
+};
+
+TEST_F(HollowCubeFixture, cavities_are_filled) {
+    const auto filled = SG::fill_holes_cavities_function(image);
+    EXPECT_EQ(get(filled, 6, 6, 6), foreground);
+    EXPECT_EQ(get(filled, 3, 3, 3), foreground);
+    // Outside is not modified
+    EXPECT_EQ(get(filled, 0, 0, 0), 0);
+    EXPECT_EQ(get(filled, 15, 6, 6), 0);
+    // Input is not modified
+    EXPECT_EQ(get(image, 6, 6, 6), 0);
+}
+
+TEST_F(HollowCubeFixture, cavities_open_to_the_border_are_not_filled) {
+    // Tunnel from the cavity to the border
+    for (long x = 10; x < 20; ++x) {
+        set(x, 6, 6, 0);
+    }
+    const auto filled = SG::fill_holes_cavities_function(image);
+    EXPECT_EQ(get(filled, 6, 6, 6), 0);
+}
+
+TEST_F(HollowCubeFixture, cavities_connectivity) {
+    // Remove the corner of the wall: the cavity voxel (9, 9, 9) touches
+    // the outside only through a vertex.
+    set(10, 10, 10, 0);
+    const bool fully_connected = true;
+    const auto filled_face =
+            SG::fill_holes_cavities_function(image, !fully_connected);
+    EXPECT_EQ(get(filled_face, 6, 6, 6), foreground);
+    EXPECT_EQ(get(filled_face, 10, 10, 10), 0);
+    const auto filled_full =
+            SG::fill_holes_cavities_function(image, fully_connected);
+    EXPECT_EQ(get(filled_full, 6, 6, 6), 0);
+}
+
+TEST(fill_holes_voting_front, same_result_than_voting_iterative) {
+    using IndexType = SG::BinaryImageType::IndexType;
+    auto image = SG::BinaryImageType::New();
+    SG::BinaryImageType::RegionType region;
+    IndexType start;
+    start.Fill(0);
+    SG::BinaryImageType::SizeType size;
+    size[0] = 24;
+    size[1] = 20;
+    size[2] = 16;
+    region.SetIndex(start);
+    region.SetSize(size);
+    image->SetRegions(region);
+    image->Allocate();
+    image->FillBuffer(0);
+    // Noisy ball
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+    IndexType index;
+    for (long z = 0; z < 16; ++z) {
+        for (long y = 0; y < 20; ++y) {
+            for (long x = 0; x < 24; ++x) {
+                const double r2 = (x - 12) * (x - 12) + (y - 10) * (y - 10) +
+                                  (z - 8) * (z - 8);
+                index[0] = x;
+                index[1] = y;
+                index[2] = z;
+                if (r2 < 49 && dist(gen) > 0.3) {
+                    image->SetPixel(index, 255);
+                }
+            }
+        }
+    }
+    for (const int radius : {1, 2}) {
+        for (const int majority : {1, 3}) {
+            const size_t iterations = 1000;
+            const auto expected = SG::fill_holes_voting_iterative_function(
+                    image, radius, majority, iterations);
+            const auto result = SG::fill_holes_voting_front_function(
+                    image, radius, majority, iterations);
+            const size_t num_pixels = region.GetNumberOfPixels();
+            size_t differences = 0;
+            for (size_t i = 0; i < num_pixels; ++i) {
+                differences += expected->GetBufferPointer()[i] !=
+                               result->GetBufferPointer()[i];
+            }
+            EXPECT_EQ(differences, 0)
+                    << "radius: " << radius << ", majority: " << majority;
+        }
+    }
+}
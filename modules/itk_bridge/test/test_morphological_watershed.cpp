@@ -0,0 +1,123 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+
+#include "morphological_watershed.hpp"
+
+#include "gmock/gmock.h"
+
+struct GeodesicLabelPropagationFromGraphFixture : public ::testing::Test {
+    SG::BinaryImageType::Pointer binary_image;
+    SG::GraphType graph;
+    SG::vertex_to_label_map_t vertex_to_label_map;
+    SG::edge_to_label_map_t edge_to_label_map;
+    void SetUp() override {
+        // A bar along x, y = [4, 5], z = 2, and an isolated voxel.
+        binary_image = SG::BinaryImageType::New();
+        SG::BinaryImageType::SizeType size;
+        size[0] = 20;
+        size[1] = 10;
+        size[2] = 5;
+        binary_image->SetRegions(size);
+        binary_image->Allocate();
+        binary_image->FillBuffer(0);
+        SG::BinaryImageType::IndexType index;
+        index[2] = 2;
+        for (index[0] = 2; index[0] < 18; ++index[0]) {
+            for (index[1] = 4; index[1] < 6; ++index[1]) {
+                binary_image->SetPixel(index, 255);
+            }
+        }
+        index[0] = 2;
+        index[1] = 8;
+        binary_image->SetPixel(index, 255);
+        // Nodes at both ends of the bar, and one outside the foreground.
+        graph = SG::GraphType(3);
+        graph[0].pos = {{2, 4, 2}};
+        graph[1].pos = {{17, 4, 2}};
+        graph[2].pos = {{10, 0, 0}};
+        vertex_to_label_map = {{0, 1}, {1, 2}, {2, 3}};
+    }
+};
+
+TEST_F(GeodesicLabelPropagationFromGraphFixture, closest_seed_wins) {
+    const bool graph_positions_are_in_physical_space = false;
+    const auto output = SG::geodesic_label_propagation_from_graph(
+            binary_image, graph, vertex_to_label_map, edge_to_label_map,
+            graph_positions_are_in_physical_space);
+    SG::BinaryImageType::IndexType index;
+    index[1] = 5;
+    index[2] = 2;
+    for (index[0] = 2; index[0] < 18; ++index[0]) {
+        EXPECT_EQ(output->GetPixel(index), index[0] < 10 ? 1 : 2)
+                << "x = " << index[0];
+    }
+    // Seeds outside the foreground are ignored.
+    index[0] = 10;
+    index[1] = 0;
+    index[2] = 0;
+    EXPECT_EQ(output->GetPixel(index), 0);
+    // Components without seeds are not labeled.
+    index[0] = 2;
+    index[1] = 8;
+    index[2] = 2;
+    EXPECT_EQ(output->GetPixel(index), 0);
+}
+
+TEST_F(GeodesicLabelPropagationFromGraphFixture, same_result_any_num_threads) {
+    // Edge with label 4 along the bar, it reaches all the bar in one step.
+    SG::SpatialEdge se;
+    se.edge_points = {{{8, 4, 2}}, {{12, 4, 2}}};
+    const auto edge = boost::add_edge(0, 1, se, graph);
+    edge_to_label_map = {{edge.first, 4}};
+    const bool graph_positions_are_in_physical_space = false;
+    const bool draw_segments = true;
+    const auto output = SG::geodesic_label_propagation_from_graph(
+            binary_image, graph, vertex_to_label_map, edge_to_label_map,
+            graph_positions_are_in_physical_space, draw_segments, 1);
+    const auto output_threaded = SG::geodesic_label_propagation_from_graph(
+            binary_image, graph, vertex_to_label_map, edge_to_label_map,
+            graph_positions_are_in_physical_space, draw_segments, 4);
+    const auto &region = binary_image->GetLargestPossibleRegion();
+    const size_t num_pixels = region.GetNumberOfPixels();
+    size_t num_labeled_with_edge = 0;
+    for (size_t i = 0; i < num_pixels; ++i) {
+        EXPECT_EQ(output->GetBufferPointer()[i],
+                  output_threaded->GetBufferPointer()[i]);
+        num_labeled_with_edge += output->GetBufferPointer()[i] == 4;
+    }
+    // The edge label wins the ties with the nodes (greatest label).
+    EXPECT_GT(num_labeled_with_edge, 0);
+    SG::BinaryImageType::IndexType index;
+    index[0] = 10;
+    index[1] = 5;
+    index[2] = 2;
+    EXPECT_EQ(output->GetPixel(index), 4);
+}
+
+TEST_F(GeodesicLabelPropagationFromGraphFixture, throws_if_label_does_not_fit) {
+    vertex_to_label_map[1] = 256;
+    const bool graph_positions_are_in_physical_space = false;
+    EXPECT_THROW(SG::geodesic_label_propagation_from_graph(
+                         binary_image, graph, vertex_to_label_map,
+                         edge_to_label_map,
+                         graph_positions_are_in_physical_space),
+                 std::runtime_error);
+}
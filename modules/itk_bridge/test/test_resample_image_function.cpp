@@ -0,0 +1,213 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+
+#include "resample_image_function.hpp"
+
+#include <itkIdentityTransform.h>
+#include <itkImageFileReader.h>
+#include <itkNearestNeighborInterpolateImageFunction.h>
+#include <itkResampleImageFilter.h>
+
+#include "gmock/gmock.h"
+
+namespace {
+/** Anisotropic image with a few blobs and a thin line along x. */
+SG::BinaryImageType::Pointer create_test_image() {
+    auto image = SG::BinaryImageType::New();
+    SG::BinaryImageType::SizeType size;
+    size[0] = 23;
+    size[1] = 17;
+    size[2] = 11;
+    image->SetRegions(size);
+    SG::BinaryImageType::SpacingType spacing;
+    spacing[0] = 0.5;
+    spacing[1] = 0.5;
+    spacing[2] = 1.25;
+    image->SetSpacing(spacing);
+    image->Allocate();
+    image->FillBuffer(0);
+    SG::BinaryImageType::IndexType index;
+    for (index[2] = 0; index[2] < 11; ++index[2]) {
+        for (index[1] = 0; index[1] < 17; ++index[1]) {
+            for (index[0] = 0; index[0] < 23; ++index[0]) {
+                const long dx = index[0] - 6;
+                const long dy = index[1] - 5;
+                const long dz = index[2] - 4;
+                if (dx * dx + dy * dy + 4 * dz * dz < 20 ||
+                    (index[0] > 14 && index[1] > 10 && index[2] > 6)) {
+                    image->SetPixel(index, 255);
+                }
+            }
+        }
+    }
+    index[1] = 13;
+    index[2] = 3;
+    for (index[0] = 0; index[0] < 23; ++index[0]) {
+        image->SetPixel(index, 255);
+    }
+    return image;
+}
+
+SG::BinaryImageType::Pointer
+itk_resample_nearest(const SG::BinaryImageType::Pointer &input,
+                     const SG::BinaryImageType::SpacingType &output_spacing,
+                     const SG::BinaryImageType::SizeType &output_size) {
+    using ResampleFilter =
+            itk::ResampleImageFilter<SG::BinaryImageType, SG::BinaryImageType>;
+    auto resampler = ResampleFilter::New();
+    resampler->SetInput(input);
+    resampler->SetTransform(
+            itk::IdentityTransform<double, 3>::New().GetPointer());
+    resampler->SetInterpolator(
+            itk::NearestNeighborInterpolateImageFunction<SG::BinaryImageType,
+                                                         double>::New());
+    resampler->SetDefaultPixelValue(0);
+    resampler->SetOutputOrigin(input->GetOrigin());
+    resampler->SetOutputSpacing(output_spacing);
+    resampler->SetOutputDirection(input->GetDirection());
+    resampler->SetSize(output_size);
+    resampler->Update();
+    return resampler->GetOutput();
+}
+
+size_t count_foreground(const SG::BinaryImageType::Pointer &image) {
+    const size_t num_pixels =
+            image->GetLargestPossibleRegion().GetNumberOfPixels();
+    return std::count_if(image->GetBufferPointer(),
+                         image->GetBufferPointer() + num_pixels,
+                         [](const auto &pixel) { return pixel > 0; });
+}
+} // namespace
+
+TEST(resample_binary_image, nearest_neighbor_same_result_than_itk) {
+    const auto input = create_test_image();
+    for (const double shrink_factor : {0.5, 1.0, 2.0, 2.5}) {
+        auto output_spacing = input->GetSpacing();
+        auto output_size = input->GetLargestPossibleRegion().GetSize();
+        for (size_t d = 0; d < 3; ++d) {
+            output_spacing[d] *= shrink_factor;
+            output_size[d] = static_cast<size_t>(output_size[d] / shrink_factor);
+        }
+        const auto expected =
+                itk_resample_nearest(input, output_spacing, output_size);
+        const auto output =
+                SG::resample_binary_image(input, output_spacing, output_size);
+        const size_t num_pixels =
+                output->GetLargestPossibleRegion().GetNumberOfPixels();
+        ASSERT_EQ(num_pixels,
+                  expected->GetLargestPossibleRegion().GetNumberOfPixels());
+        for (size_t i = 0; i < num_pixels; ++i) {
+            ASSERT_EQ(output->GetBufferPointer()[i],
+                      expected->GetBufferPointer()[i])
+                    << "shrink_factor: " << shrink_factor << ", i: " << i;
+        }
+    }
+}
+
+TEST(resample_binary_image, make_isotropic) {
+    const auto input = create_test_image();
+    const auto output = SG::make_isotropic<SG::BinaryImageType>(input);
+    auto expected_spacing = input->GetSpacing();
+    expected_spacing[2] = 0.5;
+    auto expected_size = input->GetLargestPossibleRegion().GetSize();
+    expected_size[2] = 27;
+    const auto expected =
+            itk_resample_nearest(input, expected_spacing, expected_size);
+    EXPECT_EQ(output->GetSpacing(), expected_spacing);
+    EXPECT_EQ(output->GetLargestPossibleRegion().GetSize(), expected_size);
+    EXPECT_EQ(count_foreground(output), count_foreground(expected));
+}
+
+TEST(resample_binary_image, partial_volume_keeps_thin_structures) {
+    const auto input = create_test_image();
+    auto output_spacing = input->GetSpacing();
+    auto output_size = input->GetLargestPossibleRegion().GetSize();
+    for (size_t d = 0; d < 3; ++d) {
+        output_spacing[d] *= 2;
+        output_size[d] /= 2;
+    }
+    // The thin line (y = 13, z = 3) is lost by nearest_neighbor.
+    const auto nearest =
+            SG::resample_binary_image(input, output_spacing, output_size);
+    SG::BinaryImageType::IndexType index;
+    index[0] = 1;
+    index[1] = 7;
+    index[2] = 2;
+    EXPECT_EQ(nearest->GetPixel(index), 0);
+    // A sixteenth of the volume of this output voxel is covered by the line.
+    const double threshold = 0.05;
+    const auto partial_volume = SG::resample_binary_image(
+            input, output_spacing, output_size,
+            SG::BinaryResampleRule::partial_volume, threshold);
+    EXPECT_EQ(partial_volume->GetPixel(index), 255);
+    const auto partial_volume_threaded = SG::resample_binary_image(
+            input, output_spacing, output_size,
+            SG::BinaryResampleRule::partial_volume, threshold, 1);
+    const size_t num_pixels =
+            partial_volume->GetLargestPossibleRegion().GetNumberOfPixels();
+    for (size_t i = 0; i < num_pixels; ++i) {
+        ASSERT_EQ(partial_volume->GetBufferPointer()[i],
+                  partial_volume_threaded->GetBufferPointer()[i]);
+    }
+    // With the default threshold, the line is removed.
+    const auto partial_volume_half = SG::resample_binary_image(
+            input, output_spacing, output_size,
+            SG::BinaryResampleRule::partial_volume);
+    EXPECT_EQ(partial_volume_half->GetPixel(index), 0);
+}
+
+TEST(resample_binary_image, to_file_in_slabs) {
+    const auto input = create_test_image();
+    auto output_spacing = input->GetSpacing();
+    auto output_size = input->GetLargestPossibleRegion().GetSize();
+    for (size_t d = 0; d < 3; ++d) {
+        output_spacing[d] *= 0.8;
+        output_size[d] = static_cast<size_t>(output_size[d] / 0.8);
+    }
+    const auto expected = SG::resample_binary_image(
+            input, output_spacing, output_size,
+            SG::BinaryResampleRule::partial_volume);
+    const std::string file_name = "./resample_binary_image_to_file.mha";
+    // Slabs of 4 planes, the last one is not complete.
+    const size_t planes_per_slab = 4;
+    SG::resample_binary_image_to_file(input, output_spacing, output_size,
+                                      file_name,
+                                      SG::BinaryResampleRule::partial_volume,
+                                      0.5, 0, planes_per_slab);
+    auto reader = itk::ImageFileReader<SG::BinaryImageType>::New();
+    reader->SetFileName(file_name);
+    reader->Update();
+    const auto output = reader->GetOutput();
+    ASSERT_EQ(output->GetLargestPossibleRegion().GetSize(), output_size);
+    EXPECT_EQ(output->GetSpacing(), output_spacing);
+    const size_t num_pixels =
+            expected->GetLargestPossibleRegion().GetNumberOfPixels();
+    for (size_t i = 0; i < num_pixels; ++i) {
+        ASSERT_EQ(output->GetBufferPointer()[i],
+                  expected->GetBufferPointer()[i])
+                << "i: " << i;
+    }
+
+    EXPECT_THROW(SG::resample_binary_image_to_file(
+                         input, output_spacing, output_size,
+                         "./resample_binary_image_to_file.nrrd"),
+                 std::runtime_error);
+}
@@ -21,6 +21,10 @@
 #include "segmentation_functions.hpp"
 
 #include <itkImageFileReader.h>
+#include <itkImageFileWriter.h>
+
+#include <algorithm>
+#include <cmath>
 
 #include "sgext_fixture_images.hpp"
 #include "gmock/gmock.h"
@@ -114,3 +118,195 @@ TEST(binarize_with_level_set, run) {
     //         input_image_float, output_struct.output_binary_image,
     //         label_opacity);
 }
+
+TEST(binarize_with_level_set, narrow_band_grows_to_the_edges) {
+    // Bright ball of radius 10, the safe binarization is a ball of radius 4.
+    const long size = 40;
+    const double center = 19.5;
+    auto input_image_float = SG::FloatImageType::New();
+    SG::FloatImageType::SizeType image_size;
+    image_size.Fill(size);
+    input_image_float->SetRegions(image_size);
+    input_image_float->Allocate();
+    auto seed_image = SG::BinaryImageType::New();
+    seed_image->SetRegions(image_size);
+    seed_image->Allocate();
+    seed_image->FillBuffer(0);
+    auto *float_buffer = input_image_float->GetBufferPointer();
+    auto *seed_buffer = seed_image->GetBufferPointer();
+    size_t ball_pixels = 0;
+    size_t seed_pixels = 0;
+    for (long z = 0; z < size; ++z) {
+        for (long y = 0; y < size; ++y) {
+            for (long x = 0; x < size; ++x) {
+                const double r = std::sqrt((x - center) * (x - center) +
+                                           (y - center) * (y - center) +
+                                           (z - center) * (z - center));
+                const size_t offset = (z * size + y) * size + x;
+                float_buffer[offset] = r <= 10.0 ? 100.0f : 0.0f;
+                ball_pixels += r <= 10.0;
+                if (r <= 4.0) {
+                    seed_buffer[offset] = 255;
+                    ++seed_pixels;
+                }
+            }
+        }
+    }
+
+    auto input_parameters = SG::binarize_with_level_set_parameters();
+    input_parameters.use_narrow_band = true;
+    input_parameters.gradient_sigma = 1.0;
+    input_parameters.sigmoid_alpha = -1.0;
+    input_parameters.level_set_iterations = 80;
+    input_parameters.narrow_band_width = 10;
+    input_parameters.level_set_maximum_RMS_error = 0.0;
+    input_parameters.binary_upper_threshold = 0.0;
+    const bool save_intermediate_results = true;
+    auto output_struct = SG::binarize_with_level_set(
+            input_image_float, seed_image, input_parameters,
+            save_intermediate_results);
+    ASSERT_TRUE(output_struct.level_set_image);
+    ASSERT_TRUE(output_struct.sigmoid_image);
+    ASSERT_TRUE(output_struct.gradient_image);
+
+    const auto *output_buffer =
+            output_struct.output_binary_image->GetBufferPointer();
+    size_t output_pixels = 0;
+    size_t output_pixels_outside_ball = 0;
+    for (long z = 0; z < size; ++z) {
+        for (long y = 0; y < size; ++y) {
+            for (long x = 0; x < size; ++x) {
+                const size_t offset = (z * size + y) * size + x;
+                if (!output_buffer[offset]) {
+                    continue;
+                }
+                ++output_pixels;
+                const double r = std::sqrt((x - center) * (x - center) +
+                                           (y - center) * (y - center) +
+                                           (z - center) * (z - center));
+                output_pixels_outside_ball += r > 12.0;
+            }
+        }
+    }
+    // The front grows from the seed and stops at the edges of the ball.
+    EXPECT_GT(output_pixels, 2 * seed_pixels);
+    EXPECT_GT(output_pixels, 0.6 * ball_pixels);
+    EXPECT_EQ(output_pixels_outside_ball, 0u);
+}
+
+TEST(connected_components_with_threshold, same_result_than_itk_pipeline) {
+    const std::string image_name_stem("bX3D_white");
+    const std::string filename =
+            SG::sgext_fixture_images_path + "/" + image_name_stem + ".nrrd";
+    using FloatReaderType = itk::ImageFileReader<SG::FloatImageType>;
+    auto reader_float = FloatReaderType::New();
+    reader_float->SetFileName(filename);
+    reader_float->Update();
+    SG::FloatImageType::Pointer input_image = reader_float->GetOutput();
+    const size_t num_pixels =
+            input_image->GetLargestPossibleRegion().GetNumberOfPixels();
+
+    const float lower_threshold = 1.0f;
+    const float upper_threshold = 255.0f;
+    const auto expected = SG::connected_components(
+            SG::binarize_with_threshold(input_image.GetPointer(),
+                                        lower_threshold, upper_threshold));
+    const auto output = SG::connected_components_with_threshold(
+            input_image.GetPointer(), lower_threshold, upper_threshold);
+    EXPECT_EQ(output.number_of_labels, expected.number_of_labels);
+    EXPECT_EQ(output.size_of_labels, expected.size_of_labels);
+    EXPECT_TRUE(std::equal(output.label_image->GetBufferPointer(),
+                           output.label_image->GetBufferPointer() + num_pixels,
+                           expected.label_image->GetBufferPointer()));
+
+    // Largest component
+    const auto expected_largest =
+            SG::extract_a_label(expected.label_image, 1);
+    const auto output_largest = SG::connected_components_with_threshold(
+            input_image.GetPointer(), lower_threshold, upper_threshold,
+            false /* fully_connected */, true /* only_largest_component */);
+    EXPECT_EQ(output_largest.number_of_labels, expected.number_of_labels);
+    EXPECT_TRUE(std::equal(
+            output_largest.label_image->GetBufferPointer(),
+            output_largest.label_image->GetBufferPointer() + num_pixels,
+            expected_largest->GetBufferPointer()));
+
+    // Percentage
+    const double percentage = 0.2;
+    const auto expected_percentage =
+            SG::connected_components(SG::binarize_with_percentage(
+                    input_image.GetPointer(), percentage));
+    const auto output_percentage = SG::connected_components_with_percentage(
+            input_image.GetPointer(), percentage);
+    EXPECT_EQ(output_percentage.size_of_labels,
+              expected_percentage.size_of_labels);
+    EXPECT_TRUE(std::equal(
+            output_percentage.label_image->GetBufferPointer(),
+            output_percentage.label_image->GetBufferPointer() + num_pixels,
+            expected_percentage.label_image->GetBufferPointer()));
+}
+
+TEST(connected_components_with_threshold_from_file,
+     same_result_than_in_memory) {
+    const std::string image_name_stem("bX3D_white");
+    const std::string filename =
+            SG::sgext_fixture_images_path + "/" + image_name_stem + ".nrrd";
+    using FloatReaderType = itk::ImageFileReader<SG::FloatImageType>;
+    auto reader_float = FloatReaderType::New();
+    reader_float->SetFileName(filename);
+    reader_float->Update();
+    SG::FloatImageType::Pointer input_image = reader_float->GetOutput();
+    const size_t num_pixels =
+            input_image->GetLargestPossibleRegion().GetNumberOfPixels();
+    // MetaImage supports streamed reading.
+    const std::string streamable_filename =
+            "./" + image_name_stem + "_float.mha";
+    using FloatWriterType = itk::ImageFileWriter<SG::FloatImageType>;
+    auto writer = FloatWriterType::New();
+    writer->SetFileName(streamable_filename);
+    writer->SetInput(input_image);
+    writer->Update();
+
+    const float lower_threshold = 1.0f;
+    const float upper_threshold = 255.0f;
+    const size_t planes_per_slab = 2;
+    for (const bool fully_connected : {false, true}) {
+        const auto expected = SG::connected_components_with_threshold(
+                input_image.GetPointer(), lower_threshold, upper_threshold,
+                fully_connected);
+        const auto output =
+                SG::connected_components_with_threshold_from_file<
+                        SG::FloatImageType>(
+                        streamable_filename, lower_threshold, upper_threshold,
+                        fully_connected, false /* only_largest_component */,
+                        0 /* num_threads */, planes_per_slab);
+        EXPECT_EQ(output.number_of_labels, expected.number_of_labels);
+        EXPECT_EQ(output.size_of_labels, expected.size_of_labels);
+        EXPECT_TRUE(output.label_image->GetLargestPossibleRegion() ==
+                    input_image->GetLargestPossibleRegion());
+        EXPECT_TRUE(output.label_image->GetSpacing() ==
+                    input_image->GetSpacing());
+        EXPECT_TRUE(std::equal(
+                output.label_image->GetBufferPointer(),
+                output.label_image->GetBufferPointer() + num_pixels,
+                expected.label_image->GetBufferPointer()));
+    }
+
+    const double percentage = 0.2;
+    const auto expected_percentage = SG::connected_components_with_percentage(
+            input_image.GetPointer(), percentage);
+    const auto output_percentage =
+            SG::connected_components_with_percentage_from_file<
+                    SG::FloatImageType>(streamable_filename, percentage,
+                                        false /* fully_connected */,
+                                        true /* only_largest_component */,
+                                        0 /* num_threads */, planes_per_slab);
+    const auto expected_largest = SG::extract_a_label(
+            expected_percentage.label_image, 1);
+    EXPECT_EQ(output_percentage.size_of_labels,
+              expected_percentage.size_of_labels);
+    EXPECT_TRUE(std::equal(
+            output_percentage.label_image->GetBufferPointer(),
+            output_percentage.label_image->GetBufferPointer() + num_pixels,
+            expected_largest->GetBufferPointer()));
+}
@@ -0,0 +1,160 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+#include "voxelize_graph.hpp"
+
+#include "gmock/gmock.h"
+
+#include <cmath>
+#include <cstdlib>
+
+TEST(rasterize_segment, single_voxel) {
+    SG::BinaryImageType::IndexType start;
+    start[0] = 3;
+    start[1] = -1;
+    start[2] = 2;
+    const auto voxels = SG::detail::rasterize_segment(start, start);
+    ASSERT_EQ(voxels.size(), 1u);
+    EXPECT_EQ(voxels[0], start);
+}
+
+TEST(rasterize_segment, connected_from_start_to_end) {
+    SG::BinaryImageType::IndexType start;
+    start[0] = 0;
+    start[1] = 0;
+    start[2] = 0;
+    SG::BinaryImageType::IndexType end;
+    end[0] = 7;
+    end[1] = -3;
+    end[2] = 2;
+    const auto voxels = SG::detail::rasterize_segment(start, end);
+    // One voxel per step of the driving axis (x)
+    ASSERT_EQ(voxels.size(), 8u);
+    EXPECT_EQ(voxels.front(), start);
+    EXPECT_EQ(voxels.back(), end);
+    for (size_t n = 1; n < voxels.size(); ++n) {
+        EXPECT_EQ(voxels[n][0] - voxels[n - 1][0], 1);
+        for (size_t i = 1; i < 3; ++i) {
+            EXPECT_LE(std::abs(voxels[n][i] - voxels[n - 1][i]), 1);
+        }
+    }
+}
+
+struct VoxelizeGraphRasterizedFixture : public ::testing::Test {
+    SG::BinaryImageType::Pointer reference_image;
+    SG::GraphType graph;
+    SG::vertex_to_label_map_t vertex_to_label_map;
+    SG::edge_to_label_map_t edge_to_label_map;
+    void SetUp() override {
+        reference_image = SG::BinaryImageType::New();
+        SG::BinaryImageType::SizeType size;
+        size[0] = 24;
+        size[1] = 12;
+        size[2] = 12;
+        reference_image->SetRegions(size);
+        reference_image->Allocate();
+        reference_image->FillBuffer(0);
+        // An edge along x at y = z = 5, with some edge points.
+        graph = SG::GraphType(2);
+        graph[0].pos = {{3, 5, 5}};
+        graph[1].pos = {{18, 5, 5}};
+        SG::SpatialEdge se;
+        se.edge_points = {{{8, 5, 5}}, {{13, 5, 5}}};
+        boost::add_edge(0, 1, se, graph);
+        vertex_to_label_map = {{0, 1}, {1, 3}};
+        edge_to_label_map = {{*boost::edges(graph).first, 2}};
+    }
+    SG::BinaryImageType::Pointer
+    voxelize(const bool draw_segments,
+             const SG::VertexToRadiusMap &vertex_to_radius_map,
+             const size_t num_threads) const {
+        return SG::voxelize_graph_rasterized(
+                graph, reference_image, vertex_to_label_map,
+                edge_to_label_map, false, draw_segments, vertex_to_radius_map,
+                num_threads);
+    }
+};
+
+TEST_F(VoxelizeGraphRasterizedFixture, segments) {
+    const auto image = voxelize(true, SG::VertexToRadiusMap(), 1);
+    SG::BinaryImageType::IndexType index;
+    index[1] = 5;
+    index[2] = 5;
+    for (index[0] = 0; index[0] < 24; ++index[0]) {
+        const auto label = image->GetPixel(index);
+        if (index[0] == 3) {
+            EXPECT_EQ(label, 1);
+        } else if (index[0] == 18) {
+            EXPECT_EQ(label, 3);
+        } else if (index[0] > 3 && index[0] < 18) {
+            EXPECT_EQ(label, 2) << index[0];
+        } else {
+            EXPECT_EQ(label, 0) << index[0];
+        }
+    }
+    index[1] = 6;
+    index[0] = 10;
+    EXPECT_EQ(image->GetPixel(index), 0);
+}
+
+TEST_F(VoxelizeGraphRasterizedFixture, tubes) {
+    const double radius = 2.0;
+    const SG::VertexToRadiusMap vertex_to_radius_map = {{0, radius},
+                                                        {1, radius}};
+    const auto image = voxelize(false, vertex_to_radius_map, 1);
+    SG::BinaryImageType::IndexType index;
+    size_t labeled = 0;
+    for (index[2] = 0; index[2] < 12; ++index[2]) {
+        for (index[1] = 0; index[1] < 12; ++index[1]) {
+            for (index[0] = 0; index[0] < 24; ++index[0]) {
+                const auto label = image->GetPixel(index);
+                labeled += label != 0;
+                // Distance to the capsule from (3,5,5) to (18,5,5)
+                const double dx = std::max(
+                        0.0, std::max(3.0 - index[0], index[0] - 18.0));
+                const double dy = index[1] - 5.0;
+                const double dz = index[2] - 5.0;
+                const double distance2 = dx * dx + dy * dy + dz * dz;
+                if (distance2 > radius * radius) {
+                    EXPECT_EQ(label, 0);
+                    continue;
+                }
+                // The greatest label wins where balls and tubes overlap.
+                const double dx_ball = index[0] - 18.0;
+                const bool in_ball_1 = dx_ball * dx_ball + dy * dy + dz * dz <=
+                                       radius * radius;
+                EXPECT_EQ(label, in_ball_1 ? 3 : 2);
+            }
+        }
+    }
+    EXPECT_GT(labeled, 0u);
+}
+
+TEST_F(VoxelizeGraphRasterizedFixture, same_result_any_num_threads) {
+    const SG::VertexToRadiusMap vertex_to_radius_map = {{0, 3.0}, {1, 1.5}};
+    const auto serial = voxelize(true, vertex_to_radius_map, 1);
+    const auto parallel = voxelize(true, vertex_to_radius_map, 7);
+    const auto &region = serial->GetLargestPossibleRegion();
+    const auto *serial_buffer = serial->GetBufferPointer();
+    const auto *parallel_buffer = parallel->GetBufferPointer();
+    for (size_t i = 0; i < region.GetNumberOfPixels(); ++i) {
+        EXPECT_EQ(serial_buffer[i], parallel_buffer[i]);
+    }
+}
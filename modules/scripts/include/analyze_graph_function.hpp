@@ -91,8 +91,7 @@ void transform_to_physical_point_interface(
             << itk_image->GetDirection() << std::endl;
     }
     itk_spacing = itk_image->GetSpacing();
-    SG::transform_graph_to_physical_space<ItkImageType>(
-            reduced_g, itk_image);
+    auto affine = SG::index_to_physical_space_affine<ItkImageType>(itk_image);
     if (spacing != "") {
         std::istringstream in(spacing);
         double sp;
@@ -107,9 +106,13 @@ void transform_to_physical_point_interface(
         }
 
         itk_image->SetSpacing(itk_spacing);
-        SG::transform_graph_to_physical_space<ItkImageType>(
-                reduced_g, itk_image);
+        // Compose the transform with the new spacing into a single affine,
+        // the graph is traversed only once.
+        affine = SG::compose_affine(
+                affine,
+                SG::index_to_physical_space_affine<ItkImageType>(itk_image));
     }
+    SG::transform_graph_with_affine(reduced_g, affine);
     // // Format itk_spacing into a string:
     // std::ostringstream sp_stream;
     // sp_stream << itk_spacing[0] << "_" << itk_spacing[1] << "_"
@@ -0,0 +1,270 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+#ifndef IMPLICIT_RECONSTRUCTION_HPP
+#define IMPLICIT_RECONSTRUCTION_HPP
+
+#include "array_utilities.hpp"
+#include "distance_sampler.hpp"
+#include "image_types.hpp" // for FloatImageType, BinaryImageType
+#include "spatial_graph.hpp"
+
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace SG {
+
+/**
+ * Sphere, or capsule with linearly interpolated radius between two spheres,
+ * in physical space. A sphere has start == end.
+ *
+ * The union of all the primitives of a graph is the reconstructed object,
+ * see @ref collect_implicit_primitives.
+ */
+struct ImplicitPrimitive {
+    ArrayUtilities::Array3D start;
+    ArrayUtilities::Array3D end;
+    double start_radius;
+    double end_radius;
+    /** Label used for coloring, as in @ref reconstruct_from_distance_map */
+    size_t label;
+};
+
+/**
+ * Signed distance from point to the surface of the primitive, negative inside.
+ *
+ * For capsules with different radius at each end, the radius is interpolated
+ * at the projection of the point in the axis. It is not the exact euclidean
+ * distance, but the zero level set is exact when both radius are equal,
+ * and a close approximation otherwise.
+ */
+double signed_distance_to_primitive(const ImplicitPrimitive &primitive,
+                                    const ArrayUtilities::Array3D &point);
+
+/**
+ * Gather the spheres (nodes and edge points) of the graph, with the radius
+ * given by the distance map, see @ref reconstruct_from_distance_map.
+ *
+ * @param input_sg input graph
+ * @param distance_map_image input distance map image
+ * @param spatial_nodes_position_are_in_physical_space true if the positions
+ *  are in physical space.
+ * @param distance_map_image_use_image_spacing the distance map values takes
+ *  into account image spacing.
+ * @param use_capsules if true, consecutive points of each edge are joined
+ * with capsules. If false, only spheres are returned.
+ * @param vertex_to_label_map map to assign labels to the primitives.
+ * @param apply_color_to_edges Edge primitives have the label
+ * max(source_label,target_label) of that edge.
+ *
+ * @return primitives in physical space
+ */
+std::vector<ImplicitPrimitive> collect_implicit_primitives(
+        const GraphType &input_sg,
+        FloatImageType *distance_map_image,
+        const bool spatial_nodes_position_are_in_physical_space = false,
+        const bool distance_map_image_use_image_spacing = false,
+        const bool use_capsules = true,
+        const std::unordered_map<GraphType::vertex_descriptor,
+                                 size_t> &vertex_to_label_map =
+                std::unordered_map<GraphType::vertex_descriptor, size_t>(),
+        const bool apply_color_to_edges = true);
+std::vector<ImplicitPrimitive> collect_implicit_primitives(
+        const GraphType &input_sg,
+        const DistanceSampler &distance_sampler,
+        const bool spatial_nodes_position_are_in_physical_space = false,
+        const bool use_capsules = true,
+        const std::unordered_map<GraphType::vertex_descriptor,
+                                 size_t> &vertex_to_label_map =
+                std::unordered_map<GraphType::vertex_descriptor, size_t>(),
+        const bool apply_color_to_edges = true);
+
+/**
+ * Signed distance field of the union of primitives, sampled on a regular grid
+ * aligned with the physical axes. Sample (i,j,k) is at origin + (i,j,k) *
+ * spacing.
+ *
+ * The grid is split in blocks of block_size^3 samples, and only the active
+ * blocks, close to a primitive, are stored. The samples of the b-th active
+ * block, with block coordinates blocks[b], are
+ * values[b * block_num_samples + x + block_size * (y + block_size * z)],
+ * with x,y,z local to the block. The rest of the samples are outside_value.
+ */
+struct ImplicitFieldGrid {
+    static constexpr size_t block_size = 8;
+    static constexpr size_t block_num_samples =
+            block_size * block_size * block_size;
+    /** Number of samples per axis, a multiple of block_size. */
+    std::array<size_t, 3> size;
+    ArrayUtilities::Array3D origin;
+    double spacing;
+    /** Positive value of the samples far from all the primitives. */
+    float outside_value;
+    std::array<size_t, 3> num_blocks;
+    /** Block coordinates of the active blocks, in linear block order. */
+    std::vector<std::array<size_t, 3>> blocks;
+    /** Linear block index -> position of the block in blocks. */
+    std::unordered_map<size_t, size_t> block_positions;
+    /** Signed distance, only exact near the surface, positive outside. */
+    std::vector<float> values;
+    /** Label of the closest primitive, only populated if requested. */
+    std::vector<size_t> labels;
+    /** Number of blocks of the grid where the field was evaluated. */
+    size_t active_blocks;
+    size_t total_blocks;
+
+    /**
+     * Position in values (and labels) of the sample, or values.size() if
+     * the sample is not in an active block.
+     */
+    size_t find_sample(const size_t &x, const size_t &y, const size_t &z) const;
+    /** Value of any sample, outside_value if it is not stored. */
+    float value(const size_t &x, const size_t &y, const size_t &z) const;
+};
+
+/**
+ * Evaluate the signed distance field of the union of the primitives.
+ *
+ * The field is only evaluated and stored in the blocks close to a primitive
+ * (a narrow band), against the primitives close to that block, memory is
+ * proportional to the surface of the object and not to its bounding box.
+ * Blocks are evaluated in parallel.
+ *
+ * @param primitives union of primitives, from @ref collect_implicit_primitives
+ * @param grid_spacing physical distance between samples
+ * @param compute_labels populate the labels of the grid
+ * @param num_threads 0 to use the ITK default
+ *
+ * @return grid with the active blocks of the field
+ */
+ImplicitFieldGrid
+evaluate_implicit_field(const std::vector<ImplicitPrimitive> &primitives,
+                        const double grid_spacing,
+                        const bool compute_labels = false,
+                        const size_t num_threads = 0);
+
+/**
+ * Rasterize the union of primitives into a binary image with the same
+ * metadata (region, origin, spacing, direction) than the reference image.
+ * Voxels with center inside any primitive are set to 1.
+ *
+ * The image is split in slabs along z, and each slab is filled in parallel
+ * with the primitives intersecting it.
+ *
+ * @param primitives union of primitives, from @ref collect_implicit_primitives
+ * @param reference_image image providing the metadata
+ * @param num_threads 0 to use the ITK default
+ *
+ * @return binary image
+ */
+BinaryImageType::Pointer
+rasterize_implicit_primitives(const std::vector<ImplicitPrimitive> &primitives,
+                              const FloatImageType *reference_image,
+                              const size_t num_threads = 0);
+BinaryImageType::Pointer
+rasterize_implicit_primitives(const std::vector<ImplicitPrimitive> &primitives,
+                              const BinaryImageType *reference_image,
+                              const size_t num_threads = 0);
+BinaryImageType::Pointer
+rasterize_implicit_primitives(const std::vector<ImplicitPrimitive> &primitives,
+                              const DistanceSampler &reference_sampler,
+                              const size_t num_threads = 0);
+
+/**
+ * Binary image of the object reconstructed from the graph and distance map,
+ * without creating any mesh (@sa reconstruct_from_distance_map and
+ * poly_data_to_binary_image).
+ * The output has the same metadata than the distance map.
+ *
+ * @param input_sg input graph
+ * @param distance_map_image input distance map image
+ * @param spatial_nodes_position_are_in_physical_space true if the positions
+ *  are in physical space.
+ * @param distance_map_image_use_image_spacing the distance map values takes
+ *  into account image spacing.
+ * @param use_capsules join consecutive points of each edge with capsules,
+ * closing the gaps between spheres.
+ * @param num_threads 0 to use the ITK default
+ *
+ * @return binary image
+ */
+BinaryImageType::Pointer reconstruct_binary_image_from_distance_map(
+        const GraphType &input_sg,
+        FloatImageType *distance_map_image,
+        const bool spatial_nodes_position_are_in_physical_space = false,
+        const bool distance_map_image_use_image_spacing = false,
+        const bool use_capsules = true,
+        const size_t num_threads = 0);
+BinaryImageType::Pointer reconstruct_binary_image_from_distance_map(
+        const GraphType &input_sg,
+        const DistanceSampler &distance_sampler,
+        const bool spatial_nodes_position_are_in_physical_space = false,
+        const bool use_capsules = true,
+        const size_t num_threads = 0);
+
+namespace detail {
+
+/**
+ * Returns pair, the first boolean indicates if the image is isotropic,
+ * the second, give a value for the spacing.
+ *
+ * In the non isotropic case, this value corresponds to the mean of the min
+ * and max value of the spacing.
+ *
+ * @param distance_map_image
+ *
+ * @return pair: true|false, spacing_value
+ */
+std::pair<bool, double> checkIsotropy(const FloatImageType *distance_map_image);
+std::pair<bool, double> checkIsotropy(const DistanceSampler *distance_sampler);
+const std::string isotropyWarning =
+R"(WARNING: The image is not isotropic:
+The distance map provided works on voxel space, so it ignores image spacing.
+The mean of max and min spacing is used as radius, but consider resample the image to isotropic.)";
+
+/**
+ * Physical position of the input_point and the radius of the sphere centered
+ * on it, given by the distance map.
+ * The radius is 0 if the point is outside the distance map.
+ *
+ * @param radius_multiplier The factor to multiply the radius.
+ *  Only used when distance_map_image_use_image_spacing is false.
+ *  @ref checkIsotropy
+ *
+ * @return pair: center (physical space), radius
+ */
+std::pair<ArrayUtilities::Array3D, double>
+sphere_from_distance_map(const ArrayUtilities::Array3D &input_point,
+                         const FloatImageType *distance_map_image,
+                         const bool spatial_nodes_position_are_in_physical_space,
+                         const bool distance_map_image_use_image_spacing,
+                         const double radius_multiplier);
+std::pair<ArrayUtilities::Array3D, double>
+sphere_from_distance_map(const ArrayUtilities::Array3D &input_point,
+                         const DistanceSampler *distance_sampler,
+                         const bool spatial_nodes_position_are_in_physical_space,
+                         const bool distance_map_image_use_image_spacing,
+                         const double radius_multiplier);
+} // end namespace detail
+} // end namespace SG
+
+#endif
@@ -21,7 +21,9 @@
 #ifndef RECONSTRUCT_FROM_DISTANCE_MAP_HPP
 #define RECONSTRUCT_FROM_DISTANCE_MAP_HPP
 
+#include "distance_sampler.hpp"
 #include "image_types.hpp" // for FloatImageType
+#include "implicit_reconstruction.hpp" // for checkIsotropy
 #include "spatial_graph.hpp"
 
 #include <vtkImageData.h>
@@ -82,6 +84,69 @@ ReconstructOutput reconstruct_from_distance_map(
                 std::unordered_map<GraphType::vertex_descriptor, size_t>(),
         const bool apply_color_to_edges = true);
 
+/**
+ * @ref reconstruct_from_distance_map computing the radius of each sphere
+ * lazily from a binary image, instead of using a precomputed distance map.
+ * The sampler controls if the radius is in voxel or physical units,
+ * @sa DistanceSampler
+ */
+ReconstructOutput reconstruct_from_distance_map(
+        const GraphType &input_sg,
+        const DistanceSampler &distance_sampler,
+        const bool spatial_nodes_position_are_in_physical_space = false,
+        const std::unordered_map<GraphType::vertex_descriptor,
+                                 size_t> &vertex_to_label_map =
+                std::unordered_map<GraphType::vertex_descriptor, size_t>(),
+        const bool apply_color_to_edges = true);
+
+/**
+ * Alternative to @ref reconstruct_from_distance_map that scales with the
+ * surface of the object instead of with the number of points of the graph.
+ *
+ * Instead of appending one sphere mesh per point, the union of spheres (or
+ * capsules joining consecutive points of the edges) is evaluated as a signed
+ * distance field in a narrow band around the primitives
+ * (@ref evaluate_implicit_field), and a single watertight surface is
+ * extracted with marching cubes (vtkFlyingEdges3D). Only the active blocks
+ * of the field are stored, and the surface of each block is extracted in
+ * parallel, then the points shared between blocks are merged.
+ *
+ * If vertex_to_label_map is provided, each cell of the surface gets the label
+ * of the closest primitive, in a "Colors" cell array, as in
+ * @ref reconstruct_from_distance_map.
+ *
+ * @param use_capsules join consecutive points of each edge with capsules,
+ * closing the gaps between spheres.
+ * @param grid_spacing distance between the samples of the field, 0 to use
+ * the minimum spacing of the distance map.
+ * @param num_threads 0 to use the ITK default
+ *
+ * For the rest of parameters @sa reconstruct_from_distance_map
+ */
+ReconstructOutput reconstruct_from_distance_map_implicit(
+        const GraphType &input_sg,
+        FloatImageType *distance_map_image,
+        const bool spatial_nodes_position_are_in_physical_space = false,
+        const bool distance_map_image_use_image_spacing = false,
+        const std::unordered_map<GraphType::vertex_descriptor,
+                                 size_t> &vertex_to_label_map =
+                std::unordered_map<GraphType::vertex_descriptor, size_t>(),
+        const bool apply_color_to_edges = true,
+        const bool use_capsules = true,
+        const double grid_spacing = 0.0,
+        const size_t num_threads = 0);
+ReconstructOutput reconstruct_from_distance_map_implicit(
+        const GraphType &input_sg,
+        const DistanceSampler &distance_sampler,
+        const bool spatial_nodes_position_are_in_physical_space = false,
+        const std::unordered_map<GraphType::vertex_descriptor,
+                                 size_t> &vertex_to_label_map =
+                std::unordered_map<GraphType::vertex_descriptor, size_t>(),
+        const bool apply_color_to_edges = true,
+        const bool use_capsules = true,
+        const double grid_spacing = 0.0,
+        const size_t num_threads = 0);
+
 namespace defaults {
 const std::string polydata_win_title = "SGEXT PolyData";
 const size_t polydata_win_width = 600;
@@ -163,23 +228,6 @@ void visualize_poly_data_and_graph(
 
 namespace detail {
 
-/**
- * Returns pair, the first boolean indicates if the image is isotropic,
- * the second, give a value for the spacing.
- *
- * In the non isotropic case, this value corresponds to the mean of the min
- * and max value of the spacing.
- *
- * @param distance_map_image
- *
- * @return pair: true|false, spacing_value
- */
-std::pair<bool, double> checkIsotropy(const FloatImageType *distance_map_image);
-const std::string isotropyWarning =
-R"(WARNING: The image is not isotropic:
-The distance map provided works on voxel space, so it ignores image spacing.
-The mean of max and min spacing is used as radius, but consider resample the image to isotropic.)";
-
 /**
  * Create a sphere source with center given by the input_point and radius
  * given by pixel of that position in the distance map.
@@ -213,6 +261,12 @@ createSphereSource(const ArrayUtilities::Array3D &input_point,
                    const bool spatial_nodes_position_are_in_physical_space,
                    const bool distance_map_image_use_image_spacing,
                    const double radius_multiplier);
+vtkSmartPointer<vtkSphereSource>
+createSphereSource(const ArrayUtilities::Array3D &input_point,
+                   const DistanceSampler *distance_sampler,
+                   const bool spatial_nodes_position_are_in_physical_space,
+                   const bool distance_map_image_use_image_spacing,
+                   const double radius_multiplier);
 /**
  * Associate an integer array to the sphere cell data. Used to color the spheres
  * based on the label.
@@ -0,0 +1,648 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+#include "implicit_reconstruction.hpp"
+#include "transform_to_physical_point.hpp" // for AffineMatrixType
+
+#include <itkMath.h>
+#include <itkMultiThreaderBase.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+namespace SG {
+
+namespace {
+using Array3D = ArrayUtilities::Array3D;
+
+/** Axis aligned bounding box of a primitive, in physical space. */
+void primitive_bounds(const ImplicitPrimitive &primitive,
+                      Array3D &lower,
+                      Array3D &upper) {
+    for (size_t i = 0; i < 3; ++i) {
+        lower[i] = std::min(primitive.start[i] - primitive.start_radius,
+                            primitive.end[i] - primitive.end_radius);
+        upper[i] = std::max(primitive.start[i] + primitive.start_radius,
+                            primitive.end[i] + primitive.end_radius);
+    }
+}
+
+size_t get_label(
+        const std::unordered_map<GraphType::vertex_descriptor, size_t>
+                &vertex_to_label_map,
+        const GraphType::vertex_descriptor &v) {
+    // Dev: max of size_t is not mapping to NaN, use int instead
+    const auto found = vertex_to_label_map.find(v);
+    return found == vertex_to_label_map.end()
+                   ? static_cast<size_t>(std::numeric_limits<int>::max())
+                   : found->second;
+}
+
+template <typename TDistanceMap>
+std::vector<ImplicitPrimitive> collect_implicit_primitives_impl(
+        const GraphType &input_sg,
+        const TDistanceMap *distance_map_image,
+        const bool spatial_nodes_position_are_in_physical_space,
+        const bool distance_map_image_use_image_spacing,
+        const bool use_capsules,
+        const std::unordered_map<GraphType::vertex_descriptor, size_t>
+                &vertex_to_label_map,
+        const bool apply_color_to_edges) {
+    const auto isotropic_spacing_pair =
+            detail::checkIsotropy(distance_map_image);
+    const auto &is_isotropic = isotropic_spacing_pair.first;
+    const auto &radius_multiplier = isotropic_spacing_pair.second;
+    if (!distance_map_image_use_image_spacing && !is_isotropic) {
+        std::cerr << detail::isotropyWarning << std::endl;
+        std::cerr << "radius_multiplier: " << radius_multiplier << std::endl;
+    }
+    const auto to_sphere = [&](const Array3D &point) {
+        return detail::sphere_from_distance_map(
+                point, distance_map_image,
+                spatial_nodes_position_are_in_physical_space,
+                distance_map_image_use_image_spacing, radius_multiplier);
+    };
+    const bool vertex_to_label_map_provided = !vertex_to_label_map.empty();
+    const size_t no_label = std::numeric_limits<int>::max();
+
+    std::vector<ImplicitPrimitive> primitives;
+    // Nodes
+    const auto verts = boost::vertices(input_sg);
+    for (auto vi = verts.first; vi != verts.second; ++vi) {
+        const auto sphere = to_sphere(input_sg[*vi].pos);
+        const size_t label = vertex_to_label_map_provided
+                                     ? get_label(vertex_to_label_map, *vi)
+                                     : no_label;
+        primitives.push_back({sphere.first, sphere.first, sphere.second,
+                              sphere.second, label});
+    }
+    // Edges
+    const auto edges = boost::edges(input_sg);
+    for (auto ei = edges.first; ei != edges.second; ++ei) {
+        const auto source = boost::source(*ei, input_sg);
+        const auto target = boost::target(*ei, input_sg);
+        size_t label = no_label;
+        if (vertex_to_label_map_provided && apply_color_to_edges) {
+            const auto found_source = vertex_to_label_map.find(source);
+            const auto found_target = vertex_to_label_map.find(target);
+            if (found_source != vertex_to_label_map.end() &&
+                found_target != vertex_to_label_map.end()) {
+                label = std::max(found_source->second, found_target->second);
+            }
+        }
+        const auto &edge_points = input_sg[*ei].edge_points;
+        if (!use_capsules) {
+            for (const auto &ep : edge_points) {
+                const auto sphere = to_sphere(ep);
+                primitives.push_back({sphere.first, sphere.first,
+                                      sphere.second, sphere.second, label});
+            }
+            continue;
+        }
+        // Polyline from source to target. Edge points might be stored
+        // from target to source.
+        std::vector<Array3D> polyline;
+        polyline.reserve(edge_points.size() + 2);
+        polyline.push_back(input_sg[source].pos);
+        if (!edge_points.empty() &&
+            ArrayUtilities::distance(edge_points.front(),
+                                     input_sg[source].pos) >
+                    ArrayUtilities::distance(edge_points.back(),
+                                             input_sg[source].pos)) {
+            polyline.insert(polyline.end(), edge_points.rbegin(),
+                            edge_points.rend());
+        } else {
+            polyline.insert(polyline.end(), edge_points.begin(),
+                            edge_points.end());
+        }
+        polyline.push_back(input_sg[target].pos);
+        auto previous = to_sphere(polyline.front());
+        for (size_t i = 1; i < polyline.size(); ++i) {
+            const auto current = to_sphere(polyline[i]);
+            primitives.push_back({previous.first, current.first,
+                                  previous.second, current.second, label});
+            previous = current;
+        }
+    }
+    return primitives;
+}
+
+template <typename TReference>
+BinaryImageType::Pointer
+rasterize_implicit_primitives_impl(
+        const std::vector<ImplicitPrimitive> &primitives,
+        const TReference *reference_image,
+        const size_t num_threads) {
+    const auto &region = reference_image->GetLargestPossibleRegion();
+    BinaryImageType::Pointer output_image = BinaryImageType::New();
+    output_image->SetRegions(region);
+    output_image->SetOrigin(reference_image->GetOrigin());
+    output_image->SetSpacing(reference_image->GetSpacing());
+    output_image->SetDirection(reference_image->GetDirection());
+    output_image->Allocate();
+    output_image->FillBuffer(0);
+
+    long start[3];
+    long size[3];
+    for (size_t i = 0; i < 3; ++i) {
+        start[i] = region.GetIndex()[i];
+        size[i] = static_cast<long>(region.GetSize()[i]);
+    }
+    if (primitives.empty() || size[0] == 0 || size[1] == 0 || size[2] == 0) {
+        return output_image;
+    }
+    const AffineMatrixType index_to_physical =
+            index_to_physical_space_affine(reference_image);
+    const AffineMatrixType physical_to_index = invert_affine(index_to_physical);
+
+    // Index bounding box of each primitive, clamped to the region.
+    // Empty boxes have lower > upper.
+    struct IndexBox {
+        long lower[3];
+        long upper[3];
+    };
+    std::vector<IndexBox> boxes(primitives.size());
+    for (size_t p = 0; p < primitives.size(); ++p) {
+        Array3D lower;
+        Array3D upper;
+        primitive_bounds(primitives[p], lower, upper);
+        auto &box = boxes[p];
+        for (size_t i = 0; i < 3; ++i) {
+            box.lower[i] = std::numeric_limits<long>::max();
+            box.upper[i] = std::numeric_limits<long>::min();
+        }
+        // Transform the 8 corners of the physical box to index space
+        for (size_t corner = 0; corner < 8; ++corner) {
+            const Array3D physical = {{(corner & 1) ? upper[0] : lower[0],
+                                       (corner & 2) ? upper[1] : lower[1],
+                                       (corner & 4) ? upper[2] : lower[2]}};
+            const auto index = apply_affine(physical_to_index, physical);
+            for (size_t i = 0; i < 3; ++i) {
+                box.lower[i] = std::min(
+                        box.lower[i], static_cast<long>(std::floor(index[i])));
+                box.upper[i] = std::max(
+                        box.upper[i], static_cast<long>(std::ceil(index[i])));
+            }
+        }
+        for (size_t i = 0; i < 3; ++i) {
+            box.lower[i] = std::max(box.lower[i], start[i]);
+            box.upper[i] = std::min(box.upper[i], start[i] + size[i] - 1);
+        }
+    }
+
+    auto threader = itk::MultiThreaderBase::New();
+    if (num_threads > 0) {
+        threader->SetMaximumNumberOfThreads(num_threads);
+        threader->SetNumberOfWorkUnits(num_threads);
+    }
+    // Slabs along z, each slab is written by only one work unit.
+    const size_t num_slabs = std::min<size_t>(
+            size[2], 4 * threader->GetNumberOfWorkUnits());
+    const long slab_depth = (size[2] + num_slabs - 1) / num_slabs;
+    std::vector<std::vector<size_t>> slab_primitives(num_slabs);
+    for (size_t p = 0; p < primitives.size(); ++p) {
+        const auto &box = boxes[p];
+        if (box.lower[0] > box.upper[0] || box.lower[1] > box.upper[1] ||
+            box.lower[2] > box.upper[2]) {
+            continue;
+        }
+        const size_t first_slab = (box.lower[2] - start[2]) / slab_depth;
+        const size_t last_slab = (box.upper[2] - start[2]) / slab_depth;
+        for (size_t s = first_slab; s <= last_slab; ++s) {
+            slab_primitives[s].push_back(p);
+        }
+    }
+
+    BinaryImagePixelType *buffer = output_image->GetBufferPointer();
+    threader->ParallelizeArray(
+            0, num_slabs,
+            [&](itk::SizeValueType slab) {
+                const long slab_begin = start[2] + slab * slab_depth;
+                const long slab_end =
+                        std::min(slab_begin + slab_depth, start[2] + size[2]);
+                for (const auto &p : slab_primitives[slab]) {
+                    const auto &primitive = primitives[p];
+                    const auto &box = boxes[p];
+                    const long z_begin = std::max(box.lower[2], slab_begin);
+                    const long z_end = std::min(box.upper[2] + 1, slab_end);
+                    for (long z = z_begin; z < z_end; ++z) {
+                        for (long y = box.lower[1]; y <= box.upper[1]; ++y) {
+                            const size_t row_offset =
+                                    ((z - start[2]) * size[1] +
+                                     (y - start[1])) *
+                                    size[0];
+                            for (long x = box.lower[0]; x <= box.upper[0];
+                                 ++x) {
+                                auto &pixel =
+                                        buffer[row_offset + (x - start[0])];
+                                if (pixel) {
+                                    continue;
+                                }
+                                const Array3D physical = apply_affine(
+                                        index_to_physical,
+                                        {{static_cast<double>(x),
+                                          static_cast<double>(y),
+                                          static_cast<double>(z)}});
+                                if (signed_distance_to_primitive(
+                                            primitive, physical) <= 0.0) {
+                                    pixel = 1;
+                                }
+                            }
+                        }
+                    }
+                }
+            },
+            nullptr);
+    return output_image;
+}
+
+template <typename TDistanceMap>
+std::pair<bool, double>
+check_isotropy_impl(const TDistanceMap *distance_map_image) {
+    const auto & dmap_spacing = distance_map_image->GetSpacing();
+    const auto min_max_spacing_pair = std::minmax_element(
+            dmap_spacing.Begin(), dmap_spacing.End());
+
+    const auto & min_sp = *min_max_spacing_pair.first;
+    const auto & max_sp = *min_max_spacing_pair.second;
+    if (itk::Math::FloatAlmostEqual(min_sp, max_sp)) {
+        return std::make_pair(true, max_sp);
+    } else {
+        return std::make_pair(false, (min_sp + max_sp)/2.0);
+    }
+}
+
+template <typename TDistanceMap>
+std::pair<Array3D, double>
+sphere_from_distance_map_impl(
+        const Array3D &input_point,
+        const TDistanceMap *distance_map_image,
+        const bool spatial_nodes_position_are_in_physical_space,
+        const bool distance_map_image_use_image_spacing,
+        const double radius_multiplier) {
+    FloatImageType::PointType itk_point;
+    FloatImageType::IndexType itk_index;
+    bool is_inside = true;
+    if (spatial_nodes_position_are_in_physical_space) {
+        for (size_t i = 0; i < FloatImageType::ImageDimension; ++i) {
+            itk_point[i] = input_point[i];
+        }
+        is_inside = distance_map_image->TransformPhysicalPointToIndex(
+                itk_point, itk_index);
+    } else {
+        for (size_t i = 0; i < FloatImageType::ImageDimension; ++i) {
+            itk_index[i] = input_point[i];
+        }
+        distance_map_image->TransformIndexToPhysicalPoint(itk_index, itk_point);
+        is_inside = distance_map_image->GetLargestPossibleRegion().IsInside(
+                itk_index);
+    }
+    Array3D center;
+    for (size_t i = 0; i < 3; ++i) {
+        center[i] = spatial_nodes_position_are_in_physical_space
+                            ? input_point[i]
+                            : itk_point[i];
+    }
+    const double dmap_value =
+            is_inside ? distance_map_image->GetPixel(itk_index) : 0.0;
+    // dmap_value can represent number of pixels to the object border,
+    // or a physical distance
+    const double radius = distance_map_image_use_image_spacing
+                                  ? dmap_value
+                                  : dmap_value * radius_multiplier;
+    return std::make_pair(center, radius);
+}
+} // namespace
+
+double signed_distance_to_primitive(const ImplicitPrimitive &primitive,
+                                    const ArrayUtilities::Array3D &point) {
+    const auto &a = primitive.start;
+    const auto &b = primitive.end;
+    const double ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    const double ap[3] = {point[0] - a[0], point[1] - a[1], point[2] - a[2]};
+    const double ab_ab = ab[0] * ab[0] + ab[1] * ab[1] + ab[2] * ab[2];
+    double t = 0.0;
+    if (ab_ab > 0.0) {
+        t = (ap[0] * ab[0] + ap[1] * ab[1] + ap[2] * ab[2]) / ab_ab;
+        t = std::min(1.0, std::max(0.0, t));
+    }
+    const double d[3] = {ap[0] - t * ab[0], ap[1] - t * ab[1],
+                         ap[2] - t * ab[2]};
+    const double radius =
+            primitive.start_radius +
+            t * (primitive.end_radius - primitive.start_radius);
+    return std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]) - radius;
+}
+
+std::vector<ImplicitPrimitive> collect_implicit_primitives(
+        const GraphType &input_sg,
+        FloatImageType *distance_map_image,
+        const bool spatial_nodes_position_are_in_physical_space,
+        const bool distance_map_image_use_image_spacing,
+        const bool use_capsules,
+        const std::unordered_map<GraphType::vertex_descriptor, size_t>
+                &vertex_to_label_map,
+        const bool apply_color_to_edges) {
+    return collect_implicit_primitives_impl(
+            input_sg, distance_map_image,
+            spatial_nodes_position_are_in_physical_space,
+            distance_map_image_use_image_spacing, use_capsules,
+            vertex_to_label_map, apply_color_to_edges);
+}
+
+std::vector<ImplicitPrimitive> collect_implicit_primitives(
+        const GraphType &input_sg,
+        const DistanceSampler &distance_sampler,
+        const bool spatial_nodes_position_are_in_physical_space,
+        const bool use_capsules,
+        const std::unordered_map<GraphType::vertex_descriptor, size_t>
+                &vertex_to_label_map,
+        const bool apply_color_to_edges) {
+    return collect_implicit_primitives_impl(
+            input_sg, &distance_sampler,
+            spatial_nodes_position_are_in_physical_space,
+            distance_sampler.use_image_spacing(), use_capsules,
+            vertex_to_label_map, apply_color_to_edges);
+}
+
+constexpr size_t ImplicitFieldGrid::block_size;
+constexpr size_t ImplicitFieldGrid::block_num_samples;
+
+size_t ImplicitFieldGrid::find_sample(const size_t &x,
+                                      const size_t &y,
+                                      const size_t &z) const {
+    if (x >= size[0] || y >= size[1] || z >= size[2]) {
+        return values.size();
+    }
+    const size_t key =
+            x / block_size +
+            num_blocks[0] * (y / block_size + num_blocks[1] * (z / block_size));
+    const auto found = block_positions.find(key);
+    if (found == block_positions.end()) {
+        return values.size();
+    }
+    return found->second * block_num_samples + x % block_size +
+           block_size * (y % block_size + block_size * (z % block_size));
+}
+
+float ImplicitFieldGrid::value(const size_t &x,
+                               const size_t &y,
+                               const size_t &z) const {
+    const size_t sample = find_sample(x, y, z);
+    return sample < values.size() ? values[sample] : outside_value;
+}
+
+ImplicitFieldGrid
+evaluate_implicit_field(const std::vector<ImplicitPrimitive> &primitives,
+                        const double grid_spacing,
+                        const bool compute_labels,
+                        const size_t num_threads) {
+    if (!(grid_spacing > 0.0)) {
+        throw std::runtime_error(
+                "evaluate_implicit_field: grid_spacing must be positive.");
+    }
+    constexpr size_t block_size = ImplicitFieldGrid::block_size;
+    constexpr size_t block_num_samples = ImplicitFieldGrid::block_num_samples;
+    ImplicitFieldGrid grid;
+    grid.spacing = grid_spacing;
+    // Any positive value works outside of the band.
+    grid.outside_value = static_cast<float>(block_size * grid_spacing);
+    grid.active_blocks = 0;
+    grid.total_blocks = 0;
+    grid.size = {{0, 0, 0}};
+    grid.num_blocks = {{0, 0, 0}};
+    grid.origin = {{0.0, 0.0, 0.0}};
+    if (primitives.empty()) {
+        return grid;
+    }
+
+    // Only samples closer than the band to a primitive are evaluated.
+    const double band = 2.0 * grid_spacing;
+    Array3D lower;
+    Array3D upper;
+    primitive_bounds(primitives.front(), lower, upper);
+    for (const auto &primitive : primitives) {
+        Array3D p_lower;
+        Array3D p_upper;
+        primitive_bounds(primitive, p_lower, p_upper);
+        for (size_t i = 0; i < 3; ++i) {
+            lower[i] = std::min(lower[i], p_lower[i]);
+            upper[i] = std::max(upper[i], p_upper[i]);
+        }
+    }
+    for (size_t i = 0; i < 3; ++i) {
+        grid.origin[i] = lower[i] - band;
+        const size_t samples = static_cast<size_t>(std::ceil(
+                                       (upper[i] + band - grid.origin[i]) /
+                                       grid_spacing)) +
+                               1;
+        grid.num_blocks[i] = (samples + block_size - 1) / block_size;
+        grid.size[i] = grid.num_blocks[i] * block_size;
+    }
+    const auto &num_blocks = grid.num_blocks;
+    grid.total_blocks = num_blocks[0] * num_blocks[1] * num_blocks[2];
+
+    // Assign primitives to the blocks they (plus the band) overlap.
+    std::unordered_map<size_t, std::vector<size_t>> block_primitives;
+    const double block_length = block_size * grid_spacing;
+    for (size_t p = 0; p < primitives.size(); ++p) {
+        Array3D p_lower;
+        Array3D p_upper;
+        primitive_bounds(primitives[p], p_lower, p_upper);
+        size_t first[3];
+        size_t last[3];
+        for (size_t i = 0; i < 3; ++i) {
+            const double lo = (p_lower[i] - band - grid.origin[i]) /
+                              block_length;
+            const double hi = (p_upper[i] + band - grid.origin[i]) /
+                              block_length;
+            first[i] = static_cast<size_t>(std::max(0.0, std::floor(lo)));
+            last[i] = std::min(static_cast<size_t>(std::max(0.0, hi)),
+                               num_blocks[i] - 1);
+        }
+        for (size_t bz = first[2]; bz <= last[2]; ++bz) {
+            for (size_t by = first[1]; by <= last[1]; ++by) {
+                for (size_t bx = first[0]; bx <= last[0]; ++bx) {
+                    const size_t key =
+                            bx + num_blocks[0] * (by + num_blocks[1] * bz);
+                    block_primitives[key].push_back(p);
+                }
+            }
+        }
+    }
+    // Store the active blocks in linear block order, the layout does not
+    // depend on the hashing.
+    std::vector<size_t> keys;
+    keys.reserve(block_primitives.size());
+    for (const auto &block : block_primitives) {
+        keys.push_back(block.first);
+    }
+    std::sort(keys.begin(), keys.end());
+    grid.active_blocks = keys.size();
+    grid.blocks.resize(keys.size());
+    grid.block_positions.reserve(keys.size());
+    for (size_t b = 0; b < keys.size(); ++b) {
+        const size_t key = keys[b];
+        grid.blocks[b] = {{key % num_blocks[0],
+                           (key / num_blocks[0]) % num_blocks[1],
+                           key / (num_blocks[0] * num_blocks[1])}};
+        grid.block_positions.emplace(key, b);
+    }
+    grid.values.assign(keys.size() * block_num_samples, grid.outside_value);
+    if (compute_labels) {
+        grid.labels.assign(grid.values.size(),
+                           std::numeric_limits<int>::max());
+    }
+
+    // Evaluate the active blocks in parallel, blocks do not share samples.
+    auto threader = itk::MultiThreaderBase::New();
+    if (num_threads > 0) {
+        threader->SetMaximumNumberOfThreads(num_threads);
+        threader->SetNumberOfWorkUnits(num_threads);
+    }
+    threader->ParallelizeArray(
+            0, keys.size(),
+            [&](itk::SizeValueType b) {
+                const auto &block_list = block_primitives.at(keys[b]);
+                const auto &block = grid.blocks[b];
+                size_t sample = b * block_num_samples;
+                for (size_t z = 0; z < block_size; ++z) {
+                    for (size_t y = 0; y < block_size; ++y) {
+                        for (size_t x = 0; x < block_size; ++x, ++sample) {
+                            const Array3D point = {
+                                    {grid.origin[0] +
+                                             (block[0] * block_size + x) *
+                                                     grid_spacing,
+                                     grid.origin[1] +
+                                             (block[1] * block_size + y) *
+                                                     grid_spacing,
+                                     grid.origin[2] +
+                                             (block[2] * block_size + z) *
+                                                     grid_spacing}};
+                            double min_distance = grid.outside_value;
+                            size_t min_primitive = primitives.size();
+                            for (const auto &p : block_list) {
+                                const double distance =
+                                        signed_distance_to_primitive(
+                                                primitives[p], point);
+                                if (distance < min_distance) {
+                                    min_distance = distance;
+                                    min_primitive = p;
+                                }
+                            }
+                            grid.values[sample] =
+                                    static_cast<float>(min_distance);
+                            if (compute_labels &&
+                                min_primitive < primitives.size()) {
+                                grid.labels[sample] =
+                                        primitives[min_primitive].label;
+                            }
+                        }
+                    }
+                }
+            },
+            nullptr);
+    return grid;
+}
+
+BinaryImageType::Pointer
+rasterize_implicit_primitives(const std::vector<ImplicitPrimitive> &primitives,
+                              const FloatImageType *reference_image,
+                              const size_t num_threads) {
+    return rasterize_implicit_primitives_impl(primitives, reference_image,
+                                              num_threads);
+}
+BinaryImageType::Pointer
+rasterize_implicit_primitives(const std::vector<ImplicitPrimitive> &primitives,
+                              const BinaryImageType *reference_image,
+                              const size_t num_threads) {
+    return rasterize_implicit_primitives_impl(primitives, reference_image,
+                                              num_threads);
+}
+BinaryImageType::Pointer
+rasterize_implicit_primitives(const std::vector<ImplicitPrimitive> &primitives,
+                              const DistanceSampler &reference_sampler,
+                              const size_t num_threads) {
+    return rasterize_implicit_primitives_impl(primitives, &reference_sampler,
+                                              num_threads);
+}
+
+BinaryImageType::Pointer reconstruct_binary_image_from_distance_map(
+        const GraphType &input_sg,
+        FloatImageType *distance_map_image,
+        const bool spatial_nodes_position_are_in_physical_space,
+        const bool distance_map_image_use_image_spacing,
+        const bool use_capsules,
+        const size_t num_threads) {
+    const auto primitives = collect_implicit_primitives(
+            input_sg, distance_map_image,
+            spatial_nodes_position_are_in_physical_space,
+            distance_map_image_use_image_spacing, use_capsules);
+    return rasterize_implicit_primitives(primitives, distance_map_image,
+                                         num_threads);
+}
+
+BinaryImageType::Pointer reconstruct_binary_image_from_distance_map(
+        const GraphType &input_sg,
+        const DistanceSampler &distance_sampler,
+        const bool spatial_nodes_position_are_in_physical_space,
+        const bool use_capsules,
+        const size_t num_threads) {
+    const auto primitives = collect_implicit_primitives(
+            input_sg, distance_sampler,
+            spatial_nodes_position_are_in_physical_space, use_capsules);
+    return rasterize_implicit_primitives(primitives, distance_sampler,
+                                         num_threads);
+}
+
+namespace detail {
+std::pair<bool, double> checkIsotropy(const FloatImageType *distance_map_image) {
+    return check_isotropy_impl(distance_map_image);
+}
+std::pair<bool, double> checkIsotropy(const DistanceSampler *distance_sampler) {
+    return check_isotropy_impl(distance_sampler);
+}
+
+std::pair<ArrayUtilities::Array3D, double>
+sphere_from_distance_map(const ArrayUtilities::Array3D &input_point,
+                         const FloatImageType *distance_map_image,
+                         const bool spatial_nodes_position_are_in_physical_space,
+                         const bool distance_map_image_use_image_spacing,
+                         const double radius_multiplier) {
+    return sphere_from_distance_map_impl(
+            input_point, distance_map_image,
+            spatial_nodes_position_are_in_physical_space,
+            distance_map_image_use_image_spacing, radius_multiplier);
+}
+std::pair<ArrayUtilities::Array3D, double>
+sphere_from_distance_map(const ArrayUtilities::Array3D &input_point,
+                         const DistanceSampler *distance_sampler,
+                         const bool spatial_nodes_position_are_in_physical_space,
+                         const bool distance_map_image_use_image_spacing,
+                         const double radius_multiplier) {
+    return sphere_from_distance_map_impl(
+            input_point, distance_sampler,
+            spatial_nodes_position_are_in_physical_space,
+            distance_map_image_use_image_spacing, radius_multiplier);
+}
+} // end namespace detail
+} // end namespace SG
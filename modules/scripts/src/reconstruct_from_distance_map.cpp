@@ -24,12 +24,16 @@
 #include "convert_to_vtk_unstructured_grid.hpp"
 
 #include <itkCastImageFilter.h>
+#include <itkMultiThreaderBase.h>
 #include <itkVTKImageToImageFilter.h>
 #include <vtkActor2D.h>
 #include <vtkButtonWidget.h>
 #include <vtkCallbackCommand.h>
 #include <vtkCaptionActor2D.h>
 #include <vtkDataSetMapper.h>
+#include <vtkFlyingEdges3D.h>
+#include <vtkFloatArray.h>
+#include <vtkIdList.h>
 #include <vtkImageData.h>
 #include <vtkImageStencil.h>
 #include <vtkNamedColors.h>
@@ -41,6 +45,8 @@
 #include <vtkTextProperty.h>
 #include <vtkTexturedButtonRepresentation2D.h>
 
+#include <algorithm>
+#include <limits>
 #include <tuple>
 
 #include "itksys/SystemTools.hxx"
@@ -65,9 +71,15 @@
 
 namespace SG {
 
-ReconstructOutput reconstruct_from_distance_map(
+namespace {
+/**
+ * Implementation of reconstruct_from_distance_map for FloatImageType and
+ * DistanceSampler.
+ */
+template <typename TDistanceMap>
+ReconstructOutput reconstruct_from_distance_map_impl(
         const GraphType &input_sg,
-        FloatImageType *distance_map_image,
+        TDistanceMap *distance_map_image,
         const bool spatial_nodes_position_are_in_physical_space,
         const bool distance_map_image_use_image_spacing,
         const std::unordered_map<GraphType::vertex_descriptor, size_t>
@@ -193,6 +205,244 @@ ReconstructOutput reconstruct_from_distance_map(
 
     return output;
 }
+} // namespace
+
+ReconstructOutput reconstruct_from_distance_map(
+        const GraphType &input_sg,
+        FloatImageType *distance_map_image,
+        const bool spatial_nodes_position_are_in_physical_space,
+        const bool distance_map_image_use_image_spacing,
+        const std::unordered_map<GraphType::vertex_descriptor, size_t>
+                &vertex_to_label_map,
+        const bool apply_color_to_edges) {
+    return reconstruct_from_distance_map_impl(
+            input_sg, distance_map_image,
+            spatial_nodes_position_are_in_physical_space,
+            distance_map_image_use_image_spacing, vertex_to_label_map,
+            apply_color_to_edges);
+}
+
+ReconstructOutput reconstruct_from_distance_map(
+        const GraphType &input_sg,
+        const DistanceSampler &distance_sampler,
+        const bool spatial_nodes_position_are_in_physical_space,
+        const std::unordered_map<GraphType::vertex_descriptor, size_t>
+                &vertex_to_label_map,
+        const bool apply_color_to_edges) {
+    const bool distance_map_image_use_image_spacing =
+            distance_sampler.use_image_spacing();
+    return reconstruct_from_distance_map_impl(
+            input_sg, &distance_sampler,
+            spatial_nodes_position_are_in_physical_space,
+            distance_map_image_use_image_spacing, vertex_to_label_map,
+            apply_color_to_edges);
+}
+namespace {
+/**
+ * Marching cubes over the field of the primitives.
+ * Shared by the FloatImageType and DistanceSampler overloads of
+ * reconstruct_from_distance_map_implicit.
+ */
+ReconstructOutput reconstruct_from_primitives(
+        const std::vector<ImplicitPrimitive> &primitives,
+        const double grid_spacing,
+        const std::unordered_map<GraphType::vertex_descriptor, size_t>
+                &vertex_to_label_map,
+        const size_t num_threads) {
+    ReconstructOutput output;
+    const bool vertex_to_label_map_provided = !vertex_to_label_map.empty();
+    const auto grid = evaluate_implicit_field(
+            primitives, grid_spacing, vertex_to_label_map_provided,
+            num_threads);
+    if (grid.values.empty()) {
+        output.poly_data = vtkSmartPointer<vtkPolyData>::New();
+        return output;
+    }
+
+    // Flying edges on each active block, over the cells between its samples
+    // and the first samples of the next blocks. The cells of the blocks do
+    // not overlap, and the blocks are independent pipelines.
+    constexpr size_t block_size = ImplicitFieldGrid::block_size;
+    std::vector<vtkSmartPointer<vtkPolyData>> block_surfaces(grid.blocks.size());
+    auto threader = itk::MultiThreaderBase::New();
+    if (num_threads > 0) {
+        threader->SetMaximumNumberOfThreads(num_threads);
+        threader->SetNumberOfWorkUnits(num_threads);
+    }
+    threader->ParallelizeArray(
+            0, grid.blocks.size(),
+            [&](itk::SizeValueType b) {
+                const auto &block = grid.blocks[b];
+                size_t begin[3];
+                int dimensions[3];
+                for (size_t i = 0; i < 3; ++i) {
+                    begin[i] = block[i] * block_size;
+                    dimensions[i] = static_cast<int>(
+                            std::min(block_size + 1, grid.size[i] - begin[i]));
+                }
+                auto field_array = vtkSmartPointer<vtkFloatArray>::New();
+                field_array->SetName("SignedDistance");
+                field_array->SetNumberOfComponents(1);
+                field_array->SetNumberOfTuples(
+                        static_cast<vtkIdType>(dimensions[0]) * dimensions[1] *
+                        dimensions[2]);
+                float *field = field_array->GetPointer(0);
+                bool has_inside = false;
+                bool has_outside = false;
+                for (int z = 0; z < dimensions[2]; ++z) {
+                    for (int y = 0; y < dimensions[1]; ++y) {
+                        for (int x = 0; x < dimensions[0]; ++x) {
+                            const float value = grid.value(
+                                    begin[0] + x, begin[1] + y, begin[2] + z);
+                            has_inside |= value < 0.0f;
+                            has_outside |= value >= 0.0f;
+                            *field++ = value;
+                        }
+                    }
+                }
+                if (!has_inside || !has_outside) {
+                    return;
+                }
+                auto field_image = vtkSmartPointer<vtkImageData>::New();
+                field_image->SetDimensions(dimensions);
+                field_image->SetOrigin(
+                        grid.origin[0] + begin[0] * grid.spacing,
+                        grid.origin[1] + begin[1] * grid.spacing,
+                        grid.origin[2] + begin[2] * grid.spacing);
+                field_image->SetSpacing(grid.spacing, grid.spacing,
+                                        grid.spacing);
+                field_image->GetPointData()->SetScalars(field_array);
+
+                auto contour = vtkSmartPointer<vtkFlyingEdges3D>::New();
+                contour->SetInputData(field_image);
+                contour->SetValue(0, 0.0);
+                contour->ComputeNormalsOff();
+                contour->ComputeScalarsOff();
+                contour->Update();
+                block_surfaces[b] = vtkSmartPointer<vtkPolyData>::New();
+                block_surfaces[b]->ShallowCopy(contour->GetOutput());
+            },
+            nullptr);
+
+    // Join the blocks, merging the points shared by neighbor blocks.
+    auto append = vtkSmartPointer<vtkAppendPolyData>::New();
+    for (const auto &block_surface : block_surfaces) {
+        if (block_surface && block_surface->GetNumberOfCells() > 0) {
+            append->AddInputData(block_surface);
+        }
+    }
+    if (append->GetNumberOfInputConnections(0) == 0) {
+        output.poly_data = vtkSmartPointer<vtkPolyData>::New();
+        return output;
+    }
+    auto clean = vtkSmartPointer<vtkCleanPolyData>::New();
+    clean->SetInputConnection(append->GetOutputPort());
+    clean->ToleranceIsAbsoluteOn();
+    clean->SetAbsoluteTolerance(1e-6 * grid.spacing);
+    clean->ConvertPolysToLinesOff();
+    clean->ConvertLinesToPointsOff();
+    auto normals = vtkSmartPointer<vtkPolyDataNormals>::New();
+    normals->SetInputConnection(clean->GetOutputPort());
+    normals->SplittingOff();
+    normals->ConsistencyOff();
+    normals->Update();
+    output.poly_data = normals->GetOutput();
+
+    if (vertex_to_label_map_provided) {
+        // Each cell gets the label of the grid sample closest to its first
+        // point, the label of the closest primitive to that sample.
+        auto poly_data = output.poly_data;
+        auto colors = vtkSmartPointer<vtkUnsignedLongArray>::New();
+        colors->SetNumberOfComponents(1);
+        colors->SetName("Colors");
+        colors->SetNumberOfTuples(poly_data->GetNumberOfCells());
+        auto cell_points = vtkSmartPointer<vtkIdList>::New();
+        for (vtkIdType c = 0; c < poly_data->GetNumberOfCells(); ++c) {
+            poly_data->GetCellPoints(c, cell_points);
+            double point[3];
+            poly_data->GetPoint(cell_points->GetId(0), point);
+            size_t sample_index[3];
+            for (size_t i = 0; i < 3; ++i) {
+                const double continuous =
+                        (point[i] - grid.origin[i]) / grid.spacing;
+                sample_index[i] = std::min(
+                        static_cast<size_t>(
+                                std::max(0.0, std::floor(continuous + 0.5))),
+                        grid.size[i] - 1);
+            }
+            const size_t sample = grid.find_sample(
+                    sample_index[0], sample_index[1], sample_index[2]);
+            colors->SetValue(c, sample < grid.labels.size()
+                                        ? grid.labels[sample]
+                                        : std::numeric_limits<int>::max());
+        }
+        poly_data->GetCellData()->SetScalars(colors);
+
+        const size_t max_label =
+                std::max_element(
+                        vertex_to_label_map.begin(), vertex_to_label_map.end(),
+                        [](const std::pair<GraphType::vertex_descriptor, size_t>
+                                   &p1,
+                           const std::pair<GraphType::vertex_descriptor, size_t>
+                                   &p2) { return p1.second < p2.second; })
+                        ->second;
+        output.lut =
+                detail::createLookupTable(max_label, "Brewer Qualitative Set1");
+    }
+    return output;
+}
+
+template <typename TDistanceMap>
+double default_grid_spacing(const TDistanceMap *distance_map_image) {
+    const auto &spacing = distance_map_image->GetSpacing();
+    return *std::min_element(spacing.Begin(), spacing.End());
+}
+} // namespace
+
+ReconstructOutput reconstruct_from_distance_map_implicit(
+        const GraphType &input_sg,
+        FloatImageType *distance_map_image,
+        const bool spatial_nodes_position_are_in_physical_space,
+        const bool distance_map_image_use_image_spacing,
+        const std::unordered_map<GraphType::vertex_descriptor, size_t>
+                &vertex_to_label_map,
+        const bool apply_color_to_edges,
+        const bool use_capsules,
+        const double grid_spacing,
+        const size_t num_threads) {
+    const auto primitives = collect_implicit_primitives(
+            input_sg, distance_map_image,
+            spatial_nodes_position_are_in_physical_space,
+            distance_map_image_use_image_spacing, use_capsules,
+            vertex_to_label_map, apply_color_to_edges);
+    return reconstruct_from_primitives(
+            primitives,
+            grid_spacing > 0.0 ? grid_spacing
+                               : default_grid_spacing(distance_map_image),
+            vertex_to_label_map, num_threads);
+}
+
+ReconstructOutput reconstruct_from_distance_map_implicit(
+        const GraphType &input_sg,
+        const DistanceSampler &distance_sampler,
+        const bool spatial_nodes_position_are_in_physical_space,
+        const std::unordered_map<GraphType::vertex_descriptor, size_t>
+                &vertex_to_label_map,
+        const bool apply_color_to_edges,
+        const bool use_capsules,
+        const double grid_spacing,
+        const size_t num_threads) {
+    const auto primitives = collect_implicit_primitives(
+            input_sg, distance_sampler,
+            spatial_nodes_position_are_in_physical_space, use_capsules,
+            vertex_to_label_map, apply_color_to_edges);
+    return reconstruct_from_primitives(
+            primitives,
+            grid_spacing > 0.0 ? grid_spacing
+                               : default_grid_spacing(&distance_sampler),
+            vertex_to_label_map, num_threads);
+}
+
 BinaryImageType::Pointer
 poly_data_to_binary_image(vtkPolyData *poly_data,
                           const FloatImageType::Pointer &reference_image) {
@@ -501,77 +751,57 @@ void applyColorToSphere(vtkSphereSource *sphereSource,
     sphereData->GetCellData()->SetScalars(colors);
 }
 
-std::pair<bool, double> checkIsotropy(const FloatImageType *distance_map_image) {
-    const auto & dmap_spacing = distance_map_image->GetSpacing();
-    const auto min_max_spacing_pair = std::minmax_element(
-            dmap_spacing.Begin(), dmap_spacing.End());
-
-    const auto & min_sp = *min_max_spacing_pair.first;
-    const auto & max_sp = *min_max_spacing_pair.second;
-    if (itk::Math::FloatAlmostEqual(min_sp, max_sp)) {
-        return std::make_pair(true, max_sp);
-    } else {
-        return std::make_pair(false, (min_sp + max_sp)/2.0);
-    }
-}
-
+namespace {
+template <typename TDistanceMap>
 vtkSmartPointer<vtkSphereSource>
-createSphereSource(const ArrayUtilities::Array3D &input_point,
-                   FloatImageType *distance_map_image,
-                   const bool spatial_nodes_position_are_in_physical_space,
-                   const bool distance_map_image_use_image_spacing,
-                   const double radius_multiplier) {
+create_sphere_source_impl(const ArrayUtilities::Array3D &input_point,
+                          TDistanceMap *distance_map_image,
+                          const bool spatial_nodes_position_are_in_physical_space,
+                          const bool distance_map_image_use_image_spacing,
+                          const double radius_multiplier) {
 
     vtkSmartPointer<vtkSphereSource> sphereSource =
             vtkSmartPointer<vtkSphereSource>::New();
-    double dmap_value;
-
-    // Set Center
-    if (spatial_nodes_position_are_in_physical_space) {
-        sphereSource->SetCenter(input_point[0], input_point[1],
-                                input_point[2]); // point
-    } else {
-        FloatImageType::PointType itk_point;
-        FloatImageType::IndexType itk_index;
-        for (size_t i = 0; i < FloatImageType::ImageDimension; ++i) {
-            itk_index[i] = input_point[i];
-        }
-        distance_map_image->TransformIndexToPhysicalPoint(itk_index, itk_point);
-        sphereSource->SetCenter(itk_point[0], itk_point[1],
-                                itk_point[2]); // point
-    }
-    // Set Radius:
-    if (spatial_nodes_position_are_in_physical_space) {
-        FloatImageType::PointType itk_point;
-        FloatImageType::IndexType itk_index;
-        for (size_t i = 0; i < FloatImageType::ImageDimension; ++i) {
-            itk_point[i] = input_point[i];
-        }
-        distance_map_image->TransformPhysicalPointToIndex(itk_point, itk_index);
-        dmap_value = distance_map_image->GetPixel(itk_index);
-    } else {
-        FloatImageType::IndexType itk_index;
-        for (size_t i = 0; i < FloatImageType::ImageDimension; ++i) {
-            itk_index[i] = input_point[i];
-        }
-        dmap_value = distance_map_image->GetPixel(itk_index);
-    }
-    // dmap_value can represent number of pixels to the object border,
-    // or a physical distance
-    if (distance_map_image_use_image_spacing) {
-        sphereSource->SetRadius(dmap_value);
-    } else {
-        // Use checkIsotropic to get the radius multiplier.
-        // Only works reliable if image is isotropic, a warning is raised
-        // in the function calling createSphereSource if not.
-        sphereSource->SetRadius(dmap_value * radius_multiplier);
-    }
+    // Use checkIsotropic to get the radius multiplier.
+    // Only works reliable if image is isotropic, a warning is raised
+    // in the function calling createSphereSource if not.
+    const auto center_radius = sphere_from_distance_map(
+            input_point, distance_map_image,
+            spatial_nodes_position_are_in_physical_space,
+            distance_map_image_use_image_spacing, radius_multiplier);
+    const auto &center = center_radius.first;
+    sphereSource->SetCenter(center[0], center[1], center[2]);
+    sphereSource->SetRadius(center_radius.second);
 
     // sphereSource->SetThetaResolution(100);
     // sphereSource->SetPhiResolution(100);
     sphereSource->Update();
     return sphereSource;
 }
+} // namespace
+
+vtkSmartPointer<vtkSphereSource>
+createSphereSource(const ArrayUtilities::Array3D &input_point,
+                   FloatImageType *distance_map_image,
+                   const bool spatial_nodes_position_are_in_physical_space,
+                   const bool distance_map_image_use_image_spacing,
+                   const double radius_multiplier) {
+    return create_sphere_source_impl(
+            input_point, distance_map_image,
+            spatial_nodes_position_are_in_physical_space,
+            distance_map_image_use_image_spacing, radius_multiplier);
+}
+vtkSmartPointer<vtkSphereSource>
+createSphereSource(const ArrayUtilities::Array3D &input_point,
+                   const DistanceSampler *distance_sampler,
+                   const bool spatial_nodes_position_are_in_physical_space,
+                   const bool distance_map_image_use_image_spacing,
+                   const double radius_multiplier) {
+    return create_sphere_source_impl(
+            input_point, distance_sampler,
+            spatial_nodes_position_are_in_physical_space,
+            distance_map_image_use_image_spacing, radius_multiplier);
+}
 
 vtkSmartPointer<vtkLookupTable>
 createLookupTable(const size_t max_label, const std::string &color_scheme) {
@@ -0,0 +1,185 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+#include "implicit_reconstruction.hpp"
+
+#include "gmock/gmock.h"
+
+struct ImplicitReconstructionFixture : public ::testing::Test {
+    using GraphType = SG::GraphType;
+    GraphType g0;
+    SG::FloatImageType::Pointer distance_map_image = SG::FloatImageType::New();
+
+    void SetUp() override {
+        using RegionType = typename SG::FloatImageType::RegionType;
+        typename RegionType::IndexType itk_index;
+        itk_index.Fill(0);
+        typename RegionType::SizeType itk_size;
+        itk_size[0] = 40;
+        itk_size[1] = 20;
+        itk_size[2] = 20;
+        RegionType itk_region(itk_index, itk_size);
+        distance_map_image->SetRegions(itk_region);
+        distance_map_image->Allocate();
+        distance_map_image->FillBuffer(3.0);
+
+        // Straight edge along x, with edge points every 4 voxels.
+        this->g0 = GraphType(2);
+        g0[0].pos = {{5, 10, 10}};
+        g0[1].pos = {{29, 10, 10}};
+        SG::SpatialEdge se;
+        for (int x = 9; x < 29; x += 4) {
+            se.edge_points.push_back({{static_cast<double>(x), 10, 10}});
+        }
+        boost::add_edge(0, 1, se, g0);
+    }
+};
+
+TEST(signed_distance_to_primitive, sphere_and_capsule) {
+    const SG::ImplicitPrimitive sphere{
+            {{0, 0, 0}}, {{0, 0, 0}}, 2.0, 2.0, 0};
+    EXPECT_DOUBLE_EQ(SG::signed_distance_to_primitive(sphere, {{0, 0, 0}}),
+                     -2.0);
+    EXPECT_DOUBLE_EQ(SG::signed_distance_to_primitive(sphere, {{0, 3, 0}}),
+                     1.0);
+    const SG::ImplicitPrimitive capsule{
+            {{0, 0, 0}}, {{10, 0, 0}}, 1.0, 3.0, 0};
+    // Radius interpolated in the middle
+    EXPECT_DOUBLE_EQ(SG::signed_distance_to_primitive(capsule, {{5, 2, 0}}),
+                     0.0);
+    // Beyond the end, distance to the end sphere
+    EXPECT_DOUBLE_EQ(SG::signed_distance_to_primitive(capsule, {{14, 0, 0}}),
+                     1.0);
+}
+
+TEST_F(ImplicitReconstructionFixture, collect_implicit_primitives) {
+    const auto spheres = SG::collect_implicit_primitives(
+            g0, distance_map_image.GetPointer(), false, false, false);
+    // 2 nodes + 5 edge points
+    EXPECT_EQ(spheres.size(), 7);
+    const auto capsules = SG::collect_implicit_primitives(
+            g0, distance_map_image.GetPointer(), false, false, true);
+    // 2 nodes + 6 segments of the polyline
+    EXPECT_EQ(capsules.size(), 8);
+    for (const auto &primitive : capsules) {
+        EXPECT_DOUBLE_EQ(primitive.start_radius, 3.0);
+        EXPECT_DOUBLE_EQ(primitive.end_radius, 3.0);
+    }
+}
+
+TEST_F(ImplicitReconstructionFixture,
+       reconstruct_binary_image_from_distance_map) {
+    const bool spatial_nodes_position_are_in_physical_space = false;
+    const bool distance_map_image_use_image_spacing = false;
+    const bool use_capsules = true;
+    const auto binary_image = SG::reconstruct_binary_image_from_distance_map(
+            g0, distance_map_image.GetPointer(),
+            spatial_nodes_position_are_in_physical_space,
+            distance_map_image_use_image_spacing, use_capsules);
+    SG::BinaryImageType::IndexType index;
+    // On the axis
+    index[0] = 17;
+    index[1] = 10;
+    index[2] = 10;
+    EXPECT_EQ(binary_image->GetPixel(index), 1);
+    // At distance radius from the axis
+    index[1] = 13;
+    EXPECT_EQ(binary_image->GetPixel(index), 1);
+    // Outside the radius
+    index[1] = 14;
+    EXPECT_EQ(binary_image->GetPixel(index), 0);
+    // Beyond the end nodes
+    index[0] = 33;
+    index[1] = 10;
+    EXPECT_EQ(binary_image->GetPixel(index), 0);
+    index[0] = 1;
+    EXPECT_EQ(binary_image->GetPixel(index), 0);
+
+    // Compare with a brute force evaluation of the primitives
+    const auto primitives = SG::collect_implicit_primitives(
+            g0, distance_map_image.GetPointer(),
+            spatial_nodes_position_are_in_physical_space,
+            distance_map_image_use_image_spacing, use_capsules);
+    const auto &size = binary_image->GetLargestPossibleRegion().GetSize();
+    size_t mismatches = 0;
+    for (size_t z = 0; z < size[2]; z++) {
+        for (size_t y = 0; y < size[1]; y++) {
+            for (size_t x = 0; x < size[0]; x++) {
+                index[0] = x;
+                index[1] = y;
+                index[2] = z;
+                const ArrayUtilities::Array3D point = {
+                        {static_cast<double>(x), static_cast<double>(y),
+                         static_cast<double>(z)}};
+                bool inside = false;
+                for (const auto &primitive : primitives) {
+                    inside |= SG::signed_distance_to_primitive(primitive,
+                                                               point) <= 0.0;
+                }
+                mismatches += inside != (binary_image->GetPixel(index) == 1);
+            }
+        }
+    }
+    EXPECT_EQ(mismatches, 0);
+}
+
+TEST_F(ImplicitReconstructionFixture, evaluate_implicit_field) {
+    const auto primitives = SG::collect_implicit_primitives(
+            g0, distance_map_image.GetPointer());
+    const double grid_spacing = 0.5;
+    const bool compute_labels = true;
+    const auto grid = SG::evaluate_implicit_field(primitives, grid_spacing,
+                                                  compute_labels);
+    // Only the active blocks are stored.
+    ASSERT_EQ(grid.values.size(),
+              grid.active_blocks * SG::ImplicitFieldGrid::block_num_samples);
+    EXPECT_EQ(grid.labels.size(), grid.values.size());
+    EXPECT_GT(grid.active_blocks, 0);
+    EXPECT_LE(grid.active_blocks, grid.total_blocks);
+    EXPECT_EQ(grid.blocks.size(), grid.active_blocks);
+    // The field is exact near the surface
+    size_t num_negative = 0;
+    for (size_t z = 0; z < grid.size[2]; z++) {
+        for (size_t y = 0; y < grid.size[1]; y++) {
+            for (size_t x = 0; x < grid.size[0]; x++) {
+                const ArrayUtilities::Array3D point = {
+                        {grid.origin[0] + x * grid.spacing,
+                         grid.origin[1] + y * grid.spacing,
+                         grid.origin[2] + z * grid.spacing}};
+                double expected = std::numeric_limits<double>::max();
+                for (const auto &primitive : primitives) {
+                    expected = std::min(expected,
+                                        SG::signed_distance_to_primitive(
+                                                primitive, point));
+                }
+                const auto value = grid.value(x, y, z);
+                if (std::abs(expected) < 2 * grid.spacing) {
+                    EXPECT_NEAR(value, expected, 1e-5);
+                } else {
+                    EXPECT_EQ(value > 0, expected > 0);
+                }
+                num_negative += value < 0;
+            }
+        }
+    }
+    EXPECT_GT(num_negative, 0);
+    EXPECT_THROW(SG::evaluate_implicit_field(primitives, 0.0),
+                 std::runtime_error);
+}
@@ -19,6 +19,8 @@
  * *******************************************************************/
 
 #include "reconstruct_from_distance_map.hpp"
+#include <vtkCellData.h>
+#include <vtkFeatureEdges.h>
 
 #include "gmock/gmock.h"
 
@@ -172,3 +174,34 @@ TEST_F(TreeFixture, reconstruct_from_distance_map) {
             distance_map_image_use_image_spacing, vertex_to_label_map,
             apply_color_to_edges);
 }
+
+TEST_F(TreeFixture, reconstruct_from_distance_map_implicit) {
+    std::unordered_map<GraphType::vertex_descriptor, size_t>
+            vertex_to_label_map;
+    for (size_t i = 0; i < 10; ++i) {
+        vertex_to_label_map.emplace(i, i % 3);
+    }
+    const bool spatial_nodes_position_are_in_physical_space = false;
+    const bool distance_map_image_use_image_spacing = false;
+    const bool apply_color_to_edges = true;
+    auto output = SG::reconstruct_from_distance_map_implicit(
+            g0, distance_map_image,
+            spatial_nodes_position_are_in_physical_space,
+            distance_map_image_use_image_spacing, vertex_to_label_map,
+            apply_color_to_edges);
+    EXPECT_GT(output.poly_data->GetNumberOfCells(), 0);
+    // The surfaces of the blocks are joined without gaps.
+    auto boundary_edges = vtkSmartPointer<vtkFeatureEdges>::New();
+    boundary_edges->SetInputData(output.poly_data);
+    boundary_edges->BoundaryEdgesOn();
+    boundary_edges->FeatureEdgesOff();
+    boundary_edges->NonManifoldEdgesOff();
+    boundary_edges->ManifoldEdgesOff();
+    boundary_edges->Update();
+    EXPECT_EQ(boundary_edges->GetOutput()->GetNumberOfCells(), 0);
+    EXPECT_TRUE(output.lut);
+    auto colors = output.poly_data->GetCellData()->GetArray("Colors");
+    ASSERT_TRUE(colors);
+    EXPECT_EQ(colors->GetNumberOfTuples(),
+              output.poly_data->GetNumberOfCells());
+}
@@ -21,6 +21,7 @@
 #ifndef SG_TREE_GENERATION_HPP
 #define SG_TREE_GENERATION_HPP
 
+#include "distance_sampler.hpp"
 #include "image_types.hpp" // for FloatImageType
 
 #include "spatial_graph.hpp"
@@ -126,6 +127,26 @@ VertexGenerationMap tree_generation(
         const AnomalyParameters &anomaly_parameters = AnomalyParameters(),
         const bool verbose = false);
 
+/**
+ * @ref tree_generation computing the radius lazily from a binary image, only
+ * at the positions of nodes and edge points required by the algorithm,
+ * instead of using a precomputed distance map image. @sa DistanceSampler
+ */
+VertexGenerationMap tree_generation(
+        const GraphType &graph,
+        const DistanceSampler &distance_sampler,
+        const bool spatial_nodes_position_are_in_physical_space = false,
+        const double &decrease_radius_ratio_to_increase_generation = 0.1,
+        const double &keep_generation_if_angle_less_than = 10,
+        const double &increase_generation_if_angle_greater_than = 40,
+        const size_t &num_of_edge_points_to_compute_angle = 5,
+        const std::vector<GraphType::vertex_descriptor> &input_roots =
+        std::vector<GraphType::vertex_descriptor>(),
+        const VertexGenerationMap &input_fixed_generation_map =
+                VertexGenerationMap(),
+        const AnomalyParameters &anomaly_parameters = AnomalyParameters(),
+        const bool verbose = false);
+
 /**
  * Read/Write a CSV-like file containing a one-line header and two
  * comma-separated values with vertex_id and generation.
@@ -70,8 +70,13 @@ target vertex is colored black at the time of examination. The color black
 indicates that the vertex is no longer in the queue.
 - vis.finish_vertex(u, g) is invoked after all of the out edges of u have been
 examined and all of the adjacent vertices have been discovered.
+
+ @tparam TDistanceMapPointer pointer-like to a distance map. FloatImageType by
+ default, but any type with GetPixel and TransformPhysicalPointToIndex is
+ valid, for example a pointer to a DistanceSampler.
  */
-template <typename SpatialGraph>
+template <typename SpatialGraph,
+          typename TDistanceMapPointer = typename SG::FloatImageType::Pointer>
 struct TreeGenerationVisitor : public boost::default_bfs_visitor {
     using SpatialGraphVertexBundle =
             typename boost::vertex_bundle_type<SpatialGraph>::type;
@@ -94,7 +99,7 @@ struct TreeGenerationVisitor : public boost::default_bfs_visitor {
 
     TreeGenerationVisitor(
             VertexToGenerationMap &vertex_to_generation_map,
-            const typename SG::FloatImageType::Pointer &distance_map_image,
+            const TDistanceMapPointer &distance_map_image,
             const VertexToLocalRadiusMap &vertex_to_local_radius_map,
             VertexToDistanceFromRootMap &vertex_to_distance_from_root_map,
             const double &decrease_radius_ratio = 0.1,             // 10%
@@ -126,7 +131,7 @@ struct TreeGenerationVisitor : public boost::default_bfs_visitor {
 
     // Copy constructor. The breadth_first_search takes a copy of the input
     // visitor.
-    TreeGenerationVisitor(const TreeGenerationVisitor<SpatialGraph> &other)
+    TreeGenerationVisitor(const TreeGenerationVisitor &other)
             : boost::default_bfs_visitor(other),
               m_vertex_to_generation_map(other.m_vertex_to_generation_map),
               m_distance_map_image(other.m_distance_map_image),
@@ -153,7 +158,7 @@ struct TreeGenerationVisitor : public boost::default_bfs_visitor {
      * This is the output of the visitor.
      */
     VertexToGenerationMap &m_vertex_to_generation_map;
-    const typename SG::FloatImageType::Pointer &m_distance_map_image;
+    const TDistanceMapPointer &m_distance_map_image;
     /**
      * A map from vertex to the value of the local radius, obtained from
      * a distance map.
@@ -27,24 +27,31 @@
 
 namespace SG {
 
+namespace {
+/**
+ * Implementation of tree_generation for any pointer-like distance map:
+ * FloatImageType::Pointer or a pointer to DistanceSampler.
+ */
+template <typename TDistanceMapPointer>
 VertexGenerationMap
-tree_generation(const GraphType &graph,
-                const typename FloatImageType::Pointer &distance_map_image,
-                const bool spatial_nodes_position_are_in_physical_space,
-                const double &decrease_radius_ratio_to_increase_generation,
-                const double &keep_generation_if_angle_less_than,
-                const double &increase_generation_if_angle_greater_than,
-                const size_t &num_of_edge_points_to_compute_angle,
-                const std::vector<GraphType::vertex_descriptor> &input_roots,
-                const VertexGenerationMap &input_fixed_generation_map,
-                const AnomalyParameters &anomaly_parameters,
-                const bool verbose) {
+tree_generation_impl(const GraphType &graph,
+                     const TDistanceMapPointer &distance_map_image,
+                     const bool spatial_nodes_position_are_in_physical_space,
+                     const double &decrease_radius_ratio_to_increase_generation,
+                     const double &keep_generation_if_angle_less_than,
+                     const double &increase_generation_if_angle_greater_than,
+                     const size_t &num_of_edge_points_to_compute_angle,
+                     const std::vector<GraphType::vertex_descriptor> &input_roots,
+                     const VertexGenerationMap &input_fixed_generation_map,
+                     const AnomalyParameters &anomaly_parameters,
+                     const bool verbose) {
     using vertex_descriptor = GraphType::vertex_descriptor;
     // Start the visit at the root
     // As a first approximation, we select as root the vertex with largest
     // radius
-    const auto vertex_to_radius_map = create_vertex_to_radius_map(
-            distance_map_image, graph,
+    const auto vertex_to_radius_map =
+            detail::create_vertex_to_radius_map_generic(
+            &*distance_map_image, graph,
             spatial_nodes_position_are_in_physical_space, verbose);
     // Manage roots
     if(verbose) {
@@ -65,8 +72,9 @@ tree_generation(const GraphType &graph,
         }
         for (size_t comp_index = 0; comp_index < num_of_components; comp_index++) {
             const auto & comp_graph  = component_graphs[comp_index];
-            const auto comp_vertex_to_radius_map = create_vertex_to_radius_map(
-                    distance_map_image, comp_graph,
+            const auto comp_vertex_to_radius_map =
+                    detail::create_vertex_to_radius_map_generic(
+                    &*distance_map_image, comp_graph,
                     spatial_nodes_position_are_in_physical_space, verbose);
             using vertex_radius_pair = std::pair<GraphType::vertex_descriptor, double>;
             const auto max_radius_element = std::max_element(
@@ -130,9 +138,10 @@ tree_generation(const GraphType &graph,
     // - targets with bigger radius than source,
     // - end points (degree 1)
     // - number of edge points is lesser than:
-    TreeGenerationVisitor<GraphType>::VertexAnomalies vertex_anomalies;
+    using Visitor = TreeGenerationVisitor<GraphType, TDistanceMapPointer>;
+    typename Visitor::VertexAnomalies vertex_anomalies;
     // Start the visit from root
-    TreeGenerationVisitor<GraphType> visitor(
+    Visitor visitor(
             vertex_to_generation_map, distance_map_image, vertex_to_radius_map,
             vertex_to_distance_from_root_map,
             decrease_radius_ratio_to_increase_generation,
@@ -172,6 +181,52 @@ tree_generation(const GraphType &graph,
     }
     return vertex_to_generation_map;
 }
+} // namespace
+
+VertexGenerationMap
+tree_generation(const GraphType &graph,
+                const typename FloatImageType::Pointer &distance_map_image,
+                const bool spatial_nodes_position_are_in_physical_space,
+                const double &decrease_radius_ratio_to_increase_generation,
+                const double &keep_generation_if_angle_less_than,
+                const double &increase_generation_if_angle_greater_than,
+                const size_t &num_of_edge_points_to_compute_angle,
+                const std::vector<GraphType::vertex_descriptor> &input_roots,
+                const VertexGenerationMap &input_fixed_generation_map,
+                const AnomalyParameters &anomaly_parameters,
+                const bool verbose) {
+    return tree_generation_impl(
+            graph, distance_map_image,
+            spatial_nodes_position_are_in_physical_space,
+            decrease_radius_ratio_to_increase_generation,
+            keep_generation_if_angle_less_than,
+            increase_generation_if_angle_greater_than,
+            num_of_edge_points_to_compute_angle, input_roots,
+            input_fixed_generation_map, anomaly_parameters, verbose);
+}
+
+VertexGenerationMap
+tree_generation(const GraphType &graph,
+                const DistanceSampler &distance_sampler,
+                const bool spatial_nodes_position_are_in_physical_space,
+                const double &decrease_radius_ratio_to_increase_generation,
+                const double &keep_generation_if_angle_less_than,
+                const double &increase_generation_if_angle_greater_than,
+                const size_t &num_of_edge_points_to_compute_angle,
+                const std::vector<GraphType::vertex_descriptor> &input_roots,
+                const VertexGenerationMap &input_fixed_generation_map,
+                const AnomalyParameters &anomaly_parameters,
+                const bool verbose) {
+    const DistanceSampler *distance_sampler_pointer = &distance_sampler;
+    return tree_generation_impl(
+            graph, distance_sampler_pointer,
+            spatial_nodes_position_are_in_physical_space,
+            decrease_radius_ratio_to_increase_generation,
+            keep_generation_if_angle_less_than,
+            increase_generation_if_angle_greater_than,
+            num_of_edge_points_to_compute_angle, input_roots,
+            input_fixed_generation_map, anomaly_parameters, verbose);
+}
 
 VertexGenerationMap read_vertex_to_generation_map(
         const std::string &input_fixed_generation_map_file) {
@@ -0,0 +1,133 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+#ifndef SG_ASYNC_RESULT_PY_H
+#define SG_ASYNC_RESULT_PY_H
+
+#include "pybind11_common.h"
+
+#include <chrono>
+#include <future>
+#include <type_traits>
+
+namespace SG {
+
+/**
+ * Result of a function running in a separate thread, @sa make_async.
+ * The destructor waits for the function to finish, releasing the GIL if
+ * the calling thread holds it, so the function can acquire it meanwhile.
+ */
+template <typename T> class async_result {
+  public:
+    explicit async_result(std::future<T> &&future)
+            : future_(future.share()) {}
+    async_result(const async_result &) = default;
+    async_result(async_result &&) = default;
+    async_result &operator=(const async_result &) = default;
+    async_result &operator=(async_result &&) = default;
+    ~async_result() {
+        // The shared state of std::async blocks the destructor of its last
+        // reference. Wait here instead, without holding the GIL.
+        if (!future_.valid() || done()) {
+            return;
+        }
+        if (PyGILState_Check()) {
+            pybind11::gil_scoped_release release;
+            future_.wait();
+        } else {
+            future_.wait();
+        }
+    }
+    bool done() const {
+        return future_.wait_for(std::chrono::seconds(0)) ==
+               std::future_status::ready;
+    }
+    /** Wait at most timeout seconds, negative waits until done. */
+    bool wait(const double timeout) const {
+        if (timeout < 0) {
+            future_.wait();
+            return true;
+        }
+        return future_.wait_for(std::chrono::duration<double>(timeout)) ==
+               std::future_status::ready;
+    }
+    /** Rethrows the exception of the function, if any. */
+    decltype(auto) get() const { return future_.get(); }
+
+  private:
+    std::shared_future<T> future_;
+};
+
+/**
+ * Wrap function to run in a separate thread. The arguments are copied
+ * before the thread starts, the wrapped function returns an async_result
+ * immediately.
+ */
+template <typename TReturn, typename... TArgs>
+auto make_async(TReturn (*function)(TArgs...)) {
+    return [function](std::decay_t<TArgs>... args) {
+        return async_result<TReturn>(
+                std::async(std::launch::async, [function, args...]() {
+                    return function(args...);
+                }));
+    };
+}
+
+/**
+ * Python class of async_result<T>, similar to concurrent.futures.Future.
+ * The GIL is released while waiting.
+ */
+template <typename T>
+void declare_async_result(pybind11::module &m, const char *name) {
+    namespace py = pybind11;
+    py::class_<async_result<T>>(m, name, R"(
+Result of a function running in a separate thread, the GIL is released
+while it runs. Deleting it waits until the function finishes.
+)")
+            .def("done", &async_result<T>::done,
+                 R"(True if the function has finished.)")
+            .def("wait", &async_result<T>::wait,
+                 py::arg("timeout") = -1.0,
+                 py::call_guard<py::gil_scoped_release>(),
+                 R"(
+Wait until the function finishes, or at most timeout seconds if timeout is
+not negative. Returns True if the function has finished.
+)")
+            .def("result",
+                 [](const async_result<T> &self) -> py::object {
+                     {
+                         py::gil_scoped_release release;
+                         self.wait(-1.0);
+                     }
+                     if constexpr (std::is_void_v<T>) {
+                         self.get();
+                         return py::none();
+                     } else {
+                         return py::cast(self.get());
+                     }
+                 },
+                 R"(
+Wait until the function finishes and return its result. Exceptions of the
+function are raised here.
+)");
+}
+
+} // end namespace SG
+#endif
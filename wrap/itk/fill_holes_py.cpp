@@ -71,4 +71,73 @@ verbose: bool
             py::arg("iterations") = 1000,
             py::arg("verbose") = false
          );
+
+const std::string fill_holes_voting_front_docs =
+R"delimiter(
+Same result than fill_holes, but after the first iteration only the
+neighborhood of the pixels changed in the previous iteration is visited.
+It is faster for large images.
+
+Parameters:
+----------
+input: BinaryImageType
+    input binary image.
+
+radius: int
+    radius that define the neighborhood. Defaults to 1.
+
+majority: int
+    number of pixels over 50% in the neighborhood of an OFF pixel
+    to turn it into ON. Defaults to 3.
+
+iterations: int
+    Max number of iterations. Defaults to 1000.
+
+num_threads: int
+    number of threads, 0 uses the default of ITK.
+
+verbose: bool
+    extra information displayed during the algorithm.
+
+)delimiter";
+    m.def("fill_holes_voting_front", &fill_holes_voting_front_function,
+            fill_holes_voting_front_docs.c_str(),
+            py::arg("input"),
+            py::arg("radius") = 1,
+            py::arg("majority") = 3,
+            py::arg("iterations") = 1000,
+            py::arg("num_threads") = 0,
+            py::arg("verbose") = false
+         );
+
+const std::string fill_holes_cavities_docs =
+R"delimiter(
+Fill the cavities of the binary image: background pixels not connected
+to the border of the image are set to foreground.
+It is done in one pass, labeling the connected components of the background.
+
+Parameters:
+----------
+input: BinaryImageType
+    input binary image.
+
+fully_connected: bool
+    if False (default), background pixels are connected only to their
+    face neighbors (6-connectivity in 3D).
+    If True, they are connected also by edges and corners (26-connectivity).
+
+num_threads: int
+    number of threads, 0 uses the default of ITK.
+
+verbose: bool
+    extra information displayed during the algorithm.
+
+)delimiter";
+    m.def("fill_holes_cavities", &fill_holes_cavities_function,
+            fill_holes_cavities_docs.c_str(),
+            py::arg("input"),
+            py::arg("fully_connected") = false,
+            py::arg("num_threads") = 0,
+            py::arg("verbose") = false
+         );
 }
@@ -45,4 +45,48 @@ Returns: BinaryImageType
             py::arg("original_binary_image"),
             py::arg("label_marker_image")
             );
+
+    m.def("geodesic_label_propagation_from_graph",
+          &geodesic_label_propagation_from_graph,
+          R"(Label the foreground of original_binary_image from the labels of the
+nodes and edges of a spatial graph, without creating a marker image.
+
+This is a geodesic label propagation, not a watershed. The labeled voxels
+of the graph inside the foreground are the seeds, and the labels are
+propagated in parallel only through the foreground voxels. Each voxel takes
+the label of the closest seed in steps, ties are won by the greatest label.
+Foreground components without seeds keep the label 0.
+Labels greater than 255 raise an error.
+
+Parameters:
+----------
+
+original_binary_image: BinaryImageType
+  input original image that will set the boundaries to refill from the graph
+
+graph: GraphType
+  input spatial graph
+
+vertex_to_label_map: Dict[int -> int]
+  Dict mapping vertices to label
+
+edge_to_label_map: Dict[edge -> int]
+  Dict mapping edges to label.
+  See create_edge_to_label_map_from_vertex_to_label_map_using_max.
+
+graph_positions_are_in_physical_space: Bool
+  Flag to check if the graph positions are in physical space.
+
+draw_segments: Bool
+  Seed also the voxels between consecutive points of the edges.
+
+num_threads: Int
+  Number of threads, 0 uses the default of ITK.
+
+Returns: BinaryImageType
+  original_binary_image but with labels propagated from the graph.)",
+          py::arg("original_binary_image"), py::arg("graph"),
+          py::arg("vertex_to_label_map"), py::arg("edge_to_label_map"),
+          py::arg("graph_positions_are_in_physical_space") = true,
+          py::arg("draw_segments") = true, py::arg("num_threads") = 0);
 }
@@ -23,10 +23,21 @@
 
 #include "resample_image_function.hpp"
 
+#include <array>
+#include <string>
+
 namespace py = pybind11;
 using namespace SG;
 
 void init_resample_image(py::module &m) {
+    py::enum_<SG::BinaryResampleRule>(m, "BinaryResampleRule",
+  R"(Rule to set the value of output voxels when resampling binary images.
+nearest_neighbor uses the value of the closest input voxel.
+partial_volume sets foreground the output voxels with a fraction of
+foreground volume greater or equal than a threshold.)")
+      .value("nearest_neighbor", BinaryResampleRule::nearest_neighbor)
+      .value("partial_volume", BinaryResampleRule::partial_volume);
+
     m.def("resample_image", &resample_image_function,
           R"delimiter(
 Resample binary image.
@@ -47,9 +58,109 @@ shrink_factor: Float
 
 verbose: bool
   extra information displayed during the algorithm.
+
+rule: BinaryResampleRule
+  nearest_neighbor (default) or partial_volume.
+
+num_threads: int
+  number of threads, 0 uses the default of ITK.
             )delimiter",
           py::arg("input"), py::arg("shrink_factor"),
-          py::arg("verbose") = false);
+          py::arg("verbose") = false,
+          py::arg("rule") = BinaryResampleRule::nearest_neighbor,
+          py::arg("num_threads") = 0);
+
+    m.def("resample_binary_image",
+          [](const BinaryImageType::Pointer &input,
+             const std::array<double, 3> &output_spacing,
+             const std::array<size_t, 3> &output_size,
+             const BinaryResampleRule &rule,
+             const double &partial_volume_threshold,
+             const size_t &num_threads) {
+              BinaryImageType::SpacingType spacing;
+              BinaryImageType::SizeType size;
+              for (size_t i = 0; i < 3; ++i) {
+                  spacing[i] = output_spacing[i];
+                  size[i] = output_size[i];
+              }
+              return resample_binary_image(input, spacing, size, rule,
+                                           partial_volume_threshold,
+                                           num_threads);
+          },
+          R"delimiter(
+Resample a binary image to a new spacing and size, keeping the origin and
+direction of the input.
+
+Output voxels are computed in parallel directly from the input, skipping
+empty regions. No intermediate images are created.
+
+Parameters:
+----------
+input: BinaryImageType
+  input binary image.
+
+output_spacing: List[float]
+  spacing of the output image.
+
+output_size: List[int]
+  size of the output image.
+
+rule: BinaryResampleRule
+  nearest_neighbor (default) or partial_volume.
+
+partial_volume_threshold: float
+  minimum fraction of foreground in an output voxel to be foreground,
+  only used with partial_volume.
+
+num_threads: int
+  number of threads, 0 uses the default of ITK.
+            )delimiter",
+          py::arg("input"), py::arg("output_spacing"), py::arg("output_size"),
+          py::arg("rule") = BinaryResampleRule::nearest_neighbor,
+          py::arg("partial_volume_threshold") = 0.5,
+          py::arg("num_threads") = 0);
+
+    m.def("resample_binary_image_to_file",
+          [](const BinaryImageType::Pointer &input,
+             const std::array<double, 3> &output_spacing,
+             const std::array<size_t, 3> &output_size,
+             const std::string &output_filename,
+             const BinaryResampleRule &rule,
+             const double &partial_volume_threshold,
+             const size_t &num_threads,
+             const size_t &planes_per_slab) {
+              BinaryImageType::SpacingType spacing;
+              BinaryImageType::SizeType size;
+              for (size_t i = 0; i < 3; ++i) {
+                  spacing[i] = output_spacing[i];
+                  size[i] = output_size[i];
+              }
+              resample_binary_image_to_file(
+                      input, spacing, size, output_filename, rule,
+                      partial_volume_threshold, num_threads, planes_per_slab);
+          },
+          R"delimiter(
+Same as resample_binary_image, but the output is written to a file in slabs
+of z planes, without holding the whole output image in memory.
+
+The format has to support streamed writing, as MetaImage (.mha, .mhd).
+The file is written uncompressed, and replaced if it exists.
+
+Parameters:
+----------
+output_filename: str
+  file to write the resampled image.
+
+planes_per_slab: int
+  number of z planes of the output per write.
+
+For the rest of parameters see resample_binary_image.
+            )delimiter",
+          py::arg("input"), py::arg("output_spacing"), py::arg("output_size"),
+          py::arg("output_filename"),
+          py::arg("rule") = BinaryResampleRule::nearest_neighbor,
+          py::arg("partial_volume_threshold") = 0.5,
+          py::arg("num_threads") = 0, py::arg("planes_per_slab") = 64);
 
     py::enum_<SG::Interpolator>(m, "Interpolator",
   R"(Interpolator used in resample.
@@ -244,6 +244,11 @@ BinaryImageType with the improved binarization using region growing.
             .def_readwrite(
                     "binary_inside_value",
                     &binarize_with_level_set_parameters::binary_inside_value)
+            .def_readwrite("use_narrow_band",
+                           &binarize_with_level_set_parameters::use_narrow_band)
+            .def_readwrite(
+                    "narrow_band_width",
+                    &binarize_with_level_set_parameters::narrow_band_width)
             .def("__str__", [](const binarize_with_level_set_parameters &self) {
                 std::stringstream os;
                 print_binarize_with_level_set_parameters(self, os);
@@ -282,10 +287,12 @@ BinaryImageType with the improved binarization using region growing.
             [](const FloatImageType::Pointer &input,
                const BinaryImageType::Pointer &binary_init,
                const binarize_with_level_set_parameters &input_parameters,
-               const bool save_intermediate_results) {
+               const bool save_intermediate_results,
+               const size_t num_threads) {
                 return binarize_with_level_set(
                         input.GetPointer(), binary_init.GetPointer(),
-                        input_parameters, save_intermediate_results);
+                        input_parameters, save_intermediate_results,
+                        num_threads);
             },
             R"(Binarize input image using level sets.
 
@@ -294,6 +301,10 @@ to improve the input initial binarization using level sets.
 The initial binarization should not contain false positives.
 Use binarize_with_threshold_percentage with a low percentage for this.
 
+With parameters.use_narrow_band = True, the level set evolves in float
+precision only in a band of parameters.narrow_band_width pixels around
+the surface of binary_init, saving memory for large images.
+
 Parameters:
 -----------
 input: FloatImageType
@@ -309,6 +320,10 @@ save_intermediate_results: Bool
     store intermediate images from the pipeline in the output.
     useful to tweak input parameters.
 
+num_threads: Int
+    number of threads when parameters.use_narrow_band is True.
+    0 uses the default of ITK.
+
 Returns:
 --------
 BinaryImageType with the improved binarization using level sets.
@@ -316,7 +331,8 @@ BinaryImageType with the improved binarization using level sets.
 )",
             py::arg("input"), py::arg("binary_init"),
             py::arg("parameters") = binarize_with_level_set_parameters(),
-            py::arg("save_intermediate_results") = false);
+            py::arg("save_intermediate_results") = false,
+            py::arg("num_threads") = 0);
 
     /*************** connected_components ****************/
     py::class_<ConnectedComponentsOutput>(
@@ -372,6 +388,171 @@ about the number of labels and the size of them.
 )",
             py::arg("input"));
 
+    m.def(
+            "connected_components_with_threshold",
+            [](const FloatImageType::Pointer &input,
+               const FloatImageType::PixelType &lower_threshold,
+               const FloatImageType::PixelType &upper_threshold,
+               const bool fully_connected, const bool only_largest_component,
+               const size_t num_threads) {
+                return connected_components_with_threshold<FloatImageType>(
+                        input.GetPointer(), lower_threshold, upper_threshold,
+                        fully_connected, only_largest_component, num_threads);
+            },
+            R"(Fused binarize_with_threshold and connected_components.
+
+The binary image is not stored, the pixels inside the thresholds are
+labeled on the fly, in parallel, saving memory for large images.
+The result is the same than:
+    connected_components(binarize_with_threshold(input, lower, upper))
+
+Parameters:
+-----------
+input: FloatImageType
+    input image
+
+lower_threshold: Float
+    pixels with value lower than this won't be ON.
+
+upper_threshold: Float
+    pixels with value greater than this won't be ON.
+
+fully_connected: Bool
+    False: face connectivity. True: connect also by edges and corners.
+
+only_largest_component: Bool
+    If True, label_image is a binary image with only the largest object.
+    Use it when there are more than 255 objects.
+
+num_threads: Int
+    number of threads, 0 uses the default of ITK.
+
+Returns:
+--------
+connected_components_output
+)",
+            py::arg("input"),
+            py::arg("lower_threshold") =
+                    itk::NumericTraits<FloatImageType::PixelType>::lowest(),
+            py::arg("upper_threshold") =
+                    itk::NumericTraits<FloatImageType::PixelType>::max(),
+            py::arg("fully_connected") = false,
+            py::arg("only_largest_component") = false,
+            py::arg("num_threads") = 0);
+
+    m.def(
+            "connected_components_with_percentage",
+            [](const FloatImageType::Pointer &input, const double percentage,
+               const bool fully_connected, const bool only_largest_component,
+               const size_t num_threads) {
+                return connected_components_with_percentage<FloatImageType>(
+                        input.GetPointer(), percentage, fully_connected,
+                        only_largest_component, num_threads);
+            },
+            R"(Fused binarize_with_percentage and connected_components.
+
+Parameters:
+-----------
+input: FloatImageType
+    input image
+
+percentage: Float
+    percentage of pixels (with highest value) that will be ON.
+    lower_threshold = min_value + (max_value - min_value) * (1 - percentage)
+
+fully_connected: Bool
+    False: face connectivity. True: connect also by edges and corners.
+
+only_largest_component: Bool
+    If True, label_image is a binary image with only the largest object.
+
+num_threads: Int
+    number of threads, 0 uses the default of ITK.
+
+Returns:
+--------
+connected_components_output
+)",
+            py::arg("input"), py::arg("percentage") = 0.05,
+            py::arg("fully_connected") = false,
+            py::arg("only_largest_component") = false,
+            py::arg("num_threads") = 0);
+
+    m.def(
+            "connected_components_with_threshold_from_file",
+            [](const std::string &input_filename,
+               const FloatImageType::PixelType &lower_threshold,
+               const FloatImageType::PixelType &upper_threshold,
+               const bool fully_connected, const bool only_largest_component,
+               const size_t num_threads, const size_t planes_per_slab) {
+                return connected_components_with_threshold_from_file<
+                        FloatImageType>(input_filename, lower_threshold,
+                                        upper_threshold, fully_connected,
+                                        only_largest_component, num_threads,
+                                        planes_per_slab);
+            },
+            R"(Same than connected_components_with_threshold, but reading
+the input image from a file in slabs of z planes. Only one slab of the input
+is in memory at a time, when the file format supports streamed reading
+(MetaImage .mha/.mhd). Otherwise the whole image is read.
+
+Parameters:
+-----------
+input_filename: String
+    file with the input image.
+
+planes_per_slab: Int
+    number of z planes read at a time.
+
+For the rest of parameters see connected_components_with_threshold.
+
+Returns:
+--------
+connected_components_output
+)",
+            py::arg("input_filename"),
+            py::arg("lower_threshold") =
+                    itk::NumericTraits<FloatImageType::PixelType>::lowest(),
+            py::arg("upper_threshold") =
+                    itk::NumericTraits<FloatImageType::PixelType>::max(),
+            py::arg("fully_connected") = false,
+            py::arg("only_largest_component") = false,
+            py::arg("num_threads") = 0, py::arg("planes_per_slab") = 64);
+
+    m.def(
+            "connected_components_with_percentage_from_file",
+            [](const std::string &input_filename, const double percentage,
+               const bool fully_connected, const bool only_largest_component,
+               const size_t num_threads, const size_t planes_per_slab) {
+                return connected_components_with_percentage_from_file<
+                        FloatImageType>(input_filename, percentage,
+                                        fully_connected,
+                                        only_largest_component, num_threads,
+                                        planes_per_slab);
+            },
+            R"(Same than connected_components_with_percentage, but reading
+the input image from a file in slabs of z planes. The file is read twice,
+first for the min and max values.
+
+Parameters:
+-----------
+input_filename: String
+    file with the input image.
+
+planes_per_slab: Int
+    number of z planes read at a time.
+
+For the rest of parameters see connected_components_with_percentage.
+
+Returns:
+--------
+connected_components_output
+)",
+            py::arg("input_filename"), py::arg("percentage") = 0.05,
+            py::arg("fully_connected") = false,
+            py::arg("only_largest_component") = false,
+            py::arg("num_threads") = 0, py::arg("planes_per_slab") = 64);
+
     m.def(
             "extract_a_label",
             [](const BinaryImageType::Pointer &input, const size_t &label) {
@@ -67,6 +67,57 @@ graph_positions_are_in_physical_space: Bool
 
     /*********************************************************/
 
+    m.def("voxelize_graph_rasterized", &voxelize_graph_rasterized,
+          R"delimiter(
+Rasterize the input graph into a label image, processing the edges in
+parallel.
+
+Similar to voxelize_graph, but:
+- If draw_segments is true, the voxels of the 3D line segments between
+  consecutive points of an edge (source node, edge points, target node)
+  are also labeled, not only the voxels at the points positions.
+- If vertex_to_radius_map is not empty, the nodes are voxelized as balls
+  and the edges as tubes, with a radius linearly interpolated from source
+  to target along the edge. Radius are in voxel (index) units.
+- When different labels write the same voxel, the greatest label wins.
+
+returns a BinaryImage
+
+Parameters:
+----------
+graph: GraphType
+ input spatial graph
+
+reference_image: BinaryImageType
+    binary image.
+
+vertex_to_label_map: Dict[int -> int]
+    Dict mapping vertices to label
+
+edge_to_label_map: Dict[edge -> int]
+    Dict mapping edges to label.
+
+graph_positions_are_in_physical_space: Bool
+    Flag to check if the graph positions are in physical space.
+
+draw_segments: Bool
+    Label the line segments between consecutive points of the edges.
+
+vertex_to_radius_map: Dict[int -> float]
+    Dict mapping vertices to radius (in voxels). See create_vertex_to_radius_map.
+
+num_threads: Int
+    Number of threads, 0 uses the ITK default.
+            )delimiter",
+          py::arg("graph"), py::arg("reference_image"),
+          py::arg("vertex_to_label_map"), py::arg("edge_to_label_map"),
+          py::arg("graph_positions_are_in_physical_space") = true,
+          py::arg("draw_segments") = true,
+          py::arg("vertex_to_radius_map") = VertexToRadiusMap(),
+          py::arg("num_threads") = 0);
+
+    /*********************************************************/
+
     const std::string graph_position_to_image_index_docs = R"(
 Helper function to get an ITK image index from a graph position.
 
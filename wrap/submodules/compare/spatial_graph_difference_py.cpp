@@ -19,14 +19,14 @@
  * *******************************************************************/
 
 #include "pybind11_common.h"
+#include "async_result_py.h"
 #include "spatial_graph_difference.hpp"
 
 namespace py = pybind11;
 using namespace SG;
 
 void init_spatial_graph_difference(py::module &m) {
-    m.def("spatial_graph_difference", &spatial_graph_difference,
-            R"(
+    const auto spatial_graph_difference_docs = R"(
 Compute the difference between graphs using their spatial location
 Returns: D = M - S
 
@@ -47,10 +47,22 @@ verbose: Bool
  extra information to console
 
 Returns the difference graph.
-)",
-            py::arg("minuend"),
-            py::arg("substraend"),
-            py::arg("radius"),
-            py::arg("verbose") = false
-            );
+)";
+    // Same arguments for the blocking and async versions.
+    const auto def_spatial_graph_difference = [&](const char *name,
+                                                  auto function,
+                                                  auto... extra) {
+        m.def(name, function, spatial_graph_difference_docs,
+              py::arg("minuend"),
+              py::arg("substraend"),
+              py::arg("radius"),
+              py::arg("verbose") = false,
+              extra...);
+    };
+    def_spatial_graph_difference("spatial_graph_difference",
+                                 &spatial_graph_difference,
+                                 py::call_guard<py::gil_scoped_release>());
+    // Returns a spatial_graph_async_result, use result() to get the graph.
+    def_spatial_graph_difference("spatial_graph_difference_async",
+                                 make_async(&spatial_graph_difference));
 }
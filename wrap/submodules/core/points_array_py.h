@@ -0,0 +1,79 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+#ifndef SG_POINTS_ARRAY_PY_H
+#define SG_POINTS_ARRAY_PY_H
+
+#include "pybind11_common.h"
+#include <pybind11/numpy.h>
+
+#include "common_types.hpp"
+
+#include <cstring>
+#include <string>
+
+namespace SG {
+
+using points_array_t =
+        pybind11::array_t<double,
+                          pybind11::array::c_style | pybind11::array::forcecast>;
+
+/**
+ * Check that the input array has shape (N, 3).
+ *
+ * @return N, the number of points
+ */
+inline size_t num_points_after_check_shape(const points_array_t &np_array) {
+    if (np_array.ndim() != 2 || np_array.shape(1) != 3) {
+        std::string shape;
+        for (size_t d = 0; d < static_cast<size_t>(np_array.ndim()); ++d) {
+            shape += (d == 0 ? "" : ", ") + std::to_string(np_array.shape(d));
+        }
+        throw std::runtime_error(
+                "Input array must have shape (N, 3), but has shape: (" +
+                shape + ").");
+    }
+    return static_cast<size_t>(np_array.shape(0));
+}
+
+/**
+ * Array with shape (N, 3) that views (no copy) the memory of the points.
+ * base keeps the owner of the points alive while the array exists, but the
+ * array is invalidated if the points are resized.
+ */
+inline points_array_t points_view(PointContainer &points,
+                                  pybind11::handle base) {
+    return points_array_t(
+            {points.size(), size_t(3)},
+            points.empty() ? nullptr : points.front().data(), base);
+}
+
+/** Copy rows [first, first + points.size()) of np_array into points. */
+inline void copy_points_from_array(const points_array_t &np_array,
+                                   const size_t first,
+                                   PointContainer &points) {
+    if (!points.empty()) {
+        std::memcpy(points.front().data(), np_array.data(first, 0),
+                    points.size() * sizeof(PointType));
+    }
+}
+
+} // end namespace SG
+#endif
@@ -32,6 +32,7 @@ void init_bounding_box(py::module &);
 void init_filter_spatial_graph(py::module &);
 void init_transform_to_physical_point_without_itk(py::module &);
 void init_graph_data(py::module &);
+void init_async_result(py::module &);
 
 void init_sgcore(py::module & mparent) {
     auto m = mparent.def_submodule("core");
@@ -42,6 +43,7 @@ void init_sgcore(py::module & mparent) {
     init_spatial_node(m);
     init_spatial_edge(m);
     init_spatial_graph(m);
+    init_async_result(m);
     init_spatial_graph_io(m);
     init_bounding_box(m);
     init_filter_spatial_graph(m);
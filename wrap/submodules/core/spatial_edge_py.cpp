@@ -22,6 +22,7 @@
 #include <pybind11/stl.h>
 #include <pybind11/stl_bind.h>
 
+#include "points_array_py.h"
 #include "spatial_edge.hpp"
 
 namespace py = pybind11;
@@ -31,6 +32,23 @@ void init_spatial_edge(py::module &m) {
     py::class_<SpatialEdge>(m, "spatial_edge")
             .def(py::init())
             .def_readwrite("edge_points", &SpatialEdge::edge_points)
+            .def_property(
+                    "edge_points_array",
+                    [](py::object self) {
+                        return points_view(
+                                self.cast<SpatialEdge &>().edge_points, self);
+                    },
+                    [](SpatialEdge &se, const points_array_t &np_array) {
+                        se.edge_points.resize(
+                                num_points_after_check_shape(np_array));
+                        copy_points_from_array(np_array, 0, se.edge_points);
+                    },
+                    R"(
+NumPy array with shape (N, 3) viewing the edge points, without copies.
+Modifying the array modifies the edge points. Assigning an array with shape
+(N, 3) replaces the edge points.
+The view is invalidated if the number of edge points changes.
+)")
             .def("__repr__", [](const SpatialEdge &sn) {
                 std::stringstream os;
                 print_edge_points(sn.edge_points, os);
@@ -25,7 +25,10 @@
 #include "hash_edge_descriptor.hpp"
 #include "spatial_graph.hpp"
 #include "spatial_graph_utilities.hpp"
-// For pickle
+#include "points_array_py.h"
+// For pickle and copy
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
 #include <boost/archive/text_iarchive.hpp>
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/graph/adj_list_serialize.hpp>
@@ -33,6 +36,21 @@
 namespace py = pybind11;
 using namespace SG;
 
+namespace {
+/** Copy of the graph, serialized to and from a binary archive. */
+GraphType copy_with_binary_archive(const GraphType &graph) {
+    std::stringstream ss;
+    {
+        boost::archive::binary_oarchive oarch(ss);
+        oarch << graph;
+    }
+    boost::archive::binary_iarchive iarch(ss);
+    GraphType copied_graph;
+    iarch >> copied_graph;
+    return copied_graph;
+}
+} // namespace
+
 void init_spatial_graph(py::module &m) {
     auto mgraph = m.def_submodule("graph");
     mgraph.doc() = "Graph submodule with graph related function and classes";
@@ -102,7 +120,8 @@ void init_spatial_graph(py::module &m) {
                      print_spatial_edges(graph, os);
                      return "spatial_graph:\n" + os.str();
                  })
-            // For pickle support (copy.deepcopy) define getstate and setstate
+            // For pickle support define getstate and setstate.
+            // Pickles can be persisted, use a portable text archive.
             .def(py::pickle(
                 // getstate: equivalent to write graph to file
                 [](const GraphType & graph) -> std::string {
@@ -119,6 +138,129 @@ void init_spatial_graph(py::module &m) {
                 arch >> graph;
                 return graph;
                 }))
+            // copy.copy and copy.deepcopy stay in the process, use a faster
+            // binary archive.
+            .def("__copy__",
+                 [](const GraphType &graph) {
+                     return copy_with_binary_archive(graph);
+                 })
+            .def("__deepcopy__",
+                 [](const GraphType &graph, py::dict /* memo */) {
+                     return copy_with_binary_archive(graph);
+                 }, py::arg("memo"))
+            .def("node_positions",
+                 [](const GraphType &graph) {
+                     const size_t num_vertices = boost::num_vertices(graph);
+                     points_array_t positions({num_vertices, size_t(3)});
+                     auto data = positions.mutable_unchecked<2>();
+                     for (size_t v = 0; v < num_vertices; ++v) {
+                         for (size_t d = 0; d < 3; ++d) {
+                             data(v, d) = graph[v].pos[d];
+                         }
+                     }
+                     return positions;
+                 },
+R"(
+Returns
+-------
+numpy.ndarray
+    Array with shape (num_vertices, 3) with the position of each vertex.
+)")
+            .def("set_node_positions",
+                 [](GraphType &graph, const points_array_t &positions) {
+                     const size_t num_vertices = boost::num_vertices(graph);
+                     if (num_points_after_check_shape(positions) !=
+                         num_vertices) {
+                         throw std::runtime_error(
+                                 "set_node_positions: the number of "
+                                 "positions must be equal to num_vertices.");
+                     }
+                     auto data = positions.unchecked<2>();
+                     for (size_t v = 0; v < num_vertices; ++v) {
+                         for (size_t d = 0; d < 3; ++d) {
+                             graph[v].pos[d] = data(v, d);
+                         }
+                     }
+                 }, py::arg("positions"),
+                 R"(Set the position of all vertices from an array with shape (num_vertices, 3).)")
+            .def("all_edge_points",
+                 [](const GraphType &graph) {
+                     const size_t num_edges = boost::num_edges(graph);
+                     py::array_t<int64_t> offsets(
+                             static_cast<py::ssize_t>(num_edges + 1));
+                     auto offsets_data = offsets.mutable_unchecked<1>();
+                     offsets_data(0) = 0;
+                     size_t e = 0;
+                     for (auto [ei, ei_end] = boost::edges(graph);
+                          ei != ei_end; ++ei, ++e) {
+                         offsets_data(e + 1) =
+                                 offsets_data(e) +
+                                 static_cast<int64_t>(
+                                         graph[*ei].edge_points.size());
+                     }
+                     points_array_t points(
+                             {static_cast<size_t>(offsets_data(num_edges)),
+                              size_t(3)});
+                     e = 0;
+                     for (auto [ei, ei_end] = boost::edges(graph);
+                          ei != ei_end; ++ei, ++e) {
+                         const auto &edge_points = graph[*ei].edge_points;
+                         if (!edge_points.empty()) {
+                             std::memcpy(points.mutable_data(offsets_data(e), 0),
+                                         edge_points.front().data(),
+                                         edge_points.size() *
+                                                 sizeof(PointType));
+                         }
+                     }
+                     return std::make_pair(points, offsets);
+                 },
+R"(
+Returns
+-------
+numpy.ndarray
+    Array with shape (num_edge_points, 3) with the edge points of all edges,
+    in the order of edges().
+numpy.ndarray
+    Offsets with shape (num_edges + 1,). The edge points of the i-th edge
+    are points[offsets[i]:offsets[i+1]].
+)")
+            .def("set_all_edge_points",
+                 [](GraphType &graph, const points_array_t &points,
+                    const py::array_t<int64_t, py::array::c_style |
+                                                       py::array::forcecast>
+                            &offsets) {
+                     const size_t num_edges = boost::num_edges(graph);
+                     const size_t num_points =
+                             num_points_after_check_shape(points);
+                     if (offsets.ndim() != 1 ||
+                         static_cast<size_t>(offsets.shape(0)) !=
+                                 num_edges + 1) {
+                         throw std::runtime_error(
+                                 "set_all_edge_points: offsets must have "
+                                 "shape (num_edges + 1,).");
+                     }
+                     auto offsets_data = offsets.unchecked<1>();
+                     for (size_t e = 0; e < num_edges; ++e) {
+                         if (offsets_data(e) < 0 ||
+                             offsets_data(e) > offsets_data(e + 1) ||
+                             static_cast<size_t>(offsets_data(e + 1)) >
+                                     num_points) {
+                             throw std::runtime_error(
+                                     "set_all_edge_points: offsets must be "
+                                     "increasing and within the points.");
+                         }
+                     }
+                     size_t e = 0;
+                     for (auto [ei, ei_end] = boost::edges(graph);
+                          ei != ei_end; ++ei, ++e) {
+                         auto &edge_points = graph[*ei].edge_points;
+                         edge_points.resize(offsets_data(e + 1) -
+                                            offsets_data(e));
+                         copy_points_from_array(points, offsets_data(e),
+                                                edge_points);
+                     }
+                 }, py::arg("points"), py::arg("offsets"),
+                 R"(Set the edge points of all edges, inverse of all_edge_points.)")
             .def("spatial_node",
                  [](GraphType &graph, const size_t &n) -> SpatialNode& {
                      return graph[n];
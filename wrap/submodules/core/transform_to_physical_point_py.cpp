@@ -57,4 +57,29 @@ Apply an ITK-style TransformIndexToPhysicalPoint to all the points of the input
             )",
             py::arg("graph"), py::arg("origin"), py::arg("spacing"),
             py::arg("direction"));
+
+    m.def(
+            "transform_graph_to_index_space",
+            [](const SG::GraphType &sg, const SG::PointType &origin,
+               const SG::PointType &spacing,
+               const SG::DirectionMatrixType &direction,
+               const bool round_to_nearest_index) {
+                GraphType output_graph = sg;
+                transform_graph_to_index_space(output_graph, origin, spacing,
+                                               direction,
+                                               round_to_nearest_index);
+                return output_graph;
+            },
+            R"(
+Apply an ITK-style TransformPhysicalPointToIndex to all the points of the input graph.
+Inverse of transform_graph_to_physical_space.
+
+Parameters:
+----------
+round_to_nearest_index: bool
+    If true, round the positions to the nearest index as ITK does.
+    If false, keep the continuous index.
+            )",
+            py::arg("graph"), py::arg("origin"), py::arg("spacing"),
+            py::arg("direction"), py::arg("round_to_nearest_index") = true);
 }
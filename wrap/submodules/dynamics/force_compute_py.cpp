@@ -22,6 +22,11 @@
 #include "sgdynamics_common_py.hpp"
 #include "force_compute.hpp"
 #include "pyforce_compute.hpp" // For trampolin pure virtual PyForceCompute
+#include "particle_views_py.hpp"
+
+#include <memory>
+#include <stdexcept>
+#include <string>
 
 
 namespace py = pybind11;
@@ -30,9 +35,13 @@ using namespace SG;
 void init_particle_force(py::module &m);
 void init_ParticleForceCompute(py::module &m);
 void init_ParticleRandomForceCompute(py::module &m);
+void init_ParticleBatchForceCompute(py::module &m);
 void init_bond_force(py::module &m);
 void init_PairBondForce(py::module &m);
 void init_FixedPairBondForce(py::module &m);
+void init_PairBondBatchForce(py::module &m);
+void init_PairBondForceWLCPetrosyan(py::module &m);
+void init_ExcludedVolumeForce(py::module &m);
 // Wrap to avoid including pybind11/funtional.h in this translation unit
 void wrap_force_function_with_functional(py::class_<ParticleForceCompute, ForceCompute,
         std::shared_ptr<ParticleForceCompute>> &c);
@@ -51,9 +60,197 @@ void init_force_compute(py::module &m) {
     init_particle_force(m);
     init_ParticleForceCompute(m);
     init_ParticleRandomForceCompute(m);
+    init_ParticleBatchForceCompute(m);
     init_bond_force(m);
     init_PairBondForce(m);
     init_FixedPairBondForce(m);
+    init_PairBondBatchForce(m);
+    init_PairBondForceWLCPetrosyan(m);
+    init_ExcludedVolumeForce(m);
+}
+
+namespace {
+/**
+ * Keep a python function in a C++ std::function, acquiring the GIL when the
+ * last copy is destroyed.
+ */
+std::shared_ptr<py::function> share_function(const py::function &function) {
+    return std::shared_ptr<py::function>(
+            new py::function(function), [](py::function *f) {
+                py::gil_scoped_acquire gil;
+                delete f;
+            });
+}
+
+/** Check that forces has shape (num_forces, 3). */
+py::array_t<double, py::array::c_style | py::array::forcecast>
+forces_after_check_shape(const py::object &output, const size_t num_forces) {
+    auto forces =
+            py::array_t<double, py::array::c_style | py::array::forcecast>::
+                    ensure(output);
+    if (!forces || forces.ndim() != 2 ||
+        static_cast<size_t>(forces.shape(0)) != num_forces ||
+        forces.shape(1) != 3) {
+        throw std::runtime_error("The force function must return an array "
+                                 "with shape (" +
+                                 std::to_string(num_forces) + ", 3).");
+    }
+    return forces;
+}
+
+ParticleBatchForceCompute::force_function_t
+particle_batch_force_function(const py::function &function) {
+    return [f = share_function(function)](
+                   const ParticleCollection &all,
+                   std::vector<ParticleForce> &particle_forces) {
+        py::gil_scoped_acquire gil;
+        if (particle_forces.size() != all.size()) {
+            throw std::runtime_error(
+                    "force_compute_particle_batch: the number of forces (" +
+                    std::to_string(particle_forces.size()) +
+                    ") is different than the number of particles (" +
+                    std::to_string(all.size()) + ").");
+        }
+        // The views are only valid during the call, base is not owning.
+        const auto forces = forces_after_check_shape(
+                (*f)(positions_view(all, py::none(), false),
+                     velocities_view(all, py::none(), false)),
+                all.size());
+        const auto data = forces.unchecked<2>();
+        for (size_t i = 0; i < particle_forces.size(); ++i) {
+            for (size_t d = 0; d < 3; ++d) {
+                particle_forces[i].force[d] = data(i, d);
+            }
+        }
+    };
+}
+
+PairBondBatchForce::batch_force_function_t
+pair_bond_batch_force_function(const py::function &function) {
+    return [f = share_function(function)](
+                   const ParticleCollection &all,
+                   const std::vector<size_t> &particle_a_indices,
+                   const std::vector<size_t> &particle_b_indices,
+                   std::vector<BondForce> &bond_forces) {
+        py::gil_scoped_acquire gil;
+        const size_t num_bonds = bond_forces.size();
+        // The particles of the bonds are not contiguous, copy them.
+        py::array_t<double> positions_a({num_bonds, size_t(3)});
+        py::array_t<double> positions_b({num_bonds, size_t(3)});
+        auto a = positions_a.mutable_unchecked<2>();
+        auto b = positions_b.mutable_unchecked<2>();
+        for (size_t i = 0; i < num_bonds; ++i) {
+            const auto &pos_a = all.positions[particle_a_indices[i]];
+            const auto &pos_b = all.positions[particle_b_indices[i]];
+            for (size_t d = 0; d < 3; ++d) {
+                a(i, d) = pos_a[d];
+                b(i, d) = pos_b[d];
+            }
+        }
+        const auto forces = forces_after_check_shape(
+                (*f)(positions_a, positions_b), num_bonds);
+        const auto data = forces.unchecked<2>();
+        for (size_t i = 0; i < num_bonds; ++i) {
+            for (size_t d = 0; d < 3; ++d) {
+                bond_forces[i].force[d] = data(i, d);
+            }
+        }
+    };
+}
+} // namespace
+
+void init_ParticleBatchForceCompute(py::module &m) {
+    py::class_<ParticleBatchForceCompute, ForceCompute,
+               std::shared_ptr<ParticleBatchForceCompute>>(
+            m, "force_compute_particle_batch", R"(
+Force on all the particles with one call to a python function per compute.
+
+The force function receives two read-only arrays with shape (N, 3): the
+positions and velocities of all the particles (views, without copies).
+It returns an array with shape (N, 3) with the force on each particle.
+
+The views do not own the memory, they are only valid during the call to
+the force function. Do not keep them, use numpy.copy to keep the values.
+)")
+            .def(py::init<const System *>())
+            .def(py::init([](const System *sys, const py::function &function) {
+                     return std::make_shared<ParticleBatchForceCompute>(
+                             sys, particle_batch_force_function(function));
+                 }),
+                 py::arg("sys"), py::arg("force_function"))
+            .def("set_force_function",
+                 [](ParticleBatchForceCompute &self,
+                    const py::function &function) {
+                     self.force_function =
+                             particle_batch_force_function(function);
+                 },
+                 py::arg("force_function"),
+                 "force_function(positions, velocities) -> forces");
+}
+
+void init_PairBondBatchForce(py::module &m) {
+    py::class_<PairBondBatchForce, PairBondForce,
+               std::shared_ptr<PairBondBatchForce>>(
+            m, "force_compute_pair_bond_batch", R"(
+Force of all the bonds with one call to a python function per compute.
+
+The force function receives two arrays with shape (M, 3), the positions of
+the particles a and b of each bond in bond_forces. It returns an array with
+shape (M, 3) with the force F_ab of each bond.
+)")
+            .def(py::init<const System *>())
+            .def(py::init<const System *, const BondProperties::tags_t &>())
+            .def(py::init([](const System *sys, const py::function &function) {
+                     return std::make_shared<PairBondBatchForce>(
+                             sys, pair_bond_batch_force_function(function));
+                 }),
+                 py::arg("sys"), py::arg("force_function"))
+            .def(py::init([](const System *sys, const py::function &function,
+                             const BondProperties::tags_t &tags) {
+                     return std::make_shared<PairBondBatchForce>(
+                             sys, pair_bond_batch_force_function(function),
+                             tags);
+                 }),
+                 py::arg("sys"), py::arg("force_function"), py::arg("tags"))
+            .def("set_force_function",
+                 [](PairBondBatchForce &self, const py::function &function) {
+                     self.batch_force_function =
+                             pair_bond_batch_force_function(function);
+                 },
+                 py::arg("force_function"),
+                 "force_function(positions_a, positions_b) -> bond_forces");
+}
+
+void init_PairBondForceWLCPetrosyan(py::module &m) {
+    py::class_<PairBondForceWLCPetrosyan, PairBondForce,
+               std::shared_ptr<PairBondForceWLCPetrosyan>>(
+            m, "force_compute_pair_bond_wlc_petrosyan", R"(
+Worm-like chain force of force_function_wlc_petrosyan, computed in C++
+without calling a force function per bond.
+
+The bonds must be bond_chain with bond_properties_physical.
+Call compile_bonds after modifying the parameters of the bonds.
+)")
+            .def(py::init<const System *>())
+            .def(py::init<const System *, const BondProperties::tags_t &>())
+            .def("compile_bonds", &PairBondForceWLCPetrosyan::compile_bonds);
+}
+
+void init_ExcludedVolumeForce(py::module &m) {
+    py::class_<ExcludedVolumeForce, ForceCompute,
+               std::shared_ptr<ExcludedVolumeForce>>(
+            m, "force_compute_excluded_volume", R"(
+Soft sphere repulsion between particles closer than the sum of their radii,
+using a neighbor_list. Pairs joined by a bond are ignored if exclude_bonded.
+)")
+            .def(py::init<const System *>())
+            .def(py::init<const System *, const double &>(), py::arg("sys"),
+                 py::arg("stiffness"))
+            .def_readwrite("stiffness", &ExcludedVolumeForce::stiffness)
+            .def_readwrite("exclude_bonded",
+                           &ExcludedVolumeForce::exclude_bonded)
+            .def_readwrite("neighbor_list",
+                           &ExcludedVolumeForce::neighbor_list);
 }
 
 void init_particle_force(py::module &m) {
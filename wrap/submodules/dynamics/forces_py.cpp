@@ -64,6 +64,11 @@ void init_unbonded_forces(py::module &m) {
     m.def("linear_drag", py::overload_cast<double,
             double, const ArrayUtilities::Array3D &>(&force_linear_drag),
             "Use Stokes relationship, with radius, viscosity and velocity.");
+    m.def("soft_sphere", &force_soft_sphere,
+            py::arg("stiffness"), py::arg("sigma"), py::arg("a_minus_b"),
+            py::arg("distance"),
+            "Repulsive force on sphere a from U = stiffness * (1 - r/sigma)^2, "
+            "zero for r >= sigma.");
 }
 
 void init_force_compute_functions(py::module &m) {
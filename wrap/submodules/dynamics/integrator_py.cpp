@@ -33,13 +33,15 @@ void init_integrator_methods(py::module &m) {
         .def(py::init<System*>())
         .def(py::init<System*, double>())
         .def("integrate", &IntegratorMethod::integrate)
-        .def_readwrite("deltaT", &IntegratorMethod::deltaT);
+        .def_readwrite("deltaT", &IntegratorMethod::deltaT)
+        .def_readwrite("num_threads", &IntegratorMethod::num_threads);
     py::class_<TwoStepIntegratorMethod, PyTwoStepIntegratorMethod,
         std::shared_ptr<TwoStepIntegratorMethod>>(m, "integrator_method_two_step")
         .def(py::init<System*>())
         .def(py::init<System*, double>())
         .def("integrateStepOne", &TwoStepIntegratorMethod::integrateStepOne)
-        .def("integrateStepTwo", &TwoStepIntegratorMethod::integrateStepTwo)
+        .def("integrateStepTwo", py::overload_cast<>(
+                    &TwoStepIntegratorMethod::integrateStepTwo))
         ;
 
     py::class_<VerletVelocitiesIntegratorMethod, TwoStepIntegratorMethod,
@@ -55,15 +57,21 @@ void init_integrator(py::module &m) {
     py::class_<Integrator, PyIntegrator>(m, "integrator")
         .def(py::init<System*>())
         .def_readwrite("force_types", &Integrator::force_types)
+        .def_readwrite("num_threads", &Integrator::num_threads)
+        .def_readwrite("verbose", &Integrator::verbose)
         .def("compute_net_forces", &Integrator::compute_net_forces)
-        .def("update", &Integrator::update)
+        .def("compute_forces", &Integrator::compute_forces,
+             py::call_guard<py::gil_scoped_release>())
+        .def("update", &Integrator::update,
+             py::call_guard<py::gil_scoped_release>())
         // .def("add_force", &Integrator::add_force)
         // TODO wrap forces first
         .def("add_force",  py::overload_cast<std::shared_ptr<ForceCompute>>(&Integrator::add_force<ForceCompute>))
         ;
 
-    py::class_<IntegratorTwoStep, Integrator>(m, "integrator_two_step")
+    py::class_<IntegratorTwoStep, PyIntegratorTwoStep, Integrator>(m, "integrator_two_step")
         .def(py::init<System*>())
         .def_readwrite("integrator_method", &IntegratorTwoStep::integrator_method)
+        .def("fuse_net_forces", &IntegratorTwoStep::fuse_net_forces)
         ;
 }
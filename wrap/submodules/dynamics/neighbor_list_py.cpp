@@ -0,0 +1,65 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+#include "pybind11_common.h"
+#include "neighbor_list.hpp"
+#include "sgdynamics_common_py.hpp"
+
+namespace py = pybind11;
+using namespace SG;
+
+void init_neighbor_list(py::module &m) {
+    py::class_<NeighborList>(m, "neighbor_list", R"(
+Verlet list of the pairs of particles closer than cutoff + skin, built with
+cell lists. update() only rebuilds the list when a particle has moved more
+than skin / 2 since the last build.
+Only the pairs (i, j) with i < j are stored, i, j are indices of particles.
+)")
+        .def(py::init())
+        .def(py::init<const double &, const double &>(),
+                py::arg("cutoff"), py::arg("skin"))
+        .def_readwrite("cutoff", &NeighborList::cutoff)
+        .def_readwrite("skin", &NeighborList::skin)
+        .def_readwrite("boundary_condition", &NeighborList::boundary_condition)
+        .def_readwrite("box_size", &NeighborList::box_size)
+        .def_readonly("neighbor_offsets", &NeighborList::neighbor_offsets)
+        .def_readonly("neighbors", &NeighborList::neighbors)
+        .def_readonly("number_of_builds", &NeighborList::number_of_builds)
+        .def("update", &NeighborList::update,
+                py::arg("particle_collection"),
+                "Build the list if needed, returns true if it was built.")
+        .def("build", &NeighborList::build,
+                py::arg("particle_collection"))
+        .def("needs_rebuild", &NeighborList::needs_rebuild,
+                py::arg("particle_collection"));
+    // ParticleNeighbors is not wrapped, return pairs of (id, [neighbor ids])
+    m.def("make_particle_neighbors", [](const NeighborList &neighbor_list,
+                                        const ParticleCollection &collection) {
+            std::vector<std::pair<size_t, std::vector<size_t>>> output;
+            for (auto &particle_neighbors :
+                 make_particle_neighbors(neighbor_list, collection)) {
+                output.emplace_back(particle_neighbors.particle_id,
+                                    std::move(particle_neighbors.neighbors));
+            }
+            return output;
+        },
+        py::arg("neighbor_list"), py::arg("particle_collection"),
+        "Neighbor ids of each particle, in both directions.");
+}
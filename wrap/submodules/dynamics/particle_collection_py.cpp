@@ -21,24 +21,194 @@
 #include "pybind11_common.h"
 #include "particle_collection.hpp"
 #include "sgdynamics_common_py.hpp"
+#include "particle_views_py.hpp"
+
+#include <limits>
 
 
 namespace py = pybind11;
 using namespace SG;
 
+namespace {
+/**
+ * Particle at index of a collection. The particles are stored as a struct
+ * of arrays, the reference reads and writes the arrays of the collection.
+ */
+struct ParticleRef {
+    ParticleCollection *collection;
+    size_t index;
+    size_t checked_index() const {
+        if (index >= collection->size()) {
+            throw py::index_error(
+                    "The particle is not in the collection anymore.");
+        }
+        return index;
+    }
+};
+/** Dynamic properties of a ParticleRef. */
+struct ParticleDynamicsRef {
+    ParticleRef particle;
+};
+/** Sequence of ParticleRef of all the particles of a collection. */
+struct ParticlesRef {
+    ParticleCollection *collection;
+};
+
+void init_particle_refs(py::module &m) {
+    py::class_<ParticleDynamicsRef>(m, "particle_dynamics_ref",
+R"(
+Dynamic properties of a particle of a particle_collection, modifying them
+modifies the collection.
+)")
+        .def_property("vel",
+                [](const ParticleDynamicsRef &r) {
+                    return r.particle.collection->velocities[r.particle.checked_index()];
+                },
+                [](ParticleDynamicsRef &r, const ArrayUtilities::Array3D &vel) {
+                    r.particle.collection->velocities[r.particle.checked_index()] = vel;
+                })
+        .def_property("acc",
+                [](const ParticleDynamicsRef &r) {
+                    return r.particle.collection->accelerations[r.particle.checked_index()];
+                },
+                [](ParticleDynamicsRef &r, const ArrayUtilities::Array3D &acc) {
+                    r.particle.collection->accelerations[r.particle.checked_index()] = acc;
+                })
+        .def_property("net_force",
+                [](const ParticleDynamicsRef &r) {
+                    return r.particle.collection->net_forces[r.particle.checked_index()];
+                },
+                [](ParticleDynamicsRef &r, const ArrayUtilities::Array3D &net_force) {
+                    r.particle.collection->net_forces[r.particle.checked_index()] = net_force;
+                });
+
+    py::class_<ParticleRef>(m, "particle_ref",
+R"(
+Particle of a particle_collection, modifying it modifies the collection.
+Use copy() to get a particle independent of the collection.
+As in particle, pos can only be modified as a whole.
+)")
+        .def_property("id",
+                [](const ParticleRef &r) {
+                    return r.collection->ids[r.checked_index()];
+                },
+                [](ParticleRef &r, const size_t &id) {
+                    r.collection->ids[r.checked_index()] = id;
+                    r.collection->sorted = false;
+                })
+        .def_property("pos",
+                [](const ParticleRef &r) {
+                    return r.collection->positions[r.checked_index()];
+                },
+                [](ParticleRef &r, const ArrayUtilities::Array3D &pos) {
+                    r.collection->positions[r.checked_index()] = pos;
+                })
+        .def("set_pos", [](ParticleRef &r, size_t index,
+                    const ArrayUtilities::Array3D::value_type &in_value) {
+                    r.collection->positions[r.checked_index()].at(index) = in_value;
+                })
+        .def_property("dynamics",
+                py::cpp_function([](const ParticleRef &r) {
+                    r.checked_index();
+                    return ParticleDynamicsRef{r};
+                }, py::keep_alive<0, 1>()),
+                [](ParticleRef &r, const ParticleDynamicProperties &dynamics) {
+                    const auto index = r.checked_index();
+                    r.collection->velocities[index] = dynamics.vel;
+                    r.collection->accelerations[index] = dynamics.acc;
+                    r.collection->net_forces[index] = dynamics.net_force;
+                })
+        .def_property("material",
+                py::cpp_function([](const ParticleRef &r) -> ParticleMaterial & {
+                    return r.collection->materials[r.checked_index()];
+                }, py::return_value_policy::reference_internal),
+                [](ParticleRef &r, const ParticleMaterial &material) {
+                    r.collection->materials[r.checked_index()] = material;
+                })
+        .def("copy", [](const ParticleRef &r) {
+                    return r.collection->get_particle(r.checked_index());
+                }, "Copy of the particle.")
+        .def("__str__", [](const ParticleRef &r) {
+                std::stringstream os;
+                print(r.collection->get_particle(r.checked_index()), os);
+                return os.str();
+        });
+
+    py::class_<ParticlesRef>(m, "particles_ref",
+R"(
+Sequence of particle_ref of the particles of a particle_collection.
+)")
+        .def("__len__", [](const ParticlesRef &r) {
+                return r.collection->size();
+                })
+        .def("__getitem__", [](const ParticlesRef &r, const long &index) {
+                const long size = static_cast<long>(r.collection->size());
+                const long wrapped = index < 0 ? index + size : index;
+                if (wrapped < 0 || wrapped >= size) {
+                    throw py::index_error();
+                }
+                return ParticleRef{r.collection, static_cast<size_t>(wrapped)};
+                }, py::keep_alive<0, 1>());
+}
+} // namespace
+
 void init_particle_collection(py::module &m) {
     py::bind_vector<std::vector<Particle>>(m, "VectorParticles");
+    init_particle_refs(m);
 
     py::class_<ParticleCollection>(m, "particle_collection")
         .def(py::init())
-        .def_readwrite("particles", &ParticleCollection::particles)
+        .def(py::init<const std::vector<Particle> &>())
+        .def_property("particles",
+                py::cpp_function([](ParticleCollection &collection) {
+                    return ParticlesRef{&collection};
+                }, py::keep_alive<0, 1>()),
+                &ParticleCollection::set_particles,
+R"(
+The particles of the collection, as a sequence of particle_ref: modifying
+them modifies the collection. Assign a list of particles to replace all
+the particles.
+)")
         .def_readwrite("sorted", &ParticleCollection::sorted)
+        .def("__len__", &ParticleCollection::size)
+        .def("size", &ParticleCollection::size)
+        .def("resize", &ParticleCollection::resize)
+        .def("push_back", &ParticleCollection::push_back)
+        .def("get_particle", &ParticleCollection::get_particle,
+                "Copy of the particle at index.")
+        .def("set_particle", &ParticleCollection::set_particle,
+                "Set all the data of the particle at index.")
         .def("sort", &ParticleCollection::sort)
-        .def("binary_find", [](ParticleCollection & collection, const size_t & id) -> Particle& {
-                auto it = collection.binary_find(id);
-                return *it;
-                }, py::return_value_policy::reference)
+        .def("binary_find", [](ParticleCollection & collection, const size_t & id) {
+                const auto index = collection.find_index(id);
+                if (index == std::numeric_limits<size_t>::max()) {
+                    throw py::key_error("Particle with id " +
+                            std::to_string(id) + " not found.");
+                }
+                return ParticleRef{&collection, index};
+                }, py::keep_alive<0, 1>(),
+R"(
+particle_ref of the particle with id, the collection must be sorted.
+)")
         .def("find_index", &ParticleCollection::find_index)
+        .def("positions", [](py::object self) {
+                return positions_view(
+                        self.cast<ParticleCollection &>(), self, true);
+                },
+R"(
+NumPy array with shape (N, 3) viewing (no copy) the position of each particle.
+Modifying the array modifies the particles.
+The view is invalidated if particles are added or removed.
+)")
+        .def("velocities", [](py::object self) {
+                return velocities_view(
+                        self.cast<ParticleCollection &>(), self, true);
+                },
+R"(
+NumPy array with shape (N, 3) viewing (no copy) the velocity of each particle.
+Modifying the array modifies the particles.
+The view is invalidated if particles are added or removed.
+)")
         .def("__str__", [](const ParticleCollection &p) {
                 std::stringstream os;
                 print(p, os);
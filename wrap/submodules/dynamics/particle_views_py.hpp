@@ -0,0 +1,73 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+#ifndef SG_PARTICLE_VIEWS_PY_HPP
+#define SG_PARTICLE_VIEWS_PY_HPP
+
+#include "particle_collection.hpp"
+
+#include "pybind11_common.h"
+#include <pybind11/numpy.h>
+
+#include <vector>
+
+namespace SG {
+
+/**
+ * Array with shape (N, 3) viewing (no copy) an array of the particles, for
+ * example ParticleCollection::positions.
+ *
+ * @param values contiguous 3D values of each particle
+ * @param base object that keeps the particles alive while the array exists
+ * @param writeable false to return a read-only view
+ */
+inline pybind11::array_t<double>
+array3d_view(const std::vector<ArrayUtilities::Array3D> &values,
+             pybind11::handle base,
+             const bool writeable) {
+    namespace py = pybind11;
+    const auto num_particles = static_cast<py::ssize_t>(values.size());
+    auto view = py::array_t<double>(
+            {num_particles, py::ssize_t(3)},
+            {static_cast<py::ssize_t>(sizeof(ArrayUtilities::Array3D)),
+             static_cast<py::ssize_t>(sizeof(double))},
+            values.empty() ? nullptr : values[0].data(), base);
+    if (!writeable) {
+        view.attr("setflags")(py::arg("write") = false);
+    }
+    return view;
+}
+
+inline pybind11::array_t<double>
+positions_view(const ParticleCollection &collection,
+               pybind11::handle base,
+               const bool writeable) {
+    return array3d_view(collection.positions, base, writeable);
+}
+
+inline pybind11::array_t<double>
+velocities_view(const ParticleCollection &collection,
+                pybind11::handle base,
+                const bool writeable) {
+    return array3d_view(collection.velocities, base, writeable);
+}
+
+} // end namespace SG
+#endif
@@ -42,6 +42,8 @@ struct PyIntegratorMethod : public IntegratorMethod {
 struct PyTwoStepIntegratorMethod : public TwoStepIntegratorMethod {
     /* Inherit the constructors */
     using TwoStepIntegratorMethod::TwoStepIntegratorMethod;
+    /* Keep the integrateStepTwo(force_types) overload visible */
+    using TwoStepIntegratorMethod::integrateStepTwo;
 
     /* Trampoline (need one for each virtual function) */
     void integrate() override {
@@ -85,5 +87,39 @@ struct PyIntegrator : public Integrator {
     }
 };
 
+struct PyIntegratorTwoStep : public IntegratorTwoStep {
+    /* Inherit the constructors */
+    using IntegratorTwoStep::IntegratorTwoStep;
+    /* Trampoline (need one for each virtual function) */
+    void update(unsigned int time_step) override {
+        PYBIND11_OVERLOAD(void,              /* Return type */
+                          IntegratorTwoStep, /* Parent class */
+                          update,
+                          time_step);
+    }
+
+    void compute_net_forces(System *sys) const override {
+        PYBIND11_OVERLOAD(void,              /* Return type */
+                          IntegratorTwoStep, /* Parent class */
+                          compute_net_forces,
+                          sys);
+    }
+
+    /* Do not fuse if python overrides compute_net_forces */
+    bool fuse_net_forces() const override {
+        {
+            pybind11::gil_scoped_acquire gil;
+            if (pybind11::get_overload(
+                        static_cast<const IntegratorTwoStep *>(this),
+                        "compute_net_forces")) {
+                return false;
+            }
+        }
+        PYBIND11_OVERLOAD(bool,              /* Return type */
+                          IntegratorTwoStep, /* Parent class */
+                          fuse_net_forces, );
+    }
+};
+
 } // end namespace SG
 #endif
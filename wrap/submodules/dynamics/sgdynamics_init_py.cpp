@@ -27,6 +27,7 @@ void init_bond(py::module &);
 void init_particle_collection(py::module &);
 void init_bond_collection(py::module &);
 void init_system(py::module &);
+void init_neighbor_list(py::module &);
 void init_integrator_methods(py::module &);
 void init_forces(py::module &);
 void init_force_compute(py::module &);
@@ -44,6 +45,7 @@ void init_sgdynamics(py::module & mparent) {
     init_particle_collection(m);
     init_bond_collection(m);
     init_system(m);
+    init_neighbor_list(m);
     init_integrator_methods(m);
     init_forces(m);
     init_force_compute(m);
@@ -19,6 +19,7 @@
  * *******************************************************************/
 
 #include "pybind11_common.h"
+#include "async_result_py.h"
 // #include "sgextract_common_py.hpp"
 #include "reduce_spatial_graph_via_dfs.hpp"
 
@@ -26,6 +27,14 @@ namespace py = pybind11;
 using namespace SG;
 
 void init_reduce_spatial_graph(py::module &m) {
-    m.def("reduce_spatial_graph_via_dfs", &reduce_spatial_graph_via_dfs);
-    m.def("reduce_spatial_graph", &reduce_spatial_graph_via_dfs);
+    m.def("reduce_spatial_graph_via_dfs", &reduce_spatial_graph_via_dfs,
+          py::call_guard<py::gil_scoped_release>());
+    m.def("reduce_spatial_graph", &reduce_spatial_graph_via_dfs,
+          py::call_guard<py::gil_scoped_release>());
+    m.def("reduce_spatial_graph_async",
+          make_async(&reduce_spatial_graph_via_dfs),
+          R"(
+reduce_spatial_graph running in a separate thread.
+Returns a spatial_graph_async_result, use result() to get the graph.
+)");
 }
@@ -29,7 +29,20 @@ using namespace SG;
 void init_contour_length_generator(py::module &m) {
     m.def("generate_contour_length",
            &generate_contour_length);
+    m.def("generate_contour_lengths", &generate_contour_lengths,
+          R"(
+Populate the edge_points of all the edges of the graph with a PERM
+simulation per edge.
+
+Returns the ratio between contour length and end to end distance of each edge.
+)",
+          py::arg("graph"), py::arg("k_bending"), py::arg("monomers") = 100,
+          py::call_guard<py::gil_scoped_release>());
     py::class_<contour_length_generator>(m, "contour_length_generator")
             .def("generate_contour_length",
-                 &contour_length_generator::generate_contour_length);
+                 &contour_length_generator::generate_contour_length)
+            .def("generate_contour_lengths",
+                 &contour_length_generator::generate_contour_lengths,
+                 py::arg("k_bending"), py::arg("monomers") = 100,
+                 py::call_guard<py::gil_scoped_release>());
 }
@@ -0,0 +1,56 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+#include "pybind11_common.h"
+
+#include "ensemble_generator.hpp"
+
+namespace py = pybind11;
+using namespace SG;
+
+void init_ensemble_generator(py::module &m) {
+    py::class_<ensemble_parameters>(m, "ensemble_parameters")
+            .def(py::init())
+            .def_readwrite("first_seed", &ensemble_parameters::first_seed)
+            .def_readwrite("num_runs", &ensemble_parameters::num_runs)
+            .def_readwrite("num_threads", &ensemble_parameters::num_threads)
+            .def_readwrite("output_prefix",
+                           &ensemble_parameters::output_prefix);
+
+    py::class_<ensemble_run_result>(m, "ensemble_run_result")
+            .def(py::init())
+            .def_readonly("seed", &ensemble_run_result::seed)
+            .def_readonly("transition_params",
+                          &ensemble_run_result::transition_params)
+            .def_readonly("output_file", &ensemble_run_result::output_file);
+
+    py::class_<ensemble_result>(m, "ensemble_result")
+            .def_readonly("runs", &ensemble_result::runs)
+            .def_readonly("time_elapsed", &ensemble_result::time_elapsed)
+            .def_readonly("steps_performed", &ensemble_result::steps_performed)
+            .def("runs_per_second", &ensemble_result::runs_per_second)
+            .def("steps_per_second", &ensemble_result::steps_per_second);
+
+    m.def("generate_ensemble", &generate_ensemble,
+          R"(Generate num_runs independent networks with the parameters of
+tree, in num_threads threads. Run i uses the seed first_seed + i.)",
+          py::arg("tree"), py::arg("params") = ensemble_parameters(),
+          py::call_guard<py::gil_scoped_release>());
+}
@@ -0,0 +1,82 @@
+/* ********************************************************************
+ * Copyright (C) 2020 Pablo Hernandez-Cerdan.
+ *
+ * This file is part of SGEXT: http://github.com/phcerdan/sgext.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * *******************************************************************/
+
+#include "pybind11_common.h"
+
+#include "parallel_tempering_generator.hpp"
+
+namespace py = pybind11;
+using namespace SG;
+
+void init_parallel_tempering_generator(py::module &m) {
+    py::class_<parallel_tempering_parameters>(m,
+                                              "parallel_tempering_parameters")
+            .def(py::init())
+            .def_readwrite("num_replicas",
+                           &parallel_tempering_parameters::num_replicas)
+            .def_readwrite("temp_ladder_ratio",
+                           &parallel_tempering_parameters::temp_ladder_ratio)
+            .def_readwrite(
+                    "steps_between_exchanges",
+                    &parallel_tempering_parameters::steps_between_exchanges)
+            .def_readwrite("num_threads",
+                           &parallel_tempering_parameters::num_threads)
+            .def_readwrite("seed", &parallel_tempering_parameters::seed);
+
+    py::class_<replica_statistics>(m, "replica_statistics")
+            .def(py::init())
+            .def_readonly("energy", &replica_statistics::energy)
+            .def_readonly("energy_initial", &replica_statistics::energy_initial)
+            .def_readonly("temp_initial", &replica_statistics::temp_initial)
+            .def_readonly("temp_current", &replica_statistics::temp_current)
+            .def_readonly("steps_performed",
+                          &replica_statistics::steps_performed)
+            .def_readonly("accepted_transitions",
+                          &replica_statistics::accepted_transitions)
+            .def_readonly("rejected_transitions",
+                          &replica_statistics::rejected_transitions)
+            .def_readonly("high_temp_transitions",
+                          &replica_statistics::high_temp_transitions)
+            .def_readonly("exchanges_attempted",
+                          &replica_statistics::exchanges_attempted)
+            .def_readonly("exchanges_accepted",
+                          &replica_statistics::exchanges_accepted)
+            .def_readonly("time_elapsed", &replica_statistics::time_elapsed);
+
+    py::class_<parallel_tempering_result>(m, "parallel_tempering_result")
+            .def_readonly("graph", &parallel_tempering_result::graph)
+            .def_readonly("energy", &parallel_tempering_result::energy)
+            .def_readonly("replica", &parallel_tempering_result::replica)
+            .def_readonly("replicas", &parallel_tempering_result::replicas);
+
+    py::class_<parallel_tempering_generator>(m, "parallel_tempering_generator")
+            .def(py::init<simulated_annealing_generator_config_tree,
+                          parallel_tempering_parameters>(),
+                 py::arg("tree"),
+                 py::arg("params") = parallel_tempering_parameters())
+            .def("engine", &parallel_tempering_generator::engine,
+                 py::call_guard<py::gil_scoped_release>())
+            .def("num_replicas", &parallel_tempering_generator::num_replicas)
+            .def("replica",
+                 py::overload_cast<const size_t &>(
+                         &parallel_tempering_generator::replica),
+                 py::return_value_policy::reference_internal)
+            .def_readonly("params", &parallel_tempering_generator::params);
+}
@@ -24,6 +24,8 @@ namespace py = pybind11;
 void init_histo(py::module &);
 void init_simulated_annealing_generator_parameters(py::module &);
 void init_simulated_annealing_generator(py::module &);
+void init_parallel_tempering_generator(py::module &);
+void init_ensemble_generator(py::module &);
 void init_contour_length_generator(py::module &);
 
 void init_sggenerate(py::module & mparent) {
@@ -32,5 +34,7 @@ void init_sggenerate(py::module & mparent) {
     init_histo(m);
     init_simulated_annealing_generator_parameters(m);
     init_simulated_annealing_generator(m);
+    init_parallel_tempering_generator(m);
+    init_ensemble_generator(m);
     init_contour_length_generator(m);
 }
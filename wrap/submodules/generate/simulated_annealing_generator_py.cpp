@@ -19,12 +19,73 @@
  * *******************************************************************/
 
 #include "pybind11_common.h"
+#include "async_result_py.h"
 
 #include "simulated_annealing_generator.hpp"
 
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_set>
+#include <utility>
+
 namespace py = pybind11;
 using namespace SG;
 
+namespace {
+std::mutex running_generators_mutex;
+/** Generators with an engine running, from engine or engine_async. */
+std::unordered_set<const simulated_annealing_generator *> running_generators;
+
+void throw_if_running(const simulated_annealing_generator &gen) {
+    std::lock_guard<std::mutex> lock(running_generators_mutex);
+    if (running_generators.count(&gen)) {
+        throw std::runtime_error(
+                "simulated_annealing_generator: the engine is running, the "
+                "generator cannot be modified until it finishes.");
+    }
+}
+
+/**
+ * Mark gen as running during the lifetime of the guard. Throws if the
+ * engine of gen is already running.
+ */
+class running_engine_guard {
+  public:
+    explicit running_engine_guard(const simulated_annealing_generator &gen)
+            : gen_(&gen) {
+        std::lock_guard<std::mutex> lock(running_generators_mutex);
+        if (!running_generators.insert(gen_).second) {
+            throw std::runtime_error(
+                    "simulated_annealing_generator: the engine is already "
+                    "running.");
+        }
+    }
+    running_engine_guard(const running_engine_guard &) = delete;
+    running_engine_guard &operator=(const running_engine_guard &) = delete;
+    ~running_engine_guard() {
+        std::lock_guard<std::mutex> lock(running_generators_mutex);
+        running_generators.erase(gen_);
+    }
+
+  private:
+    const simulated_annealing_generator *gen_;
+};
+
+/**
+ * Wrap a method that modifies the generator, throwing if the engine is
+ * running.
+ */
+template <typename... TArgs>
+auto when_not_running(
+        void (simulated_annealing_generator::*method)(TArgs...)) {
+    return [method](simulated_annealing_generator &gen, TArgs... args) {
+        throw_if_running(gen);
+        (gen.*method)(std::forward<TArgs>(args)...);
+    };
+}
+} // namespace
+
 void init_simulated_annealing_generator_parameters(py::module &m) {
     py::class_<domain_parameters>(m, "domain_parameters")
             .def(py::init())
@@ -198,23 +259,69 @@ void init_simulated_annealing_generator(py::module &m) {
             .def(py::init<simulated_annealing_generator_config_tree>())
             .def(py::init<std::string>())
             .def("init_graph_degree",
-                 &simulated_annealing_generator::init_graph_degree)
+                 when_not_running(&simulated_annealing_generator::init_graph_degree))
             .def("init_graph_vertex_positions",
-                 &simulated_annealing_generator::init_graph_vertex_positions)
+                 when_not_running(&simulated_annealing_generator::init_graph_vertex_positions))
             .def("init_histograms",
-                 &simulated_annealing_generator::init_histograms)
+                 when_not_running(&simulated_annealing_generator::init_histograms))
             .def("set_parameters_from_file",
-                 &simulated_annealing_generator::set_parameters_from_file)
+                 when_not_running(&simulated_annealing_generator::set_parameters_from_file))
             .def("set_parameters_from_configuration_tree",
-                 &simulated_annealing_generator::
-                         set_parameters_from_configuration_tree)
+                 when_not_running(&simulated_annealing_generator::
+                         set_parameters_from_configuration_tree))
             .def("save_parameters_to_file",
                  &simulated_annealing_generator::save_parameters_to_file)
             .def("save_parameters_to_configuration_tree",
                  &simulated_annealing_generator::save_parameters_to_configuration_tree)
+            .def("save_checkpoint",
+                 &simulated_annealing_generator::save_checkpoint)
+            .def("load_checkpoint",
+                 when_not_running(&simulated_annealing_generator::load_checkpoint))
             .def("engine",
-                 &simulated_annealing_generator::engine,
-                 py::arg("reset_steps") = false)
+                 [](simulated_annealing_generator &gen,
+                    const bool reset_steps, const bool reset_temperature) {
+                     running_engine_guard guard(gen);
+                     py::gil_scoped_release release;
+                     gen.engine(reset_steps, reset_temperature);
+                 },
+                 py::arg("reset_steps") = false,
+                 py::arg("reset_temperature") = true,
+                 R"(
+Run the simulated annealing. Raises if the engine is already running.
+)")
+            .def("engine_async",
+                 [](simulated_annealing_generator &gen,
+                    const bool reset_steps, const bool reset_temperature) {
+                     auto guard = std::make_shared<running_engine_guard>(gen);
+                     return async_result<void>(std::async(
+                             std::launch::async,
+                             [&gen, guard, reset_steps,
+                              reset_temperature]() mutable {
+                                 // Not running once the engine finishes,
+                                 // before the result is done.
+                                 const auto running = std::move(guard);
+                                 gen.engine(reset_steps, reset_temperature);
+                             }));
+                 },
+                 py::arg("reset_steps") = false,
+                 py::arg("reset_temperature") = true,
+                 py::keep_alive<0, 1>(),
+                 R"(
+engine running in a separate thread, returns an async_result.
+Until the result is done, engine, engine_async and the methods that modify
+the generator (init_*, set_*, load_checkpoint) raise an error.
+Do not assign the attributes of the generator until the result is done.
+)")
+            .def_readwrite("show_progress",
+                 &simulated_annealing_generator::show_progress)
+            .def_readwrite("incremental_energy_min_bins",
+                 &simulated_annealing_generator::incremental_energy_min_bins)
+            .def_readwrite("update_steps_batch_size",
+                 &simulated_annealing_generator::update_steps_batch_size)
+            .def_readwrite("checkpoint_every_steps",
+                 &simulated_annealing_generator::checkpoint_every_steps)
+            .def_readwrite("checkpoint_file",
+                 &simulated_annealing_generator::checkpoint_file)
             .def_readwrite("graph",
                  &simulated_annealing_generator::graph_)
             .def_readwrite("histo_ete_distances",
@@ -232,7 +339,8 @@ void init_simulated_annealing_generator(py::module &m) {
                 return os.str();
                 })
             .def("set_boundary_condition",
-                    &simulated_annealing_generator::set_boundary_condition)
+                    when_not_running(&simulated_annealing_generator::
+                                             set_boundary_condition))
             .def("print_histo_and_target_distribution_cosines",
                     [](const simulated_annealing_generator &sa) {
                 std::stringstream os;
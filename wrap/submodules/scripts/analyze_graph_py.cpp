@@ -19,6 +19,7 @@
  * *******************************************************************/
 
 #include "pybind11_common.h"
+#include "async_result_py.h"
 
 #include "analyze_graph_function.hpp"
 
@@ -152,33 +153,42 @@ visualize: bool
         py::arg("ignoreEdgesToEndNodes") = false,
         py::arg("ignoreEdgesShorterThan") = 0,
         py::arg("verbose") = false,
-        py::arg("visualize") = false
+        py::arg("visualize") = false,
+        py::call_guard<py::gil_scoped_release>()
             );
 
-    m.def("extract_graph", &analyze_graph_function,
-            analyze_graph_docs.c_str(),
-        py::arg("input"),
-        py::arg("output_base_name") = "extracted_graph",
-        py::arg("removeExtraEdges") = true,
-        py::arg("mergeThreeConnectedNodes") = true,
-        py::arg("mergeFourConnectedNodes") = true,
-        py::arg("mergeTwoThreeConnectedNodes") = true,
-        py::arg("checkParallelEdges") = true,
-        py::arg("transformToPhysicalPoints") = false,
-        py::arg("spacing") = "",
-        py::arg("output_filename_simple") = false,
-        py::arg("exportReducedGraph_foldername") = "",
-        py::arg("exportSerialized") = false,
-        py::arg("exportVtu") = false,
-        py::arg("exportVtuWithEdgePoints") = false,
-        py::arg("exportGraphviz") = false,
-        py::arg("exportData_foldername") = "",
-        py::arg("ignoreAngleBetweenParallelEdges") = false,
-        py::arg("ignoreEdgesToEndNodes") = false,
-        py::arg("ignoreEdgesShorterThan") = 0,
-        py::arg("verbose") = false,
-        py::arg("visualize") = false
-            );
-
-
+    // Same arguments for the blocking and async versions.
+    const auto def_extract_graph = [&](const char *name, auto function,
+                                       auto... extra) {
+        m.def(name, function,
+                analyze_graph_docs.c_str(),
+            py::arg("input"),
+            py::arg("output_base_name") = "extracted_graph",
+            py::arg("removeExtraEdges") = true,
+            py::arg("mergeThreeConnectedNodes") = true,
+            py::arg("mergeFourConnectedNodes") = true,
+            py::arg("mergeTwoThreeConnectedNodes") = true,
+            py::arg("checkParallelEdges") = true,
+            py::arg("transformToPhysicalPoints") = false,
+            py::arg("spacing") = "",
+            py::arg("output_filename_simple") = false,
+            py::arg("exportReducedGraph_foldername") = "",
+            py::arg("exportSerialized") = false,
+            py::arg("exportVtu") = false,
+            py::arg("exportVtuWithEdgePoints") = false,
+            py::arg("exportGraphviz") = false,
+            py::arg("exportData_foldername") = "",
+            py::arg("ignoreAngleBetweenParallelEdges") = false,
+            py::arg("ignoreEdgesToEndNodes") = false,
+            py::arg("ignoreEdgesShorterThan") = 0,
+            py::arg("verbose") = false,
+            py::arg("visualize") = false,
+            extra...
+                );
+    };
+    def_extract_graph("extract_graph", &analyze_graph_function,
+                      py::call_guard<py::gil_scoped_release>());
+    // Returns a spatial_graph_async_result, use result() to get the graph.
+    def_extract_graph("extract_graph_async",
+                      make_async(&analyze_graph_function));
 }
@@ -19,14 +19,16 @@
  * *******************************************************************/
 
 #include "pybind11_common.h"
+#include "async_result_py.h"
 
 #include "create_distance_map_function.hpp"
 
 namespace py = pybind11;
 using namespace SG;
 void init_create_distance_map(py::module &m) {
-    m.def("create_distance_map", &create_distance_map_function,
-            R"delimiter(
+    declare_async_result<FloatImageType::Pointer>(m,
+                                                  "float_image_async_result");
+    const auto create_distance_map_docs = R"delimiter(
 Create distance map using DGtal (high precision).
 Returns dist_map image.
 
@@ -40,11 +42,22 @@ use_itk: bool
 
 verbose: bool
     extra information displayed during the algorithm.
-            )delimiter",
-            py::arg("input"),
-            py::arg("use_itk") = false,
-            py::arg("verbose") = false
-         );
+            )delimiter";
+    // Same arguments for the blocking and async versions.
+    const auto def_create_distance_map = [&](const char *name, auto function,
+                                             auto... extra) {
+        m.def(name, function, create_distance_map_docs,
+                py::arg("input"),
+                py::arg("use_itk") = false,
+                py::arg("verbose") = false,
+                extra...);
+    };
+    def_create_distance_map("create_distance_map",
+                            &create_distance_map_function,
+                            py::call_guard<py::gil_scoped_release>());
+    // Returns a float_image_async_result, use result() to get the image.
+    def_create_distance_map("create_distance_map_async",
+                            make_async(&create_distance_map_function));
     m.def("create_distance_map_io", &create_distance_map_function_io,
             R"delimiter(
 Create distance map using DGtal (high precision). Read/write from/to file.
@@ -70,7 +83,8 @@ verbose: bool
             py::arg("out_folder"),
             py::arg("foreground") = "white",
             py::arg("use_itk") = false,
-            py::arg("verbose") = false
+            py::arg("verbose") = false,
+            py::call_guard<py::gil_scoped_release>()
          );
 
 }
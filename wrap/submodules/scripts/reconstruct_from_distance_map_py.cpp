@@ -92,6 +92,102 @@ apply_color_to_edges: Bool [True]
 
     /* ************************************************** */
 
+    m.def(
+            "reconstruct_from_distance_map_implicit",
+            [](const GraphType &input_sg,
+               FloatImageType::Pointer &distance_map_image,
+               const bool spatial_nodes_position_are_in_physical_space,
+               const bool distance_map_image_use_image_spacing,
+               const std::unordered_map<GraphType::vertex_descriptor, size_t>
+                       &vertex_to_label_map,
+               const bool apply_color_to_edges, const bool use_capsules,
+               const double grid_spacing, const size_t num_threads) {
+                return reconstruct_from_distance_map_implicit(
+                        input_sg, distance_map_image.GetPointer(),
+                        spatial_nodes_position_are_in_physical_space,
+                        distance_map_image_use_image_spacing,
+                        vertex_to_label_map, apply_color_to_edges,
+                        use_capsules, grid_spacing, num_threads);
+            },
+            R"(
+Create a single watertight mesh from the graph and the distance_map_image.
+The union of spheres (or capsules joining consecutive edge points) is
+evaluated as a signed distance field in a narrow band, and the surface is
+extracted with marching cubes. The output size scales with the surface of
+the object, not with the number of points of the graph.
+
+Parameters:
+---------
+graph: GraphType
+  input spatial graph to get the vertices/nodes
+distance_map_image: FloatImageType
+  distance map image
+spatial_nodes_position_are_in_physical_space: Bool [False]
+  node positions are in physical space (instead of default index space)
+distance_map_image_use_image_spacing: Bool [False]
+ the distance map values takes into account image spacing (false for DGtal,
+ maybe true if computed via ITK) @ref create_distance_map
+vertex_to_label_map map: Dict[int,int] [Empty]
+ to assign different colors to the poly data, empty by default.
+apply_color_to_edges: Bool [True]
+ Edge points have a label associated to max(source_label,target_label) of that edge.
+use_capsules: Bool [True]
+ join consecutive points of each edge with capsules instead of only spheres.
+grid_spacing: Float [0.0]
+ distance between samples of the field. 0 uses the minimum spacing of the
+ distance map.
+num_threads: Int [0]
+ number of threads, 0 uses the default of ITK.
+)",
+            py::arg("graph"), py::arg("distance_map_image"),
+            py::arg("spatial_nodes_position_are_in_physical_space") = false,
+            py::arg("distance_map_image_use_image_spacing") = false,
+            py::arg("vertex_to_label_map") =
+                    std::unordered_map<GraphType::vertex_descriptor, size_t>(),
+            py::arg("apply_color_to_edges") = true,
+            py::arg("use_capsules") = true, py::arg("grid_spacing") = 0.0,
+            py::arg("num_threads") = 0);
+
+    m.def(
+            "reconstruct_binary_image_from_distance_map",
+            [](const GraphType &input_sg,
+               FloatImageType::Pointer &distance_map_image,
+               const bool spatial_nodes_position_are_in_physical_space,
+               const bool distance_map_image_use_image_spacing,
+               const bool use_capsules, const size_t num_threads) {
+                return reconstruct_binary_image_from_distance_map(
+                        input_sg, distance_map_image.GetPointer(),
+                        spatial_nodes_position_are_in_physical_space,
+                        distance_map_image_use_image_spacing, use_capsules,
+                        num_threads);
+            },
+            R"(
+Rasterize the spheres (or capsules) of the graph directly into a binary image,
+without creating a mesh. The output has the same metadata than the
+distance map.
+
+Parameters:
+---------
+graph: GraphType
+  input spatial graph to get the vertices/nodes
+distance_map_image: FloatImageType
+  distance map image
+spatial_nodes_position_are_in_physical_space: Bool [False]
+  node positions are in physical space (instead of default index space)
+distance_map_image_use_image_spacing: Bool [False]
+ the distance map values takes into account image spacing
+use_capsules: Bool [True]
+ join consecutive points of each edge with capsules instead of only spheres.
+num_threads: Int [0]
+ number of threads, 0 uses the default of ITK.
+)",
+            py::arg("graph"), py::arg("distance_map_image"),
+            py::arg("spatial_nodes_position_are_in_physical_space") = false,
+            py::arg("distance_map_image_use_image_spacing") = false,
+            py::arg("use_capsules") = true, py::arg("num_threads") = 0);
+
+    /* ************************************************** */
+
     m.def(
             "view_poly_data",
             [](vtkSmartPointer<vtkPolyData> &poly_data,
@@ -19,14 +19,16 @@
  * *******************************************************************/
 
 #include "pybind11_common.h"
+#include "async_result_py.h"
 
 #include "thin_function.hpp"
 
 namespace py = pybind11;
 using namespace SG;
 void init_thin(py::module &m) {
-    m.def("thin", &thin_function,
-            R"delimiter(
+    declare_async_result<BinaryImageType::Pointer>(
+            m, "binary_image_async_result");
+    const auto thin_docs = R"delimiter(
 Get a skeletonized or thinned image from a binary image.
 
 Parameters:
@@ -73,18 +75,26 @@ verbose: bool
 
 visualize: bool
     visualize results when finished.
-            )delimiter",
-            py::arg("input"),
-            py::arg("skel_type"),
-            py::arg("select_type"),
-            py::arg("tables_folder"),
-            py::arg("persistence") = 0,
-            // FloatImageType::Pointer is initialized to nullptr by default
-            py::arg("input_distance_map_image") = FloatImageType::New(),
-            py::arg("profile") = false,
-            py::arg("verbose") = false,
-            py::arg("visualize") = false
-         );
+            )delimiter";
+    // Same arguments for the blocking and async versions.
+    const auto def_thin = [&](const char *name, auto function,
+                              auto... extra) {
+        m.def(name, function, thin_docs,
+                py::arg("input"),
+                py::arg("skel_type"),
+                py::arg("select_type"),
+                py::arg("tables_folder"),
+                py::arg("persistence") = 0,
+                // FloatImageType::Pointer is initialized to nullptr by default
+                py::arg("input_distance_map_image") = FloatImageType::New(),
+                py::arg("profile") = false,
+                py::arg("verbose") = false,
+                py::arg("visualize") = false,
+                extra...);
+    };
+    def_thin("thin", &thin_function, py::call_guard<py::gil_scoped_release>());
+    // Returns a binary_image_async_result, use result() to get the image.
+    def_thin("thin_async", make_async(&thin_function));
 
     m.def("thin_io", &thin_function_io,
             R"delimiter(
@@ -157,6 +167,7 @@ visualize: bool
             py::arg("out_discrete_points_folder") = "",
             py::arg("profile") = false,
             py::arg("verbose") = false,
-            py::arg("visualize") = false
+            py::arg("visualize") = false,
+            py::call_guard<py::gil_scoped_release>()
          );
 }
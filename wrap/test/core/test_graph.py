@@ -19,6 +19,8 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 from sgext import core
 import unittest
 import copy
+import pickle
+import numpy as np
 
 class TestGraph(unittest.TestCase):
     def test_spatial_node(self):
@@ -99,6 +101,17 @@ class TestGraph(unittest.TestCase):
         self.assertEqual(graph.num_edges(), gc.num_edges())
         self.assertEqual(graph.num_edge_points(), gc.num_edge_points())
 
+        gc = copy.copy(graph)
+        self.assertEqual(graph.num_edge_points(), gc.num_edge_points())
+
+        # Persisted pickles are text
+        state = graph.__getstate__()
+        self.assertIsInstance(state, str)
+        gp = pickle.loads(pickle.dumps(graph))
+        self.assertEqual(graph.num_vertices(), gp.num_vertices())
+        self.assertEqual(graph.num_edges(), gp.num_edges())
+        self.assertEqual(graph.num_edge_points(), gp.num_edge_points())
+
 
     def test_spatial_graph_source_target(self):
         print("test_spatial_graph_source_target")
@@ -218,6 +231,56 @@ class TestGraph(unittest.TestCase):
         self.assertEqual(descriptors[3].edge_points_index, 1)
         print("end test_get_all_points")
 
+    def test_edge_points_array(self):
+        se = core.spatial_edge()
+        se.edge_points = [[0,0,0], [1,2,3]]
+        view = se.edge_points_array
+        self.assertEqual(view.shape, (2, 3))
+        self.assertEqual(view.dtype, np.float64)
+        self.assertAlmostEqual(view[1, 2], 3.0)
+        # The array is a view, not a copy
+        view[1, 2] = 5.0
+        self.assertAlmostEqual(se.edge_points[1][2], 5.0)
+        se.edge_points_array = np.array([[1,1,1], [2,2,2], [3,3,3]])
+        self.assertEqual(len(se.edge_points), 3)
+        self.assertAlmostEqual(se.edge_points[2][0], 3.0)
+        with self.assertRaises(RuntimeError):
+            se.edge_points_array = np.zeros((2, 2))
+
+    def test_bulk_points(self):
+        graph = core.spatial_graph(3)
+        graph.set_node_positions(np.array([[0,0,0], [1,0,0], [2,0,0]]))
+        self.assertAlmostEqual(graph.spatial_node(2).pos[0], 2.0)
+        positions = graph.node_positions()
+        self.assertEqual(positions.shape, (3, 3))
+        self.assertAlmostEqual(positions[1, 0], 1.0)
+        with self.assertRaises(RuntimeError):
+            graph.set_node_positions(np.zeros((2, 3)))
+
+        se = core.spatial_edge()
+        se.edge_points = [[0.5,0,0]]
+        core.graph.add_edge(0, 1, se, graph)
+        core.graph.add_edge(1, 2, core.spatial_edge(), graph)
+        [points, offsets] = graph.all_edge_points()
+        self.assertEqual(points.shape, (1, 3))
+        self.assertEqual(list(offsets), [0, 1, 1])
+        self.assertAlmostEqual(points[0, 0], 0.5)
+
+        new_points = np.array([[0.2,0,0], [1.2,0,0], [1.4,0,0]])
+        graph.set_all_edge_points(new_points, np.array([0, 1, 3]))
+        edges = graph.edges()
+        self.assertEqual(len(graph.spatial_edge(edges[0]).edge_points), 1)
+        self.assertEqual(len(graph.spatial_edge(edges[1]).edge_points), 2)
+        [points, offsets] = graph.all_edge_points()
+        np.testing.assert_allclose(points, new_points)
+        self.assertEqual(list(offsets), [0, 1, 3])
+        with self.assertRaises(RuntimeError):
+            graph.set_all_edge_points(new_points, np.array([0, 2, 4]))
+
+        gc = copy.deepcopy(graph)
+        np.testing.assert_allclose(gc.node_positions(), graph.node_positions())
+        np.testing.assert_allclose(gc.all_edge_points()[0], new_points)
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -18,6 +18,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 from sgext import dynamics
 import unittest
+import numpy as np
 from fixture_system4 import System4Fixture
 
 def a_particle_force(a_particle):
@@ -47,3 +48,57 @@ class TestDynamicsForceCompute(unittest.TestCase):
             bond.properties = props
 
         self.force_compute.compute()
+
+    def test_particle_batch_force_compute(self):
+        def batch_force(positions, velocities):
+            self.assertEqual(positions.shape, (4, 3))
+            self.assertEqual(velocities.shape, (4, 3))
+            return 2.0 * positions
+        self.force_compute = dynamics.force_compute_particle_batch(
+            self.fixture.system, batch_force)
+        self.assertEqual(self.force_compute.get_type(), "ParticleBatchForceCompute")
+        self.force_compute.compute()
+        positions = self.fixture.system.all.positions()
+        for i, particle_force in enumerate(self.force_compute.particle_forces):
+            np.testing.assert_allclose(particle_force.force, 2.0 * positions[i])
+        # Wrong shape of the returned forces
+        self.force_compute.set_force_function(lambda pos, vel: np.zeros((2, 3)))
+        with self.assertRaises(RuntimeError):
+            self.force_compute.compute()
+
+    def test_pair_bond_batch_force(self):
+        self.fixture.system.all.sort()
+        def spring(positions_a, positions_b):
+            return positions_b - positions_a
+        self.force_compute = dynamics.force_compute_pair_bond_batch(
+            self.fixture.system, spring)
+        self.assertEqual(self.force_compute.get_type(), "PairBondBatchForce")
+        self.force_compute.compute()
+        num_bonds = len(self.force_compute.bond_forces)
+        self.assertEqual(num_bonds, 3)
+        for bond_force in self.force_compute.bond_forces:
+            self.assertAlmostEqual(np.linalg.norm(bond_force.force), 1.0)
+
+    def test_excluded_volume(self):
+        self.fixture.system.all.sort()
+        self.force_compute = dynamics.force_compute_excluded_volume(
+            self.fixture.system, 1.0)
+        self.assertEqual(self.force_compute.get_type(), "ExcludedVolumeForce")
+        self.force_compute.compute()
+        self.assertEqual(self.force_compute.neighbor_list.number_of_builds, 1)
+        # Particle index 1 is bonded to all the others.
+        np.testing.assert_allclose(
+            self.force_compute.particle_forces[1].force, [0, 0, 0])
+        self.force_compute.exclude_bonded = False
+        self.force_compute.compute()
+        self.assertGreater(
+            np.linalg.norm(self.force_compute.particle_forces[1].force), 0.0)
+
+    def test_neighbor_list(self):
+        self.fixture.system.all.sort()
+        neighbor_list = dynamics.neighbor_list(cutoff=1.1, skin=0.0)
+        self.assertTrue(neighbor_list.update(self.fixture.system.all))
+        self.assertFalse(neighbor_list.update(self.fixture.system.all))
+        # Pairs closer than 1.1: (0, 1) and (1, 2)
+        self.assertEqual(len(neighbor_list.neighbors), 2)
+        self.assertEqual(len(neighbor_list.neighbor_offsets), 5)
@@ -29,3 +29,35 @@ class TestDynamicsIntegrator(unittest.TestCase):
 
     def test_print(self):
         print("Integrator:")
+
+    def test_parallel_update(self):
+        def spring(particle):
+            return [-x for x in particle.pos]
+        def drag(particle):
+            return [-0.5 * v for v in particle.dynamics.vel]
+        for force_function in (spring, drag):
+            force = dynamics.force_compute_particle(self.fixture.system)
+            force.force_function = force_function
+            self.integrator.add_force(force)
+        self.integrator.integrator_method = self.integrator_method
+        self.integrator.num_threads = 2
+        self.integrator_method.num_threads = 2
+        self.assertFalse(self.integrator.verbose)
+        for time_step in range(3):
+            self.integrator.update(time_step)
+
+    def test_update_calls_overridden_compute_net_forces(self):
+        class CountingIntegrator(dynamics.integrator_two_step):
+            def __init__(self, system):
+                dynamics.integrator_two_step.__init__(self, system)
+                self.calls = 0
+            def compute_net_forces(self, system):
+                self.calls += 1
+                dynamics.integrator_two_step.compute_net_forces(self, system)
+        integrator = CountingIntegrator(self.fixture.system)
+        integrator.integrator_method = self.integrator_method
+        self.assertFalse(integrator.fuse_net_forces())
+        self.assertTrue(self.integrator.fuse_net_forces())
+        for time_step in range(2):
+            integrator.update(time_step)
+        self.assertEqual(integrator.calls, 2)
@@ -18,6 +18,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 from sgext import dynamics
 import unittest
+import numpy as np
 
 class TestDynamicsParticleCollection(unittest.TestCase):
     def setUp(self):
@@ -41,12 +42,40 @@ class TestDynamicsParticleCollection(unittest.TestCase):
         p_found.id = new_id
         self.assertEqual(p_found.id, new_id)
         self.assertEqual(self.collection.particles[0].id, new_id)
+        p_found.pos = [3, 3, 3]
+        p_found.dynamics.vel = [1, 2, 3]
+        p_found.material.radius = 2.0
+        particle = self.collection.get_particle(0)
+        self.assertEqual(particle.pos[0], 3)
+        self.assertEqual(particle.dynamics.vel[2], 3)
+        self.assertEqual(particle.material.radius, 2.0)
+        # copy() is independent of the collection
+        p_copy = p_found.copy()
+        p_copy.pos = [4, 4, 4]
+        self.assertEqual(self.collection.particles[0].pos[0], 3)
+        with self.assertRaises(KeyError):
+            self.collection.binary_find(100)
         print(self.collection)
     def test_find_index(self):
         print("test_find_index")
         id_to_find = 1
         index_found = self.collection.find_index(id_to_find)
         self.assertEqual(self.collection.particles[index_found].id, id_to_find)
+        self.assertEqual(self.collection.particles[-1].id, 2)
+        with self.assertRaises(IndexError):
+            self.collection.particles[2]
+        self.assertEqual([p.id for p in self.collection.particles], [1, 2])
+    def test_positions_view(self):
+        positions = self.collection.positions()
+        self.assertEqual(positions.shape, (2, 3))
+        np.testing.assert_allclose(positions[0], [1, 1, 1])
+        # The array is a view of the particles
+        positions[1, 2] = 5.0
+        self.assertAlmostEqual(self.collection.get_particle(1).pos[2], 5.0)
+        velocities = self.collection.velocities()
+        self.assertEqual(velocities.shape, (2, 3))
+        self.assertEqual(len(self.collection), 2)
+        self.assertEqual(len(self.collection.particles), 2)
     def test_print(self):
         print("Collection:")
         print(self.collection)
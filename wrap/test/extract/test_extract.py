@@ -100,6 +100,14 @@ class TestReduceSpatialGraph(unittest.TestCase):
         reduced_graph = extract.reduce_spatial_graph_via_dfs(self.graph, verbose)
         self.assertEqual(reduced_graph.num_vertices(), self.graph.num_vertices())
         self.assertEqual(reduced_graph.num_edges(), self.graph.num_edges())
+    def test_reduce_spatial_graph_async(self):
+        verbose = False
+        future = extract.reduce_spatial_graph_async(self.graph, verbose)
+        self.assertTrue(future.wait(timeout=60))
+        self.assertTrue(future.done())
+        reduced_graph = future.result()
+        self.assertEqual(reduced_graph.num_vertices(), self.graph.num_vertices())
+        self.assertEqual(reduced_graph.num_edges(), self.graph.num_edges())
 
 class TestDetectAndCollapseClusters(unittest.TestCase):
     def setUp(self):
@@ -94,3 +94,39 @@ class TestVoxelize(unittest.TestCase):
         # Check vertex 5 is 255
         self.assertEqual(voxelized_graph.get_pixel([1,0,2]), 255)
 
+    def test_voxelize_rasterized(self):
+        # Add a long edge without edge points to check segments are drawn
+        vertex_6 = self.graph.add_vertex()
+        v6 = self.graph.spatial_node(vertex_6)
+        v6.pos = [-4, 3, 0]
+        self.graph.set_vertex(vertex_6, v6)
+        core.graph.add_edge(3, vertex_6, core.spatial_edge(), self.graph)
+        self.vertex_to_label_map[vertex_6] = 255
+        edge_to_label_map = scripts.create_edge_to_label_map_from_vertex_to_label_map_using_max(
+            graph=self.graph, vertex_to_label_map=self.vertex_to_label_map)
+
+        voxelized_graph = scripts.voxelize_graph_rasterized(
+            graph=self.graph,
+            reference_image=self.reference_image,
+            vertex_to_label_map=self.vertex_to_label_map,
+            edge_to_label_map=edge_to_label_map,
+            graph_positions_are_in_physical_space=False,
+            draw_segments=True)
+        self.assertEqual(voxelized_graph.get_pixel([3,3,3]), 0)
+        self.assertEqual(voxelized_graph.get_pixel([1,0,2]), 255)
+        # Voxel in the segment between [-1,0,0] and [-4,3,0]
+        self.assertEqual(voxelized_graph.get_pixel([-2,1,0]), 255)
+
+        # Tubes
+        vertex_to_radius_map = {0:1.0, 1:1.0, 2:1.0, 3:1.0, 4:1.0, 5:1.0, vertex_6:1.0}
+        voxelized_tubes = scripts.voxelize_graph_rasterized(
+            graph=self.graph,
+            reference_image=self.reference_image,
+            vertex_to_label_map=self.vertex_to_label_map,
+            edge_to_label_map=edge_to_label_map,
+            graph_positions_are_in_physical_space=False,
+            draw_segments=True,
+            vertex_to_radius_map=vertex_to_radius_map)
+        self.assertEqual(voxelized_tubes.get_pixel([3,3,3]), 0)
+        # Neighbor of vertex 3 at distance 1
+        self.assertEqual(voxelized_tubes.get_pixel([-1,0,1]), 255)